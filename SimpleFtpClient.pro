@@ -9,23 +9,17 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
-    ftpclient.cpp \
     main.cpp \
     mainwindow.cpp
 
 HEADERS += \
-    ftpclient.h \
     mainwindow.h
 
 FORMS += \
     mainwindow.ui
 
-# LibCURL configuration
-win32 {
-    CURL_DIR = C:/curl
-    INCLUDEPATH += $$CURL_DIR/include
-    LIBS += -L$$CURL_DIR/lib -lcurl
-}
+# FTP client core and LibCURL configuration
+include(ftpcore.pri)
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
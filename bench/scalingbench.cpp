@@ -0,0 +1,847 @@
+/**
+ * @file scalingbench.cpp
+ * @brief 并发数×文件大小扩展性基准测试
+ *
+ * 在并发连接数、文件大小、往返时延和TLS开关组成的矩阵上逐格运行下载，
+ * 记录吞吐量、每秒文件数、CPU占用、上下文切换次数和内存占用，
+ * 输出CSV文件，并在摘要中标出吞吐量不再随并发数增长的扩展拐点。
+ *
+ * 默认在临时目录中生成测试数据，以file://本地传输加模拟链路作为替身服务器；
+ * 也可以先用--generate生成数据目录交给本地FTP服务器，再用--server指向该服务器。
+ * 数据布局为 <根目录>/<大小标签>/fNNNNN.bin，例如 /1M/f00000.bin
+ *
+ * --sink-bench 单独测量落盘输出的写入吞吐量：普通文件与两种加密输出对比，
+ * 每次写入16KiB（libcurl写回调的最大块），用于确认加密不会把下载限制在线速以下
+ *
+ * --shards 改为测量按核心分片的TransferEngine：同一批文件交给不同分片数的引擎，
+ * 输出吞吐量、每秒文件数、窃取次数和相对单分片的加速比，用于确认吞吐量随核心数近似线性增长；
+ * 各分片数下的合计连接数相同（最大分片数×4），差异只来自分片本身
+ *
+ * --prewarm 改为测量块模式下数据连接预热的效果：在FTP服务器（--server）上用一个块模式会话
+ * 依次下载同一批文件，对比不同预热深度下每个文件等待第一个数据块的平均时间和每秒文件数；
+ * 往返时延取决于实际网络，--rtt的模拟时延不适用
+ *
+ * 以 CONFIG+=hotpath_trace 构建时，每格测试后附加接收路径各阶段的ns/MiB和p50/p99表格
+ */
+
+#include "ftpclient.h"
+#include "downloadsink.h"
+#include "transferengine.h"
+#include "hotpathtrace.h"
+#include "blockmodesession.h"
+#include "bytesize.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFileInfo>
+#include <QThread>
+#include <QFile>
+#include <QDir>
+#include <QUrl>
+#include <QMap>
+#include <algorithm>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+/**
+ * @struct BenchOptions
+ * @brief 基准测试参数
+ */
+struct BenchOptions {
+    QString server;              ///< 服务器地址
+    int port = 21;               ///< 端口号
+    QString username;            ///< 用户名
+    QString password;            ///< 密码
+    QList<int> concurrency;      ///< 并发连接数列表
+    QList<qint64> sizes;         ///< 文件大小列表
+    QList<int> rttMs;            ///< 模拟往返时延列表（毫秒）
+    QList<bool> tls;             ///< TLS开关列表
+    qint64 bandwidth = 0;        ///< 每个连接的模拟带宽（字节/秒），0表示不限制
+    qint64 cellBytes = 0;        ///< 每格测试的目标数据量
+    int maxFiles = 0;            ///< 每格测试的最大文件数
+    bool localServer = false;    ///< 是否使用本地替身服务器
+};
+
+/**
+ * @struct CellResult
+ * @brief 单格测试结果
+ */
+struct CellResult {
+    int concurrency = 0;         ///< 并发连接数
+    qint64 fileSize = 0;         ///< 文件大小
+    int rttMs = 0;               ///< 模拟往返时延
+    bool tls = false;            ///< 是否启用TLS
+    int files = 0;               ///< 成功下载的文件数
+    int failures = 0;            ///< 失败的文件数
+    qint64 bytes = 0;            ///< 下载字节数
+    double seconds = 0.0;        ///< 耗时（秒）
+    double cpuPercent = 0.0;     ///< 进程CPU占用（100%表示一个核心）
+    qint64 contextSwitches = -1; ///< 上下文切换次数，平台不支持时为-1
+    double rssMiB = 0.0;         ///< 测试期间的最大常驻内存（MiB）
+    QString error;               ///< 无法运行时的错误信息
+
+    double throughputMiB() const { return seconds > 0.0 ? bytes / seconds / (1024.0 * 1024.0) : 0.0; }
+    double filesPerSecond() const { return seconds > 0.0 ? files / seconds : 0.0; }
+};
+
+/**
+ * @struct ProcessSample
+ * @brief 进程资源占用采样
+ */
+struct ProcessSample {
+    double cpuSeconds = 0.0;     ///< 累计CPU时间（用户态+内核态）
+    qint64 contextSwitches = -1; ///< 累计上下文切换次数
+    double rssMiB = 0.0;         ///< 当前常驻内存（MiB）
+};
+
+/**
+ * @brief 采样当前进程的资源占用
+ * @return 资源占用采样
+ */
+static ProcessSample sampleProcess()
+{
+    ProcessSample sample;
+#ifdef Q_OS_WIN
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) {
+        auto toSeconds = [](const FILETIME &time) {
+            ULARGE_INTEGER value;
+            value.LowPart = time.dwLowDateTime;
+            value.HighPart = time.dwHighDateTime;
+            return value.QuadPart / 1e7;
+        };
+        sample.cpuSeconds = toSeconds(kernelTime) + toSeconds(userTime);
+    }
+
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        sample.rssMiB = counters.WorkingSetSize / (1024.0 * 1024.0);
+    }
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        sample.cpuSeconds = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+                          + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        sample.contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+    }
+
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly)) {
+        const QList<QByteArray> lines = status.readAll().split('\n');
+        for (const QByteArray &line : lines) {
+            if (line.startsWith("VmRSS:")) {
+                sample.rssMiB = line.mid(6).simplified().split(' ').first().toDouble() / 1024.0;
+                break;
+            }
+        }
+    }
+#endif
+    return sample;
+}
+
+/**
+ * @brief 生成大小标签，用作数据目录名
+ * @param size 字节数
+ * @return 大小标签，如"1K"、"10G"
+ */
+static QString sizeLabel(qint64 size)
+{
+    if (size % (1024LL * 1024 * 1024) == 0) {
+        return QString("%1G").arg(size / (1024LL * 1024 * 1024));
+    } else if (size % (1024LL * 1024) == 0) {
+        return QString("%1M").arg(size / (1024LL * 1024));
+    } else if (size % 1024 == 0) {
+        return QString("%1K").arg(size / 1024);
+    }
+    return QString::number(size);
+}
+
+/**
+ * @brief 计算某个文件大小在每格测试中使用的文件数
+ * @param options 测试参数
+ * @param fileSize 文件大小
+ * @return 文件数
+ */
+static int filesForSize(const BenchOptions &options, qint64 fileSize)
+{
+    return static_cast<int>(qBound<qint64>(1, options.cellBytes / fileSize, options.maxFiles));
+}
+
+/**
+ * @brief 生成测试数据目录
+ * @param root 数据根目录
+ * @param options 测试参数
+ * @return 操作是否成功
+ *
+ * 文件以稀疏方式创建，内容为零，不占用与大小相当的磁盘空间
+ */
+static bool generateData(const QString &root, const BenchOptions &options)
+{
+    for (qint64 fileSize : options.sizes) {
+        QDir dir(root + "/" + sizeLabel(fileSize));
+        if (!dir.mkpath(".")) {
+            return false;
+        }
+
+        int count = filesForSize(options, fileSize);
+        for (int i = 0; i < count; ++i) {
+            QFile file(dir.filePath(QString("f%1.bin").arg(i, 5, 10, QChar('0'))));
+            if (file.exists() && file.size() == fileSize) {
+                continue;
+            }
+            if (!file.open(QIODevice::WriteOnly) || !file.resize(fileSize)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 运行单格测试
+ * @param options 测试参数
+ * @param fileSize 文件大小
+ * @param concurrency 并发连接数
+ * @param rttMs 模拟往返时延
+ * @param tls 是否启用TLS
+ * @return 测试结果
+ *
+ * 每个并发连接在独立线程中使用自己的FtpClient，从共享的文件序号中领取任务，
+ * 下载完成的文件立即删除，避免大文件矩阵占满磁盘
+ */
+static CellResult runCell(const BenchOptions &options, qint64 fileSize, int concurrency, int rttMs, bool tls)
+{
+    CellResult result;
+    result.concurrency = concurrency;
+    result.fileSize = fileSize;
+    result.rttMs = rttMs;
+    result.tls = tls;
+
+    int fileCount = filesForSize(options, fileSize);
+    int workers = qMin(concurrency, fileCount);
+
+    QTemporaryDir outputDir;
+    if (!outputDir.isValid()) {
+        result.error = "无法创建临时输出目录";
+        return result;
+    }
+
+    // 连接在计时开始前完成，测量的只是传输阶段
+    std::vector<std::unique_ptr<FtpClient>> clients;
+    for (int i = 0; i < workers; ++i) {
+        std::unique_ptr<FtpClient> client(new FtpClient());
+        client->setUseTls(tls);
+        client->setSimulatedLink(rttMs, options.bandwidth);
+        if (!client->connect(options.server, options.port, options.username, options.password)) {
+            result.error = client->lastError();
+            return result;
+        }
+        clients.push_back(std::move(client));
+    }
+
+    QString remoteDir = "/" + sizeLabel(fileSize) + "/";
+    std::atomic<int> nextFile(0);
+    std::atomic<int> files(0);
+    std::atomic<int> failures(0);
+    std::atomic<qint64> bytes(0);
+
+    ProcessSample before = sampleProcess();
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QThread*> threads;
+    for (int i = 0; i < workers; ++i) {
+        FtpClient *client = clients[i].get();
+        QThread *thread = QThread::create([&, client]() {
+            for (int index = nextFile.fetch_add(1); index < fileCount; index = nextFile.fetch_add(1)) {
+                QString name = QString("f%1.bin").arg(index, 5, 10, QChar('0'));
+                QString localPath = outputDir.filePath(name);
+                if (client->downloadFile(remoteDir + name, localPath)) {
+                    files++;
+                    bytes += QFileInfo(localPath).size();
+                } else {
+                    failures++;
+                }
+                QFile::remove(localPath);
+            }
+        });
+        threads.append(thread);
+        thread->start();
+    }
+
+    // 等待期间周期性采样内存占用
+    double peakRssMiB = 0.0;
+    for (QThread *thread : threads) {
+        while (!thread->wait(100UL)) {
+            peakRssMiB = qMax(peakRssMiB, sampleProcess().rssMiB);
+        }
+    }
+
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    ProcessSample after = sampleProcess();
+    qDeleteAll(threads);
+
+    result.files = files;
+    result.failures = failures;
+    result.bytes = bytes;
+    result.rssMiB = qMax(peakRssMiB, after.rssMiB);
+    if (result.seconds > 0.0) {
+        result.cpuPercent = (after.cpuSeconds - before.cpuSeconds) / result.seconds * 100.0;
+    }
+    if (before.contextSwitches >= 0 && after.contextSwitches >= 0) {
+        result.contextSwitches = after.contextSwitches - before.contextSwitches;
+    }
+
+    return result;
+}
+
+/**
+ * @brief 输出并清空接收路径计时（仅在计时模式构建时）
+ * @param out 输出流
+ */
+static void printHotPathReport(QTextStream &out)
+{
+    if (HotPathTrace::isEnabled()) {
+        out << HotPathTrace::report() << "\n";
+        HotPathTrace::reset();
+    }
+}
+
+/**
+ * @brief 测量一种落盘输出的写入吞吐量
+ * @param output 未打开的输出设备
+ * @param totalBytes 写入的总字节数
+ * @param cpuPercent 输出写入期间的CPU占用
+ * @return 吞吐量（MiB/s），失败时为-1
+ */
+static double measureSink(QIODevice *output, qint64 totalBytes, double *cpuPercent)
+{
+    // 与libcurl每次回调交付的数据块大小一致
+    QByteArray block(16 * 1024, 'x');
+    for (int i = 0; i < block.size(); ++i) {
+        block[i] = static_cast<char>(i * 131 + 7);
+    }
+
+    if (!output->open(QIODevice::WriteOnly)) {
+        return -1.0;
+    }
+    ProcessSample before = sampleProcess();
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 written = 0; written < totalBytes; written += block.size()) {
+        if (output->write(block) != block.size()) {
+            return -1.0;
+        }
+    }
+    EncryptedFileSink *sink = qobject_cast<EncryptedFileSink*>(output);
+    if (sink && !sink->finish()) {
+        return -1.0;
+    }
+    output->close();
+    double seconds = timer.nsecsElapsed() / 1e9;
+    ProcessSample after = sampleProcess();
+    *cpuPercent = seconds > 0.0 ? (after.cpuSeconds - before.cpuSeconds) / seconds * 100.0 : 0.0;
+    return seconds > 0.0 ? totalBytes / seconds / (1024.0 * 1024.0) : 0.0;
+}
+
+/**
+ * @brief 对比普通文件与加密输出的写入吞吐量
+ * @param totalBytes 每种输出写入的字节数
+ * @param out 输出流
+ * @return 程序退出代码
+ */
+static int runSinkBench(qint64 totalBytes, QTextStream &out)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        out << "无法创建临时目录\n";
+        return 1;
+    }
+    QByteArray key(EncryptedFileSink::KeySize, '\x5a');
+
+    struct SinkCase {
+        QString name;
+        std::function<QIODevice*(const QString &)> create;
+    };
+    QList<SinkCase> cases = {
+        {"plain", [](const QString &path) { return static_cast<QIODevice*>(new QFile(path)); }},
+        {"aes-256-gcm", [&key](const QString &path) {
+             return static_cast<QIODevice*>(new EncryptedFileSink(path, key, EncryptedFileSink::Aes256Gcm)); }},
+        {"chacha20-poly1305", [&key](const QString &path) {
+             return static_cast<QIODevice*>(new EncryptedFileSink(path, key, EncryptedFileSink::ChaCha20Poly1305)); }},
+    };
+
+    double plainMiB = 0.0;
+    for (const SinkCase &sinkCase : cases) {
+        QString path = dir.filePath(sinkCase.name + ".bin");
+        std::unique_ptr<QIODevice> output(sinkCase.create(path));
+        double cpuPercent = 0.0;
+        double mib = measureSink(output.get(), totalBytes, &cpuPercent);
+        QFile::remove(path);
+        if (mib < 0.0) {
+            out << sinkCase.name << ": 写入失败\n";
+            return 1;
+        }
+        if (sinkCase.name == "plain") {
+            plainMiB = mib;
+        }
+        out << QString("%1: %2 MiB/s (%3 Gbit/s), CPU %4%%5\n")
+                   .arg(sinkCase.name, -18)
+                   .arg(mib, 0, 'f', 1)
+                   .arg(mib * 1024 * 1024 * 8 / 1e9, 0, 'f', 2)
+                   .arg(cpuPercent, 0, 'f', 0)
+                   .arg(plainMiB > 0.0 && sinkCase.name != "plain"
+                            ? QString("，为普通写入的 %1%").arg(mib / plainMiB * 100.0, 0, 'f', 0)
+                            : QString());
+        printHotPathReport(out);
+        out.flush();
+    }
+    return 0;
+}
+
+/**
+ * @brief 用分片传输引擎运行单格测试
+ * @param options 测试参数
+ * @param fileSize 文件大小
+ * @param shards 分片数
+ * @param connections 合计连接数，在分片之间平分
+ * @param rttMs 模拟往返时延
+ * @param steals 输出从其他分片窃取的任务数
+ * @return 测试结果，concurrency字段为分片数
+ *
+ * 合计连接数固定，不随分片数增加，否则加速比里混入了连接数增加带来的收益
+ */
+static CellResult runShardCell(const BenchOptions &options, qint64 fileSize, int shards, int connections,
+                               int rttMs, qint64 *steals)
+{
+    CellResult result;
+    result.concurrency = shards;
+    result.fileSize = fileSize;
+    result.rttMs = rttMs;
+
+    QTemporaryDir outputDir;
+    if (!outputDir.isValid()) {
+        result.error = "无法创建临时输出目录";
+        return result;
+    }
+
+    TransferEngine engine(shards);
+    engine.setServer(options.server, options.port, options.username, options.password);
+    engine.setMaxConnections(connections);
+    engine.setConfigurator([&options, rttMs](FtpClient *client) {
+        client->setSimulatedLink(rttMs, options.bandwidth);
+    });
+    // 下载完成的文件立即删除，避免大文件矩阵占满磁盘
+    engine.setCompletionHandler([](const TransferResult &done) { QFile::remove(done.task.localPath); });
+    if (!engine.start()) {
+        result.error = engine.lastError();
+        return result;
+    }
+
+    QString remoteDir = "/" + sizeLabel(fileSize) + "/";
+    int fileCount = filesForSize(options, fileSize);
+
+    ProcessSample before = sampleProcess();
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < fileCount; ++i) {
+        QString name = QString("f%1.bin").arg(i, 5, 10, QChar('0'));
+        DownloadTask task;
+        task.remotePath = remoteDir + name;
+        task.localPath = outputDir.filePath(name);
+        task.isDirectory = false;
+        task.fileSize = fileSize;
+        task.displayName = name;
+        engine.submit(task);
+    }
+    double peakRssMiB = 0.0;
+    while (engine.pending() > 0) {
+        QThread::msleep(100);
+        peakRssMiB = qMax(peakRssMiB, sampleProcess().rssMiB);
+    }
+    engine.finish();
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    ProcessSample after = sampleProcess();
+
+    TransferEngineStats stats = engine.stats();
+    result.files = static_cast<int>(stats.files);
+    result.failures = static_cast<int>(stats.failures);
+    result.bytes = stats.bytes;
+    result.rssMiB = qMax(peakRssMiB, after.rssMiB);
+    if (result.seconds > 0.0) {
+        result.cpuPercent = (after.cpuSeconds - before.cpuSeconds) / result.seconds * 100.0;
+    }
+    if (before.contextSwitches >= 0 && after.contextSwitches >= 0) {
+        result.contextSwitches = after.contextSwitches - before.contextSwitches;
+    }
+    *steals = stats.steals;
+    return result;
+}
+
+/**
+ * @brief 对每个文件大小和往返时延测量分片引擎随分片数的扩展
+ * @param options 测试参数
+ * @param shardCounts 分片数列表
+ * @param out 输出流
+ * @return 程序退出代码
+ */
+static int runShardBench(const BenchOptions &options, const QList<int> &shardCounts, QTextStream &out)
+{
+    // 所有分片数共用同一个连接总数，取最大分片数时每个分片4个连接
+    int maxShards = 1;
+    for (int shards : shardCounts) {
+        maxShards = qMax(maxShards, shards);
+    }
+    int connections = maxShards * 4;
+    out << QString("合计连接数 %1\n").arg(connections);
+
+    for (int rttMs : options.rttMs) {
+        for (qint64 fileSize : options.sizes) {
+            double baseline = 0.0;
+            for (int shards : shardCounts) {
+                if (shards <= 0) {
+                    continue;
+                }
+                qint64 steals = 0;
+                CellResult result = runShardCell(options, fileSize, shards, connections, rttMs, &steals);
+                if (!result.error.isEmpty()) {
+                    out << QString("分片=%1 大小=%2 rtt=%3ms: 失败: %4\n")
+                               .arg(shards).arg(sizeLabel(fileSize)).arg(rttMs).arg(result.error);
+                    return 1;
+                }
+                if (baseline <= 0.0) {
+                    baseline = result.filesPerSecond() / shards;
+                }
+                out << QString("分片=%1 大小=%2 rtt=%3ms: %4 MiB/s, %5 文件/s, 窃取 %6, CPU %7%, 加速比 %8\n")
+                           .arg(shards).arg(sizeLabel(fileSize)).arg(rttMs)
+                           .arg(result.throughputMiB(), 0, 'f', 1)
+                           .arg(result.filesPerSecond(), 0, 'f', 1)
+                           .arg(steals)
+                           .arg(result.cpuPercent, 0, 'f', 0)
+                           .arg(baseline > 0.0 ? result.filesPerSecond() / baseline : 0.0, 0, 'f', 2);
+                printHotPathReport(out);
+                out.flush();
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * @class DiscardDevice
+ * @brief 丢弃所有写入数据的输出设备，只测量网络部分
+ */
+class DiscardDevice : public QIODevice
+{
+protected:
+    qint64 readData(char *, qint64) override { return -1; }
+    qint64 writeData(const char *, qint64 len) override { return len; }
+};
+
+/**
+ * @brief 测量块模式数据连接预热的效果
+ * @param options 测试参数
+ * @param depths 预热深度列表，0表示不预热
+ * @param out 输出流
+ * @return 程序退出代码
+ *
+ * 每格使用新的块模式会话，登录在计时开始前完成；第一个文件用于判断服务器是否保持数据连接，
+ * 之后的文件才开始预热，因此每格至少需要两个文件才能看出差别
+ */
+static int runPrewarmBench(const BenchOptions &options, const QList<int> &depths, QTextStream &out)
+{
+    if (options.localServer) {
+        out << "块模式预热测量需要支持MODE B的FTP服务器（--server）\n";
+        return 1;
+    }
+    QString host = options.server.contains("://") ? QUrl(options.server).host() : options.server;
+
+    for (qint64 fileSize : options.sizes) {
+        QString remoteDir = "/" + sizeLabel(fileSize) + "/";
+        QStringList paths;
+        for (int i = 0; i < filesForSize(options, fileSize); ++i) {
+            paths << remoteDir + QString("f%1.bin").arg(i, 5, 10, QChar('0'));
+        }
+
+        double baseline = 0.0;
+        for (int depth : depths) {
+            BlockModeSession session;
+            if (!session.open(host, options.port, options.username, options.password)) {
+                out << QString("深度=%1 大小=%2: 失败: %3\n").arg(depth).arg(sizeLabel(fileSize)).arg(session.lastError());
+                return 1;
+            }
+            session.setPrewarmDepth(depth);
+            session.setUpcoming(paths);
+
+            DiscardDevice output;
+            output.open(QIODevice::WriteOnly);
+            int files = 0;
+            int failures = 0;
+            QElapsedTimer timer;
+            timer.start();
+            for (const QString &path : paths) {
+                if (session.retrieve(path, &output)) {
+                    ++files;
+                } else {
+                    ++failures;
+                    if (!session.isOpen()) {
+                        break;
+                    }
+                }
+            }
+            double seconds = timer.nsecsElapsed() / 1e9;
+            double filesPerSecond = seconds > 0.0 ? files / seconds : 0.0;
+            if (baseline <= 0.0) {
+                baseline = filesPerSecond;
+            }
+            out << QString("深度=%1 大小=%2: %3 文件/s, %4 MiB/s, 平均等待 %5 ms/文件, 数据连接 %6, "
+                           "预热命中 %7, 失败 %8, 相对第一格 %9\n")
+                       .arg(depth).arg(sizeLabel(fileSize))
+                       .arg(filesPerSecond, 0, 'f', 1)
+                       .arg(seconds > 0.0 ? files * fileSize / seconds / (1024.0 * 1024.0) : 0.0, 0, 'f', 1)
+                       .arg(files + failures > 0 ? session.startWaitNs() / 1e6 / (files + failures) : 0.0, 0, 'f', 2)
+                       .arg(session.dataConnections())
+                       .arg(session.prewarmedFiles())
+                       .arg(failures)
+                       .arg(baseline > 0.0 ? filesPerSecond / baseline : 0.0, 0, 'f', 2);
+            out.flush();
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 输出扩展性摘要
+ * @param results 全部测试结果
+ * @param out 输出流
+ *
+ * 按(文件大小, 往返时延, TLS)分组，沿并发数方向找出吞吐量增长不足10%的第一个点作为扩展拐点
+ */
+static void printSummary(const QList<CellResult> &results, QTextStream &out)
+{
+    QMap<QString, QList<CellResult>> series;
+    for (const CellResult &result : results) {
+        if (!result.error.isEmpty()) {
+            continue;
+        }
+        QString key = QString("size=%1 rtt=%2ms tls=%3")
+                          .arg(sizeLabel(result.fileSize))
+                          .arg(result.rttMs)
+                          .arg(result.tls ? "on" : "off");
+        series[key].append(result);
+    }
+
+    out << "\n===== 扩展性摘要 =====\n";
+    for (auto it = series.constBegin(); it != series.constEnd(); ++it) {
+        QList<CellResult> cells = it.value();
+        std::sort(cells.begin(), cells.end(), [](const CellResult &a, const CellResult &b) {
+            return a.concurrency < b.concurrency;
+        });
+
+        const CellResult *best = &cells.first();
+        const CellResult *knee = nullptr;
+        for (int i = 0; i < cells.size(); ++i) {
+            if (cells[i].throughputMiB() > best->throughputMiB()) {
+                best = &cells[i];
+            }
+            if (!knee && i + 1 < cells.size()
+                && cells[i + 1].throughputMiB() < cells[i].throughputMiB() * 1.1) {
+                knee = &cells[i];
+            }
+        }
+
+        out << it.key() << ": 最佳并发 " << best->concurrency
+            << " (" << QString::number(best->throughputMiB(), 'f', 1) << " MiB/s, "
+            << QString::number(best->filesPerSecond(), 'f', 1) << " 文件/s)";
+        if (knee) {
+            out << "，扩展拐点在并发 " << knee->concurrency
+                << "（之后吞吐量增长不足10%，CPU " << QString::number(knee->cpuPercent, 'f', 0) << "%）";
+        } else {
+            out << "，在测试范围内未出现扩展拐点";
+        }
+        out << "\n";
+    }
+}
+
+/**
+ * @brief 解析逗号分隔的整数列表
+ * @param text 列表文本
+ * @return 整数列表，忽略无法解析的项
+ */
+static QList<int> parseIntList(const QString &text)
+{
+    QList<int> values;
+    for (const QString &item : text.split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        int value = item.trimmed().toInt(&ok);
+        if (ok && value >= 0) {
+            values.append(value);
+        }
+    }
+    return values;
+}
+
+/**
+ * @brief 主函数
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数数组
+ * @return 程序退出代码
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("scalingbench");
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("并发数×文件大小扩展性基准测试");
+    parser.addHelpOption();
+    QCommandLineOption serverOption("server", "服务器地址，省略时使用临时目录作为file://替身服务器", "url");
+    QCommandLineOption portOption("port", "端口号", "port", "21");
+    QCommandLineOption userOption("user", "用户名", "name");
+    QCommandLineOption passwordOption("password", "密码", "password");
+    QCommandLineOption concurrencyOption("concurrency", "并发连接数列表", "list", "1,2,4,8,16,32,64,128,256");
+    QCommandLineOption sizesOption("sizes", "文件大小列表", "list", "1K,32K,1M,32M,1G,10G");
+    QCommandLineOption rttOption("rtt", "模拟往返时延列表（毫秒）", "list", "0,20,100");
+    QCommandLineOption tlsOption("tls", "TLS开关列表（off,on）", "list", "off,on");
+    QCommandLineOption bandwidthOption("bandwidth", "每个连接的模拟带宽（如100M，0表示不限制）", "bytes", "0");
+    QCommandLineOption cellBytesOption("cell-bytes", "每格测试的目标数据量", "bytes", "1G");
+    QCommandLineOption maxFilesOption("max-files", "每格测试的最大文件数", "count", "2000");
+    QCommandLineOption csvOption("csv", "CSV输出文件", "file", "scaling.csv");
+    QCommandLineOption generateOption("generate", "只在指定目录生成测试数据，供FTP服务器使用", "dir");
+    QCommandLineOption sinkBenchOption("sink-bench", "只对比普通写入与加密输出的写入吞吐量", "bytes");
+    QCommandLineOption shardsOption("shards", "改为测量分片传输引擎，分片数列表", "list");
+    QCommandLineOption prewarmOption("prewarm", "改为测量块模式数据连接预热，预热深度列表（如0,1,4）", "list");
+    parser.addOptions({serverOption, portOption, userOption, passwordOption, concurrencyOption, sizesOption,
+                       rttOption, tlsOption, bandwidthOption, cellBytesOption, maxFilesOption, csvOption,
+                       generateOption, sinkBenchOption, shardsOption, prewarmOption});
+    parser.process(app);
+
+    if (parser.isSet(sinkBenchOption)) {
+        qint64 totalBytes = ByteSize::parse(parser.value(sinkBenchOption));
+        if (totalBytes <= 0) {
+            out << "参数无效\n";
+            return 1;
+        }
+        return runSinkBench(totalBytes, out);
+    }
+
+    BenchOptions options;
+    options.server = parser.value(serverOption);
+    options.port = parser.value(portOption).toInt();
+    options.username = parser.value(userOption);
+    options.password = parser.value(passwordOption);
+    options.concurrency = parseIntList(parser.value(concurrencyOption));
+    options.rttMs = parseIntList(parser.value(rttOption));
+    options.bandwidth = qMax<qint64>(0, ByteSize::parse(parser.value(bandwidthOption)));
+    options.cellBytes = ByteSize::parse(parser.value(cellBytesOption));
+    options.maxFiles = qMax(1, parser.value(maxFilesOption).toInt());
+    for (const QString &item : parser.value(sizesOption).split(',', Qt::SkipEmptyParts)) {
+        qint64 size = ByteSize::parse(item);
+        if (size > 0) {
+            options.sizes.append(size);
+        }
+    }
+    for (const QString &item : parser.value(tlsOption).split(',', Qt::SkipEmptyParts)) {
+        options.tls.append(item.trimmed() == "on");
+    }
+
+    if (options.concurrency.isEmpty() || options.sizes.isEmpty() || options.rttMs.isEmpty()
+        || options.tls.isEmpty() || options.cellBytes <= 0) {
+        out << "参数无效\n";
+        return 1;
+    }
+
+    if (parser.isSet(generateOption)) {
+        bool ok = generateData(parser.value(generateOption), options);
+        out << (ok ? "测试数据已生成\n" : "生成测试数据失败\n");
+        return ok ? 0 : 1;
+    }
+
+    // 未指定服务器时在临时目录生成数据，通过file://本地传输访问
+    QTemporaryDir dataDir;
+    if (options.server.isEmpty()) {
+        if (!dataDir.isValid() || !generateData(dataDir.path(), options)) {
+            out << "生成测试数据失败\n";
+            return 1;
+        }
+        options.server = QUrl::fromLocalFile(dataDir.path()).toString();
+        options.localServer = true;
+    }
+
+    if (parser.isSet(shardsOption)) {
+        return runShardBench(options, parseIntList(parser.value(shardsOption)), out);
+    }
+    if (parser.isSet(prewarmOption)) {
+        return runPrewarmBench(options, parseIntList(parser.value(prewarmOption)), out);
+    }
+
+    QFile csvFile(parser.value(csvOption));
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        out << "无法创建CSV文件: " << csvFile.fileName() << "\n";
+        return 1;
+    }
+    QTextStream csv(&csvFile);
+    csv << "concurrency,file_size,rtt_ms,tls,files,failures,bytes,seconds,throughput_mib_s,files_per_s,"
+           "cpu_percent,context_switches,rss_mib\n";
+
+    QList<CellResult> results;
+    for (bool tls : options.tls) {
+        // 本地替身服务器没有TLS层，跳过TLS开启的格子
+        if (tls && options.localServer) {
+            out << "本地替身服务器不支持TLS，跳过tls=on\n";
+            continue;
+        }
+        for (int rttMs : options.rttMs) {
+            for (qint64 fileSize : options.sizes) {
+                for (int concurrency : options.concurrency) {
+                    if (concurrency <= 0) {
+                        continue;
+                    }
+
+                    CellResult result = runCell(options, fileSize, concurrency, rttMs, tls);
+                    if (!result.error.isEmpty()) {
+                        out << QString("并发=%1 大小=%2 rtt=%3ms tls=%4: 失败: %5\n")
+                                   .arg(concurrency).arg(sizeLabel(fileSize)).arg(rttMs)
+                                   .arg(tls ? "on" : "off").arg(result.error);
+                        continue;
+                    }
+
+                    results.append(result);
+                    csv << result.concurrency << ',' << result.fileSize << ',' << result.rttMs << ','
+                        << (result.tls ? "on" : "off") << ',' << result.files << ',' << result.failures << ','
+                        << result.bytes << ',' << QString::number(result.seconds, 'f', 3) << ','
+                        << QString::number(result.throughputMiB(), 'f', 2) << ','
+                        << QString::number(result.filesPerSecond(), 'f', 2) << ','
+                        << QString::number(result.cpuPercent, 'f', 1) << ',' << result.contextSwitches << ','
+                        << QString::number(result.rssMiB, 'f', 1) << '\n';
+                    csv.flush();
+
+                    out << QString("并发=%1 大小=%2 rtt=%3ms tls=%4: %5 MiB/s, %6 文件/s, CPU %7%\n")
+                               .arg(concurrency).arg(sizeLabel(fileSize)).arg(rttMs).arg(tls ? "on" : "off")
+                               .arg(result.throughputMiB(), 0, 'f', 1)
+                               .arg(result.filesPerSecond(), 0, 'f', 1)
+                               .arg(result.cpuPercent, 0, 'f', 0);
+                    printHotPathReport(out);
+                    out.flush();
+                }
+            }
+        }
+    }
+
+    printSummary(results, out);
+    out << "结果已写入 " << csvFile.fileName() << "\n";
+    return 0;
+}
@@ -0,0 +1,15 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = scalingbench
+
+SOURCES += \
+    scalingbench.cpp
+
+# FTP client core and LibCURL configuration
+include(../ftpcore.pri)
+
+win32: LIBS += -lpsapi
@@ -0,0 +1,581 @@
+/**
+ * @file blockmodesession.cpp
+ * @brief FTP块模式（MODE B）会话实现文件
+ */
+
+#include "blockmodesession.h"
+#include "hotpathtrace.h"
+#include <QRegularExpression>
+#include <QElapsedTimer>
+
+// 块描述符标志（RFC 959 3.4.2）
+static const quint8 BLOCK_EOF = 64;       // 本块是文件的最后一块
+static const quint8 BLOCK_RESTART = 16;   // 本块是重启标记，不属于文件数据
+
+/**
+ * @brief 构造函数
+ */
+BlockModeSession::BlockModeSession()
+    : m_timeoutMs(30000)
+    , m_unsupported(false)
+    , m_epsvRejected(false)
+    , m_dataReuse(-1)
+    , m_prewarmDepth(1)
+    , m_dataConnections(0)
+    , m_prewarmedFiles(0)
+    , m_startWaitNs(0)
+{
+}
+
+/**
+ * @brief 析构函数，发送QUIT并关闭连接
+ */
+BlockModeSession::~BlockModeSession()
+{
+    close();
+}
+
+/**
+ * @brief 连接服务器、登录并切换到块模式
+ * @param host 主机名
+ * @param port 控制连接端口
+ * @param username 用户名
+ * @param password 密码
+ * @return 操作是否成功
+ */
+bool BlockModeSession::open(const QString &host, int port, const QString &username, const QString &password)
+{
+    close();
+    m_host = host;
+    m_unsupported = false;
+    m_epsvRejected = false;
+    m_dataReuse = -1;
+
+    if (!m_localAddress.isNull() && !m_control.bind(m_localAddress)) {
+        m_lastError = QString("块模式连接无法绑定本地地址 %1: %2")
+                          .arg(m_localAddress.toString(), m_control.errorString());
+        return false;
+    }
+    m_control.connectToHost(host, static_cast<quint16>(port));
+    if (!m_control.waitForConnected(m_timeoutMs)) {
+        m_lastError = QString("块模式连接失败: %1").arg(m_control.errorString());
+        return false;
+    }
+
+    int code = 0;
+    if (!readReply(&code, nullptr) || code != 220) {
+        m_lastError = QString("块模式连接失败: 服务器应答 %1").arg(code);
+        close();
+        return false;
+    }
+
+    // 与libcurl一致，未填写用户名时匿名登录
+    QString user = username.isEmpty() ? QString("anonymous") : username;
+    QString pass = username.isEmpty() ? QString("ftp@example.com") : password;
+    if (!sendCommand("USER " + user, &code)) {
+        close();
+        return false;
+    }
+    if (code == 331 && !sendCommand("PASS " + pass, &code)) {
+        close();
+        return false;
+    }
+    if (code != 230) {
+        m_lastError = QString("块模式登录失败: 服务器应答 %1").arg(code);
+        close();
+        return false;
+    }
+
+    if (!sendCommand("TYPE I", &code) || code != 200) {
+        m_lastError = QString("块模式设置二进制传输失败: 服务器应答 %1").arg(code);
+        close();
+        return false;
+    }
+
+    QString text;
+    if (!sendCommand("MODE B", &code, &text)) {
+        close();
+        return false;
+    }
+    if (code != 200) {
+        // 4xx是临时错误，之后还可以再试
+        m_unsupported = code >= 500;
+        m_lastError = QString("服务器不支持块模式: %1").arg(text);
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 告知接下来将按顺序下载的文件
+ * @param remotePaths 远程文件路径
+ */
+void BlockModeSession::setUpcoming(const QStringList &remotePaths)
+{
+    // 已预先请求的文件保持在最前面，不在新列表中时由下一次retrieve()丢弃
+    int overlap = remotePaths.mid(0, m_requested.size()) == m_requested ? m_requested.size() : 0;
+    m_upcoming = m_requested + remotePaths.mid(overlap);
+}
+
+/**
+ * @brief 通过块模式下载一个文件
+ * @param remotePath 远程文件路径
+ * @param output 输出设备
+ * @param progress 进度回调
+ * @return 操作是否成功
+ */
+bool BlockModeSession::retrieve(const QString &remotePath, QIODevice *output, std::function<void(qint64)> progress)
+{
+    if (!isOpen()) {
+        m_lastError = "块模式会话未连接";
+        return false;
+    }
+    QElapsedTimer waitTimer;
+    waitTimer.start();
+
+    // 调用方跳过了已预先请求的文件，读取并丢弃它们的内容
+    while (!m_requested.isEmpty() && m_requested.first() != remotePath) {
+        if (!skipRequested()) {
+            return false;
+        }
+    }
+
+    int code = 0;
+    QString text;
+    bool sent = false;
+    if (!m_requested.isEmpty()) {
+        // RETR已在上一个文件结束时发出
+        m_requested.removeFirst();
+        if (!readReply(&code, &text)) {
+            close();
+            return false;
+        }
+        sent = true;
+        if (code == 425 || code == 426) {
+            // 服务器关闭了数据连接，之后预先请求的文件也都会失败，读完它们的应答后重新请求
+            m_data.reset();
+            m_dataReuse = 0;
+            while (!m_requested.isEmpty()) {
+                if (!skipRequested()) {
+                    return false;
+                }
+            }
+            sent = false;
+        } else {
+            ++m_prewarmedFiles;
+        }
+    }
+    int index = m_upcoming.indexOf(remotePath);
+    if (index >= 0) {
+        m_upcoming.erase(m_upcoming.begin(), m_upcoming.begin() + index + 1);
+    }
+
+    if (!sent) {
+        if (!hasDataConnection() && !openDataConnection()) {
+            return false;
+        }
+        // 没有收到应答时控制连接的状态已不可知，不能再用于下一个文件
+        if (!sendCommand("RETR " + remotePath, &code, &text)) {
+            close();
+            return false;
+        }
+    }
+    if (code != 125 && code != 150) {
+        // 文件不存在等错误不影响会话；425/426表示数据连接已不可用，下一个文件重新建立
+        if (code == 425 || code == 426) {
+            m_data.reset();
+        }
+        m_lastError = QString("下载文件失败: %1 (%2)").arg(remotePath, text.trimmed());
+        return false;
+    }
+
+    // 预热的数据连接可能仍在建立
+    if (!m_data || (m_data->state() != QAbstractSocket::ConnectedState && !m_data->waitForConnected(m_timeoutMs))) {
+        m_lastError = QString("建立数据连接失败: %1").arg(m_data ? m_data->errorString() : QString("没有数据连接"));
+        m_data.reset();
+        close();
+        return false;
+    }
+
+    // 逐块读取直到EOF描述符；数据连接不会关闭
+    bool writeFailed = false;
+    if (!receiveBlocks(output, progress, &writeFailed, &waitTimer)) {
+        m_data.reset();
+        close();
+        return false;
+    }
+
+    // 服务器发送完成应答之前发出后续文件的命令
+    bool passive = sendPrewarm();
+    if (!readCompletion(&code, &text)) {
+        close();
+        return false;
+    }
+    if (passive && !finishPrewarm()) {
+        return false;
+    }
+    if (code != 226 && code != 250) {
+        m_lastError = QString("下载文件失败: %1 (%2)").arg(remotePath, text.trimmed());
+        return false;
+    }
+    if (writeFailed) {
+        m_lastError = QString("写入本地文件失败: %1").arg(output->errorString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 读取一个文件的所有数据块
+ * @param output 输出设备，为nullptr时丢弃数据
+ * @param progress 进度回调
+ * @param writeFailed 输出写入失败时置为true
+ * @param waitTimer 从调用retrieve()开始的计时，收到第一个数据块时计入等待时间（可选）
+ * @return 读到EOF时返回true
+ */
+bool BlockModeSession::receiveBlocks(QIODevice *output, const std::function<void(qint64)> &progress,
+                                     bool *writeFailed, QElapsedTimer *waitTimer)
+{
+    qint64 received = 0;
+    QByteArray payload;
+    for (;;) {
+        uchar header[3];
+        if (!readData(reinterpret_cast<char*>(header), 3)) {
+            return false;
+        }
+        if (waitTimer) {
+            m_startWaitNs += waitTimer->nsecsElapsed();
+            waitTimer = nullptr;
+        }
+        quint8 descriptor = header[0];
+        qint64 count = (static_cast<qint64>(header[1]) << 8) | header[2];
+        payload.resize(count);
+        if (count > 0 && !readData(payload.data(), count)) {
+            return false;
+        }
+        if (output && !(descriptor & BLOCK_RESTART) && count > 0 && !*writeFailed) {
+            HOTPATH_SPAN(callbackSpan, Callback, count);
+            {
+                HOTPATH_SPAN(sinkSpan, Sink, count);
+                if (output->write(payload) != count) {
+                    *writeFailed = true;
+                }
+            }
+            received += count;
+            if (progress) {
+                HOTPATH_SPAN(progressSpan, Progress, count);
+                progress(received);
+            }
+        }
+        if (descriptor & BLOCK_EOF) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief 读取文件的完成应答
+ * @param code 输出应答码
+ * @param text 输出应答文本
+ * @return 收到应答时返回true
+ */
+bool BlockModeSession::readCompletion(int *code, QString *text)
+{
+    if (!readReply(code, text)) {
+        return false;
+    }
+    // 226表示服务器随后会关闭数据连接，250表示数据连接保持打开
+    if (*code == 226) {
+        m_data.reset();
+        m_dataReuse = 0;
+    } else if (*code == 250) {
+        m_dataReuse = 1;
+    }
+    return true;
+}
+
+/**
+ * @brief 在当前文件的完成应答之前发出后续文件的命令
+ * @return 是否发出了EPSV/PASV
+ *
+ * 服务器处理完当前文件后依次处理这些命令，应答紧跟在完成应答之后到达；
+ * 第一个文件结束前还不知道服务器是否保持数据连接，不预热
+ */
+bool BlockModeSession::sendPrewarm()
+{
+    if (m_prewarmDepth == 0 || m_dataReuse < 0 || m_upcoming.size() <= m_requested.size()) {
+        return false;
+    }
+    if (m_dataReuse == 1) {
+        QByteArray commands;
+        int depth = qMin(m_prewarmDepth, m_upcoming.size());
+        while (m_requested.size() < depth) {
+            QString path = m_upcoming.at(m_requested.size());
+            commands += "RETR " + path.toUtf8() + "\r\n";
+            m_requested.append(path);
+        }
+        m_control.write(commands);
+        m_control.flush();
+        return false;
+    }
+
+    // 每个文件后关闭数据连接：先请求下一个文件的被动模式端口
+    if (!m_requested.isEmpty()) {
+        return false;
+    }
+    m_control.write(m_epsvRejected ? "PASV\r\n" : "EPSV\r\n");
+    m_control.flush();
+    return true;
+}
+
+/**
+ * @brief 读取预先发出的EPSV/PASV的应答，开始建立数据连接并发出下一个文件的RETR
+ * @return 控制连接仍然可用时返回true
+ */
+bool BlockModeSession::finishPrewarm()
+{
+    int code = 0;
+    QString text;
+    if (!readReply(&code, &text)) {
+        close();
+        return false;
+    }
+    int port = passivePort(code, text);
+    if (port == 0) {
+        // 预热失败不影响下一个文件，届时按常规建立数据连接
+        if (!m_epsvRejected && code >= 500) {
+            m_epsvRejected = true;
+        }
+        return true;
+    }
+    if (!connectData(port, false) || m_upcoming.isEmpty()) {
+        return true;
+    }
+    QString path = m_upcoming.first();
+    m_control.write("RETR " + path.toUtf8() + "\r\n");
+    m_control.flush();
+    m_requested.append(path);
+    return true;
+}
+
+/**
+ * @brief 读取一个预先请求但不再下载的文件，丢弃其内容
+ * @return 控制连接仍然可用时返回true
+ */
+bool BlockModeSession::skipRequested()
+{
+    QString path = m_requested.takeFirst();
+    m_upcoming.removeOne(path);
+
+    int code = 0;
+    QString text;
+    if (!readReply(&code, &text)) {
+        close();
+        return false;
+    }
+    if (code == 425 || code == 426) {
+        m_data.reset();
+        m_dataReuse = 0;
+        return true;
+    }
+    if (code != 125 && code != 150) {
+        return true;
+    }
+    bool writeFailed = false;
+    if (!m_data || (m_data->state() != QAbstractSocket::ConnectedState && !m_data->waitForConnected(m_timeoutMs))
+        || !receiveBlocks(nullptr, nullptr, &writeFailed, nullptr)) {
+        m_data.reset();
+        close();
+        return false;
+    }
+    if (!readCompletion(&code, &text)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 发送QUIT并关闭连接
+ */
+void BlockModeSession::close()
+{
+    // 预先发出的命令的应答随连接一起丢弃
+    m_requested.clear();
+    m_data.reset();
+    if (m_control.state() == QAbstractSocket::ConnectedState) {
+        m_control.write("QUIT\r\n");
+        m_control.waitForBytesWritten(1000);
+    }
+    m_control.abort();
+}
+
+/**
+ * @brief 发送命令并读取最终应答
+ * @param command 命令
+ * @param code 输出应答码
+ * @param text 输出应答文本
+ * @return 收到应答时返回true
+ */
+bool BlockModeSession::sendCommand(const QString &command, int *code, QString *text)
+{
+    m_control.write(command.toUtf8() + "\r\n");
+    if (!m_control.waitForBytesWritten(m_timeoutMs)) {
+        m_lastError = QString("发送FTP命令失败: %1").arg(m_control.errorString());
+        return false;
+    }
+    return readReply(code, text);
+}
+
+/**
+ * @brief 读取一个（可能为多行的）应答
+ * @param code 输出应答码
+ * @param text 输出应答文本
+ * @return 收到应答时返回true
+ */
+bool BlockModeSession::readReply(int *code, QString *text)
+{
+    // 多行应答以"NNN-"开始，以"NNN "结束
+    QString prefix;
+    QString reply;
+    for (;;) {
+        while (!m_control.canReadLine()) {
+            if (!m_control.waitForReadyRead(m_timeoutMs)) {
+                m_lastError = QString("等待FTP应答超时: %1").arg(m_control.errorString());
+                return false;
+            }
+        }
+        QString line = QString::fromUtf8(m_control.readLine()).trimmed();
+        reply += line + "\n";
+        if (prefix.isEmpty() && line.size() >= 4 && line.at(3) == '-') {
+            prefix = line.left(3) + " ";
+            continue;
+        }
+        if (prefix.isEmpty() || line.startsWith(prefix)) {
+            *code = line.left(3).toInt();
+            break;
+        }
+    }
+    if (text) {
+        *text = reply;
+    }
+    return true;
+}
+
+/**
+ * @brief 发送PASV并建立数据连接
+ * @return 操作是否成功
+ */
+bool BlockModeSession::openDataConnection()
+{
+    m_data.reset();
+
+    // 优先使用EPSV；PASV返回的地址可能是服务器的内网地址，与libcurl默认行为一致只取端口
+    int code = 0;
+    QString text;
+    int port = 0;
+    if (!m_epsvRejected) {
+        // 命令没有收到应答时迟到的应答会错位到之后的命令上，只能关闭会话
+        if (!sendCommand("EPSV", &code, &text)) {
+            close();
+            return false;
+        }
+        port = passivePort(code, text);
+        if (port == 0 && code >= 500) {
+            m_epsvRejected = true;
+        }
+    }
+    if (port == 0) {
+        if (!sendCommand("PASV", &code, &text)) {
+            close();
+            return false;
+        }
+        if (code != 227) {
+            m_lastError = QString("进入被动模式失败: %1").arg(text.trimmed());
+            return false;
+        }
+        port = passivePort(code, text);
+        if (port == 0) {
+            m_lastError = QString("无法解析被动模式应答: %1").arg(text.trimmed());
+            return false;
+        }
+    }
+    return connectData(port, true);
+}
+
+/**
+ * @brief 解析EPSV/PASV应答中的端口
+ * @param code 应答码
+ * @param text 应答文本
+ * @return 端口，无法解析时返回0
+ */
+int BlockModeSession::passivePort(int code, const QString &text)
+{
+    if (code == 229) {
+        QRegularExpressionMatch match = QRegularExpression("\\(\\|\\|\\|(\\d+)\\|\\)").match(text);
+        return match.hasMatch() ? match.captured(1).toInt() : 0;
+    }
+    if (code == 227) {
+        QRegularExpressionMatch match =
+            QRegularExpression("(\\d+),(\\d+),(\\d+),(\\d+),(\\d+),(\\d+)").match(text);
+        return match.hasMatch() ? match.captured(5).toInt() * 256 + match.captured(6).toInt() : 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief 开始建立数据连接
+ * @param port 服务器的被动模式端口
+ * @param wait 是否等待连接完成
+ * @return 操作是否成功
+ */
+bool BlockModeSession::connectData(int port, bool wait)
+{
+    // 直接连接控制连接的对端地址：无需再次解析主机名，不等待时握手也已在后台开始
+    m_data.reset(new QTcpSocket);
+    if (!m_localAddress.isNull()) {
+        m_data->bind(m_localAddress);
+    }
+    m_data->connectToHost(m_control.peerAddress(), static_cast<quint16>(port));
+    ++m_dataConnections;
+    if (wait && !m_data->waitForConnected(m_timeoutMs)) {
+        m_lastError = QString("建立数据连接失败: %1").arg(m_data->errorString());
+        m_data.reset();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 数据连接是否可用（已连接或正在连接）
+ */
+bool BlockModeSession::hasDataConnection() const
+{
+    return m_data && (m_data->state() == QAbstractSocket::ConnectedState
+                      || m_data->state() == QAbstractSocket::ConnectingState);
+}
+
+/**
+ * @brief 从数据连接读取指定长度的数据
+ * @param buffer 输出缓冲区
+ * @param length 长度
+ * @return 读满时返回true
+ */
+bool BlockModeSession::readData(char *buffer, qint64 length)
+{
+    qint64 done = 0;
+    while (done < length) {
+        if (m_data->bytesAvailable() == 0 && !m_data->waitForReadyRead(m_timeoutMs)) {
+            m_lastError = QString("块模式数据连接中断: %1").arg(m_data->errorString());
+            return false;
+        }
+        qint64 n = m_data->read(buffer + done, length - done);
+        if (n < 0) {
+            m_lastError = QString("块模式数据连接中断: %1").arg(m_data->errorString());
+            return false;
+        }
+        done += n;
+    }
+    return true;
+}
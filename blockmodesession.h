@@ -0,0 +1,244 @@
+/**
+ * @file blockmodesession.h
+ * @brief FTP块模式（MODE B）会话
+ * @details 流模式下每个文件的结束靠关闭数据连接来表示，每传一个文件都要重新PASV并建立数据连接；
+ *          高时延链路上小文件的传输时间几乎全部花在这些往返上。
+ *
+ * 块模式（RFC 959 3.4.2）把数据分成带描述符的块，文件结束由EOF标志表示，
+ * 数据连接可以在连续的多次RETR之间保持打开：
+ *   块头 = 描述符(1字节) + 数据长度(2字节，大端)，描述符64表示文件结束，16表示重启标记
+ * libcurl不支持块模式，这里直接在TCP连接上实现所需的最小FTP命令集（USER/PASS/TYPE/MODE/PASV/RETR）。
+ * 不支持TLS；服务器拒绝MODE B时由调用方退回流模式
+ *
+ * 数据连接预热：调用方用setUpcoming()告知接下来要下载的文件，当前文件的最后一块到达、
+ * 服务器即将发送完成应答时，就在控制连接上发出后续文件所需的命令，连续文件之间不再等待往返：
+ * - 服务器保持数据连接（完成应答250）时，预先发出后续最多depth个文件的RETR
+ * - 服务器每个文件后关闭数据连接（完成应答226）时，预先发出EPSV/PASV，收到端口后立即
+ *   开始连接新的数据连接（不等待连接完成）并发出下一个文件的RETR；每个文件需要自己的
+ *   数据连接，这种情况下只能预备一个文件
+ */
+
+#ifndef BLOCKMODESESSION_H
+#define BLOCKMODESESSION_H
+
+#include <QString>
+#include <QIODevice>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QStringList>
+#include <functional>
+#include <memory>
+
+class QElapsedTimer;
+
+/**
+ * @class BlockModeSession
+ * @brief 保持数据连接的FTP块模式下载会话
+ */
+class BlockModeSession
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    BlockModeSession();
+
+    /**
+     * @brief 析构函数，发送QUIT并关闭连接
+     */
+    ~BlockModeSession();
+
+    /**
+     * @brief 设置网络操作超时
+     * @param ms 单次等待的超时（毫秒）
+     */
+    void setTimeout(int ms) { m_timeoutMs = ms; }
+
+    /**
+     * @brief 设置数据连接预热深度
+     * @param depth 预先发出命令的后续文件数，0表示不预热（默认1）
+     */
+    void setPrewarmDepth(int depth) { m_prewarmDepth = qMax(0, depth); }
+
+    /**
+     * @brief 设置本地绑定地址
+     * @param address 控制连接和数据连接使用的源地址，为空地址时使用系统默认路由
+     *
+     * 应在open()之前调用；只绑定地址，本地端口由系统分配
+     */
+    void setLocalAddress(const QHostAddress &address) { m_localAddress = address; }
+
+    /**
+     * @brief 告知接下来将按顺序下载的文件，用于预热
+     * @param remotePaths 远程文件路径，顺序与之后调用retrieve()的顺序一致
+     *
+     * 调用方可以跳过其中的文件，预先请求但未下载的文件内容会被读取并丢弃
+     */
+    void setUpcoming(const QStringList &remotePaths);
+
+    /**
+     * @brief 连接服务器、登录并切换到块模式
+     * @param host 主机名
+     * @param port 控制连接端口
+     * @param username 用户名，为空时匿名登录
+     * @param password 密码
+     * @return 操作是否成功；服务器以5xx拒绝MODE B时isUnsupported()返回true
+     */
+    bool open(const QString &host, int port, const QString &username, const QString &password);
+
+    /**
+     * @brief 会话是否可用
+     */
+    bool isOpen() const { return m_control.state() == QAbstractSocket::ConnectedState; }
+
+    /**
+     * @brief 服务器是否明确拒绝了块模式（MODE B的应答为5xx）
+     *
+     * 连接、登录失败或4xx等临时错误不算拒绝
+     */
+    bool isUnsupported() const { return m_unsupported; }
+
+    /**
+     * @brief 通过块模式下载一个文件
+     * @param remotePath 远程文件路径
+     * @param output 已打开的输出设备
+     * @param progress 进度回调，参数为本文件已接收的字节数（可选）
+     * @return 操作是否成功；失败后会话可能已关闭，需检查isOpen()
+     *
+     * 数据连接仍然打开时直接复用，否则重新PASV建立；RETR已预先发出时直接读取应答
+     */
+    bool retrieve(const QString &remotePath, QIODevice *output, std::function<void(qint64)> progress = nullptr);
+
+    /**
+     * @brief 发送QUIT并关闭连接
+     */
+    void close();
+
+    /**
+     * @brief 本会话建立过的数据连接数
+     */
+    int dataConnections() const { return m_dataConnections; }
+
+    /**
+     * @brief 预先发出的RETR被使用的次数
+     */
+    int prewarmedFiles() const { return m_prewarmedFiles; }
+
+    /**
+     * @brief 各文件从调用retrieve()到收到第一个数据块的累计等待（纳秒）
+     */
+    qint64 startWaitNs() const { return m_startWaitNs; }
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    /**
+     * @brief 发送命令并读取最终应答
+     * @param command 命令（不含CRLF）
+     * @param code 输出应答码
+     * @return 收到应答时返回true
+     */
+    bool sendCommand(const QString &command, int *code, QString *text = nullptr);
+
+    /**
+     * @brief 读取一个（可能为多行的）应答
+     * @param code 输出应答码
+     * @param text 输出应答文本
+     * @return 收到应答时返回true
+     */
+    bool readReply(int *code, QString *text);
+
+    /**
+     * @brief 发送PASV并建立数据连接
+     * @return 操作是否成功
+     */
+    bool openDataConnection();
+
+    /**
+     * @brief 解析EPSV/PASV应答中的端口
+     * @param code 应答码
+     * @param text 应答文本
+     * @return 端口，无法解析时返回0
+     */
+    static int passivePort(int code, const QString &text);
+
+    /**
+     * @brief 开始建立数据连接
+     * @param port 服务器的被动模式端口
+     * @param wait 是否等待连接完成；不等待时由下一次retrieve()等待
+     * @return 操作是否成功
+     */
+    bool connectData(int port, bool wait);
+
+    /**
+     * @brief 数据连接是否可用（已连接或正在连接）
+     */
+    bool hasDataConnection() const;
+
+    /**
+     * @brief 读取一个文件的所有数据块，直到EOF描述符
+     * @param output 输出设备，为nullptr时丢弃数据
+     * @param progress 进度回调（可选）
+     * @param writeFailed 输出写入失败时置为true，数据仍读完
+     * @param waitTimer 从调用retrieve()开始的计时，收到第一个数据块时计入等待时间（可选）
+     * @return 读到EOF时返回true；否则数据连接已不可用
+     */
+    bool receiveBlocks(QIODevice *output, const std::function<void(qint64)> &progress, bool *writeFailed,
+                       QElapsedTimer *waitTimer);
+
+    /**
+     * @brief 读取文件的完成应答，并记录服务器是否保持数据连接
+     * @param code 输出应答码
+     * @param text 输出应答文本
+     * @return 收到应答时返回true
+     */
+    bool readCompletion(int *code, QString *text);
+
+    /**
+     * @brief 在当前文件的完成应答之前发出后续文件的命令
+     * @return 是否发出了EPSV/PASV，需要在完成应答之后读取其应答
+     */
+    bool sendPrewarm();
+
+    /**
+     * @brief 读取预先发出的EPSV/PASV的应答，开始建立数据连接并发出下一个文件的RETR
+     * @return 控制连接仍然可用时返回true
+     */
+    bool finishPrewarm();
+
+    /**
+     * @brief 读取一个预先请求但不再下载的文件，丢弃其内容
+     * @return 控制连接仍然可用时返回true
+     */
+    bool skipRequested();
+
+    /**
+     * @brief 从数据连接读取指定长度的数据
+     * @param buffer 输出缓冲区
+     * @param length 长度
+     * @return 读满时返回true
+     */
+    bool readData(char *buffer, qint64 length);
+
+private:
+    QTcpSocket m_control;                 ///< 控制连接
+    std::unique_ptr<QTcpSocket> m_data;   ///< 数据连接，在多次RETR之间保持
+    QString m_host;                       ///< 主机名，用于PASV返回内网地址时替换
+    QHostAddress m_localAddress;          ///< 本地绑定地址，为空时使用系统默认路由
+    int m_timeoutMs;                      ///< 网络操作超时
+    bool m_unsupported;                   ///< 服务器以5xx拒绝了MODE B
+    bool m_epsvRejected;                  ///< 服务器拒绝了EPSV，之后直接使用PASV
+    int m_dataReuse;                      ///< 服务器是否保持数据连接：-1未知，0每个文件后关闭，1保持
+    int m_prewarmDepth;                   ///< 预先发出命令的后续文件数
+    QStringList m_upcoming;               ///< 接下来将下载的文件
+    QStringList m_requested;              ///< 已发出RETR但尚未读取应答的文件，是m_upcoming的前缀
+    int m_dataConnections;                ///< 建立过的数据连接数
+    int m_prewarmedFiles;                 ///< 预先发出的RETR被使用的次数
+    qint64 m_startWaitNs;                 ///< 各文件等待第一个数据块的累计时间（纳秒）
+    QString m_lastError;                  ///< 最后一个错误信息
+};
+
+#endif // BLOCKMODESESSION_H
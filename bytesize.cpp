@@ -0,0 +1,32 @@
+/**
+ * @file bytesize.cpp
+ * @brief 带单位的字节数解析实现文件
+ */
+
+#include "bytesize.h"
+#include <QRegularExpression>
+
+/**
+ * @brief 解析带单位的字节数
+ * @param text 字节数文本
+ * @return 字节数，格式错误时返回-1
+ */
+qint64 ByteSize::parse(const QString &text)
+{
+    static const QRegularExpression pattern("^\\s*(\\d+)\\s*(?:([KMG])i?)?B?\\s*$",
+                                            QRegularExpression::CaseInsensitiveOption);
+    QRegularExpressionMatch match = pattern.match(text);
+    if (!match.hasMatch()) {
+        return -1;
+    }
+    qint64 value = match.captured(1).toLongLong();
+    QString unit = match.captured(2).toUpper();
+    if (unit == "K") {
+        value *= 1024;
+    } else if (unit == "M") {
+        value *= 1024 * 1024;
+    } else if (unit == "G") {
+        value *= 1024LL * 1024 * 1024;
+    }
+    return value;
+}
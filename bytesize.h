@@ -0,0 +1,29 @@
+/**
+ * @file bytesize.h
+ * @brief 带单位的字节数解析
+ * @details 环境变量（如FTPCLIENT_MEMORY_BUDGET）和基准测试、模拟器的命令行参数
+ *          使用同一种写法："65536"、"64K"、"512M"、"2G"，也接受"64KB"、"64KiB"，单位按1024进制
+ */
+
+#ifndef BYTESIZE_H
+#define BYTESIZE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @class ByteSize
+ * @brief 字节数文本的解析
+ */
+class ByteSize
+{
+public:
+    /**
+     * @brief 解析带单位的字节数
+     * @param text 如"512M"、"2G"、"65536"，单位K/M/G不区分大小写
+     * @return 字节数，格式错误时返回-1
+     */
+    static qint64 parse(const QString &text);
+};
+
+#endif // BYTESIZE_H
@@ -0,0 +1,158 @@
+/**
+ * @file connectionpool.cpp
+ * @brief 已登录连接池实现文件
+ */
+
+#include "connectionpool.h"
+
+/**
+ * @brief 构造函数
+ * @param maxConnections 最大连接数
+ */
+ConnectionPool::ConnectionPool(int maxConnections)
+    : m_port(21)
+    , m_maxConnections(qMax(1, maxConnections))
+    , m_total(0)
+    , m_generation(0)
+{
+}
+
+/**
+ * @brief 析构函数，关闭所有空闲连接
+ */
+ConnectionPool::~ConnectionPool()
+{
+    qDeleteAll(m_idle);
+    m_idle.clear();
+}
+
+/**
+ * @brief 设置服务器和登录信息
+ * @param server 服务器地址
+ * @param port 端口号
+ * @param username 用户名
+ * @param password 密码
+ */
+void ConnectionPool::setServer(const QString &server, int port, const QString &username, const QString &password)
+{
+    QMutexLocker locker(&m_mutex);
+    m_server = server;
+    m_port = port;
+    m_username = username;
+    m_password = password;
+}
+
+/**
+ * @brief 取出一个已连接的客户端
+ * @return 客户端，无法建立连接时返回nullptr
+ */
+FtpClient *ConnectionPool::acquire()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_idle.isEmpty() && m_total >= m_maxConnections) {
+        m_available.wait(&m_mutex);
+    }
+    if (!m_idle.isEmpty()) {
+        FtpClient *client = m_idle.takeLast();
+        m_inUse.insert(client);
+        return client;
+    }
+
+    // 在锁外建立新连接，不阻塞其他线程取用空闲连接
+    ++m_total;
+    QString server = m_server;
+    int port = m_port;
+    QString username = m_username;
+    QString password = m_password;
+    int generation = m_generation;
+    locker.unlock();
+
+    FtpClient *client = new FtpClient();
+    if (m_configure) {
+        m_configure(client);
+    }
+    if (client->connect(server, port, username, password)) {
+        locker.relock();
+        m_inUse.insert(client);
+        if (generation != m_generation) {
+            m_stale.insert(client);
+        }
+        return client;
+    }
+
+    locker.relock();
+    m_lastError = client->lastError();
+    --m_total;
+    m_available.wakeOne();
+    locker.unlock();
+    delete client;
+    return nullptr;
+}
+
+/**
+ * @brief 取出一个空闲的客户端，不等待也不建立新连接
+ * @return 客户端，没有空闲连接时返回nullptr
+ */
+FtpClient *ConnectionPool::tryAcquire()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_idle.isEmpty()) {
+        return nullptr;
+    }
+    FtpClient *client = m_idle.takeLast();
+    m_inUse.insert(client);
+    return client;
+}
+
+/**
+ * @brief 归还客户端
+ * @param client 由acquire()取得的客户端
+ * @param reusable 是否放回池中复用
+ */
+void ConnectionPool::release(FtpClient *client, bool reusable)
+{
+    if (!client) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_inUse.remove(client);
+    if (m_stale.remove(client) || !reusable || !client->isConnected()) {
+        locker.unlock();
+        delete client;
+        client = nullptr;
+        locker.relock();
+    }
+
+    if (client) {
+        m_idle.append(client);
+    } else {
+        --m_total;
+    }
+    m_available.wakeOne();
+}
+
+/**
+ * @brief 关闭所有连接
+ */
+void ConnectionPool::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    QList<FtpClient *> idle = m_idle;
+    m_idle.clear();
+    m_total -= idle.size();
+    m_stale.unite(m_inUse);
+    ++m_generation;
+    m_available.wakeAll();
+    locker.unlock();
+    qDeleteAll(idle);
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString ConnectionPool::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
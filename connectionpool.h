@@ -0,0 +1,112 @@
+/**
+ * @file connectionpool.h
+ * @brief 已登录连接池
+ * @details 为需要多线程并发访问同一服务器的场景（如文件系统挂载的并行读取和预读）
+ *          维护一组已连接的FtpClient，避免每次请求都重新建立连接和登录
+ */
+
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QString>
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+#include <functional>
+#include "ftpclient.h"
+
+/**
+ * @class ConnectionPool
+ * @brief FtpClient连接池
+ *
+ * 连接在首次需要时建立，用完后归还以供复用；连接数达到上限时acquire()阻塞等待。
+ * 每个FtpClient同一时刻只由取得它的线程使用，池本身是线程安全的
+ */
+class ConnectionPool
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param maxConnections 最大连接数
+     */
+    explicit ConnectionPool(int maxConnections = 4);
+
+    /**
+     * @brief 析构函数，关闭所有空闲连接
+     *
+     * 调用前所有取出的连接都必须已归还
+     */
+    ~ConnectionPool();
+
+    /**
+     * @brief 设置服务器和登录信息
+     * @param server 服务器地址
+     * @param port 端口号
+     * @param username 用户名
+     * @param password 密码
+     */
+    void setServer(const QString &server, int port, const QString &username, const QString &password);
+
+    /**
+     * @brief 设置新连接的初始化函数
+     * @param configure 在连接之前对新建的FtpClient调用（如启用TLS、设置模拟链路）
+     */
+    void setConfigurator(std::function<void(FtpClient *)> configure) { m_configure = configure; }
+
+    /**
+     * @brief 最大连接数
+     */
+    int maxConnections() const { return m_maxConnections; }
+
+    /**
+     * @brief 取出一个已连接的客户端
+     * @return 客户端；无法建立连接时返回nullptr，原因见lastError()
+     */
+    FtpClient *acquire();
+
+    /**
+     * @brief 取出一个空闲的客户端，不等待也不建立新连接
+     * @return 客户端；没有空闲连接时返回nullptr
+     *
+     * 供预取等可有可无的后台读取借用其他用途留下的空闲连接
+     */
+    FtpClient *tryAcquire();
+
+    /**
+     * @brief 归还客户端
+     * @param client 由acquire()取得的客户端
+     * @param reusable 为false时（如传输出错、连接状态未知）关闭该连接而不放回池中
+     */
+    void release(FtpClient *client, bool reusable = true);
+
+    /**
+     * @brief 关闭所有连接（如更换服务器或断开时）
+     *
+     * 空闲连接立即关闭，使用中的连接在归还时关闭
+     */
+    void clear();
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+private:
+    QString m_server;                            ///< 服务器地址
+    int m_port;                                  ///< 端口号
+    QString m_username;                          ///< 用户名
+    QString m_password;                          ///< 密码
+    std::function<void(FtpClient *)> m_configure; ///< 新连接的初始化函数
+    int m_maxConnections;                        ///< 最大连接数
+    mutable QMutex m_mutex;                      ///< 保护以下成员
+    QWaitCondition m_available;                  ///< 有连接归还时唤醒等待者
+    QList<FtpClient *> m_idle;                   ///< 空闲连接
+    QSet<FtpClient *> m_inUse;                   ///< 已取出的连接
+    QSet<FtpClient *> m_stale;                   ///< clear()时正在使用、归还时需要关闭的连接
+    int m_total;                                 ///< 已建立（含使用中）的连接数
+    int m_generation;                            ///< 每次clear()加一，识别clear()期间建立的连接
+    QString m_lastError;                         ///< 最后一个错误信息
+};
+
+#endif // CONNECTIONPOOL_H
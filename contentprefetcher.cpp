@@ -0,0 +1,288 @@
+/**
+ * @file contentprefetcher.cpp
+ * @brief 小文件内容预取实现文件
+ */
+
+#include "contentprefetcher.h"
+#include "connectionpool.h"
+#include "memorybudget.h"
+#include <QThread>
+
+/**
+ * @brief 构造函数
+ * @param pool 借用空闲连接的连接池
+ * @param capacity 缓存容量（字节）
+ */
+ContentPrefetcher::ContentPrefetcher(ConnectionPool *pool, qint64 capacity)
+    : m_pool(pool)
+    , m_capacity(qMax<qint64>(0, capacity))
+    , m_sizeLimit(256 * 1024)
+    , m_generation(0)
+    , m_hits(0)
+    , m_fetched(0)
+    , m_bytes(0)
+    , m_budget(nullptr)
+{
+    // 每个连接一个工作线程，借用连接时不会互相等待
+    m_threads.setMaxThreadCount(m_pool->maxConnections());
+}
+
+/**
+ * @brief 析构函数，取消预取并等待进行中的读取结束
+ */
+ContentPrefetcher::~ContentPrefetcher()
+{
+    cancel();
+    m_threads.waitForDone();
+    setMemoryBudget(nullptr);
+}
+
+/**
+ * @brief 设置内存预算
+ * @param budget 内存预算
+ */
+void ContentPrefetcher::setMemoryBudget(MemoryBudget *budget)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_budget) {
+        m_budget->removeReclaimer(MemoryBudget::PrefetchCache);
+        m_budget->release(MemoryBudget::PrefetchCache, m_bytes);
+    }
+    m_budget = budget;
+    if (m_budget) {
+        m_budget->charge(MemoryBudget::PrefetchCache, m_bytes);
+        m_budget->setReclaimer(MemoryBudget::PrefetchCache, [this](qint64 bytes) {
+            return evict(bytes);
+        });
+    }
+}
+
+/**
+ * @brief 在后台预取一个目录中的小文件
+ * @param directory 远程目录路径
+ * @param entries 目录项
+ */
+void ContentPrefetcher::prefetch(const QString &directory, const QList<RemoteEntry> &entries)
+{
+    cancel();
+    int generation = m_generation;
+    QString prefix = directory.endsWith('/') ? directory : directory + "/";
+
+    qint64 queuedBytes = 0;
+    for (const RemoteEntry &entry : entries) {
+        if (entry.isDirectory || entry.size <= 0 || entry.size >= m_sizeLimit) {
+            continue;
+        }
+        if (queuedBytes + entry.size > m_capacity) {
+            break;
+        }
+        QString remotePath = prefix + entry.name;
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_entries.constFind(remotePath);
+            if (it != m_entries.constEnd() && it->size == entry.size && it->modified == entry.modified) {
+                continue;
+            }
+        }
+        queuedBytes += entry.size;
+        qint64 size = entry.size;
+        QDateTime modified = entry.modified;
+        m_threads.start([this, remotePath, size, modified, generation]() {
+            fetch(remotePath, size, modified, generation);
+        });
+    }
+}
+
+/**
+ * @brief 取消尚未开始的预取
+ */
+void ContentPrefetcher::cancel()
+{
+    ++m_generation;
+    m_threads.clear();
+}
+
+/**
+ * @brief 查找已预取的文件内容
+ * @param remotePath 远程文件路径
+ * @param size 当前列表中的文件大小
+ * @param modified 当前列表中的修改时间
+ * @param data 输出文件内容
+ * @return 命中时返回true
+ */
+bool ContentPrefetcher::lookup(const QString &remotePath, qint64 size, const QDateTime &modified, QByteArray *data)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.constFind(remotePath);
+    if (it == m_entries.constEnd()) {
+        return false;
+    }
+    // 同样大小的改写只能从修改时间看出来
+    if (it->size != size || it->modified != modified) {
+        removeLocked(remotePath);
+        return false;
+    }
+    *data = it->data;
+    m_order.removeOne(remotePath);
+    m_order.append(remotePath);
+    ++m_hits;
+    return true;
+}
+
+/**
+ * @brief 使一个目录下的所有缓存内容失效
+ * @param directory 远程目录路径
+ */
+void ContentPrefetcher::invalidate(const QString &directory)
+{
+    QString prefix = directory.endsWith('/') ? directory : directory + "/";
+    QMutexLocker locker(&m_mutex);
+    const QList<QString> keys = m_order;
+    for (const QString &key : keys) {
+        // 只移除该目录的直接子文件
+        if (key.startsWith(prefix) && !key.mid(prefix.size()).contains('/')) {
+            removeLocked(key);
+        }
+    }
+}
+
+/**
+ * @brief 清空缓存
+ */
+void ContentPrefetcher::clear()
+{
+    cancel();
+    QMutexLocker locker(&m_mutex);
+    if (m_budget) {
+        m_budget->release(MemoryBudget::PrefetchCache, m_bytes);
+    }
+    m_entries.clear();
+    m_order.clear();
+    m_bytes = 0;
+}
+
+/**
+ * @brief 丢弃最久未用的条目
+ * @param bytes 希望释放的字节数
+ * @return 实际释放的字节数
+ */
+qint64 ContentPrefetcher::evict(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 freed = 0;
+    while (freed < bytes && !m_order.isEmpty()) {
+        QString key = m_order.first();
+        freed += removeLocked(key);
+    }
+    return freed;
+}
+
+/**
+ * @brief 当前占用的字节数
+ */
+qint64 ContentPrefetcher::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+/**
+ * @brief 读取一个文件并放入缓存
+ * @param remotePath 远程文件路径
+ * @param size 文件大小
+ * @param modified 列表中的修改时间
+ * @param generation 排队时的预取代数
+ */
+void ContentPrefetcher::fetch(const QString &remotePath, qint64 size, const QDateTime &modified, int generation)
+{
+    if (generation != m_generation) {
+        return;
+    }
+    // 预取只利用空闲的CPU和连接，不与界面和批量下载争抢
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    // 只借用空闲的连接，不为预取建立连接，也不与预览争抢
+    FtpClient *client = m_pool->tryAcquire();
+    if (!client) {
+        return;
+    }
+    if (generation != m_generation) {
+        m_pool->release(client);
+        return;
+    }
+    QByteArray data;
+    bool ok = client->readRange(remotePath, 0, size, &data);
+    m_pool->release(client, ok);
+
+    // 读取期间被取消（如已开始批量下载）时仍然保留结果，内容本身有效
+    if (ok && data.size() == size) {
+        insert(remotePath, data, size, modified);
+        ++m_fetched;
+    }
+}
+
+/**
+ * @brief 放入缓存，必要时淘汰旧条目
+ * @param remotePath 远程文件路径
+ * @param data 文件内容
+ * @param size 文件大小
+ * @param modified 列表中的修改时间
+ */
+void ContentPrefetcher::insert(const QString &remotePath, const QByteArray &data, qint64 size, const QDateTime &modified)
+{
+    qint64 bytes = data.size() + remotePath.size() * 2 + 64;
+    {
+        QMutexLocker locker(&m_mutex);
+        removeLocked(remotePath);
+        while (m_bytes + bytes > m_capacity && !m_order.isEmpty()) {
+            QString oldest = m_order.first();
+            removeLocked(oldest);
+        }
+    }
+
+    // 申请预算时不能持有缓存锁，预算可能回调evict()
+    MemoryBudget *budget;
+    {
+        QMutexLocker locker(&m_mutex);
+        budget = m_budget;
+    }
+    if (budget && !budget->reserve(MemoryBudget::PrefetchCache, bytes)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.contains(remotePath)) {
+        if (budget) {
+            budget->release(MemoryBudget::PrefetchCache, bytes);
+        }
+        return;
+    }
+    Entry entry;
+    entry.data = data;
+    entry.size = size;
+    entry.modified = modified;
+    m_entries.insert(remotePath, entry);
+    m_order.append(remotePath);
+    m_bytes += bytes;
+}
+
+/**
+ * @brief 移除一个条目，调用方需持有m_mutex
+ * @param remotePath 远程文件路径
+ * @return 释放的字节数
+ */
+qint64 ContentPrefetcher::removeLocked(const QString &remotePath)
+{
+    auto it = m_entries.find(remotePath);
+    if (it == m_entries.end()) {
+        return 0;
+    }
+    qint64 bytes = it->data.size() + remotePath.size() * 2 + 64;
+    m_entries.erase(it);
+    m_order.removeOne(remotePath);
+    m_bytes -= bytes;
+    if (m_budget) {
+        m_budget->release(MemoryBudget::PrefetchCache, bytes);
+    }
+    return bytes;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file contentprefetcher.h
+ * @brief 小文件内容预取
+ * @details 浏览配置文件、文本文件等小文件目录时，每次打开都要一次完整的往返。
+ *          目录显示期间在后台把小于阈值的文件内容预先读入有界缓存，之后的预览和打开直接命中。
+ *
+ * 预取只借用连接池中当时空闲的连接（如预览留下的连接），不为预取建立连接，
+ * 没有空闲连接时跳过该文件；工作线程以最低优先级运行。
+ * 显示新目录或开始批量下载时，尚未开始的预取立即取消。
+ * 缓存的内容以列表中的大小和修改时间校验，按最近使用顺序淘汰，占用记入MemoryBudget
+ */
+
+#ifndef CONTENTPREFETCHER_H
+#define CONTENTPREFETCHER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+#include "ftpclient.h"
+
+class ConnectionPool;
+class MemoryBudget;
+
+/**
+ * @class ContentPrefetcher
+ * @brief 小文件内容预取器，所有方法都是线程安全的
+ */
+class ContentPrefetcher
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param pool 借用空闲连接的连接池（不归本对象所有）
+     * @param capacity 缓存容量（字节）
+     */
+    explicit ContentPrefetcher(ConnectionPool *pool, qint64 capacity = 16 * 1024 * 1024);
+
+    /**
+     * @brief 析构函数，取消预取并等待进行中的读取结束
+     */
+    ~ContentPrefetcher();
+
+    /**
+     * @brief 设置内存预算
+     * @param budget 内存预算，为nullptr时不记账
+     */
+    void setMemoryBudget(MemoryBudget *budget);
+
+    /**
+     * @brief 设置预取的文件大小上限
+     * @param bytes 小于该大小的非空文件才会预取
+     */
+    void setSizeLimit(qint64 bytes) { m_sizeLimit = bytes; }
+
+    /**
+     * @brief 预取文件大小上限
+     */
+    qint64 sizeLimit() const { return m_sizeLimit; }
+
+    /**
+     * @brief 在后台预取一个目录中的小文件
+     * @param directory 远程目录路径
+     * @param entries 目录项，按显示顺序
+     *
+     * 取消之前尚未开始的预取；已缓存的文件和目录项跳过，累计大小超过缓存容量的部分不再排队
+     */
+    void prefetch(const QString &directory, const QList<RemoteEntry> &entries);
+
+    /**
+     * @brief 取消尚未开始的预取
+     */
+    void cancel();
+
+    /**
+     * @brief 查找已预取的文件内容
+     * @param remotePath 远程文件路径
+     * @param size 当前列表中的文件大小
+     * @param modified 当前列表中的修改时间
+     * @param data 输出文件内容
+     * @return 命中时返回true；大小或修改时间与预取时不同视为已变化
+     */
+    bool lookup(const QString &remotePath, qint64 size, const QDateTime &modified, QByteArray *data);
+
+    /**
+     * @brief 使一个目录下的所有缓存内容失效
+     * @param directory 远程目录路径
+     */
+    void invalidate(const QString &directory);
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+    /**
+     * @brief 丢弃最久未用的条目
+     * @param bytes 希望释放的字节数
+     * @return 实际释放的字节数
+     */
+    qint64 evict(qint64 bytes);
+
+    /**
+     * @brief 当前占用的字节数
+     */
+    qint64 memoryUsage() const;
+
+    /**
+     * @brief 命中次数
+     */
+    qint64 hits() const { return m_hits; }
+
+    /**
+     * @brief 已预取的文件数
+     */
+    qint64 fetched() const { return m_fetched; }
+
+private:
+    struct Entry {
+        QByteArray data;        ///< 文件内容
+        qint64 size;            ///< 预取时列表中的文件大小
+        QDateTime modified;     ///< 预取时列表中的修改时间
+    };
+
+    /**
+     * @brief 读取一个文件并放入缓存（在工作线程中执行）
+     * @param remotePath 远程文件路径
+     * @param size 文件大小
+     * @param modified 列表中的修改时间
+     * @param generation 排队时的预取代数，已取消时直接返回
+     */
+    void fetch(const QString &remotePath, qint64 size, const QDateTime &modified, int generation);
+
+    /**
+     * @brief 放入缓存，必要时淘汰旧条目
+     */
+    void insert(const QString &remotePath, const QByteArray &data, qint64 size, const QDateTime &modified);
+
+    /**
+     * @brief 移除一个条目，调用方需持有m_mutex
+     * @return 释放的字节数
+     */
+    qint64 removeLocked(const QString &remotePath);
+
+private:
+    ConnectionPool *m_pool;             ///< 借用空闲连接的连接池（不拥有）
+    qint64 m_capacity;                  ///< 缓存容量
+    qint64 m_sizeLimit;                 ///< 预取的文件大小上限
+    std::atomic<int> m_generation;      ///< 预取代数，取消时加一
+    std::atomic<qint64> m_hits;         ///< 命中次数
+    std::atomic<qint64> m_fetched;      ///< 已预取的文件数
+    mutable QMutex m_mutex;             ///< 保护以下成员
+    QHash<QString, Entry> m_entries;    ///< 远程路径到内容
+    QList<QString> m_order;             ///< 使用顺序，末尾为最近使用
+    qint64 m_bytes;                     ///< 总占用
+    MemoryBudget *m_budget;             ///< 内存预算（不拥有）
+    QThreadPool m_threads;              ///< 预取工作线程
+};
+
+#endif // CONTENTPREFETCHER_H
@@ -0,0 +1,301 @@
+/**
+ * @file directoryindex.cpp
+ * @brief 已知远程目录的持久化索引实现文件
+ */
+
+#include "directoryindex.h"
+#include "remoteindex.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 构造函数
+ * @param path 索引文件路径
+ * @param maxEntries 最多保存的目录数
+ */
+DirectoryIndex::DirectoryIndex(const QString &path, int maxEntries)
+    : m_path(path)
+    , m_maxEntries(qMax(1, maxEntries))
+    , m_dirty(false)
+{
+}
+
+/**
+ * @brief 析构函数，保存有变化的索引
+ */
+DirectoryIndex::~DirectoryIndex()
+{
+    save();
+}
+
+/**
+ * @brief 从索引文件加载
+ * @return 操作是否成功
+ */
+bool DirectoryIndex::load()
+{
+    if (m_path.isEmpty()) {
+        return true;
+    }
+    QFile file(m_path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = QString("无法打开目录索引: %1").arg(m_path);
+        return false;
+    }
+
+    QMap<QString, qint64> entries;
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (line.endsWith('\n')) {
+            line.chop(1);
+        }
+        // 目录路径是最后一个字段，本身可以包含制表符
+        int firstTab = line.indexOf('\t');
+        int secondTab = firstTab < 0 ? -1 : line.indexOf('\t', firstTab + 1);
+        if (secondTab < 0) {
+            continue;
+        }
+        bool ok = false;
+        qint64 seen = line.mid(firstTab + 1, secondTab - firstTab - 1).toLongLong(&ok);
+        QString directory = QString::fromUtf8(line.mid(secondTab + 1));
+        if (ok && directory.startsWith('/') && directory.endsWith('/')) {
+            entries.insert(QString::fromUtf8(line.left(firstTab)) + '\t' + directory, seen);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        m_entries.insert(it.key(), qMax(it.value(), m_entries.value(it.key())));
+    }
+    trimLocked();
+    return true;
+}
+
+/**
+ * @brief 保存到索引文件
+ * @return 操作是否成功
+ */
+bool DirectoryIndex::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_path.isEmpty() || !m_dirty) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_lastError = QString("无法写入目录索引: %1").arg(m_path);
+        return false;
+    }
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        // 键为"服务器\t目录"，写出时在中间插入时间
+        const QString &key = it.key();
+        int tab = key.indexOf('\t');
+        file.write(key.left(tab).toUtf8() + '\t' + QByteArray::number(it.value()) + '\t'
+                   + key.mid(tab + 1).toUtf8() + '\n');
+    }
+    if (!file.commit()) {
+        m_lastError = QString("保存目录索引失败: %1").arg(file.errorString());
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 设置当前服务器
+ * @param server 服务器标识
+ */
+void DirectoryIndex::setServer(const QString &server)
+{
+    QMutexLocker locker(&m_mutex);
+    m_server = server;
+}
+
+/**
+ * @brief 记录一个目录的子目录
+ * @param directory 远程目录路径
+ * @param names 子目录名称
+ */
+void DirectoryIndex::addChildren(const QString &directory, const QStringList &names)
+{
+    QString parent = normalize(directory);
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QMutexLocker locker(&m_mutex);
+    addLocked(parent, now);
+    for (const QString &name : names) {
+        if (name.isEmpty() || name == "." || name == ".." || name.contains('/') || name.contains('\n')) {
+            continue;
+        }
+        addLocked(parent + name + "/", now);
+    }
+    trimLocked();
+}
+
+/**
+ * @brief 记录索引文件中所有文件的上级目录
+ * @param indexPath 索引文件
+ * @return 操作是否成功
+ */
+bool DirectoryIndex::addIndex(const QString &indexPath)
+{
+    QFile input(indexPath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = QString("无法打开索引文件: %1").arg(indexPath);
+        return false;
+    }
+
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QString previous;
+    QMutexLocker locker(&m_mutex);
+    while (!input.atEnd()) {
+        IndexRecord record;
+        if (!RemoteIndex::parseRecord(input.readLine(), &record)) {
+            continue;
+        }
+        // 扫描按目录逐个写出，同一目录的文件相邻，只需处理目录变化的位置
+        QString directory = record.path.left(record.path.lastIndexOf('/') + 1);
+        if (directory != previous) {
+            addLocked(directory, now);
+            previous = directory;
+        }
+    }
+    trimLocked();
+    return true;
+}
+
+/**
+ * @brief 移除一个目录及其下所有目录
+ * @param directory 远程目录路径
+ */
+void DirectoryIndex::remove(const QString &directory)
+{
+    QString dir = normalize(directory);
+    QMutexLocker locker(&m_mutex);
+    QString prefix = m_server + '\t' + dir;
+    auto it = m_entries.lowerBound(prefix);
+    while (it != m_entries.end() && it.key().startsWith(prefix)) {
+        it = m_entries.erase(it);
+        m_dirty = true;
+    }
+}
+
+/**
+ * @brief 补全路径
+ * @param prefix 已输入的路径
+ * @param limit 最多返回的条数
+ * @return 同层的候选目录
+ */
+QStringList DirectoryIndex::complete(const QString &prefix, int limit) const
+{
+    QString typed = prefix.startsWith('/') ? prefix : "/" + prefix;
+    int parentLength = typed.lastIndexOf('/') + 1;
+
+    QStringList result;
+    QMutexLocker locker(&m_mutex);
+    QString start = m_server + '\t';
+    int pathOffset = start.size();
+    start += typed;
+    for (auto it = m_entries.lowerBound(start); it != m_entries.end() && result.size() < limit; ++it) {
+        if (!it.key().startsWith(start)) {
+            break;
+        }
+        // 只返回与输入的最后一级同层的目录，更深的目录在继续输入后再补全
+        QString path = it.key().mid(pathOffset);
+        if (path.indexOf('/', parentLength) == path.size() - 1) {
+            result.append(path);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 目录数
+ */
+int DirectoryIndex::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString DirectoryIndex::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief 规范化目录路径
+ * @param directory 远程目录路径
+ * @return 以/开头和结尾的路径
+ */
+QString DirectoryIndex::normalize(const QString &directory)
+{
+    QString result = directory.startsWith('/') ? directory : "/" + directory;
+    if (!result.endsWith('/')) {
+        result += '/';
+    }
+    return result;
+}
+
+/**
+ * @brief 记录一个目录及其所有上级目录
+ * @param directory 规范化后的目录路径
+ * @param now 当前时间
+ */
+void DirectoryIndex::addLocked(const QString &directory, qint64 now)
+{
+    QString dir = directory;
+    while (!dir.isEmpty()) {
+        QString key = m_server + '\t' + dir;
+        auto it = m_entries.find(key);
+        if (it != m_entries.end() && it.value() == now) {
+            // 本轮已经记录过，上级目录也一定已经记录
+            return;
+        }
+        m_entries.insert(key, now);
+        m_dirty = true;
+        if (dir == "/") {
+            return;
+        }
+        dir = dir.left(dir.lastIndexOf('/', dir.size() - 2) + 1);
+    }
+}
+
+/**
+ * @brief 条目超出上限时淘汰最久未见的目录
+ */
+void DirectoryIndex::trimLocked()
+{
+    if (m_entries.size() <= m_maxEntries) {
+        return;
+    }
+
+    // 一次淘汰到上限的九成，避免之后每次记录都要重新淘汰
+    std::vector<std::pair<qint64, QString>> ages;
+    ages.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        ages.emplace_back(it.value(), it.key());
+    }
+    size_t removeCount = ages.size() - static_cast<size_t>(m_maxEntries) * 9 / 10;
+    std::nth_element(ages.begin(), ages.begin() + removeCount, ages.end());
+    for (size_t i = 0; i < removeCount; ++i) {
+        m_entries.remove(ages[i].second);
+    }
+    m_dirty = true;
+}
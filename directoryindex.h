@@ -0,0 +1,125 @@
+/**
+ * @file directoryindex.h
+ * @brief 已知远程目录的持久化索引
+ * @details 为路径栏的自动补全记录浏览和扫描中见过的远程目录。
+ *          每次列出目录时记录其子目录，生成RemoteIndex时记录所有文件的上级目录，
+ *          输入深层路径时可以直接补全，无需逐级列出
+ *
+ * 目录按服务器区分，条目数有上限，超出时淘汰最久未见的目录。
+ * 索引文件为文本格式，每行一条：服务器\t最近见到的时间（UTC秒数）\t目录路径
+ */
+
+#ifndef DIRECTORYINDEX_H
+#define DIRECTORYINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QMutex>
+
+/**
+ * @class DirectoryIndex
+ * @brief 按服务器区分的远程目录集合，支持前缀补全，线程安全
+ */
+class DirectoryIndex
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param path 索引文件路径，为空时只在内存中保存
+     * @param maxEntries 最多保存的目录数（所有服务器合计）
+     */
+    explicit DirectoryIndex(const QString &path = QString(), int maxEntries = 200000);
+
+    /**
+     * @brief 析构函数，保存有变化的索引
+     */
+    ~DirectoryIndex();
+
+    /**
+     * @brief 从索引文件加载
+     * @return 操作是否成功；索引文件不存在时视为空索引并返回true
+     */
+    bool load();
+
+    /**
+     * @brief 保存到索引文件（先写临时文件再替换）
+     * @return 操作是否成功；没有变化时直接返回true
+     */
+    bool save();
+
+    /**
+     * @brief 设置当前服务器，之后的记录和补全都针对该服务器
+     * @param server 服务器标识（如"ftp.example.com:21"）
+     */
+    void setServer(const QString &server);
+
+    /**
+     * @brief 记录一个目录的子目录
+     * @param directory 远程目录路径
+     * @param names 子目录名称（不含路径）
+     */
+    void addChildren(const QString &directory, const QStringList &names);
+
+    /**
+     * @brief 记录索引文件中所有文件的上级目录
+     * @param indexPath RemoteIndex生成的索引文件
+     * @return 操作是否成功
+     */
+    bool addIndex(const QString &indexPath);
+
+    /**
+     * @brief 移除一个目录及其下所有目录（如列出时发现已不存在）
+     * @param directory 远程目录路径
+     */
+    void remove(const QString &directory);
+
+    /**
+     * @brief 补全路径
+     * @param prefix 已输入的路径
+     * @param limit 最多返回的条数
+     * @return 以prefix开头、与prefix的最后一级同层的目录，以/结尾，按路径排序
+     */
+    QStringList complete(const QString &prefix, int limit = 50) const;
+
+    /**
+     * @brief 目录数（所有服务器合计）
+     */
+    int size() const;
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+    /**
+     * @brief 规范化目录路径：以/开头和结尾
+     * @param directory 远程目录路径
+     * @return 规范化后的路径
+     */
+    static QString normalize(const QString &directory);
+
+private:
+    /**
+     * @brief 记录一个目录及其所有上级目录，调用方需持有m_mutex
+     * @param directory 规范化后的目录路径
+     * @param now 当前时间（UTC秒数）
+     */
+    void addLocked(const QString &directory, qint64 now);
+
+    /**
+     * @brief 条目超出上限时淘汰最久未见的目录，调用方需持有m_mutex
+     */
+    void trimLocked();
+
+private:
+    QString m_path;                   ///< 索引文件路径
+    int m_maxEntries;                 ///< 最多保存的目录数
+    mutable QMutex m_mutex;           ///< 保护以下成员
+    QString m_server;                 ///< 当前服务器
+    QMap<QString, qint64> m_entries;  ///< "服务器\t目录"到最近见到的时间，按键排序以便前缀查找
+    bool m_dirty;                     ///< 自上次保存以来是否有变化
+    QString m_lastError;              ///< 最后一个错误信息
+};
+
+#endif // DIRECTORYINDEX_H
@@ -0,0 +1,418 @@
+/**
+ * @file downloadqueue.cpp
+ * @brief 去重下载队列实现文件
+ */
+
+#include "downloadqueue.h"
+#include "memorybudget.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+// 每次从溢出文件读回的任务数
+static const int SPILL_REFILL_TASKS = 1024;
+
+/**
+ * @brief 构造函数
+ */
+DownloadQueue::DownloadQueue()
+    : m_nextId(0)
+    , m_bytes(0)
+    , m_budget(nullptr)
+{
+}
+
+/**
+ * @brief 析构函数，释放在内存预算中的记账
+ */
+DownloadQueue::~DownloadQueue()
+{
+    dropSpillFiles();
+    setMemoryBudget(nullptr);
+}
+
+/**
+ * @brief 设置内存预算
+ * @param budget 内存预算
+ */
+void DownloadQueue::setMemoryBudget(MemoryBudget *budget)
+{
+    if (m_budget) {
+        m_budget->release(MemoryBudget::TaskQueue, m_bytes);
+    }
+    m_budget = budget;
+    if (m_budget) {
+        m_budget->charge(MemoryBudget::TaskQueue, m_bytes);
+    }
+}
+
+/**
+ * @brief 估算一个下载任务占用的内存
+ * @param task 下载任务
+ * @return 字节数
+ */
+qint64 DownloadQueue::estimateBytes(const DownloadTask &task)
+{
+    // QString按UTF-16存储，另加每个字符串的分配开销
+    qint64 bytes = sizeof(DownloadTask)
+        + (task.remotePath.size() + task.localPath.size() + task.displayName.size()) * 2 + 3 * 32;
+    for (const QString &target : task.copyTargets) {
+        bytes += target.size() * 2 + 32;
+    }
+    return bytes;
+}
+
+/**
+ * @brief 添加下载任务
+ * @param task 下载任务
+ * @return 新增了一次传输时返回true
+ */
+bool DownloadQueue::enqueue(const DownloadTask &task)
+{
+    QString fileKey = remoteKey(task.remotePath);
+    QString localPath = normalizeLocal(task.localPath);
+    QString fullKey = fileKey + '\n' + localPath;
+
+    // 同一文件到同一位置：已排队、正在传输或已完成，直接丢弃
+    if (m_seen.contains(fullKey)) {
+        return false;
+    }
+    m_seen.insert(fullKey);
+    account(fullKey.size() * 2 + 32);
+
+    // 同一文件已在排队但目标不同：只传输一次，完成后复制到新位置
+    if (!task.isDirectory) {
+        auto it = m_pendingByRemote.constFind(fileKey);
+        if (it != m_pendingByRemote.constEnd()) {
+            m_tasks[it.value()].copyTargets.append(task.localPath);
+            account(task.localPath.size() * 2 + 32);
+            return false;
+        }
+
+        // 已出队（正在传输或已完成）：不再传输，从已下载的本地文件复制
+        auto done = m_dequeuedByRemote.constFind(fileKey);
+        if (done != m_dequeuedByRemote.constEnd()) {
+            m_localCopies.append(LocalCopy{done.value(), task});
+            account(estimateBytes(task) + done.value().size() * 2 + 32);
+            return false;
+        }
+    }
+
+    quint64 id = m_nextId++;
+    m_tasks.insert(id, task);
+    m_order.enqueue(id);
+    account(estimateBytes(task));
+    if (!task.isDirectory) {
+        m_pendingByRemote.insert(fileKey, id);
+    }
+    return true;
+}
+
+/**
+ * @brief 合并一个目录作业扫描出的任务
+ * @param tasks 扫描得到的任务
+ * @return 新增的传输数量
+ */
+int DownloadQueue::merge(const QQueue<DownloadTask> &tasks)
+{
+    int added = 0;
+    for (const DownloadTask &task : tasks) {
+        if (enqueue(task)) {
+            ++added;
+        }
+    }
+    return added;
+}
+
+/**
+ * @brief 接管一个任务溢出文件
+ * @param path 溢出文件
+ */
+void DownloadQueue::addSpillFile(const QString &path)
+{
+    if (path.isEmpty()) {
+        return;
+    }
+    m_spillFiles.append(path);
+    if (m_order.isEmpty()) {
+        refill();
+    }
+}
+
+/**
+ * @brief 把任务写入溢出文件
+ * @param out 溢出文件的数据流
+ * @param task 下载任务
+ */
+void DownloadQueue::writeTask(QDataStream &out, const DownloadTask &task)
+{
+    out << task.remotePath << task.localPath << task.isDirectory << task.fileSize
+        << task.displayName << task.copyTargets;
+}
+
+/**
+ * @brief 队列取空时从溢出文件读回下一批任务
+ */
+void DownloadQueue::refill()
+{
+    while (m_order.isEmpty() && !m_spillFiles.isEmpty()) {
+        if (!m_spillReader) {
+            m_spillReader.reset(new QFile(m_spillFiles.first()));
+            if (!m_spillReader->open(QIODevice::ReadOnly)) {
+                m_spillReader.reset();
+                QFile::remove(m_spillFiles.takeFirst());
+                continue;
+            }
+        }
+
+        QDataStream in(m_spillReader.get());
+        for (int i = 0; i < SPILL_REFILL_TASKS && !in.atEnd(); ++i) {
+            DownloadTask task;
+            in >> task.remotePath >> task.localPath >> task.isDirectory >> task.fileSize
+               >> task.displayName >> task.copyTargets;
+            if (in.status() != QDataStream::Ok) {
+                break;
+            }
+            enqueue(task);
+        }
+
+        // 读完（或文件损坏）时删除，继续下一个溢出文件
+        if (in.atEnd() || in.status() != QDataStream::Ok) {
+            m_spillReader.reset();
+            QFile::remove(m_spillFiles.takeFirst());
+        }
+    }
+}
+
+/**
+ * @brief 关闭并删除所有溢出文件
+ */
+void DownloadQueue::dropSpillFiles()
+{
+    m_spillReader.reset();
+    for (const QString &path : m_spillFiles) {
+        QFile::remove(path);
+    }
+    m_spillFiles.clear();
+}
+
+/**
+ * @brief 记录已扫描的目录作业
+ * @param remoteDir 远程目录
+ * @param localDir 对应的本地目录
+ * @param nameFilters 扫描时使用的文件名过滤条件
+ * @param mode 扫描时使用的扫描方式
+ */
+void DownloadQueue::addCrawlRoot(const QString &remoteDir, const QString &localDir,
+                                 const QStringList &nameFilters, FtpClient::CrawlMode mode)
+{
+    CrawlRoot root;
+    root.remoteKey = remoteKey(normalizeRemoteDir(remoteDir));
+    root.localDir = normalizeLocal(localDir);
+    root.nameFilters = normalizeFilters(nameFilters);
+    root.mode = mode;
+    m_crawlRoots.append(root);
+}
+
+/**
+ * @brief 判断目录是否已被之前的作业完整覆盖
+ * @param remoteDir 远程目录
+ * @param localDir 本地目标目录
+ * @param nameFilters 本次扫描的文件名过滤条件
+ * @param mode 本次扫描的扫描方式
+ * @return 已被覆盖时返回true
+ */
+bool DownloadQueue::coversDirectory(const QString &remoteDir, const QString &localDir,
+                                    const QStringList &nameFilters, FtpClient::CrawlMode mode) const
+{
+    QString key = remoteKey(normalizeRemoteDir(remoteDir));
+    QString local = normalizeLocal(localDir);
+    QStringList filters = normalizeFilters(nameFilters);
+
+    for (const CrawlRoot &root : m_crawlRoots) {
+        if (!key.startsWith(root.remoteKey)) {
+            continue;
+        }
+        // 过滤过的作业只找到了部分文件，只能覆盖过滤条件和扫描方式完全相同的作业
+        if (!root.nameFilters.isEmpty() && (root.nameFilters != filters || root.mode != mode)) {
+            continue;
+        }
+        // 子目录在已扫描作业中的本地位置 = 作业本地目录 + 相对路径
+        QString relative = key.mid(root.remoteKey.size());
+        if (normalizeLocal(root.localDir + "/" + relative) == local) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 取出队首任务
+ * @return 队首任务
+ */
+DownloadTask DownloadQueue::dequeue()
+{
+    quint64 id = m_order.dequeue();
+    DownloadTask task = m_tasks.take(id);
+    if (!task.isDirectory) {
+        QString fileKey = remoteKey(task.remotePath);
+        m_pendingByRemote.remove(fileKey);
+        m_dequeuedByRemote.insert(fileKey, task.localPath);
+        account((fileKey.size() + task.localPath.size()) * 2 + 64);
+    }
+    account(-estimateBytes(task));
+    if (m_order.isEmpty()) {
+        refill();
+    }
+    return task;
+}
+
+/**
+ * @brief 取出文件出队后才加入的新目标
+ * @return 本地复制列表
+ */
+QList<LocalCopy> DownloadQueue::takeLocalCopies()
+{
+    QList<LocalCopy> copies;
+    copies.swap(m_localCopies);
+    for (const LocalCopy &copy : copies) {
+        account(-(estimateBytes(copy.task) + copy.source.size() * 2 + 32));
+    }
+    return copies;
+}
+
+/**
+ * @brief 查看队首任务
+ * @return 队首任务
+ */
+const DownloadTask &DownloadQueue::head() const
+{
+    return *m_tasks.constFind(m_order.head());
+}
+
+/**
+ * @brief 清空队列以及已记录的传输和扫描目录
+ */
+void DownloadQueue::clear()
+{
+    m_order.clear();
+    m_tasks.clear();
+    m_pendingByRemote.clear();
+    m_dequeuedByRemote.clear();
+    m_localCopies.clear();
+    m_seen.clear();
+    m_crawlRoots.clear();
+    dropSpillFiles();
+    account(-m_bytes);
+}
+
+/**
+ * @brief 将已下载的文件放到另一个位置
+ * @param source 已下载的本地文件
+ * @param target 目标路径
+ * @return 操作是否成功
+ */
+bool DownloadQueue::cloneFile(const QString &source, const QString &target)
+{
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    QFile::remove(target);
+
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    // 先尝试reflink，目标与源共享数据块，不产生额外的读写
+    QFile in(source);
+    QFile out(target);
+    if (in.open(QIODevice::ReadOnly) && out.open(QIODevice::WriteOnly)) {
+        if (ioctl(out.handle(), FICLONE, in.handle()) == 0) {
+            return true;
+        }
+        out.close();
+        in.close();
+        QFile::remove(target);
+    }
+#endif
+
+    return QFile::copy(source, target);
+}
+
+/**
+ * @brief 生成远程文件键
+ * @param remotePath 远程路径
+ * @return 服务器与远程路径组成的键
+ */
+QString DownloadQueue::remoteKey(const QString &remotePath) const
+{
+    return m_server + '\n' + remotePath;
+}
+
+/**
+ * @brief 规范化本地路径用于比较
+ * @param localPath 本地路径
+ * @return 规范化后的路径
+ */
+QString DownloadQueue::normalizeLocal(const QString &localPath)
+{
+    QString path = QDir::cleanPath(QFileInfo(localPath).absoluteFilePath());
+#ifdef Q_OS_WIN
+    // Windows文件系统不区分大小写
+    path = path.toLower();
+#endif
+    return path;
+}
+
+/**
+ * @brief 调整内存占用并同步到内存预算
+ * @param delta 变化的字节数
+ */
+void DownloadQueue::account(qint64 delta)
+{
+    m_bytes += delta;
+    if (m_budget) {
+        if (delta >= 0) {
+            m_budget->charge(MemoryBudget::TaskQueue, delta);
+        } else {
+            m_budget->release(MemoryBudget::TaskQueue, -delta);
+        }
+    }
+}
+
+/**
+ * @brief 规范化远程目录路径，确保以/开头和结尾
+ * @param remoteDir 远程目录
+ * @return 规范化后的路径
+ */
+QString DownloadQueue::normalizeRemoteDir(const QString &remoteDir)
+{
+    QString path = remoteDir;
+    if (!path.startsWith("/")) {
+        path = "/" + path;
+    }
+    if (!path.endsWith("/")) {
+        path += "/";
+    }
+    return path;
+}
+
+/**
+ * @brief 规范化文件名过滤条件用于比较
+ * @param nameFilters 过滤条件
+ * @return 小写、去重并排序后的过滤条件
+ */
+QStringList DownloadQueue::normalizeFilters(const QStringList &nameFilters)
+{
+    QStringList filters;
+    for (const QString &filter : nameFilters) {
+        QString trimmed = filter.trimmed().toLower();
+        if (!trimmed.isEmpty()) {
+            filters.append(trimmed);
+        }
+    }
+    filters.sort();
+    filters.removeDuplicates();
+    return filters;
+}
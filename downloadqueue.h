@@ -0,0 +1,262 @@
+/**
+ * @file downloadqueue.h
+ * @brief 去重下载队列
+ * @details 按（服务器、远程路径、本地路径）去重的下载任务队列
+ *
+ * 多个下载作业可能覆盖同一批文件（如先下载/data再下载/data/2024）：
+ * 1. 同一文件下载到同一位置只保留一个任务
+ * 2. 同一文件下载到不同位置只传输一次，其余位置在下载完成后从本地复制；
+ *    文件出队后才加入的新位置同样从本地复制（takeLocalCopies()）
+ * 3. 已被之前作业以相同（或不限）的文件名过滤和扫描方式扫描过的目录不再重复扫描
+ *
+ * 排队任务和去重记录占用的内存记入MemoryBudget；预算紧张时扫描出的任务先写入磁盘上的
+ * 溢出文件（addSpillFile()），队列取空后再分批读回
+ */
+
+#ifndef DOWNLOADQUEUE_H
+#define DOWNLOADQUEUE_H
+
+#include <QString>
+#include <QStringList>
+#include <QQueue>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <QPair>
+#include <QFile>
+#include <memory>
+#include "ftpclient.h"
+
+class MemoryBudget;
+class QDataStream;
+
+/**
+ * @struct LocalCopy
+ * @brief 已出队文件的新目标，从本地复制而不再传输
+ */
+struct LocalCopy {
+    QString source;          ///< 已下载（或正在下载）的本地文件
+    DownloadTask task;       ///< 新目标的下载任务，源文件不可用时可直接下载
+};
+
+/**
+ * @class DownloadQueue
+ * @brief 去重下载队列
+ *
+ * 队列本身不加锁，调用方需要像使用QQueue一样自行保护并发访问。
+ * 已出队（正在传输或已完成）的任务会被记住，直到调用clear()，
+ * 以免在同一批下载中再次传输
+ */
+class DownloadQueue
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    DownloadQueue();
+
+    /**
+     * @brief 析构函数，释放在内存预算中的记账
+     */
+    ~DownloadQueue();
+
+    /**
+     * @brief 设置内存预算
+     * @param budget 内存预算，为nullptr时不记账
+     */
+    void setMemoryBudget(MemoryBudget *budget);
+
+    /**
+     * @brief 当前占用的字节数（估算）
+     */
+    qint64 memoryUsage() const { return m_bytes; }
+
+    /**
+     * @brief 估算一个下载任务占用的内存
+     * @param task 下载任务
+     * @return 字节数
+     */
+    static qint64 estimateBytes(const DownloadTask &task);
+
+    /**
+     * @brief 设置当前服务器标识
+     * @param server 服务器标识（如"ftp.example.com:21"），作为去重键的一部分
+     */
+    void setServer(const QString &server) { m_server = server; }
+
+    /**
+     * @brief 添加下载任务
+     * @param task 下载任务
+     * @return 新增了一次传输时返回true；任务被合并（重复或改为本地复制）时返回false
+     *
+     * 同一远程文件已在队列中但目标不同时，新目标会被加入该任务的copyTargets；
+     * 已出队时记为本地复制，由takeLocalCopies()取出
+     */
+    bool enqueue(const DownloadTask &task);
+
+    /**
+     * @brief 取出文件出队后才加入的新目标
+     * @return 本地复制列表，源文件可能仍在传输或落盘中
+     */
+    QList<LocalCopy> takeLocalCopies();
+
+    /**
+     * @brief 是否有待处理的本地复制
+     */
+    bool hasLocalCopies() const { return !m_localCopies.isEmpty(); }
+
+    /**
+     * @brief 合并一个目录作业扫描出的任务
+     * @param tasks 扫描得到的任务
+     * @return 新增的传输数量
+     */
+    int merge(const QQueue<DownloadTask> &tasks);
+
+    /**
+     * @brief 接管一个任务溢出文件
+     * @param path 由writeTask()写成的文件，读完或clear()时删除
+     *
+     * 文件中的任务在队列中已有的任务全部取出后才分批读回，读回时照常去重
+     */
+    void addSpillFile(const QString &path);
+
+    /**
+     * @brief 把任务写入溢出文件
+     * @param out 溢出文件的数据流
+     * @param task 下载任务
+     */
+    static void writeTask(QDataStream &out, const DownloadTask &task);
+
+    /**
+     * @brief 记录已扫描的目录作业
+     * @param remoteDir 远程目录
+     * @param localDir 对应的本地目录
+     * @param nameFilters 扫描时使用的文件名过滤条件，为空表示不过滤
+     * @param mode 扫描时使用的扫描方式
+     */
+    void addCrawlRoot(const QString &remoteDir, const QString &localDir,
+                      const QStringList &nameFilters, FtpClient::CrawlMode mode);
+
+    /**
+     * @brief 判断目录是否已被之前的作业完整覆盖
+     * @param remoteDir 远程目录
+     * @param localDir 本地目标目录
+     * @param nameFilters 本次扫描的文件名过滤条件
+     * @param mode 本次扫描的扫描方式
+     * @return 某个已扫描目录包含remoteDir、映射到相同的本地位置，
+     *         且该作业不过滤文件名或过滤条件和扫描方式都与本次相同时返回true
+     */
+    bool coversDirectory(const QString &remoteDir, const QString &localDir,
+                         const QStringList &nameFilters, FtpClient::CrawlMode mode) const;
+
+    /**
+     * @brief 取出队首任务
+     * @return 队首任务
+     */
+    DownloadTask dequeue();
+
+    /**
+     * @brief 查看队首任务
+     * @return 队首任务
+     */
+    const DownloadTask &head() const;
+
+    /**
+     * @brief 队列是否为空（包括溢出文件中的任务）
+     */
+    bool isEmpty() const { return m_order.isEmpty(); }
+
+    /**
+     * @brief 内存中排队的任务数量，不包括溢出文件中尚未读回的任务
+     */
+    int size() const { return m_order.size(); }
+
+    /**
+     * @brief 清空队列以及已记录的传输和扫描目录
+     */
+    void clear();
+
+    /**
+     * @brief 将已下载的文件放到另一个位置
+     * @param source 已下载的本地文件
+     * @param target 目标路径，已存在时会被覆盖
+     * @return 操作是否成功
+     *
+     * 在支持的文件系统上（Linux的btrfs/XFS等）使用reflink共享数据块，否则普通复制
+     */
+    static bool cloneFile(const QString &source, const QString &target);
+
+private:
+    /**
+     * @brief 生成远程文件键
+     * @param remotePath 远程路径
+     * @return 服务器与远程路径组成的键
+     */
+    QString remoteKey(const QString &remotePath) const;
+
+    /**
+     * @brief 规范化本地路径用于比较
+     * @param localPath 本地路径
+     * @return 规范化后的路径
+     */
+    static QString normalizeLocal(const QString &localPath);
+
+    /**
+     * @brief 规范化远程目录路径，确保以/开头和结尾
+     * @param remoteDir 远程目录
+     * @return 规范化后的路径
+     */
+    static QString normalizeRemoteDir(const QString &remoteDir);
+
+    /**
+     * @brief 规范化文件名过滤条件用于比较（过滤不区分大小写，与顺序无关）
+     * @param nameFilters 过滤条件
+     * @return 小写、去重并排序后的过滤条件
+     */
+    static QStringList normalizeFilters(const QStringList &nameFilters);
+
+    /**
+     * @brief 队列取空时从溢出文件读回下一批任务
+     *
+     * 读回的任务可能全部因去重被丢弃，因此一直读到有任务入队或溢出文件读完
+     */
+    void refill();
+
+    /**
+     * @brief 关闭并删除所有溢出文件
+     */
+    void dropSpillFiles();
+
+    /**
+     * @brief 调整内存占用并同步到内存预算
+     * @param delta 变化的字节数
+     */
+    void account(qint64 delta);
+
+private:
+    /**
+     * @brief 已扫描的目录作业
+     */
+    struct CrawlRoot {
+        QString remoteKey;          ///< 服务器与远程目录组成的键
+        QString localDir;           ///< 规范化的本地目录
+        QStringList nameFilters;    ///< 规范化的文件名过滤条件，为空表示不过滤
+        FtpClient::CrawlMode mode;  ///< 扫描方式
+    };
+
+    QString m_server;                         ///< 当前服务器标识
+    QQueue<quint64> m_order;                  ///< 按入队顺序排列的任务编号
+    QHash<quint64, DownloadTask> m_tasks;     ///< 排队中的任务
+    QHash<QString, quint64> m_pendingByRemote; ///< 远程文件键到排队任务编号的映射
+    QHash<QString, QString> m_dequeuedByRemote; ///< 远程文件键到已出队任务本地路径的映射
+    QList<LocalCopy> m_localCopies;           ///< 出队后才加入的新目标
+    QSet<QString> m_seen;                     ///< 已排队或已出队的（远程文件、本地路径）键
+    QList<CrawlRoot> m_crawlRoots;            ///< 已扫描的目录作业
+    QStringList m_spillFiles;                 ///< 尚未读完的溢出文件
+    std::unique_ptr<QFile> m_spillReader;     ///< 正在读回的溢出文件（m_spillFiles的第一个）
+    quint64 m_nextId;                         ///< 下一个任务编号
+    qint64 m_bytes;                           ///< 估算的内存占用
+    MemoryBudget *m_budget;                   ///< 内存预算（不拥有）
+};
+
+#endif // DOWNLOADQUEUE_H
@@ -0,0 +1,90 @@
+/**
+ * @file downloadscheduler.cpp
+ * @brief 下载调度策略实现文件
+ */
+
+#include "downloadscheduler.h"
+#include "downloadqueue.h"
+
+/**
+ * @brief 构造函数
+ * @param policy 调度参数
+ */
+DownloadScheduler::DownloadScheduler(const SchedulerPolicy &policy)
+    : m_policy(policy)
+{
+}
+
+/**
+ * @brief 判断任务是否可以合并到批量下载中
+ * @param task 下载任务
+ * @return 可以合并时返回true
+ */
+bool DownloadScheduler::isBatchable(const DownloadTask &task) const
+{
+    switch (m_policy.batchMode) {
+    case SchedulerPolicy::Multiplexed:
+        return task.fileSize < m_policy.segmentThreshold;
+    case SchedulerPolicy::BlockMode:
+        // 块模式下批内文件共用一个数据连接依次传输，非分段的文件都可以合并；本地已有部分内容的文件仍单独续传
+        return task.fileSize < m_policy.segmentThreshold && resumeOffset(task) == 0;
+    default:
+        return task.fileSize > 0 && task.fileSize <= m_policy.tinyFileLimit;
+    }
+}
+
+/**
+ * @brief 取出下一步传输
+ * @param queue 下载队列
+ * @return 下一步
+ */
+ScheduledStep DownloadScheduler::next(DownloadQueue *queue) const
+{
+    ScheduledStep step;
+    if (queue->isEmpty()) {
+        return step;
+    }
+
+    DownloadTask task = queue->dequeue();
+    step.tasks << task;
+    if (task.isDirectory) {
+        step.kind = ScheduledStep::Directory;
+        return step;
+    }
+
+    if (isBatchable(task)) {
+        // 把队列中连续的可合并文件组成一批
+        step.kind = ScheduledStep::Batch;
+        while (!queue->isEmpty() && step.tasks.size() < m_policy.batchSize) {
+            const DownloadTask &next = queue->head();
+            if (next.isDirectory || !isBatchable(next)) {
+                break;
+            }
+            step.tasks << queue->dequeue();
+        }
+        return step;
+    }
+
+    // 本地已有部分文件时从已有位置续传，大文件使用分段并行下载
+    qint64 localSize = resumeOffset(task);
+    if (task.fileSize > 0 && localSize > 0 && localSize < task.fileSize) {
+        step.resumeOffset = localSize;
+    }
+    if (step.resumeOffset == 0 && task.fileSize >= m_policy.segmentThreshold) {
+        step.kind = ScheduledStep::Segmented;
+        step.segments = qMax(1, m_policy.segments);
+    } else {
+        step.kind = ScheduledStep::Single;
+    }
+    return step;
+}
+
+/**
+ * @brief 本地已有的可续传字节数
+ * @param task 下载任务
+ * @return 字节数
+ */
+qint64 DownloadScheduler::resumeOffset(const DownloadTask &task) const
+{
+    return m_resumeProbe ? m_resumeProbe(task) : 0;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file downloadscheduler.h
+ * @brief 下载调度策略
+ * @details 决定下载队列中的下一步如何传输：哪些文件合并为一批并发下载、
+ *          哪些大文件分段并行下载、哪些文件从本地已有位置续传。
+ *
+ * 调度只读写DownloadQueue，不做任何网络或磁盘操作（续传探测由调用方提供），
+ * 主窗口和离线模拟器（sim/jobsim）使用同一份调度代码
+ */
+
+#ifndef DOWNLOADSCHEDULER_H
+#define DOWNLOADSCHEDULER_H
+
+#include <QList>
+#include <functional>
+#include "ftpclient.h"
+
+class DownloadQueue;
+
+/**
+ * @struct SchedulerPolicy
+ * @brief 调度参数
+ */
+struct SchedulerPolicy {
+    /**
+     * @brief 批量合并方式，对应服务器的能力
+     */
+    enum BatchMode {
+        TinyFiles,       ///< 只合并极小文件，内容缓存在内存中由落盘线程池批量写入（普通FTP）
+        Multiplexed,     ///< 合并所有非分段文件，在同一个HTTP/2连接上多路复用（HTTP(S)）
+        BlockMode        ///< 合并所有非分段且无需续传的文件，在同一个数据连接上依次传输（FTP块模式）
+    };
+
+    BatchMode batchMode = TinyFiles;                 ///< 批量合并方式
+    int batchSize = 64;                              ///< 每批最多的文件数
+    qint64 tinyFileLimit = 64 * 1024;                ///< TinyFiles方式下可合并的文件大小上限，0表示不合并
+    qint64 segmentThreshold = 64LL * 1024 * 1024;    ///< 不小于该大小的文件分段并行下载
+    int segments = 4;                                ///< 分段数量
+};
+
+/**
+ * @struct ScheduledStep
+ * @brief 调度出的一步传输
+ */
+struct ScheduledStep {
+    /**
+     * @brief 传输方式
+     */
+    enum Kind {
+        Idle,            ///< 队列为空
+        Directory,       ///< 目录任务，目录已在扫描时创建
+        Batch,           ///< 多个文件并发下载
+        Segmented,       ///< 单个大文件分段并行下载
+        Single           ///< 单个文件普通下载（可能续传）
+    };
+
+    Kind kind = Idle;                ///< 传输方式
+    QList<DownloadTask> tasks;       ///< 本步的任务，Batch以外只有一个
+    qint64 resumeOffset = 0;         ///< Single时的续传起始位置
+    int segments = 1;                ///< Segmented时的分段数量
+};
+
+/**
+ * @class DownloadScheduler
+ * @brief 从下载队列中取出下一步传输
+ *
+ * 不加锁，调用方需要持有保护下载队列的锁
+ */
+class DownloadScheduler
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param policy 调度参数
+     */
+    explicit DownloadScheduler(const SchedulerPolicy &policy = SchedulerPolicy());
+
+    /**
+     * @brief 设置调度参数
+     * @param policy 调度参数
+     */
+    void setPolicy(const SchedulerPolicy &policy) { m_policy = policy; }
+
+    /**
+     * @brief 当前调度参数
+     */
+    const SchedulerPolicy &policy() const { return m_policy; }
+
+    /**
+     * @brief 设置续传探测
+     * @param probe 返回本地文件中可以确认属于该远程文件未完成部分的字节数，不能确认时返回0；
+     *              未设置时视为没有可续传的文件
+     */
+    void setResumeProbe(std::function<qint64(const DownloadTask &)> probe) { m_resumeProbe = probe; }
+
+    /**
+     * @brief 判断任务是否可以合并到批量下载中
+     * @param task 下载任务
+     * @return 可以合并时返回true
+     */
+    bool isBatchable(const DownloadTask &task) const;
+
+    /**
+     * @brief 取出下一步传输
+     * @param queue 下载队列，本步的任务从中出队
+     * @return 下一步，队列为空时kind为Idle
+     *
+     * 队首可以合并时，连续取出其后可以合并的文件组成一批，遇到目录或不可合并的文件为止
+     */
+    ScheduledStep next(DownloadQueue *queue) const;
+
+private:
+    /**
+     * @brief 本地已有的可续传字节数
+     */
+    qint64 resumeOffset(const DownloadTask &task) const;
+
+private:
+    SchedulerPolicy m_policy;                                  ///< 调度参数
+    std::function<qint64(const DownloadTask &)> m_resumeProbe; ///< 续传探测
+};
+
+#endif // DOWNLOADSCHEDULER_H
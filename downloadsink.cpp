@@ -0,0 +1,462 @@
+/**
+ * @file downloadsink.cpp
+ * @brief 加密落盘输出实现文件
+ */
+
+#include "downloadsink.h"
+#include "hotpathtrace.h"
+#include <QtEndian>
+#include <cstring>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace {
+
+const char FILE_MAGIC[] = "FTPENC01";   ///< 文件头魔数（8字节）
+const int HEADER_SIZE = 16;             ///< 文件头长度
+const int NONCE_SIZE = 12;              ///< 每块nonce长度
+const int TAG_SIZE = 16;                ///< 认证标签长度
+const int LENGTH_SIZE = 4;              ///< 块明文长度字段
+
+/**
+ * @brief 获取算法对应的EVP实现
+ */
+const EVP_CIPHER *evpCipher(int cipher)
+{
+    switch (cipher) {
+    case EncryptedFileSink::Aes256Gcm:
+        return EVP_aes_256_gcm();
+    case EncryptedFileSink::ChaCha20Poly1305:
+        return EVP_chacha20_poly1305();
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief 生成文件头
+ */
+QByteArray makeHeader(int cipher, qint64 chunkSize)
+{
+    QByteArray header(HEADER_SIZE, '\0');
+    memcpy(header.data(), FILE_MAGIC, 8);
+    header[8] = static_cast<char>(cipher);
+    qToBigEndian<quint32>(static_cast<quint32>(chunkSize), header.data() + 12);
+    return header;
+}
+
+/**
+ * @brief 生成一块的附加认证数据
+ */
+QByteArray makeAad(const QByteArray &header, quint64 index, bool final)
+{
+    QByteArray aad = header;
+    aad.resize(HEADER_SIZE + 9);
+    qToBigEndian<quint64>(index, aad.data() + HEADER_SIZE);
+    aad[HEADER_SIZE + 8] = final ? 1 : 0;
+    return aad;
+}
+
+/**
+ * @brief 读取文件头并统计完整块
+ * @param file 已打开的加密文件
+ * @param header 输出文件头
+ * @param cipher 输出算法
+ * @param chunkSize 输出块大小
+ * @param fullChunks 输出完整块数量
+ * @return 最后一个完整块之后的文件偏移，文件头无效时为-1
+ *
+ * 只读取每块的长度字段，不做解密，续传前的检查代价与块数成正比而与文件大小无关
+ */
+qint64 scanChunks(QFile &file, QByteArray *header, int *cipher, qint64 *chunkSize, quint64 *fullChunks)
+{
+    *header = file.read(HEADER_SIZE);
+    if (header->size() != HEADER_SIZE || memcmp(header->constData(), FILE_MAGIC, 8) != 0) {
+        return -1;
+    }
+    *cipher = static_cast<unsigned char>(header->at(8));
+    *chunkSize = qFromBigEndian<quint32>(header->constData() + 12);
+    if (!evpCipher(*cipher) || *chunkSize <= 0) {
+        return -1;
+    }
+
+    qint64 pos = HEADER_SIZE;
+    qint64 recordSize = LENGTH_SIZE + NONCE_SIZE + *chunkSize + TAG_SIZE;
+    *fullChunks = 0;
+    while (pos + recordSize <= file.size()) {
+        char lengthField[LENGTH_SIZE];
+        if (!file.seek(pos) || file.read(lengthField, LENGTH_SIZE) != LENGTH_SIZE) {
+            break;
+        }
+        // 短块是最后一块（或被中断的尾块），不计入可续传部分
+        if (qFromBigEndian<quint32>(lengthField) != static_cast<quint32>(*chunkSize)) {
+            break;
+        }
+        pos += recordSize;
+        ++*fullChunks;
+    }
+    return pos;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ * @param path 输出文件路径
+ * @param key 32字节密钥
+ * @param cipher 加密算法
+ * @param chunkSize 每块明文大小
+ * @param parent 父对象
+ */
+EncryptedFileSink::EncryptedFileSink(const QString &path, const QByteArray &key, Cipher cipher,
+                                     qint64 chunkSize, QObject *parent)
+    : QIODevice(parent)
+    , m_file(path)
+    , m_key(key)
+    , m_cipher(cipher)
+    , m_chunkSize(qBound<qint64>(4096, chunkSize, 64 * 1024 * 1024))
+    , m_chunkIndex(0)
+    , m_ctx(nullptr)
+    , m_finished(false)
+{
+}
+
+/**
+ * @brief 析构函数
+ */
+EncryptedFileSink::~EncryptedFileSink()
+{
+    close();
+    if (m_ctx) {
+        EVP_CIPHER_CTX_free(m_ctx);
+    }
+}
+
+/**
+ * @brief 打开输出文件
+ * @param mode WriteOnly新建文件；Append在已有文件的最后一个完整块之后续写
+ * @return 操作是否成功
+ */
+bool EncryptedFileSink::open(OpenMode mode)
+{
+    if (m_key.size() != KeySize) {
+        setErrorString("加密密钥长度必须为32字节");
+        return false;
+    }
+
+    if (mode & Append) {
+        // 续传：保留所有完整块，截掉之后的短块或残缺记录
+        if (!m_file.open(QIODevice::ReadWrite)) {
+            setErrorString(m_file.errorString());
+            return false;
+        }
+        int cipher = 0;
+        qint64 endPos = scanChunks(m_file, &m_header, &cipher, &m_chunkSize, &m_chunkIndex);
+        if (endPos < 0 || cipher != m_cipher) {
+            m_file.close();
+            setErrorString("已有文件不是使用相同算法加密的文件，无法续传");
+            return false;
+        }
+        if (!m_file.resize(endPos) || !m_file.seek(endPos)) {
+            setErrorString(m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    } else {
+        if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            setErrorString(m_file.errorString());
+            return false;
+        }
+        m_header = makeHeader(m_cipher, m_chunkSize);
+        m_chunkIndex = 0;
+        if (m_file.write(m_header) != HEADER_SIZE) {
+            setErrorString(m_file.errorString());
+            m_file.close();
+            return false;
+        }
+    }
+
+    if (!initCipher()) {
+        m_file.close();
+        return false;
+    }
+
+    m_plain.reserve(m_chunkSize);
+    m_plain.resize(0);
+    m_sealed.reserve(LENGTH_SIZE + NONCE_SIZE + m_chunkSize + TAG_SIZE);
+    m_finished = false;
+    return QIODevice::open(WriteOnly | (mode & Append));
+}
+
+/**
+ * @brief 关闭文件
+ */
+void EncryptedFileSink::close()
+{
+    if (!isOpen()) {
+        return;
+    }
+    // 不足一块的数据没有写入磁盘，续传时会重新下载
+    m_plain.resize(0);
+    m_file.close();
+    QIODevice::close();
+}
+
+/**
+ * @brief 写入最后一块，标记文件完整
+ * @return 操作是否成功
+ */
+bool EncryptedFileSink::finish()
+{
+    if (!isOpen() || !m_ctx) {
+        return false;
+    }
+    if (m_finished) {
+        return true;
+    }
+    if (!sealChunk(m_plain.constData(), m_plain.size(), true) || !m_file.flush()) {
+        return false;
+    }
+    m_plain.resize(0);
+    m_finished = true;
+    return true;
+}
+
+/**
+ * @brief 获取已有加密文件中可续传的明文字节数
+ * @param path 加密文件路径
+ * @return 完整块的明文总字节数
+ */
+qint64 EncryptedFileSink::resumableSize(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QByteArray header;
+    int cipher = 0;
+    qint64 chunkSize = 0;
+    quint64 fullChunks = 0;
+    if (scanChunks(file, &header, &cipher, &chunkSize, &fullChunks) < 0) {
+        return 0;
+    }
+    return static_cast<qint64>(fullChunks) * chunkSize;
+}
+
+/**
+ * @brief 解密整个文件
+ * @param source 加密文件
+ * @param target 输出的明文文件
+ * @param key 32字节密钥
+ * @param error 输出错误信息（可选）
+ * @return 所有块认证通过且文件完整时返回true
+ */
+bool EncryptedFileSink::decryptFile(const QString &source, const QString &target, const QByteArray &key,
+                                    QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly)) {
+        return fail(QString("无法打开加密文件: %1").arg(source));
+    }
+    QByteArray header = in.read(HEADER_SIZE);
+    if (header.size() != HEADER_SIZE || memcmp(header.constData(), FILE_MAGIC, 8) != 0) {
+        return fail("不是加密文件");
+    }
+    const EVP_CIPHER *cipher = evpCipher(static_cast<unsigned char>(header.at(8)));
+    qint64 chunkSize = qFromBigEndian<quint32>(header.constData() + 12);
+    if (!cipher || chunkSize <= 0 || key.size() != KeySize) {
+        return fail("不支持的加密参数或密钥长度错误");
+    }
+
+    QFile out(target);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return fail(QString("无法创建输出文件: %1").arg(target));
+    }
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    if (!ctx || EVP_DecryptInit_ex(ctx, cipher, nullptr, nullptr, nullptr) != 1
+        || EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, NONCE_SIZE, nullptr) != 1) {
+        EVP_CIPHER_CTX_free(ctx);
+        return fail("无法初始化解密上下文");
+    }
+
+    bool complete = false;
+    QByteArray plain;
+    for (quint64 index = 0; !complete; ++index) {
+        QByteArray lengthField = in.read(LENGTH_SIZE);
+        if (lengthField.size() != LENGTH_SIZE) {
+            break;
+        }
+        qint64 length = qFromBigEndian<quint32>(lengthField.constData());
+        if (length > chunkSize) {
+            break;
+        }
+        QByteArray nonce = in.read(NONCE_SIZE);
+        QByteArray sealed = in.read(length);
+        QByteArray tag = in.read(TAG_SIZE);
+        if (nonce.size() != NONCE_SIZE || sealed.size() != length || tag.size() != TAG_SIZE) {
+            break;
+        }
+
+        bool final = length < chunkSize;
+        QByteArray aad = makeAad(header, index, final);
+        plain.resize(length);
+        int outLen = 0;
+        int finalLen = 0;
+        bool ok = EVP_DecryptInit_ex(ctx, nullptr, nullptr,
+                                     reinterpret_cast<const unsigned char*>(key.constData()),
+                                     reinterpret_cast<const unsigned char*>(nonce.constData())) == 1
+               && EVP_DecryptUpdate(ctx, nullptr, &outLen, reinterpret_cast<const unsigned char*>(aad.constData()),
+                                    aad.size()) == 1
+               && EVP_DecryptUpdate(ctx, reinterpret_cast<unsigned char*>(plain.data()), &outLen,
+                                    reinterpret_cast<const unsigned char*>(sealed.constData()),
+                                    static_cast<int>(length)) == 1
+               && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, TAG_SIZE, tag.data()) == 1
+               && EVP_DecryptFinal_ex(ctx, reinterpret_cast<unsigned char*>(plain.data()) + outLen, &finalLen) == 1;
+        if (!ok) {
+            EVP_CIPHER_CTX_free(ctx);
+            return fail(QString("第 %1 块认证失败，文件已损坏或密钥错误").arg(index));
+        }
+        if (out.write(plain) != length) {
+            EVP_CIPHER_CTX_free(ctx);
+            return fail(QString("写入输出文件失败: %1").arg(out.errorString()));
+        }
+        complete = final;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    // 最后一块之后不能有多余数据，没有最后一块说明下载未完成
+    if (!complete || !in.atEnd()) {
+        return fail("加密文件不完整");
+    }
+    return true;
+}
+
+/**
+ * @brief 不支持读取
+ */
+qint64 EncryptedFileSink::readData(char *data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+/**
+ * @brief 缓冲并加密写入的数据
+ * @param data 明文数据
+ * @param len 数据长度
+ * @return 接受的字节数，出错时为-1
+ */
+qint64 EncryptedFileSink::writeData(const char *data, qint64 len)
+{
+    if (m_finished) {
+        setErrorString("文件已经结束，不能继续写入");
+        return -1;
+    }
+
+    qint64 remaining = len;
+    while (remaining > 0) {
+        // 缓冲为空且剩余数据足够一整块时直接加密，避免多一次拷贝
+        if (m_plain.isEmpty() && remaining >= m_chunkSize) {
+            if (!sealChunk(data, m_chunkSize, false)) {
+                return -1;
+            }
+            data += m_chunkSize;
+            remaining -= m_chunkSize;
+            continue;
+        }
+
+        qint64 take = qMin(remaining, m_chunkSize - m_plain.size());
+        m_plain.append(data, take);
+        data += take;
+        remaining -= take;
+        if (m_plain.size() == m_chunkSize) {
+            if (!sealChunk(m_plain.constData(), m_chunkSize, false)) {
+                return -1;
+            }
+            m_plain.resize(0);
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief 加密一块并写入文件
+ * @param data 明文
+ * @param len 明文长度
+ * @param final 是否为最后一块
+ * @return 操作是否成功
+ */
+bool EncryptedFileSink::sealChunk(const char *data, qint64 len, bool final)
+{
+    // 记录布局：长度 | nonce | 密文 | 标签
+    m_sealed.resize(LENGTH_SIZE + NONCE_SIZE + len + TAG_SIZE);
+    unsigned char *record = reinterpret_cast<unsigned char*>(m_sealed.data());
+    unsigned char *nonce = record + LENGTH_SIZE;
+    unsigned char *sealed = nonce + NONCE_SIZE;
+    qToBigEndian<quint32>(static_cast<quint32>(len), record);
+
+    // 每块使用随机nonce，续传时重写同一序号的块也不会重复使用nonce
+    if (RAND_bytes(nonce, NONCE_SIZE) != 1) {
+        setErrorString("无法生成随机数");
+        return false;
+    }
+
+    QByteArray aad = makeAad(m_header, m_chunkIndex, final);
+    int outLen = 0;
+    int finalLen = 0;
+    bool ok;
+    {
+        HOTPATH_SPAN(encryptSpan, Encrypt, len);
+        ok = EVP_EncryptInit_ex(m_ctx, nullptr, nullptr, nullptr, nonce) == 1
+          && EVP_EncryptUpdate(m_ctx, nullptr, &outLen, reinterpret_cast<const unsigned char*>(aad.constData()),
+                               aad.size()) == 1
+          && (len == 0 || EVP_EncryptUpdate(m_ctx, sealed, &outLen,
+                                            reinterpret_cast<const unsigned char*>(data),
+                                            static_cast<int>(len)) == 1)
+          && EVP_EncryptFinal_ex(m_ctx, sealed + outLen, &finalLen) == 1
+          && EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_AEAD_GET_TAG, TAG_SIZE, sealed + len) == 1;
+    }
+    if (!ok) {
+        setErrorString("加密失败");
+        return false;
+    }
+
+    HOTPATH_SPAN(writeSpan, DiskWrite, len);
+    if (m_file.write(m_sealed) != m_sealed.size()) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+    ++m_chunkIndex;
+    return true;
+}
+
+/**
+ * @brief 初始化加密上下文
+ * @return 操作是否成功
+ *
+ * 密钥只在打开时设置一次，之后每块只更换nonce
+ */
+bool EncryptedFileSink::initCipher()
+{
+    if (!m_ctx) {
+        m_ctx = EVP_CIPHER_CTX_new();
+    }
+    bool ok = m_ctx
+           && EVP_EncryptInit_ex(m_ctx, evpCipher(m_cipher), nullptr, nullptr, nullptr) == 1
+           && EVP_CIPHER_CTX_ctrl(m_ctx, EVP_CTRL_AEAD_SET_IVLEN, NONCE_SIZE, nullptr) == 1
+           && EVP_EncryptInit_ex(m_ctx, nullptr, nullptr,
+                                 reinterpret_cast<const unsigned char*>(m_key.constData()), nullptr) == 1;
+    if (!ok) {
+        setErrorString("无法初始化加密上下文");
+    }
+    return ok;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file downloadsink.h
+ * @brief 加密落盘输出
+ * @details 在下载数据写入磁盘的同时进行认证加密，省去下载后再读写一遍的加密过程
+ *
+ * 文件格式（整数均为大端序）：
+ * 1. 文件头16字节："FTPENC01" | 算法(1) | 保留(3) | 块大小(4)
+ * 2. 若干数据块：明文长度(4) | 随机nonce(12) | 密文 | 认证标签(16)
+ * 每个块的附加认证数据为 文件头 | 块序号(8) | 是否最后一块(1)，
+ * 块不能被重排、删除或截断；除最后一块外每块的明文都恰好为块大小，
+ * 最后一块总是短于块大小（可以为空），据此判断文件是否完整。
+ * 中断的下载保留所有完整的块，续传从最后一个完整块之后开始
+ */
+
+#ifndef DOWNLOADSINK_H
+#define DOWNLOADSINK_H
+
+#include <QIODevice>
+#include <QFile>
+#include <QByteArray>
+#include <QString>
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+/**
+ * @class EncryptedFileSink
+ * @brief 流式加密文件输出
+ *
+ * 只写的顺序设备，可以直接替代QFile作为下载输出。
+ * 下载成功后必须调用finish()写入最后一块；未调用finish()就关闭时，
+ * 缓冲中不足一块的数据被丢弃，文件保持可续传状态
+ */
+class EncryptedFileSink : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 加密算法
+     */
+    enum Cipher {
+        Aes256Gcm = 1,           ///< AES-256-GCM，有AES-NI的CPU上最快
+        ChaCha20Poly1305 = 2     ///< ChaCha20-Poly1305，没有AES硬件加速时更快
+    };
+
+    static constexpr int KeySize = 32;                      ///< 密钥长度（字节）
+    static constexpr qint64 DefaultChunkSize = 1024 * 1024; ///< 默认块大小（字节）
+
+    /**
+     * @brief 构造函数
+     * @param path 输出文件路径
+     * @param key 32字节密钥
+     * @param cipher 加密算法
+     * @param chunkSize 每块明文大小
+     * @param parent 父对象
+     */
+    EncryptedFileSink(const QString &path, const QByteArray &key, Cipher cipher = Aes256Gcm,
+                      qint64 chunkSize = DefaultChunkSize, QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数，未完成的文件保持可续传状态
+     */
+    ~EncryptedFileSink() override;
+
+    /**
+     * @brief 打开输出文件
+     * @param mode WriteOnly新建文件；Append在已有文件的最后一个完整块之后续写
+     * @return 操作是否成功
+     */
+    bool open(OpenMode mode) override;
+
+    /**
+     * @brief 关闭文件，未调用finish()时丢弃不足一块的缓冲数据
+     */
+    void close() override;
+
+    /**
+     * @brief 顺序设备
+     */
+    bool isSequential() const override { return true; }
+
+    /**
+     * @brief 写入最后一块，标记文件完整
+     * @return 操作是否成功
+     */
+    bool finish();
+
+    /**
+     * @brief 获取已有加密文件中可续传的明文字节数
+     * @param path 加密文件路径
+     * @return 完整块的明文总字节数，文件不存在或格式不符时为0
+     */
+    static qint64 resumableSize(const QString &path);
+
+    /**
+     * @brief 解密整个文件
+     * @param source 加密文件
+     * @param target 输出的明文文件
+     * @param key 32字节密钥
+     * @param error 输出错误信息（可选）
+     * @return 所有块认证通过且文件完整时返回true
+     */
+    static bool decryptFile(const QString &source, const QString &target, const QByteArray &key,
+                            QString *error = nullptr);
+
+protected:
+    /**
+     * @brief 不支持读取
+     */
+    qint64 readData(char *data, qint64 maxSize) override;
+
+    /**
+     * @brief 缓冲并加密写入的数据
+     * @param data 明文数据
+     * @param len 数据长度
+     * @return 接受的字节数，出错时为-1
+     */
+    qint64 writeData(const char *data, qint64 len) override;
+
+private:
+    /**
+     * @brief 加密一块并写入文件
+     * @param data 明文
+     * @param len 明文长度
+     * @param final 是否为最后一块
+     * @return 操作是否成功
+     */
+    bool sealChunk(const char *data, qint64 len, bool final);
+
+    /**
+     * @brief 初始化加密上下文
+     * @return 操作是否成功
+     */
+    bool initCipher();
+
+private:
+    QFile m_file;                 ///< 底层文件
+    QByteArray m_key;             ///< 密钥
+    Cipher m_cipher;              ///< 加密算法
+    qint64 m_chunkSize;           ///< 每块明文大小
+    QByteArray m_header;          ///< 文件头，同时作为附加认证数据的前缀
+    QByteArray m_plain;           ///< 未满一块的明文缓冲
+    QByteArray m_sealed;          ///< 加密后的块记录缓冲
+    quint64 m_chunkIndex;         ///< 下一块的序号
+    EVP_CIPHER_CTX *m_ctx;        ///< 加密上下文
+    bool m_finished;              ///< 是否已写入最后一块
+};
+
+#endif // DOWNLOADSINK_H
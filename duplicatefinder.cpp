@@ -0,0 +1,448 @@
+/**
+ * @file duplicatefinder.cpp
+ * @brief 远程重复文件查找实现文件
+ */
+
+#include "duplicatefinder.h"
+#include "hashcache.h"
+#include <QCryptographicHash>
+#include <QHash>
+#include <QScopeGuard>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVector>
+
+/**
+ * @brief 构造函数
+ */
+DuplicateFinder::DuplicateFinder()
+    : m_port(21)
+    , m_parallelism(4)
+    , m_sampleSize(64 * 1024)
+    , m_batchSize(10000)
+    , m_hashCache(nullptr)
+    , m_hashSupport(0)
+    , m_sampled(false)
+    , m_processedFiles(0)
+    , m_cancelled(false)
+{
+}
+
+/**
+ * @brief 设置服务器连接参数
+ * @param server 服务器地址
+ * @param port 端口号
+ * @param username 用户名
+ * @param password 密码
+ */
+void DuplicateFinder::setConnection(const QString &server, int port, const QString &username, const QString &password)
+{
+    m_server = server;
+    m_port = port;
+    m_username = username;
+    m_password = password;
+}
+
+/**
+ * @brief 在按大小排序的索引中查找重复文件
+ * @param sortedIndexPath 按大小排序的索引文件
+ * @param reportPath 输出报告文件
+ * @return 操作是否成功
+ */
+bool DuplicateFinder::run(const QString &sortedIndexPath, const QString &reportPath)
+{
+    m_summary = DuplicateSummary();
+    m_hashSupport = 0;
+    m_sampled = false;
+    m_processedFiles = 0;
+
+    QFile index(sortedIndexPath);
+    if (!index.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("无法打开索引文件: %1").arg(sortedIndexPath);
+        return false;
+    }
+    QFile report(reportPath);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        m_lastError = QString("无法创建报告文件: %1").arg(reportPath);
+        return false;
+    }
+    QTemporaryDir spillDir;
+    if (!spillDir.isValid()) {
+        m_lastError = "无法创建临时目录";
+        return false;
+    }
+
+    // 每个工作线程使用独立的连接
+    for (int i = 0; i < m_parallelism; ++i) {
+        FtpClient *client = new FtpClient();
+        m_clients.append(client);
+        if (!client->connect(m_server, m_port, m_username, m_password)) {
+            m_lastError = QString("连接服务器失败: %1").arg(client->lastError());
+            qDeleteAll(m_clients);
+            m_clients.clear();
+            return false;
+        }
+    }
+    m_localRoot.clear();
+    if (m_hashCache && m_clients.first()->isLocal()) {
+        m_localRoot = m_clients.first()->localRoot();
+        if (m_localRoot.endsWith('/')) {
+            m_localRoot.chop(1);
+        }
+    }
+
+    bool success = true;
+    QList<QList<IndexRecord>> batch;
+    int batchFiles = 0;
+    QList<IndexRecord> group;
+    qint64 groupSize = -1;
+    QFile spill(spillDir.filePath("group.tsv"));
+
+    // 大小相同的记录在排序后相邻，组结束时只保留至少两个文件的非空组；
+    // 已分段写入临时文件的大组在结束时统一按指纹归类
+    auto closeGroup = [&]() -> bool {
+        bool ok = true;
+        if (spill.isOpen()) {
+            m_summary.candidateFiles += group.size();
+            ok = spillRecords(group, spill) && reportSpilledGroup(spill, groupSize, report);
+        } else if (group.size() >= 2 && groupSize > 0) {
+            m_summary.candidateFiles += group.size();
+            batchFiles += group.size();
+            batch.append(group);
+        }
+        group.clear();
+        return ok;
+    };
+
+    while (success && !index.atEnd()) {
+        if (m_cancelled) {
+            m_lastError = "查找已取消";
+            success = false;
+            break;
+        }
+        IndexRecord record;
+        if (!RemoteIndex::parseRecord(index.readLine(), &record)) {
+            continue;
+        }
+        ++m_summary.scannedFiles;
+
+        if (record.size != groupSize) {
+            success = closeGroup();
+            groupSize = record.size;
+            if (success && batchFiles >= m_batchSize) {
+                success = processBatch(batch, report);
+                batch.clear();
+                batchFiles = 0;
+            }
+        }
+        group.append(record);
+
+        // 同一大小的文件超过一批时不再整组留在内存中：先处理已累积的批次，
+        // 再分段计算指纹并写入临时文件，内存占用始终不超过一批
+        if (success && groupSize > 0 && group.size() >= m_batchSize) {
+            if (!spill.isOpen()) {
+                if (!batch.isEmpty()) {
+                    success = processBatch(batch, report);
+                    batch.clear();
+                    batchFiles = 0;
+                }
+                if (success && !spill.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    m_lastError = QString("无法创建临时文件: %1").arg(spill.fileName());
+                    success = false;
+                }
+            }
+            if (success) {
+                m_summary.candidateFiles += group.size();
+                success = spillRecords(group, spill);
+            }
+            group.clear();
+        }
+    }
+    if (success) {
+        success = closeGroup();
+    }
+    if (success && !batch.isEmpty()) {
+        success = processBatch(batch, report);
+    }
+
+    m_summary.sampled = m_sampled;
+    qDeleteAll(m_clients);
+    m_clients.clear();
+    return success;
+}
+
+/**
+ * @brief 并行计算一组文件的指纹
+ * @param items 文件记录
+ * @return 与items一一对应的指纹，失败的文件为空；被中止时返回空列表
+ */
+QVector<QByteArray> DuplicateFinder::fingerprintAll(const QVector<const IndexRecord*> &items)
+{
+    QVector<QByteArray> prints(items.size());
+    std::atomic<int> next(0);
+
+    // 本地目录上未缓存的摘要先由缓存的线程池并行计算，之后的指纹查询全部命中
+    if (!m_localRoot.isEmpty()) {
+        QStringList paths;
+        for (const IndexRecord *record : items) {
+            paths.append(m_localRoot + record->path);
+        }
+        m_hashCache->prefetch(paths);
+        m_hashCache->waitForDone();
+    }
+
+    QList<QThread*> workers;
+    int workerCount = qMin(m_clients.size(), static_cast<int>(items.size()));
+    for (int w = 0; w < workerCount; ++w) {
+        FtpClient *client = m_clients.at(w);
+        workers.append(QThread::create([this, client, &items, &prints, &next]() {
+            for (int i = next++; i < items.size() && !m_cancelled; i = next++) {
+                prints[i] = fingerprint(client, *items[i]);
+                ++m_processedFiles;
+            }
+        }));
+        workers.last()->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    if (m_cancelled) {
+        m_lastError = "查找已取消";
+        return QVector<QByteArray>();
+    }
+    return prints;
+}
+
+/**
+ * @brief 并行计算一批候选组的指纹并写出重复组
+ * @param groups 候选组
+ * @param report 报告文件
+ * @return 操作是否成功
+ */
+bool DuplicateFinder::processBatch(const QList<QList<IndexRecord>> &groups, QFile &report)
+{
+    // 展平为一个数组，工作线程通过原子下标领取文件
+    QVector<const IndexRecord*> items;
+    for (const QList<IndexRecord> &group : groups) {
+        for (const IndexRecord &record : group) {
+            items.append(&record);
+        }
+    }
+    QVector<QByteArray> prints = fingerprintAll(items);
+    if (prints.size() != items.size()) {
+        return false;
+    }
+
+    // 按组内指纹归类，写出每个重复组
+    int offset = 0;
+    for (const QList<IndexRecord> &group : groups) {
+        QHash<QByteArray, QStringList> byPrint;
+        QList<QByteArray> order;
+        for (int i = 0; i < group.size(); ++i) {
+            const QByteArray &print = prints.at(offset + i);
+            if (print.isEmpty()) {
+                ++m_summary.failedFiles;
+                continue;
+            }
+            if (!byPrint.contains(print)) {
+                order.append(print);
+            }
+            byPrint[print].append(group.at(i).path);
+        }
+
+        qint64 size = group.first().size;
+        for (const QByteArray &print : order) {
+            const QStringList &paths = byPrint.value(print);
+            if (paths.size() < 2) {
+                continue;
+            }
+            QByteArray block = groupHeader(size, paths.size(), print);
+            block += paths.join('\n').toUtf8();
+            block += "\n\n";
+            if (report.write(block) < 0) {
+                m_lastError = QString("写入报告失败: %1").arg(report.errorString());
+                return false;
+            }
+        }
+        offset += group.size();
+    }
+
+    return true;
+}
+
+/**
+ * @brief 计算一段大组文件的指纹并追加到临时文件
+ * @param records 同一大小的一段文件
+ * @param spill 临时文件，每行一条"指纹\t路径"作为路径字段的索引记录
+ * @return 操作是否成功
+ */
+bool DuplicateFinder::spillRecords(const QList<IndexRecord> &records, QFile &spill)
+{
+    QVector<const IndexRecord*> items;
+    for (const IndexRecord &record : records) {
+        items.append(&record);
+    }
+    QVector<QByteArray> prints = fingerprintAll(items);
+    if (prints.size() != items.size()) {
+        return false;
+    }
+
+    for (int i = 0; i < items.size(); ++i) {
+        if (prints.at(i).isEmpty()) {
+            ++m_summary.failedFiles;
+            continue;
+        }
+        // 指纹不含制表符，按路径排序后相同指纹的记录相邻
+        IndexRecord keyed = *items.at(i);
+        keyed.path = QString::fromLatin1(prints.at(i)) + '\t' + keyed.path;
+        if (spill.write(RemoteIndex::formatRecord(keyed)) < 0) {
+            m_lastError = QString("写入临时文件失败: %1").arg(spill.errorString());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 把临时文件中的大组按指纹外部排序后写出重复组
+ * @param spill 临时文件，调用后被关闭并删除
+ * @param size 组内文件大小
+ * @param report 报告文件
+ * @return 操作是否成功
+ */
+bool DuplicateFinder::reportSpilledGroup(QFile &spill, qint64 size, QFile &report)
+{
+    spill.close();
+    QString sortedPath = spill.fileName() + ".sorted";
+    auto cleanup = qScopeGuard([&]() {
+        QFile::remove(spill.fileName());
+        QFile::remove(sortedPath);
+    });
+
+    RemoteIndex sorter;
+    if (!sorter.sortByPath(spill.fileName(), sortedPath)) {
+        m_lastError = sorter.lastError();
+        return false;
+    }
+    QFile sorted(sortedPath);
+    if (!sorted.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("无法打开临时文件: %1").arg(sortedPath);
+        return false;
+    }
+
+    // 同一指纹的文件可能也很多：先数出个数写组头，再回到组开头逐行复制路径
+    QByteArray current;
+    qint64 start = 0;
+    qint64 count = 0;
+    auto writeGroup = [&]() -> bool {
+        if (count < 2) {
+            return true;
+        }
+        qint64 resume = sorted.pos();
+        if (report.write(groupHeader(size, count, current)) < 0 || !sorted.seek(start)) {
+            m_lastError = QString("写入报告失败: %1").arg(report.errorString());
+            return false;
+        }
+        for (qint64 i = 0; i < count; ++i) {
+            IndexRecord record;
+            RemoteIndex::parseRecord(sorted.readLine(), &record);
+            QByteArray path = record.path.section('\t', 1).toUtf8();
+            if (report.write(path + '\n') < 0) {
+                m_lastError = QString("写入报告失败: %1").arg(report.errorString());
+                return false;
+            }
+        }
+        report.write("\n");
+        return sorted.seek(resume);
+    };
+
+    while (!sorted.atEnd()) {
+        qint64 position = sorted.pos();
+        IndexRecord record;
+        if (!RemoteIndex::parseRecord(sorted.readLine(), &record)) {
+            continue;
+        }
+        QByteArray print = record.path.section('\t', 0, 0).toLatin1();
+        if (print != current) {
+            if (!writeGroup()) {
+                return false;
+            }
+            current = print;
+            start = position;
+            count = 0;
+        }
+        ++count;
+    }
+    return writeGroup();
+}
+
+/**
+ * @brief 生成重复组的报告头并计入汇总
+ * @param size 文件大小
+ * @param copies 副本数
+ * @param print 指纹
+ * @return 报告头行
+ */
+QByteArray DuplicateFinder::groupHeader(qint64 size, qint64 copies, const QByteArray &print)
+{
+    ++m_summary.duplicateGroups;
+    m_summary.duplicateFiles += copies - 1;
+    m_summary.reclaimableBytes += size * (copies - 1);
+    return QString("# size=%1 copies=%2 reclaimable=%3 fingerprint=%4\n")
+               .arg(size).arg(copies).arg(size * (copies - 1))
+               .arg(QString::fromLatin1(print)).toUtf8();
+}
+
+/**
+ * @brief 计算单个文件的指纹
+ * @param client 该工作线程使用的客户端
+ * @param record 文件记录
+ * @return 指纹，失败时为空
+ */
+QByteArray DuplicateFinder::fingerprint(FtpClient *client, const IndexRecord &record)
+{
+    if (!m_localRoot.isEmpty()) {
+        QByteArray digest = m_hashCache->digest(m_localRoot + record.path);
+        return digest.isEmpty() ? QByteArray() : "sha-256:" + digest;
+    }
+
+    // 服务器端摘要不需要传输文件内容，只要服务器未被确认不支持就优先使用
+    if (m_hashSupport >= 0) {
+        QString algorithm;
+        QString digest;
+        if (client->remoteHash(record.path, &algorithm, &digest)) {
+            m_hashSupport = 1;
+            return (algorithm + ":" + digest).toLatin1();
+        }
+        // 从未成功过的HASH失败视为服务器不支持；已确认支持时则是该文件本身出错
+        int unknown = 0;
+        if (!m_hashSupport.compare_exchange_strong(unknown, -1) && m_hashSupport > 0) {
+            return QByteArray();
+        }
+    }
+
+    // 抽样指纹：小文件完整读取，大文件读取开头、中间和结尾三个区间
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QList<qint64> offsets;
+    qint64 length = m_sampleSize;
+    if (record.size <= 3 * m_sampleSize) {
+        offsets << 0;
+        length = record.size;
+    } else {
+        offsets << 0 << (record.size - m_sampleSize) / 2 << record.size - m_sampleSize;
+        m_sampled = true;
+    }
+
+    for (qint64 offset : offsets) {
+        QByteArray data;
+        if (!client->readRange(record.path, offset, length, &data) || data.size() != length) {
+            return QByteArray();
+        }
+        hash.addData(data);
+    }
+
+    QByteArray prefix = offsets.size() == 1 ? "sha-256:" : "sampled-sha-256:";
+    return prefix + hash.result().toHex();
+}
@@ -0,0 +1,188 @@
+/**
+ * @file duplicatefinder.h
+ * @brief 远程重复文件查找
+ * @details 基于按大小排序的远程索引查找重复文件
+ *
+ * 查找分两步：
+ * 1. 顺序读取按大小排序的索引，大小相同的文件构成候选组，大小唯一的文件直接排除
+ * 2. 对候选文件并行计算指纹：服务器支持HASH命令时使用服务器端摘要，
+ *    否则读取文件开头、中间、结尾的若干区间计算抽样指纹；
+ *    本地目录（file://）上设置了HashCache时直接使用缓存的完整摘要，只有变化过的文件才重新计算
+ * 内存中最多只保留一批候选组；同一大小的文件超过一批时分段计算指纹写入临时文件，
+ * 再外部排序归类，适用于千万级条目的索引
+ */
+
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QFile>
+#include <atomic>
+#include "ftpclient.h"
+#include "remoteindex.h"
+
+class HashCache;
+
+/**
+ * @struct DuplicateSummary
+ * @brief 重复文件查找结果汇总
+ */
+struct DuplicateSummary {
+    qint64 scannedFiles = 0;     ///< 索引中的文件数
+    qint64 candidateFiles = 0;   ///< 与其他文件大小相同的候选文件数
+    qint64 duplicateGroups = 0;  ///< 确认的重复组数
+    qint64 duplicateFiles = 0;   ///< 可删除的多余副本数（每组保留一份）
+    qint64 reclaimableBytes = 0; ///< 删除多余副本后可回收的字节数
+    qint64 failedFiles = 0;      ///< 无法计算指纹的文件数
+    bool sampled = false;        ///< 是否有文件使用抽样指纹（可能存在误判）
+};
+
+/**
+ * @class DuplicateFinder
+ * @brief 远程重复文件查找器
+ *
+ * 指纹计算使用独立的客户端连接并行进行，不占用主窗口的连接
+ */
+class DuplicateFinder
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    DuplicateFinder();
+
+    /**
+     * @brief 设置服务器连接参数
+     * @param server 服务器地址
+     * @param port 端口号
+     * @param username 用户名
+     * @param password 密码
+     */
+    void setConnection(const QString &server, int port, const QString &username, const QString &password);
+
+    /**
+     * @brief 设置并行连接数
+     * @param connections 计算指纹时使用的连接数
+     */
+    void setParallelism(int connections) { m_parallelism = qMax(1, connections); }
+
+    /**
+     * @brief 设置抽样区间大小
+     * @param bytes 每个抽样区间的字节数，不超过三个区间大小的文件会被完整读取
+     */
+    void setSampleSize(qint64 bytes) { m_sampleSize = qMax<qint64>(4096, bytes); }
+
+    /**
+     * @brief 设置每批处理的候选文件数
+     * @param files 累积到该数量后并行计算指纹，决定内存占用上限
+     */
+    void setBatchSize(int files) { m_batchSize = qMax(1, files); }
+
+    /**
+     * @brief 设置本地文件摘要缓存
+     * @param cache 缓存，为空时不使用；由调用方持有
+     *
+     * 只用于本地目录（file://）：候选文件的完整摘要先在缓存的线程池中并行补齐，再按摘要比较
+     */
+    void setHashCache(HashCache *cache) { m_hashCache = cache; }
+
+    /**
+     * @brief 在按大小排序的索引中查找重复文件
+     * @param sortedIndexPath 按大小排序的索引文件（见RemoteIndex::sortBySize）
+     * @param reportPath 输出报告文件，每个重复组一段
+     * @return 操作是否成功
+     */
+    bool run(const QString &sortedIndexPath, const QString &reportPath);
+
+    /**
+     * @brief 中止查找，可以从其他线程调用；之后的run()也会立即失败
+     */
+    void cancel() { m_cancelled = true; }
+
+    /**
+     * @brief 已计算指纹的文件数，查找进行中也可以从其他线程读取
+     */
+    qint64 processedFiles() const { return m_processedFiles; }
+
+    /**
+     * @brief 获取结果汇总
+     */
+    DuplicateSummary summary() const { return m_summary; }
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    /**
+     * @brief 并行计算一批候选组的指纹并写出重复组
+     * @param groups 候选组，每组内文件大小相同
+     * @param report 报告文件
+     * @return 操作是否成功
+     */
+    bool processBatch(const QList<QList<IndexRecord>> &groups, QFile &report);
+
+    /**
+     * @brief 用所有工作连接并行计算一组文件的指纹
+     * @param items 文件记录
+     * @return 与items一一对应的指纹，失败的文件为空；被中止时返回空列表
+     */
+    QVector<QByteArray> fingerprintAll(const QVector<const IndexRecord*> &items);
+
+    /**
+     * @brief 计算一段大组文件的指纹并追加到临时文件
+     * @param records 同一大小的一段文件
+     * @param spill 临时文件
+     * @return 操作是否成功
+     */
+    bool spillRecords(const QList<IndexRecord> &records, QFile &spill);
+
+    /**
+     * @brief 把临时文件中的大组按指纹外部排序后写出重复组
+     * @param spill 临时文件，调用后被关闭并删除
+     * @param size 组内文件大小
+     * @param report 报告文件
+     * @return 操作是否成功
+     */
+    bool reportSpilledGroup(QFile &spill, qint64 size, QFile &report);
+
+    /**
+     * @brief 生成重复组的报告头并计入汇总
+     * @param size 文件大小
+     * @param copies 副本数
+     * @param print 指纹
+     * @return 报告头行
+     */
+    QByteArray groupHeader(qint64 size, qint64 copies, const QByteArray &print);
+
+    /**
+     * @brief 计算单个文件的指纹
+     * @param client 该工作线程使用的客户端
+     * @param record 文件记录
+     * @return 指纹，失败时为空
+     */
+    QByteArray fingerprint(FtpClient *client, const IndexRecord &record);
+
+private:
+    QString m_server;                 ///< 服务器地址
+    int m_port;                       ///< 端口号
+    QString m_username;               ///< 用户名
+    QString m_password;               ///< 密码
+    int m_parallelism;                ///< 并行连接数
+    qint64 m_sampleSize;              ///< 抽样区间大小
+    int m_batchSize;                  ///< 每批候选文件数
+    QList<FtpClient*> m_clients;      ///< 工作连接
+    HashCache *m_hashCache;           ///< 本地文件摘要缓存（不归本对象所有）
+    QString m_localRoot;              ///< 本地目录服务器的根目录，非本地服务器时为空
+    std::atomic<int> m_hashSupport;   ///< HASH命令支持状态：0未知，1支持，-1不支持
+    std::atomic<bool> m_sampled;      ///< 是否使用过抽样指纹
+    std::atomic<qint64> m_processedFiles; ///< 已计算指纹的文件数
+    std::atomic<bool> m_cancelled;    ///< 是否已请求中止
+    DuplicateSummary m_summary;       ///< 结果汇总
+    QString m_lastError;              ///< 最后一个错误信息
+};
+
+#endif // DUPLICATEFINDER_H
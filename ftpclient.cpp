@@ -7,24 +7,126 @@
  */
 
 #include "ftpclient.h"
+#include "downloadqueue.h"
+#include "blockmodesession.h"
+#include "hotpathtrace.h"
+#include "uploadsource.h"
 #include <QDir>
 #include <QFileInfo>
 #include <QRegularExpression>
+#include <QSet>
+#include <QUrl>
+#include <QLocale>
+#include <QThread>
+#include <QTimeZone>
+#include <QBuffer>
+#include <QTemporaryFile>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QNetworkInterface>
+#include <QDataStream>
+
+/**
+ * @struct MultiTransfer
+ * @brief 并发传输中单个CURL句柄的上下文
+ * 
+ * 多路复用批量下载和分段下载共用此结构，每个句柄写入各自的本地文件（或文件中的一段）
+ */
+struct MultiTransfer {
+    FtpClient *client = nullptr;     ///< 所属的客户端
+    CURL *handle = nullptr;          ///< CURL句柄
+    QIODevice *file = nullptr;       ///< 本地输出文件（普通文件或加密输出）
+    QString remotePath;              ///< 远程文件路径
+    QString localPath;               ///< 本地文件路径（内存缓冲的小文件在完成后落盘）
+    bool buffered = false;           ///< 是否先下载到内存缓冲
+    QString interfaceName;           ///< 绑定的本地接口
+    qint64 received = 0;             ///< 已接收字节数
+    qint64 limit = -1;               ///< 允许接收的最大字节数，-1表示不限制
+    bool done = false;               ///< 传输是否已结束
+    CURLcode result = CURLE_OK;      ///< 传输结果
+    qint64 startAt = -1;             ///< 模拟延迟结束、加入多路句柄的时间（链路计时毫秒），-1表示尚未开始等待
+    qint64 resumeAt = -1;            ///< 超出模拟带宽而暂停时恢复的时间（链路计时毫秒），-1表示未暂停
+};
+
+/**
+ * @brief 并发传输写入回调函数
+ * @param contents 接收到的数据
+ * @param size 数据块大小
+ * @param nmemb 数据块数量
+ * @param userp 指向MultiTransfer的指针
+ * @return 实际写入的数据大小，返回值与输入不一致时CURL会中止该传输
+ */
+size_t FtpClient::MultiWriteCallback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    MultiTransfer *transfer = static_cast<MultiTransfer*>(userp);
+    size_t realsize = size * nmemb;
+    HOTPATH_SPAN(callbackSpan, Callback, realsize);
+    
+    // 模拟链路带宽限制：链路超出带宽时只暂停这个传输，不在回调中休眠阻塞整组传输；
+    // 恢复后libcurl重新交付同一数据
+    {
+        HOTPATH_SPAN(throttleSpan, Throttle, realsize);
+        qint64 delayMs = transfer->client->linkDelay(static_cast<qint64>(realsize));
+        if (delayMs > 0) {
+            transfer->resumeAt = transfer->client->m_linkTimer.elapsed() + delayMs;
+            return CURL_WRITEFUNC_PAUSE;
+        }
+    }
+    
+    // 服务器忽略Range请求而返回完整内容时，超出分段范围的数据会覆盖相邻分段，必须中止
+    if (transfer->limit >= 0 && transfer->received + static_cast<qint64>(realsize) > transfer->limit) {
+        return 0;
+    }
+    
+    qint64 written;
+    {
+        HOTPATH_SPAN(sinkSpan, Sink, realsize);
+        written = transfer->file->write(static_cast<char*>(contents), realsize);
+    }
+    if (written > 0) {
+        transfer->received += written;
+    }
+    
+    return written < 0 ? 0 : static_cast<size_t>(written);
+}
 
 /**
  * @brief 构造函数，初始化资源
  */
 FtpClient::FtpClient()
     : m_curl(nullptr)
+    , m_rangeHandle(nullptr)
     , m_headers(nullptr)
     , m_isConnected(false)
+    , m_isHttp(false)
+    , m_isLocal(false)
+    , m_useTls(false)
     , m_port(21)
     , m_currentDownloadFile(nullptr)
     , m_totalBytesReceived(0)
+    , m_currentUploadSource(nullptr)
+    , m_localPort(0)
+    , m_localPortRange(0)
+    , m_nextInterface(0)
+    , m_simulatedLatencyMs(0)
+    , m_simulatedBytesPerSecond(0)
+    , m_linkBytes(0)
+    , m_crawlMode(FullListCrawl)
+    , m_mlsdUnsupported(false)
+    , m_encryptionCipher(EncryptedFileSink::Aes256Gcm)
+    , m_localWriter(nullptr)
+    , m_listingCache(nullptr)
+    , m_budget(nullptr)
+    , m_crawlQueueBytes(0)
+    , m_crawlSpill(nullptr)
+    , m_blockModeEnabled(true)
+    , m_blockModeState(0)
+    , m_blockProbe(nullptr)
+    , m_prewarmDepth(1)
+    , m_maxHostConnections(0)
+    , m_curlInitialized(false)
 {
-    // 初始化 libcurl 全局环境
-    curl_global_init(CURL_GLOBAL_ALL);
-    m_curl = curl_easy_init();
+    // libcurl全局初始化会加载TLS库，推迟到initialize()，不占用启动时间
 }
 
 /**
@@ -32,10 +134,11 @@ FtpClient::FtpClient()
  */
 FtpClient::~FtpClient()
 {
-    // 清理下载相关资源
+    waitForBlockModeProbe();
+    
+    // 清理下载相关资源，未完成的输出保持可续传状态
     if (m_currentDownloadFile) {
-        m_currentDownloadFile->close();
-        delete m_currentDownloadFile;
+        closeOutput(m_currentDownloadFile, false);
         m_currentDownloadFile = nullptr;
     }
     
@@ -47,7 +150,45 @@ FtpClient::~FtpClient()
         curl_easy_cleanup(m_curl);
     }
     
-    curl_global_cleanup();
+    if (m_rangeHandle) {
+        curl_easy_cleanup(m_rangeHandle);
+    }
+    
+    // 没有被取走的溢出文件
+    QString spill = takeCrawlSpill();
+    if (!spill.isEmpty()) {
+        QFile::remove(spill);
+    }
+    
+    if (m_curlInitialized) {
+        curl_global_cleanup();
+    }
+}
+
+/**
+ * @brief 初始化libcurl全局环境和主连接句柄
+ * @return 操作是否成功
+ */
+bool FtpClient::initialize()
+{
+    if (m_curl) {
+        return true;
+    }
+    // curl_global_init按引用计数，每个客户端各自初始化一次，析构时对应清理
+    if (!m_curlInitialized) {
+        CURLcode res = curl_global_init(CURL_GLOBAL_ALL);
+        if (res != CURLE_OK) {
+            m_lastError = QString("CURL初始化失败: %1").arg(curl_easy_strerror(res));
+            return false;
+        }
+        m_curlInitialized = true;
+    }
+    m_curl = curl_easy_init();
+    if (!m_curl) {
+        m_lastError = "CURL未初始化";
+        return false;
+    }
+    return true;
 }
 
 /**
@@ -60,8 +201,7 @@ FtpClient::~FtpClient()
  */
 bool FtpClient::connect(const QString &server, int port, const QString &username, const QString &password)
 {
-    if (!m_curl) {
-        m_lastError = "CURL未初始化";
+    if (!initialize()) {
         return false;
     }
     
@@ -75,31 +215,49 @@ bool FtpClient::connect(const QString &server, int port, const QString &username
     m_port = port;
     m_username = username;
     m_password = password;
+    m_mlsdUnsupported = false;
+    m_blockModeState = 0;
+    if (m_listingCache) {
+        m_listingCache->clear();
+    }
     
-    // 构建FTP URL
-    QString ftpUrl = m_server;
-    if (!ftpUrl.startsWith("ftp://")) {
-        ftpUrl = "ftp://" + ftpUrl;
+    // 根据URL协议选择传输方式，未指定协议时默认使用FTP
+    QString baseUrl = serverBaseUrl();
+    m_isHttp = baseUrl.startsWith("http://", Qt::CaseInsensitive)
+            || baseUrl.startsWith("https://", Qt::CaseInsensitive);
+    m_isLocal = baseUrl.startsWith("file://", Qt::CaseInsensitive);
+    
+    // 本地目录传输只需确认目录存在
+    if (m_isLocal) {
+        simulateLatency();
+        if (!QFileInfo(localRoot()).isDir()) {
+            m_lastError = QString("连接失败: 本地目录不存在: %1").arg(localRoot());
+            return false;
+        }
+        m_isConnected = true;
+        return true;
     }
 
     // 设置CURL选项
-    curl_easy_setopt(m_curl, CURLOPT_URL, ftpUrl.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PORT, m_port);
-    curl_easy_setopt(m_curl, CURLOPT_USERNAME, m_username.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PASSWORD, m_password.toUtf8().constData());
+    curl_easy_setopt(m_curl, CURLOPT_URL, (baseUrl + "/").toUtf8().constData());
+    applyCommonOptions(m_curl);
     curl_easy_setopt(m_curl, CURLOPT_VERBOSE, 1L);
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, WriteCallback);
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, this);
+    QString interfaceName = applyLocalBinding(m_curl);
 
     // 执行连接测试
-    m_listBuffer.clear();
+    m_receiveBuffer.clear();
     CURLcode res = curl_easy_perform(m_curl);
+    m_receiveBuffer.clear();
+    recordInterfaceUsage(m_curl, interfaceName);
     if (res != CURLE_OK) {
         m_lastError = QString("连接失败: %1").arg(curl_easy_strerror(res));
         return false;
     }
 
     m_isConnected = true;
+    startBlockModeProbe();
     return true;
 }
 
@@ -108,11 +266,19 @@ bool FtpClient::connect(const QString &server, int port, const QString &username
  */
 void FtpClient::disconnect()
 {
+    waitForBlockModeProbe();
+    
     if (m_curl) {
         curl_easy_cleanup(m_curl);
         m_curl = curl_easy_init();
     }
     
+    if (m_rangeHandle) {
+        curl_easy_cleanup(m_rangeHandle);
+        m_rangeHandle = nullptr;
+    }
+    
+    m_blockSession.reset();
     m_isConnected = false;
 }
 
@@ -128,65 +294,48 @@ QStringList FtpClient::listDirectory(const QString &path)
         return QStringList();
     }
 
-    // 清空接收缓冲区
-    m_listBuffer.clear();
-    
-    // 移除可能存在的\r字符，确保路径格式正确
-    QString cleanPath = path;
-    cleanPath.remove('\r');
-    
-    // 构建完整的URL，用于FTP请求
-    QString server = m_server;
-    if (!server.startsWith("ftp://")) {
-        server = "ftp://" + server;
-    }
-    
-    // 确保server不以/结尾，而path以/开头
-    if (server.endsWith("/")) {
-        server.chop(1);
-    }
-    
-    // 规范化路径格式
-    QString normalizedPath = cleanPath;
-    if (!normalizedPath.startsWith("/")) {
-        normalizedPath = "/" + normalizedPath;
+    // 本地传输直接读取目录
+    if (m_isLocal) {
+        QStringList lines;
+        localListing(path, &lines);
+        return lines;
     }
-    // 确保路径以/结尾，这对于FTP目录浏览很重要
-    if (!normalizedPath.endsWith("/")) {
-        normalizedPath += "/";
+
+    QStringList cached;
+    if (m_listingCache && m_listingCache->lookup(path, &cached)) {
+        return cached;
     }
+
+    // 清空接收缓冲区
+    m_receiveBuffer.clear();
     
-    // 对URL进行编码处理
-    QByteArray pathUtf8 = normalizedPath.toUtf8();
-    char *escapedPath = curl_easy_escape(m_curl, pathUtf8.constData(), pathUtf8.length());
-    
-    // 替换掉编码后的斜杠，因为我们需要保留路径结构
-    QString encodedPath = QString(escapedPath);
-    encodedPath.replace("%2F", "/");
-    
-    QString fullUrl = server + encodedPath;
-    
-    // 释放CURL分配的内存
-    curl_free(escapedPath);
+    // 构建完整的URL，目录路径需要以/结尾，这对于FTP目录浏览很重要
+    QString fullUrl = buildUrl(path, true);
     
     // 设置CURL选项
     curl_easy_setopt(m_curl, CURLOPT_URL, fullUrl.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_USERNAME, m_username.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PASSWORD, m_password.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PORT, m_port);
+    applyCommonOptions(m_curl);
+    curl_easy_setopt(m_curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(0));
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, WriteCallback);
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, this);
     curl_easy_setopt(m_curl, CURLOPT_DIRLISTONLY, 0L);
+    QString interfaceName = applyLocalBinding(m_curl);
 
     // 执行列表命令
+    simulateLatency();
     CURLcode res = curl_easy_perform(m_curl);
+    recordInterfaceUsage(m_curl, interfaceName);
     if (res != CURLE_OK) {
         m_lastError = QString("获取目录列表失败: %1").arg(curl_easy_strerror(res));
         return QStringList();
     }
 
     // 返回目录列表数据
-    return m_listBuffer;
+    QStringList lines = takeReceivedLines();
+    if (m_listingCache) {
+        m_listingCache->insert(path, lines);
+    }
+    return lines;
 }
 
 /**
@@ -197,7 +346,8 @@ QStringList FtpClient::listDirectory(const QString &path)
  * @return 下载是否成功
  */
 bool FtpClient::downloadFile(const QString &remotePath, const QString &localPath, 
-                            std::function<void(qint64, qint64)> progressCallback)
+                            std::function<void(qint64, qint64)> progressCallback,
+                            qint64 resumeOffset, qint64 remoteSize)
 {
     if (!m_curl || !m_isConnected) {
         m_lastError = "未连接到FTP服务器";
@@ -206,185 +356,726 @@ bool FtpClient::downloadFile(const QString &remotePath, const QString &localPath
     
     // 保存回调函数
     m_progressCallback = progressCallback;
+    m_transferInfo.clear();
     
-    // 创建本地文件
-    m_currentDownloadFile = new QFile(localPath);
-    if (!m_currentDownloadFile->open(QIODevice::WriteOnly)) {
-        m_lastError = QString("无法创建本地文件: %1").arg(localPath);
-        delete m_currentDownloadFile;
-        m_currentDownloadFile = nullptr;
+    // 创建本地文件，续传时以追加方式打开已有的部分文件
+    m_currentDownloadFile = openOutput(localPath, resumeOffset);
+    if (!m_currentDownloadFile) {
         return false;
     }
-    
-    // 重置已接收字节数
-    m_totalBytesReceived = 0;
-    
-    // 构建完整的URL
-    QString server = m_server;
-    if (!server.startsWith("ftp://")) {
-        server = "ftp://" + server;
-    }
-    
-    // 确保server不以/结尾
-    if (server.endsWith("/")) {
-        server.chop(1);
-    }
-    
-    // 确保remotePath以/开头
-    QString normalizedPath = remotePath;
-    if (!normalizedPath.startsWith("/")) {
-        normalizedPath = "/" + normalizedPath;
+    // 下载进行中的标记不可续传，进程中途退出后下次从头下载
+    if (remoteSize > 0) {
+        writeResumeMarker(localPath, remotePath, remoteSize, -1);
     }
     
-    // 对URL进行编码处理
-    QByteArray pathUtf8 = normalizedPath.toUtf8();
-    char *escapedPath = curl_easy_escape(m_curl, pathUtf8.constData(), pathUtf8.length());
-    
-    // 替换掉编码后的斜杠，因为我们需要保留路径结构
-    QString encodedPath = QString(escapedPath);
-    encodedPath.replace("%2F", "/");
-    
-    QString fullUrl = server + encodedPath;
+    // 重置已接收字节数，续传时从已有的字节数开始计算
+    m_totalBytesReceived = resumeOffset;
     
-    // 释放CURL分配的内存
-    curl_free(escapedPath);
+    // 构建完整的URL
+    QString fullUrl = buildUrl(remotePath, false);
     
-    // 设置CURL选项
+    // 设置CURL选项，续传时FTP使用REST命令，HTTP使用Range请求
     curl_easy_setopt(m_curl, CURLOPT_URL, fullUrl.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_USERNAME, m_username.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PASSWORD, m_password.toUtf8().constData());
-    curl_easy_setopt(m_curl, CURLOPT_PORT, m_port);
+    applyCommonOptions(m_curl);
+    curl_easy_setopt(m_curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(resumeOffset));
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, DownloadCallback);
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, this);
+    QString interfaceName = applyLocalBinding(m_curl);
     
     // 执行下载
+    simulateLatency();
+    m_linkBytes = 0;
+    m_linkTimer.start();
     CURLcode res = curl_easy_perform(m_curl);
+    recordInterfaceUsage(m_curl, interfaceName);
+    recordTransferInfo(m_curl, remotePath, res);
     
-    // 关闭文件
-    m_currentDownloadFile->close();
-    delete m_currentDownloadFile;
+    // 关闭文件，只有下载成功时才写入加密输出的最后一块
+    bool closed = closeOutput(m_currentDownloadFile, res == CURLE_OK);
     m_currentDownloadFile = nullptr;
+    curl_easy_setopt(m_curl, CURLOPT_RESUME_FROM_LARGE, static_cast<curl_off_t>(0));
+    
+    // 完成后删除续传标记，中断时记下本地文件的大小，下次只有大小未变才续传
+    if (remoteSize > 0) {
+        if (res == CURLE_OK && closed) {
+            QFile::remove(localPath + ".part");
+        } else {
+            writeResumeMarker(localPath, remotePath, remoteSize, QFileInfo(localPath).size());
+        }
+    }
+    
+    // 服务器不支持断点续传时，从头重新下载
+    if (resumeOffset > 0 && (res == CURLE_RANGE_ERROR || res == CURLE_BAD_DOWNLOAD_RESUME)) {
+        bool retried = downloadFile(remotePath, localPath, progressCallback, 0, remoteSize);
+        TransferRecord &info = m_transferInfo[remotePath];
+        info.remotePath = remotePath;
+        info.retries += 1;
+        return retried;
+    }
     
     if (res != CURLE_OK) {
         m_lastError = QString("下载文件失败: %1").arg(curl_easy_strerror(res));
         return false;
     }
     
-    return true;
+    return closed;
 }
 
 /**
- * @brief 下载目录
- * @param remotePath 远程目录路径
- * @param localPath 本地保存路径
+ * @brief 流式上传文件
+ * @param source 上传数据源
+ * @param remotePath 远程文件路径
  * @param progressCallback 进度回调函数
- * @param taskQueue 下载任务队列，用于存储待下载的文件任务
- * @return 下载是否成功
+ * @return 上传是否成功
  */
-bool FtpClient::downloadDirectory(const QString &remotePath, const QString &localPath,
-                                 std::function<void(qint64, qint64)> progressCallback,
-                                 QQueue<DownloadTask> *taskQueue)
+bool FtpClient::uploadFile(UploadSource *source, const QString &remotePath,
+                           std::function<void(qint64, qint64)> progressCallback)
 {
-    // 创建本地目录
-    if (!createLocalDirectory(localPath)) {
-        m_lastError = QString("无法创建本地目录: %1").arg(localPath);
+    if (!m_curl || !m_isConnected) {
+        m_lastError = "未连接到FTP服务器";
+        return false;
+    }
+    if (!source || !source->open()) {
+        m_lastError = QString("无法打开上传数据源: %1").arg(source ? source->lastError() : QString());
+        return false;
+    }
+    
+    m_progressCallback = progressCallback;
+    m_currentUploadSource = source;
+    m_transferInfo.clear();
+    
+    // 大小未知时传-1，FTP上STOR直到数据结束，HTTP上使用分块传输
+    QString fullUrl = buildUrl(remotePath, false);
+    curl_easy_setopt(m_curl, CURLOPT_URL, fullUrl.toUtf8().constData());
+    applyCommonOptions(m_curl);
+    curl_easy_setopt(m_curl, CURLOPT_UPLOAD, 1L);
+    curl_easy_setopt(m_curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(source->size()));
+    curl_easy_setopt(m_curl, CURLOPT_READFUNCTION, UploadCallback);
+    curl_easy_setopt(m_curl, CURLOPT_READDATA, this);
+    // 较大的发送缓冲减少回调次数，数据源的双缓冲仍能让读取和发送重叠
+    curl_easy_setopt(m_curl, CURLOPT_UPLOAD_BUFFERSIZE, 512L * 1024);
+    QString interfaceName = applyLocalBinding(m_curl);
+    
+    // 执行上传
+    simulateLatency();
+    m_linkBytes = 0;
+    m_linkTimer.start();
+    CURLcode res = curl_easy_perform(m_curl);
+    recordInterfaceUsage(m_curl, interfaceName);
+    recordTransferInfo(m_curl, remotePath, res);
+    
+    // 恢复下载使用的选项
+    curl_easy_setopt(m_curl, CURLOPT_UPLOAD, 0L);
+    curl_easy_setopt(m_curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(-1));
+    curl_easy_setopt(m_curl, CURLOPT_READFUNCTION, nullptr);
+    curl_easy_setopt(m_curl, CURLOPT_READDATA, nullptr);
+    m_currentUploadSource = nullptr;
+    QString sourceError = source->lastError();
+    source->close();
+    
+    if (res != CURLE_OK) {
+        // 数据源出错时由回调中止传输，报告数据源的原因
+        if (res == CURLE_ABORTED_BY_CALLBACK && !sourceError.isEmpty()) {
+            m_lastError = QString("上传文件失败: %1").arg(sourceError);
+        } else {
+            m_lastError = QString("上传文件失败: %1").arg(curl_easy_strerror(res));
+        }
         return false;
     }
     
-    // 列出目录内容并创建目录结构、添加文件到下载队列
-    return listDirectoryForDownload(remotePath, localPath, progressCallback, taskQueue);
+    return true;
 }
 
 /**
- * @brief 列出目录内容用于下载
- * @param path 要列出的目录路径
- * @param targetDir 本地目标目录
- * @param progressCallback 进度回调函数
- * @param taskQueue 下载任务队列，用于存储待下载的文件任务
- * @return 操作是否成功
+ * @brief 批量下载多个文件
+ * @param tasks 下载任务列表
+ * @param progressCallback 进度回调函数，报告整批的已接收字节数和总字节数
+ * @param failedFiles 输出下载失败的远程路径（可选）
+ * @return 是否全部下载成功
  */
-bool FtpClient::listDirectoryForDownload(const QString &path, const QString &targetDir,
-                                        std::function<void(qint64, qint64)> progressCallback,
-                                        QQueue<DownloadTask> *taskQueue)
+bool FtpClient::downloadFiles(const QList<DownloadTask> &tasks,
+                              std::function<void(qint64, qint64)> progressCallback,
+                              QStringList *failedFiles)
 {
     if (!m_curl || !m_isConnected) {
         m_lastError = "未连接到FTP服务器";
         return false;
     }
     
-    // 清空列表缓冲区
-    m_listBuffer.clear();
+    bool success = true;
+    qint64 bytesTotal = 0;
+    QList<MultiTransfer*> transfers;
+    m_transferInfo.clear();
     
-    // 构建完整的URL
-    QString server = m_server;
-    if (!server.startsWith("ftp://")) {
-        server = "ftp://" + server;
+    // 支持块模式的FTP服务器上，所有文件共用一个数据连接依次传输；会话中断后剩余文件退回流模式
+    QList<DownloadTask> streamTasks = tasks;
+    if (ensureBlockSession()) {
+        QList<DownloadTask> remaining;
+        success = downloadFilesBlockMode(tasks, progressCallback, failedFiles, &remaining);
+        if (remaining.isEmpty()) {
+            return success;
+        }
+        streamTasks = remaining;
     }
     
-    // 确保server不以/结尾，而path以/开头
-    if (server.endsWith("/")) {
-        server.chop(1);
+    for (const DownloadTask &task : streamTasks) {
+        MultiTransfer *transfer = new MultiTransfer;
+        transfer->remotePath = task.remotePath;
+        transfer->localPath = task.localPath;
+        if (m_localWriter && !isEncrypting() && task.fileSize > 0
+            && task.fileSize <= m_localWriter->tinyFileLimit()) {
+            // 小文件先下载到内存，完成后交给落盘线程池批量创建和写入
+            QBuffer *buffer = new QBuffer;
+            buffer->open(QIODevice::WriteOnly);
+            transfer->file = buffer;
+            transfer->buffered = true;
+        } else {
+            transfer->file = openOutput(task.localPath, 0);
+        }
+        if (!transfer->file) {
+            if (failedFiles) {
+                failedFiles->append(task.remotePath);
+            }
+            delete transfer;
+            success = false;
+            continue;
+        }
+        
+        transfer->handle = createTransferHandle(buildUrl(task.remotePath, false), transfer);
+        bytesTotal += task.fileSize;
+        transfers.append(transfer);
     }
     
-    QString normalizedPath = path;
-    if (!normalizedPath.startsWith("/")) {
-        normalizedPath = "/" + normalizedPath;
+    return performMulti(transfers, bytesTotal, progressCallback, failedFiles) && success;
+}
+
+/**
+ * @brief 当前服务器是否可以使用块模式
+ * @return 可以使用时返回true
+ */
+bool FtpClient::blockModeAvailable() const
+{
+    return blockModeAllowed() && m_blockModeState > 0;
+}
+
+/**
+ * @brief 是否满足使用块模式的前提
+ */
+bool FtpClient::blockModeAllowed() const
+{
+    return m_blockModeEnabled && m_isConnected && !m_isHttp && !m_isLocal && !m_useTls && !isEncrypting();
+}
+
+/**
+ * @brief 在后台线程中探测服务器是否接受MODE B
+ */
+void FtpClient::startBlockModeProbe()
+{
+    waitForBlockModeProbe();
+    if (!blockModeAllowed()) {
+        return;
     }
     
-    // 确保路径以/结尾
-    if (!normalizedPath.endsWith("/")) {
-        normalizedPath += "/";
+    // 探测会话在后台线程中创建、使用和销毁；下载时的会话另行建立，与之无关
+    QString host = QUrl(serverBaseUrl()).host();
+    QString interfaceSpec = nextLocalInterface();
+    int port = m_port;
+    QString username = m_username;
+    QString password = m_password;
+    std::atomic<int> *state = &m_blockModeState;
+    m_blockProbe = QThread::create([=]() {
+        BlockModeSession session;
+        session.setLocalAddress(interfaceAddress(interfaceSpec));
+        if (session.open(host, port, username, password)) {
+            *state = 1;
+        } else if (session.isUnsupported()) {
+            *state = -1;
+        }
+    });
+    m_blockProbe->start(QThread::LowPriority);
+}
+
+/**
+ * @brief 等待后台的块模式探测结束
+ */
+void FtpClient::waitForBlockModeProbe()
+{
+    if (m_blockProbe) {
+        m_blockProbe->wait();
+        delete m_blockProbe;
+        m_blockProbe = nullptr;
     }
-    
-    // 对URL进行编码处理
-    QByteArray pathUtf8 = normalizedPath.toUtf8();
-    char *escapedPath = curl_easy_escape(m_curl, pathUtf8.constData(), pathUtf8.length());
-    
-    // 替换编码后的斜杠
-    QString encodedPath = QString(escapedPath);
-    encodedPath.replace("%2F", "/");
-    
-    QString fullUrl = server + encodedPath;
-    
-    // 释放CURL分配的内存
-    curl_free(escapedPath);
-    
-    // 设置CURL选项
-    CURL *listHandle = curl_easy_init();
-    if (!listHandle) {
-        m_lastError = "无法初始化CURL列表句柄";
+}
+
+/**
+ * @brief 确保块模式会话已打开
+ * @return 会话可用时返回true
+ */
+bool FtpClient::ensureBlockSession()
+{
+    if (!blockModeAllowed()) {
         return false;
     }
-    
-    curl_easy_setopt(listHandle, CURLOPT_URL, fullUrl.toUtf8().constData());
-    curl_easy_setopt(listHandle, CURLOPT_USERNAME, m_username.toUtf8().constData());
-    curl_easy_setopt(listHandle, CURLOPT_PASSWORD, m_password.toUtf8().constData());
-    curl_easy_setopt(listHandle, CURLOPT_PORT, m_port);
-    curl_easy_setopt(listHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(listHandle, CURLOPT_WRITEDATA, this);
-    curl_easy_setopt(listHandle, CURLOPT_DIRLISTONLY, 0L);
-    
-    // 执行列表命令
-    CURLcode res = curl_easy_perform(listHandle);
-    
-    // 清理CURL句柄
-    curl_easy_cleanup(listHandle);
-    
-    if (res != CURLE_OK) {
-        m_lastError = QString("获取目录列表失败: %1").arg(curl_easy_strerror(res));
+    // 批量下载本身就要等待网络，此时等探测结束不会阻塞界面上的其他操作
+    waitForBlockModeProbe();
+    if (m_blockModeState < 0) {
         return false;
     }
+    if (m_blockSession && m_blockSession->isOpen()) {
+        return true;
+    }
     
-    // 解析目录列表
-    QString listData = m_listBuffer.join("\n");
-    QStringList lines = listData.split("\n", Qt::SkipEmptyParts);
+    // 块模式会话使用独立的控制连接，host取自服务器地址，端口与CURL传输一致，并绑定到下一个本地接口
+    if (!m_blockSession) {
+        m_blockSession.reset(new BlockModeSession);
+        m_blockSession->setPrewarmDepth(m_prewarmDepth);
+    }
+    m_blockSession->setLocalAddress(interfaceAddress(nextLocalInterface()));
+    QString host = QUrl(serverBaseUrl()).host();
+    if (m_blockSession->open(host, m_port, m_username, m_password)) {
+        m_blockModeState = 1;
+        return true;
+    }
+    // 只有服务器明确拒绝MODE B才在本次连接上放弃块模式，超时、断线等只让这一批改用流模式
+    if (m_blockSession->isUnsupported()) {
+        m_blockModeState = -1;
+    }
+    m_blockSession.reset();
+    return false;
+}
+
+/**
+ * @brief 块模式会话建立过的数据连接数
+ * @return 数据连接数
+ */
+int FtpClient::blockModeDataConnections() const
+{
+    return m_blockSession ? m_blockSession->dataConnections() : 0;
+}
+
+/**
+ * @brief 设置块模式下数据连接的预热深度
+ * @param depth 预先发出命令的后续文件数
+ */
+void FtpClient::setPrewarmDepth(int depth)
+{
+    m_prewarmDepth = qMax(0, depth);
+    if (m_blockSession) {
+        m_blockSession->setPrewarmDepth(m_prewarmDepth);
+    }
+}
+
+/**
+ * @brief 通过块模式会话依次下载多个文件
+ * @param tasks 下载任务列表
+ * @param progressCallback 进度回调函数
+ * @param failedFiles 输出下载失败的远程路径
+ * @param remaining 输出尚未尝试的任务
+ * @return 已尝试的文件是否全部下载成功
+ */
+bool FtpClient::downloadFilesBlockMode(const QList<DownloadTask> &tasks,
+                                       std::function<void(qint64, qint64)> progressCallback,
+                                       QStringList *failedFiles, QList<DownloadTask> *remaining)
+{
+    qint64 bytesTotal = 0;
+    QStringList remotePaths;
+    for (const DownloadTask &task : tasks) {
+        bytesTotal += task.fileSize;
+        remotePaths << task.remotePath;
+    }
+    // 会话据此在每个文件结束前预先请求后续文件
+    m_blockSession->setUpcoming(remotePaths);
     
-    // 使用正则表达式解析文件列表
-    QRegularExpression unixRe("([d-])([rwx-]{9})\\s+(\\d+)\\s+(\\w+)\\s+(\\w+)\\s+(\\d+)\\s+(\\w+\\s+\\d+\\s+[\\d:]+)\\s+(.+)");
+    bool success = true;
+    qint64 bytesDone = 0;
+    for (int i = 0; i < tasks.size(); ++i) {
+        const DownloadTask &task = tasks.at(i);
+        
+        // 会话中断（控制连接断开）后，剩余文件交给流模式，下一批重新建立会话
+        if (!m_blockSession->isOpen()) {
+            *remaining = tasks.mid(i);
+            break;
+        }
+        
+        // 与并发下载相同，小文件先下载到内存再交给落盘线程池
+        bool buffered = m_localWriter && task.fileSize > 0 && task.fileSize <= m_localWriter->tinyFileLimit();
+        QIODevice *output = nullptr;
+        if (buffered) {
+            QBuffer *buffer = new QBuffer;
+            buffer->open(QIODevice::WriteOnly);
+            output = buffer;
+        } else {
+            output = openOutput(task.localPath, 0);
+        }
+        if (!output) {
+            success = false;
+            if (failedFiles) {
+                failedFiles->append(task.remotePath);
+            }
+            continue;
+        }
+        
+        bool ok = m_blockSession->retrieve(task.remotePath, output, [&](qint64 received) {
+            if (progressCallback) {
+                progressCallback(bytesDone + received, bytesTotal);
+            }
+        });
+        if (!ok) {
+            m_lastError = m_blockSession->lastError();
+        }
+        
+        if (buffered) {
+            if (ok) {
+                m_localWriter->writeFile(task.localPath, static_cast<QBuffer*>(output)->data());
+            }
+            delete output;
+        } else if (!closeOutput(output, ok)) {
+            ok = false;
+        }
+        
+        if (!ok && !m_blockSession->isOpen()) {
+            // 传输中途会话断开，这个文件也交给流模式重新下载
+            *remaining = tasks.mid(i);
+            break;
+        }
+        if (!ok) {
+            success = false;
+            if (failedFiles) {
+                failedFiles->append(task.remotePath);
+            }
+        }
+        bytesDone += task.fileSize;
+    }
+    
+    if (!m_blockSession->isOpen()) {
+        m_blockSession.reset();
+    }
+    return success;
+}
+
+/**
+ * @brief 分段并行下载单个大文件
+ * @param remotePath 远程文件路径
+ * @param localPath 本地保存路径
+ * @param fileSize 远程文件大小（字节）
+ * @param segments 分段数量
+ * @param progressCallback 进度回调函数
+ * @return 下载是否成功
+ */
+bool FtpClient::downloadFileSegmented(const QString &remotePath, const QString &localPath, qint64 fileSize,
+                                      int segments, std::function<void(qint64, qint64)> progressCallback)
+{
+    if (!m_curl || !m_isConnected) {
+        m_lastError = "未连接到FTP服务器";
+        return false;
+    }
+    
+    // 大小未知或只有一段时退回普通下载；加密输出是顺序流，不能分段写入
+    if (fileSize <= 0 || segments < 2 || isEncrypting()) {
+        return downloadFile(remotePath, localPath, progressCallback);
+    }
+    
+    m_transferInfo.clear();
+    
+    // 预先分配文件大小，各分段直接写入各自的偏移位置
+    QFile preallocated(localPath);
+    if (!preallocated.open(QIODevice::WriteOnly) || !preallocated.resize(fileSize)) {
+        m_lastError = QString("无法创建本地文件: %1").arg(localPath);
+        return false;
+    }
+    preallocated.close();
+    
+    QString fullUrl = buildUrl(remotePath, false);
+    qint64 segmentSize = (fileSize + segments - 1) / segments;
+    QList<MultiTransfer*> transfers;
+    bool success = true;
+    
+    for (int i = 0; i < segments; ++i) {
+        qint64 start = i * segmentSize;
+        if (start >= fileSize) {
+            break;
+        }
+        qint64 end = qMin(fileSize, start + segmentSize) - 1;
+        
+        MultiTransfer *transfer = new MultiTransfer;
+        transfer->remotePath = remotePath;
+        transfer->limit = end - start + 1;
+        transfer->file = new QFile(localPath);
+        if (!transfer->file->open(QIODevice::ReadWrite) || !transfer->file->seek(start)) {
+            m_lastError = QString("无法打开本地文件: %1").arg(localPath);
+            delete transfer->file;
+            delete transfer;
+            success = false;
+            break;
+        }
+        
+        // FTP使用REST加提前中止，HTTP使用Range请求获取各自的分段
+        transfer->handle = createTransferHandle(fullUrl, transfer);
+        if (transfer->handle) {
+            QByteArray range = QString("%1-%2").arg(start).arg(end).toUtf8();
+            curl_easy_setopt(transfer->handle, CURLOPT_RANGE, range.constData());
+        }
+        transfers.append(transfer);
+    }
+    
+    if (!success) {
+        // 打开本地文件失败时丢弃已创建的分段
+        performMulti(transfers, fileSize, nullptr, nullptr, true);
+        return false;
+    }
+    
+    return performMulti(transfers, fileSize, progressCallback);
+}
+
+/**
+ * @brief 下载目录
+ * @param remotePath 远程目录路径
+ * @param localPath 本地保存路径
+ * @param progressCallback 进度回调函数
+ * @param taskQueue 下载任务队列，用于存储待下载的文件任务
+ * @return 下载是否成功
+ */
+bool FtpClient::downloadDirectory(const QString &remotePath, const QString &localPath,
+                                 std::function<void(qint64, qint64)> progressCallback,
+                                 QQueue<DownloadTask> *taskQueue)
+{
+    DownloadTask root;
+    root.remotePath = remotePath;
+    root.localPath = localPath;
+    root.isDirectory = true;
+    root.fileSize = 0;
+    return downloadDirectories(QList<DownloadTask>() << root, progressCallback, taskQueue);
+}
+
+/**
+ * @brief 在一次扫描中下载多个目录
+ * @param roots 目录任务（远程目录和对应的本地目录）
+ * @param progressCallback 进度回调函数
+ * @param taskQueue 下载任务队列，用于存储所有目录中待下载的文件任务
+ * @return 是否全部成功，某个目录失败时仍继续扫描其余目录
+ */
+bool FtpClient::downloadDirectories(const QList<DownloadTask> &roots,
+                                    std::function<void(qint64, qint64)> progressCallback,
+                                    QQueue<DownloadTask> *taskQueue)
+{
+    // 列出各目录内容并创建目录结构、添加文件到下载队列
+    m_pendingDirectories.clear();
+    bool success = true;
+    for (const DownloadTask &root : roots) {
+        if (!createLocalDirectory(root.localPath)) {
+            m_lastError = QString("无法创建本地目录: %1").arg(root.localPath);
+            success = false;
+            continue;
+        }
+        success = listDirectoryForDownload(root.remotePath, root.localPath, progressCallback, taskQueue) && success;
+    }
+    
+    // 扫描出的任务由调用方接管（如合并到DownloadQueue，由其重新记账）
+    if (m_budget) {
+        m_budget->release(MemoryBudget::TaskQueue, m_crawlQueueBytes);
+    }
+    m_crawlQueueBytes = 0;
+    
+    // 在任何文件开始下载之前并行创建所有目录中扫描到的子目录
+    if (!m_pendingDirectories.isEmpty()) {
+        if (!m_localWriter->createDirectories(m_pendingDirectories)) {
+            m_lastError = "无法创建部分本地目录";
+            success = false;
+        }
+        m_pendingDirectories.clear();
+    }
+    return success;
+}
+
+/**
+ * @brief 列出目录内容用于下载
+ * @param path 要列出的目录路径
+ * @param targetDir 本地目标目录
+ * @param progressCallback 进度回调函数
+ * @param taskQueue 下载任务队列，用于存储待下载的文件任务
+ * @return 操作是否成功
+ */
+bool FtpClient::listDirectoryForDownload(const QString &path, const QString &targetDir,
+                                        std::function<void(qint64, qint64)> progressCallback,
+                                        QQueue<DownloadTask> *taskQueue)
+{
+    if (!m_curl || !m_isConnected) {
+        m_lastError = "未连接到FTP服务器";
+        return false;
+    }
+    
+    // 规范化路径，确保以/开头并以/结尾
+    QString normalizedPath = path;
+    if (!normalizedPath.startsWith("/")) {
+        normalizedPath = "/" + normalizedPath;
+    }
+    
+    // 确保路径以/结尾
+    if (!normalizedPath.endsWith("/")) {
+        normalizedPath += "/";
+    }
+    
+    // 获取目录项，MLSD扫描时连同大小和修改时间一次取得
+    QList<RemoteEntry> entries;
+    if (!fetchEntries(normalizedPath, &entries)) {
+        return false;
+    }
+    
+    bool success = true;
+    
+    for (const RemoteEntry &entry : entries) {
+        const QString &name = entry.name;
+        bool isDir = entry.isDirectory;
+        qint64 fileSize = entry.size;
+        
+        // 名称过滤只作用于文件，目录总是需要继续扫描
+        if (!isDir && !matchesNameFilter(name)) {
+            continue;
+        }
+        
+        if (isDir) {
+            // 如果是目录，先创建本地目录，然后递归处理
+            QString newRemotePath = normalizedPath + name;
+            QString newLocalPath = targetDir + "/" + name;
+            
+            // 文件进入任务队列时，目录留到扫描结束后由落盘线程池批量创建
+            if (taskQueue && m_localWriter) {
+                m_pendingDirectories.append(newLocalPath);
+            } else if (!createLocalDirectory(newLocalPath)) {
+                m_lastError = QString("无法创建本地目录: %1").arg(newLocalPath);
+                success = false;
+                continue;
+            }
+            
+            // 递归处理子目录，继续使用相同的任务队列
+            success = listDirectoryForDownload(newRemotePath, newLocalPath, progressCallback, taskQueue) && success;
+        } else {
+            // 如果是文件，添加到任务队列而不是直接下载
+            if (taskQueue) {
+                // 创建下载任务并添加到队列
+                DownloadTask task;
+                task.remotePath = normalizedPath + name;
+                task.localPath = targetDir + "/" + name;
+                task.isDirectory = false;
+                task.fileSize = fileSize;
+                task.displayName = name;
+                
+                // 内存预算紧张时不再扩大队列，扫描继续进行，任务暂存到磁盘上的溢出文件
+                if (m_budget && m_budget->underPressure()) {
+                    success = spillCrawlTask(task) && success;
+                    continue;
+                }
+                
+                // 将任务添加到队列
+                taskQueue->enqueue(task);
+                if (m_budget) {
+                    qint64 bytes = DownloadQueue::estimateBytes(task);
+                    m_budget->charge(MemoryBudget::TaskQueue, bytes);
+                    m_crawlQueueBytes += bytes;
+                }
+            } else {
+                // 如果没有提供队列，则使用传统方式直接下载
+                QString remoteFilePath = normalizedPath + name;
+                QString localFilePath = targetDir + "/" + name;
+                if (!downloadFile(remoteFilePath, localFilePath, progressCallback)) {
+                    success = false;
+                }
+            }
+        }
+    }
+    
+    return success;
+}
+
+/**
+ * @brief 把扫描到的任务追加到溢出文件
+ * @param task 下载任务
+ * @return 操作是否成功
+ */
+bool FtpClient::spillCrawlTask(const DownloadTask &task)
+{
+    if (!m_crawlSpill) {
+        QTemporaryFile *file = new QTemporaryFile(QDir::tempPath() + "/ftpclient-tasks-XXXXXX");
+        file->setAutoRemove(false);
+        if (!file->open()) {
+            m_lastError = QString("无法创建任务溢出文件: %1").arg(file->errorString());
+            delete file;
+            return false;
+        }
+        m_crawlSpill = file;
+    }
+    
+    QDataStream out(m_crawlSpill);
+    DownloadQueue::writeTask(out, task);
+    if (out.status() != QDataStream::Ok) {
+        m_lastError = QString("写入任务溢出文件失败: %1").arg(m_crawlSpill->errorString());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 取走上次扫描的溢出文件
+ * @return 溢出文件路径，没有溢出时为空
+ */
+QString FtpClient::takeCrawlSpill()
+{
+    if (!m_crawlSpill) {
+        return QString();
+    }
+    QString path = m_crawlSpill->fileName();
+    m_crawlSpill->close();
+    delete m_crawlSpill;
+    m_crawlSpill = nullptr;
+    return path;
+}
+
+/**
+ * @brief 获取目录项
+ * @param normalizedPath 以/开头和结尾的远程目录路径
+ * @param entries 输出目录项
+ * @return 操作是否成功
+ */
+bool FtpClient::fetchEntries(const QString &normalizedPath, QList<RemoteEntry> *entries)
+{
+    // MLSD扫描；服务器不支持MLSD时直接使用LIST，每个目录只列一次
+    if (m_crawlMode == MachineListCrawl && !m_isHttp && !m_isLocal && !m_mlsdUnsupported) {
+        return fetchMachineListEntries(normalizedPath, entries);
+    }
+    
+    // 获取目录列表，本地传输直接读取目录而不经过CURL
+    QStringList lines;
+    if (m_isLocal) {
+        if (!localListing(normalizedPath, &lines)) {
+            return false;
+        }
+    } else if (!m_listingCache || !m_listingCache->lookup(normalizedPath, &lines)) {
+        if (!fetchListing(normalizedPath, &lines)) {
+            return false;
+        }
+        if (m_listingCache) {
+            m_listingCache->insert(normalizedPath, lines);
+        }
+    }
+    
+    *entries = parseListLines(lines, normalizedPath);
+    return true;
+}
+
+/**
+ * @brief 解析LIST格式的目录列表
+ * @param lines 目录列表
+ * @param normalizedPath 以/开头和结尾的远程目录路径，用于无法识别格式时探测目录
+ * @return 目录项列表，不包含"."和".."
+ */
+QList<RemoteEntry> FtpClient::parseListLines(const QStringList &lines, const QString &normalizedPath)
+{
+    // 使用正则表达式解析文件列表
+    QRegularExpression unixRe("([d-])([rwx-]{9})\\s+(\\d+)\\s+(\\w+)\\s+(\\w+)\\s+(\\d+)\\s+(\\w+\\s+\\d+\\s+[\\d:]+)\\s+(.+)");
     QRegularExpression windowsRe("(\\d{2}-\\d{2}-\\d{2})\\s+(\\d{2}:\\d{2}[AP]M)\\s+(<DIR>|\\d+)\\s+(.+)");
     QRegularExpression simpleRe("([d-])[^\\s]+\\s+.*\\s+(.+)$");
     
-    bool success = true;
+    QList<RemoteEntry> entries;
     
     for (const QString &line : lines) {
         bool isDir = false;
@@ -462,73 +1153,446 @@ bool FtpClient::listDirectoryForDownload(const QString &path, const QString &tar
             }
         }
         
-        // 处理找到的项目
-        if (isDir) {
-            // 如果是目录，先创建本地目录，然后递归处理
-            QString newRemotePath = normalizedPath + name;
-            QString newLocalPath = targetDir + "/" + name;
-            
-            if (!createLocalDirectory(newLocalPath)) {
-                m_lastError = QString("无法创建本地目录: %1").arg(newLocalPath);
-                success = false;
-                continue;
-            }
-            
-            // 递归处理子目录，继续使用相同的任务队列
-            success = listDirectoryForDownload(newRemotePath, newLocalPath, progressCallback, taskQueue) && success;
-        } else {
-            // 如果是文件，添加到任务队列而不是直接下载
-            if (taskQueue) {
-                // 创建下载任务并添加到队列
-                DownloadTask task;
-                task.remotePath = normalizedPath + name;
-                task.localPath = targetDir + "/" + name;
-                task.isDirectory = false;
-                task.fileSize = fileSize;
-                task.displayName = name;
-                
-                // 将任务添加到队列
-                taskQueue->enqueue(task);
-            } else {
-                // 如果没有提供队列，则使用传统方式直接下载
-                QString remoteFilePath = normalizedPath + name;
-                QString localFilePath = targetDir + "/" + name;
-                
-                if (!downloadFile(remoteFilePath, localFilePath, progressCallback)) {
-                    success = false;
-                }
-            }
-        }
+        RemoteEntry entry;
+        entry.name = name;
+        entry.isDirectory = isDir;
+        entry.size = fileSize;
+        entries.append(entry);
     }
     
-    return success;
+    return entries;
 }
 
 /**
- * @brief 创建本地目录
- * @param localPath 本地目录路径
+ * @brief 以MLSD获取目录项
+ * @param normalizedPath 以/开头和结尾的远程目录路径
+ * @param entries 输出目录项
  * @return 操作是否成功
  */
-bool FtpClient::createLocalDirectory(const QString &localPath)
+bool FtpClient::fetchMachineListEntries(const QString &normalizedPath, QList<RemoteEntry> *entries)
 {
-    QDir dir;
-    return dir.mkpath(localPath);
+    QStringList facts;
+    int code = 0;
+    if (fetchListing(normalizedPath, &facts, ListMachine, &code)) {
+        *entries = parseMlsdLines(facts);
+        return true;
+    }
+    // 只有服务器明确拒绝命令才认定不支持，超时、断线等临时失败只算本目录失败
+    if (code != 500 && code != 502) {
+        return false;
+    }
+    m_mlsdUnsupported = true;
+    return fetchEntries(normalizedPath, entries);
 }
 
 /**
- * @brief 获取上级目录路径
- * @param path 当前路径
- * @return 上级目录路径
+ * @brief 解析MLSD格式的目录列表
+ * @param lines 目录列表（如"type=file;size=1024;modify=20240101120000; name"）
+ * @return 目录项列表，不包含"."和".."
  */
-QString FtpClient::getParentDirectory(const QString &path)
+QList<RemoteEntry> FtpClient::parseMlsdLines(const QStringList &lines)
 {
-    if (path == "/" || path.isEmpty()) {
-        return "/";
-    }
+    QList<RemoteEntry> entries;
     
-    QString workPath = path;
-    // 如果路径已经以/结尾，先去掉它再处理
-    if (workPath.endsWith('/')) {
+    for (const QString &line : lines) {
+        // 事实与名称之间以第一个空格分隔，名称本身可以包含空格
+        int spacePos = line.indexOf(' ');
+        if (spacePos < 0) {
+            continue;
+        }
+        
+        RemoteEntry entry;
+        entry.name = line.mid(spacePos + 1);
+        entry.name.remove('\r');
+        QString type;
+        
+        const QStringList facts = line.left(spacePos).split(';', Qt::SkipEmptyParts);
+        for (const QString &fact : facts) {
+            QString key = fact.section('=', 0, 0).toLower();
+            QString value = fact.section('=', 1);
+            if (key == "type") {
+                type = value.toLower();
+            } else if (key == "size") {
+                entry.size = value.toLongLong();
+            } else if (key == "modify") {
+                // MLSD的时间固定为UTC，可能带有小数秒
+                entry.modified = QDateTime::fromString(value.left(14), "yyyyMMddHHmmss");
+                entry.modified.setTimeZone(QTimeZone::UTC);
+            }
+        }
+        
+        // 跳过当前目录和上级目录
+        if (type == "cdir" || type == "pdir" || entry.name == "." || entry.name == "..") {
+            continue;
+        }
+        entry.isDirectory = (type == "dir");
+        entries.append(entry);
+    }
+    
+    return entries;
+}
+
+/**
+ * @brief 设置文件名过滤条件
+ * @param patterns 通配符列表，不区分大小写，为空表示不过滤
+ */
+void FtpClient::setNameFilter(const QStringList &patterns)
+{
+    m_nameFilterPatterns.clear();
+    m_nameFilters.clear();
+    for (const QString &pattern : patterns) {
+        QString trimmed = pattern.trimmed();
+        if (!trimmed.isEmpty()) {
+            m_nameFilterPatterns.append(trimmed);
+            m_nameFilters.append(QRegularExpression::fromWildcard(trimmed, Qt::CaseInsensitive));
+        }
+    }
+}
+
+/**
+ * @brief 判断文件名是否匹配过滤条件
+ * @param name 文件名
+ * @return 未设置过滤条件或匹配任一通配符时返回true
+ */
+bool FtpClient::matchesNameFilter(const QString &name) const
+{
+    if (m_nameFilters.isEmpty()) {
+        return true;
+    }
+    for (const QRegularExpression &filter : m_nameFilters) {
+        if (filter.match(name).hasMatch()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 使用独立的CURL句柄获取目录列表
+ * @param normalizedPath 以/开头和结尾的远程目录路径
+ * @param lines 输出目录列表
+ * @param command 使用的列表命令
+ * @param responseCode 输出服务器最后的应答码，可以为nullptr
+ * @return 操作是否成功
+ */
+bool FtpClient::fetchListing(const QString &normalizedPath, QStringList *lines, ListCommand command,
+                             int *responseCode)
+{
+    // 清空列表缓冲区
+    m_receiveBuffer.clear();
+    
+    QString fullUrl = buildUrl(normalizedPath, true);
+    
+    // 设置CURL选项
+    CURL *listHandle = curl_easy_init();
+    if (!listHandle) {
+        m_lastError = "无法初始化CURL列表句柄";
+        return false;
+    }
+    
+    curl_easy_setopt(listHandle, CURLOPT_URL, fullUrl.toUtf8().constData());
+    applyCommonOptions(listHandle);
+    curl_easy_setopt(listHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(listHandle, CURLOPT_WRITEDATA, this);
+    if (command == ListMachine) {
+        // libcurl没有内置MLSD，对目录URL的自定义命令会替代LIST在数据连接上执行
+        curl_easy_setopt(listHandle, CURLOPT_CUSTOMREQUEST, "MLSD");
+    }
+    QString interfaceName = applyLocalBinding(listHandle);
+    
+    // 执行列表命令
+    simulateLatency();
+    CURLcode res = curl_easy_perform(listHandle);
+    recordInterfaceUsage(listHandle, interfaceName);
+    if (responseCode) {
+        long code = 0;
+        curl_easy_getinfo(listHandle, CURLINFO_RESPONSE_CODE, &code);
+        *responseCode = static_cast<int>(code);
+    }
+    
+    // 清理CURL句柄
+    curl_easy_cleanup(listHandle);
+    
+    if (res != CURLE_OK) {
+        m_lastError = QString("获取目录列表失败: %1").arg(curl_easy_strerror(res));
+        return false;
+    }
+    
+    // 按行拆分目录列表
+    *lines = takeReceivedLines();
+    return true;
+}
+
+/**
+ * @brief 列出目录项
+ * @param path 要列出的目录路径
+ * @param entries 输出目录项
+ * @return 操作是否成功
+ */
+bool FtpClient::listEntries(const QString &path, QList<RemoteEntry> *entries)
+{
+    if (!m_isConnected) {
+        m_lastError = "未连接到FTP服务器";
+        return false;
+    }
+    
+    QString normalizedPath = path;
+    if (!normalizedPath.startsWith("/")) {
+        normalizedPath = "/" + normalizedPath;
+    }
+    if (!normalizedPath.endsWith("/")) {
+        normalizedPath += "/";
+    }
+    
+    return fetchEntries(normalizedPath, entries);
+}
+
+/**
+ * @brief 请求服务器计算文件摘要（FTP HASH命令）
+ * @param remotePath 远程文件路径
+ * @param algorithm 输出服务器使用的摘要算法
+ * @param digest 输出十六进制摘要
+ * @return 服务器支持并成功返回摘要时为true
+ */
+bool FtpClient::remoteHash(const QString &remotePath, QString *algorithm, QString *digest)
+{
+    if (!m_isConnected || m_isHttp || m_isLocal) {
+        m_lastError = "当前服务器不支持HASH命令";
+        return false;
+    }
+    
+    CURL *hashHandle = curl_easy_init();
+    if (!hashHandle) {
+        m_lastError = "无法初始化CURL句柄";
+        return false;
+    }
+    
+    // 不传输数据，只在登录后发送HASH，服务器的应答通过头部回调收集
+    struct curl_slist *quote = curl_slist_append(nullptr, QString("HASH %1").arg(remotePath).toUtf8().constData());
+    m_receiveBuffer.clear();
+    curl_easy_setopt(hashHandle, CURLOPT_URL, buildUrl("/", true).toUtf8().constData());
+    applyCommonOptions(hashHandle);
+    applyLocalBinding(hashHandle);
+    curl_easy_setopt(hashHandle, CURLOPT_NOBODY, 1L);
+    curl_easy_setopt(hashHandle, CURLOPT_QUOTE, quote);
+    curl_easy_setopt(hashHandle, CURLOPT_HEADERFUNCTION, WriteCallback);
+    curl_easy_setopt(hashHandle, CURLOPT_HEADERDATA, this);
+    
+    simulateLatency();
+    CURLcode res = curl_easy_perform(hashHandle);
+    curl_easy_cleanup(hashHandle);
+    curl_slist_free_all(quote);
+    
+    QStringList responses = QString::fromUtf8(m_receiveBuffer).split("\n", Qt::SkipEmptyParts);
+    m_receiveBuffer.clear();
+    
+    if (res != CURLE_OK) {
+        m_lastError = QString("HASH命令失败: %1").arg(curl_easy_strerror(res));
+        return false;
+    }
+    
+    // 应答格式："213 SHA-256 0-1023 <摘要> <文件名>"
+    for (const QString &response : responses) {
+        if (!response.startsWith("213 ")) {
+            continue;
+        }
+        QStringList parts = response.trimmed().split(' ', Qt::SkipEmptyParts);
+        if (parts.size() >= 4) {
+            *algorithm = parts.at(1);
+            *digest = parts.at(3).toLower();
+            return true;
+        }
+    }
+    
+    m_lastError = "无法解析HASH应答";
+    return false;
+}
+
+/**
+ * @brief 读取远程文件的一段数据
+ * @param remotePath 远程文件路径
+ * @param offset 起始偏移
+ * @param length 读取长度
+ * @param data 输出数据
+ * @return 操作是否成功
+ */
+bool FtpClient::readRange(const QString &remotePath, qint64 offset, qint64 length, QByteArray *data)
+{
+    if (!m_isConnected) {
+        m_lastError = "未连接到FTP服务器";
+        return false;
+    }
+    if (length <= 0) {
+        data->clear();
+        return true;
+    }
+    
+    // 保留句柄（及其连接）供下一次区间读取复用
+    if (!m_rangeHandle) {
+        m_rangeHandle = curl_easy_init();
+        if (!m_rangeHandle) {
+            m_lastError = "无法初始化CURL句柄";
+            return false;
+        }
+    }
+    CURL *rangeHandle = m_rangeHandle;
+    
+    QByteArray range = QString("%1-%2").arg(offset).arg(offset + length - 1).toUtf8();
+    m_receiveBuffer.clear();
+    curl_easy_setopt(rangeHandle, CURLOPT_URL, buildUrl(remotePath, false).toUtf8().constData());
+    applyCommonOptions(rangeHandle);
+    curl_easy_setopt(rangeHandle, CURLOPT_RANGE, range.constData());
+    curl_easy_setopt(rangeHandle, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(rangeHandle, CURLOPT_WRITEDATA, this);
+    QString interfaceName = applyLocalBinding(rangeHandle);
+    
+    simulateLatency();
+    CURLcode res = curl_easy_perform(rangeHandle);
+    recordInterfaceUsage(rangeHandle, interfaceName);
+    long responseCode = 0;
+    curl_easy_getinfo(rangeHandle, CURLINFO_RESPONSE_CODE, &responseCode);
+    
+    if (res != CURLE_OK) {
+        m_receiveBuffer.clear();
+        m_lastError = QString("读取文件区间失败: %1").arg(curl_easy_strerror(res));
+        return false;
+    }
+    
+    // 不支持Range的HTTP服务器会以200返回整个文件，只保留请求的部分
+    qint64 skip = (m_isHttp && responseCode == 200) ? offset : 0;
+    *data = m_receiveBuffer.mid(skip, length);
+    m_receiveBuffer.clear();
+    return true;
+}
+
+/**
+ * @brief 启用下载文件的落盘加密
+ * @param key 32字节密钥，为空表示关闭加密
+ * @param cipher 加密算法
+ */
+void FtpClient::setEncryption(const QByteArray &key, EncryptedFileSink::Cipher cipher)
+{
+    m_encryptionKey = key;
+    m_encryptionCipher = cipher;
+}
+
+/**
+ * @brief 获取本地文件可续传的位置
+ * @param localPath 本地文件路径
+ * @return 可以从该偏移继续下载，文件不存在时为0
+ */
+qint64 FtpClient::localResumeOffset(const QString &localPath, const QString &remotePath, qint64 remoteSize) const
+{
+    QFileInfo info(localPath);
+    if (remoteSize <= 0 || !info.exists()) {
+        return 0;
+    }
+
+    // 标记格式：远程路径\t远程大小\t中断时的本地大小
+    QFile marker(localPath + ".part");
+    if (!marker.open(QIODevice::ReadOnly)) {
+        return 0;
+    }
+    QList<QByteArray> fields = marker.readAll().trimmed().split('\t');
+    if (fields.size() != 3 || QString::fromUtf8(fields.at(0)) != remotePath
+        || fields.at(1).toLongLong() != remoteSize || fields.at(2).toLongLong() != info.size()) {
+        return 0;
+    }
+
+    qint64 offset = isEncrypting() ? EncryptedFileSink::resumableSize(localPath) : info.size();
+    return offset < remoteSize ? offset : 0;
+}
+
+/**
+ * @brief 写入续传标记
+ * @param localPath 本地文件路径
+ * @param remotePath 远程文件路径
+ * @param remoteSize 远程文件大小
+ * @param localBytes 下载中断时本地文件的大小
+ */
+void FtpClient::writeResumeMarker(const QString &localPath, const QString &remotePath, qint64 remoteSize,
+                                  qint64 localBytes)
+{
+    QFile marker(localPath + ".part");
+    if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        marker.write(remotePath.toUtf8() + '\t' + QByteArray::number(remoteSize) + '\t'
+                     + QByteArray::number(localBytes) + '\n');
+    }
+}
+
+/**
+ * @brief 打开下载输出
+ * @param localPath 本地文件路径
+ * @param resumeOffset 续传偏移，0表示新建文件
+ * @return 已打开的输出设备，失败时返回nullptr
+ */
+QIODevice *FtpClient::openOutput(const QString &localPath, qint64 resumeOffset)
+{
+    QIODevice *output = nullptr;
+    if (isEncrypting()) {
+        // 加密文件只能从完整块的边界续传
+        if (resumeOffset > 0 && resumeOffset != EncryptedFileSink::resumableSize(localPath)) {
+            m_lastError = QString("续传位置与加密块边界不一致: %1").arg(localPath);
+            return nullptr;
+        }
+        output = new EncryptedFileSink(localPath, m_encryptionKey, m_encryptionCipher);
+    } else {
+        output = new QFile(localPath);
+    }
+    
+    QIODevice::OpenMode openMode = resumeOffset > 0 ? QIODevice::Append : QIODevice::WriteOnly;
+    if (!output->open(openMode)) {
+        m_lastError = QString("无法创建本地文件: %1 (%2)").arg(localPath).arg(output->errorString());
+        delete output;
+        return nullptr;
+    }
+    return output;
+}
+
+/**
+ * @brief 关闭并释放下载输出
+ * @param output 输出设备
+ * @param complete 下载是否已完整结束
+ * @return 输出是否成功写完
+ */
+bool FtpClient::closeOutput(QIODevice *output, bool complete)
+{
+    bool success = true;
+    EncryptedFileSink *sink = qobject_cast<EncryptedFileSink*>(output);
+    if (sink && complete && !sink->finish()) {
+        m_lastError = QString("写入加密文件失败: %1").arg(sink->errorString());
+        success = false;
+    }
+    output->close();
+    delete output;
+    return success;
+}
+
+/**
+ * @brief 创建本地目录
+ * @param localPath 本地目录路径
+ * @return 操作是否成功
+ */
+bool FtpClient::createLocalDirectory(const QString &localPath)
+{
+    QDir dir;
+    return dir.mkpath(localPath);
+}
+
+/**
+ * @brief 获取上级目录路径
+ * @param path 当前路径
+ * @return 上级目录路径
+ */
+QString FtpClient::getParentDirectory(const QString &path)
+{
+    if (path == "/" || path.isEmpty()) {
+        return "/";
+    }
+    
+    QString workPath = path;
+    // 如果路径已经以/结尾，先去掉它再处理
+    if (workPath.endsWith('/')) {
         workPath.chop(1);
     }
     
@@ -548,6 +1612,683 @@ QString FtpClient::getParentDirectory(const QString &path)
     return "/";
 }
 
+/**
+ * @brief 设置本地绑定接口
+ * @param interfaces 本地网卡名或源地址列表
+ * @param localPort 起始本地端口，0表示由系统分配
+ * @param localPortRange 从起始端口开始可尝试的端口数量
+ */
+void FtpClient::setLocalInterfaces(const QStringList &interfaces, int localPort, int localPortRange)
+{
+    m_localInterfaces.clear();
+    for (const QString &iface : interfaces) {
+        QString trimmed = iface.trimmed();
+        if (!trimmed.isEmpty()) {
+            m_localInterfaces.append(trimmed);
+        }
+    }
+    
+    m_localPort = localPort;
+    m_localPortRange = localPortRange;
+    m_nextInterface = 0;
+}
+
+/**
+ * @brief 为CURL句柄绑定下一个本地接口
+ * @param handle CURL句柄
+ * @return 本次绑定的接口名，未配置接口时返回"default"
+ */
+QString FtpClient::applyLocalBinding(CURL *handle)
+{
+    if (m_localInterfaces.isEmpty()) {
+        // 未配置接口时清除之前可能设置过的绑定，走系统默认路由
+        curl_easy_setopt(handle, CURLOPT_INTERFACE, nullptr);
+        curl_easy_setopt(handle, CURLOPT_LOCALPORT, 0L);
+        curl_easy_setopt(handle, CURLOPT_LOCALPORTRANGE, 1L);
+        return "default";
+    }
+    
+    // 轮询选择下一个接口；libcurl按接口区分缓存的连接，
+    // 因此每个接口上的控制连接都能在后续传输中被复用
+    QString interfaceName = nextLocalInterface();
+    
+    curl_easy_setopt(handle, CURLOPT_INTERFACE, interfaceName.toUtf8().constData());
+    curl_easy_setopt(handle, CURLOPT_LOCALPORT, static_cast<long>(m_localPort));
+    curl_easy_setopt(handle, CURLOPT_LOCALPORTRANGE, static_cast<long>(qMax(1, m_localPortRange)));
+    
+    return interfaceName;
+}
+
+/**
+ * @brief 按轮询方式取下一个本地绑定接口
+ * @return 接口名或源地址，未配置接口时为空
+ */
+QString FtpClient::nextLocalInterface()
+{
+    if (m_localInterfaces.isEmpty()) {
+        return QString();
+    }
+    QString interfaceName = m_localInterfaces.at(m_nextInterface % m_localInterfaces.size());
+    m_nextInterface = (m_nextInterface + 1) % m_localInterfaces.size();
+    return interfaceName;
+}
+
+/**
+ * @brief 解析本地绑定接口对应的源地址
+ * @param interfaceSpec 接口名或源地址
+ * @return 源地址，无法解析时为空地址
+ */
+QHostAddress FtpClient::interfaceAddress(const QString &interfaceSpec)
+{
+    // 与CURLOPT_INTERFACE的写法一致："if!网卡"、"host!地址或主机名"、"ifhost!网卡!地址"，或不带前缀
+    QString spec = interfaceSpec;
+    if (spec.startsWith("ifhost!")) {
+        spec = spec.section('!', 2);
+    } else if (spec.startsWith("if!") || spec.startsWith("host!")) {
+        spec = spec.section('!', 1);
+    }
+    if (spec.isEmpty()) {
+        return QHostAddress();
+    }
+    
+    QHostAddress address(spec);
+    if (!address.isNull()) {
+        return address;
+    }
+    QNetworkInterface networkInterface = QNetworkInterface::interfaceFromName(spec);
+    if (networkInterface.isValid()) {
+        const QList<QNetworkAddressEntry> entries = networkInterface.addressEntries();
+        for (const QNetworkAddressEntry &entry : entries) {
+            if (entry.ip().protocol() == QAbstractSocket::IPv4Protocol) {
+                return entry.ip();
+            }
+        }
+        if (!entries.isEmpty()) {
+            return entries.first().ip();
+        }
+        return QHostAddress();
+    }
+    QHostInfo info = QHostInfo::fromName(spec);
+    return info.addresses().isEmpty() ? QHostAddress() : info.addresses().first();
+}
+
+/**
+ * @brief 记录一次传输的接口吞吐统计
+ * @param handle 已完成传输的CURL句柄
+ * @param interfaceName 本次传输使用的接口名
+ */
+void FtpClient::recordInterfaceUsage(CURL *handle, const QString &interfaceName)
+{
+    curl_off_t downloaded = 0;
+    curl_off_t totalTimeUs = 0;
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &totalTimeUs);
+    
+    InterfaceStats &stats = m_interfaceStats[interfaceName];
+    stats.bytes += downloaded;
+    stats.seconds += totalTimeUs / 1000000.0;
+    stats.transfers++;
+}
+
+/**
+ * @brief 记录一个文件传输的libcurl计时和连接信息
+ * @param handle 已完成传输的CURL句柄
+ * @param remotePath 远程文件路径
+ * @param result 传输结果
+ */
+void FtpClient::recordTransferInfo(CURL *handle, const QString &remotePath, CURLcode result)
+{
+    curl_off_t downloaded = 0;
+    curl_off_t uploaded = 0;
+    curl_off_t nameLookupUs = 0;
+    curl_off_t connectUs = 0;
+    curl_off_t tlsUs = 0;
+    curl_off_t firstByteUs = 0;
+    curl_off_t totalUs = 0;
+    curl_easy_getinfo(handle, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+    curl_easy_getinfo(handle, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+    curl_easy_getinfo(handle, CURLINFO_TOTAL_TIME_T, &totalUs);
+    // 一次传输只有一个方向，上传记录发送的字节数
+    downloaded += uploaded;
+    curl_easy_getinfo(handle, CURLINFO_NAMELOOKUP_TIME_T, &nameLookupUs);
+    curl_easy_getinfo(handle, CURLINFO_CONNECT_TIME_T, &connectUs);
+    curl_easy_getinfo(handle, CURLINFO_APPCONNECT_TIME_T, &tlsUs);
+    curl_easy_getinfo(handle, CURLINFO_STARTTRANSFER_TIME_T, &firstByteUs);
+    curl_off_t connectionId = -1;
+#if LIBCURL_VERSION_NUM >= 0x080200
+    curl_easy_getinfo(handle, CURLINFO_CONN_ID, &connectionId);
+#endif
+
+    // 分段下载的各段合并：字节数累加，计时取最慢的一段，结果取第一个错误
+    auto it = m_transferInfo.find(remotePath);
+    if (it == m_transferInfo.end()) {
+        TransferRecord record;
+        record.remotePath = remotePath;
+        record.resultCode = result;
+        record.connectionId = connectionId;
+        record.nameLookupUs = nameLookupUs;
+        record.connectUs = connectUs;
+        record.tlsUs = tlsUs > 0 ? tlsUs : -1;
+        record.firstByteUs = firstByteUs;
+        record.bytes = downloaded;
+        record.durationMs = totalUs / 1000;
+        m_transferInfo.insert(remotePath, record);
+        return;
+    }
+    TransferRecord &record = it.value();
+    if (record.resultCode == CURLE_OK) {
+        record.resultCode = result;
+    }
+    record.nameLookupUs = qMax<qint64>(record.nameLookupUs, nameLookupUs);
+    record.connectUs = qMax<qint64>(record.connectUs, connectUs);
+    record.tlsUs = qMax<qint64>(record.tlsUs, tlsUs > 0 ? tlsUs : -1);
+    record.firstByteUs = qMax<qint64>(record.firstByteUs, firstByteUs);
+    record.durationMs = qMax<qint64>(record.durationMs, totalUs / 1000);
+    record.bytes += downloaded;
+}
+
+/**
+ * @brief 获取最近一次下载调用中某个文件的传输信息
+ * @param remotePath 远程文件路径
+ * @param record 输出记录
+ * @return 有该文件的记录时返回true
+ */
+bool FtpClient::transferInfo(const QString &remotePath, TransferRecord *record) const
+{
+    auto it = m_transferInfo.constFind(remotePath);
+    if (it == m_transferInfo.constEnd()) {
+        return false;
+    }
+    *record = it.value();
+    return true;
+}
+
+/**
+ * @brief 获取服务器基础URL
+ * @return 带协议前缀且不以/结尾的服务器地址
+ */
+QString FtpClient::serverBaseUrl() const
+{
+    QString server = m_server;
+    
+    // 未指定协议时默认使用FTP
+    if (!server.contains("://")) {
+        server = "ftp://" + server;
+    }
+    
+    // 确保server不以/结尾，而path以/开头
+    if (server.endsWith("/")) {
+        server.chop(1);
+    }
+    
+    return server;
+}
+
+/**
+ * @brief 构建远程路径对应的完整URL
+ * @param path 远程路径
+ * @param isDirectory 是否是目录，目录URL以/结尾
+ * @return 经过编码的完整URL
+ */
+QString FtpClient::buildUrl(const QString &path, bool isDirectory) const
+{
+    // 移除可能存在的\r字符，确保路径格式正确
+    QString normalizedPath = path;
+    normalizedPath.remove('\r');
+    
+    if (!normalizedPath.startsWith("/")) {
+        normalizedPath = "/" + normalizedPath;
+    }
+    if (isDirectory && !normalizedPath.endsWith("/")) {
+        normalizedPath += "/";
+    }
+    
+    // 对URL进行编码处理
+    QByteArray pathUtf8 = normalizedPath.toUtf8();
+    char *escapedPath = curl_easy_escape(m_curl, pathUtf8.constData(), pathUtf8.length());
+    
+    // 替换掉编码后的斜杠，因为我们需要保留路径结构
+    QString encodedPath = QString(escapedPath);
+    encodedPath.replace("%2F", "/");
+    
+    // 释放CURL分配的内存
+    curl_free(escapedPath);
+    
+    return serverBaseUrl() + encodedPath;
+}
+
+/**
+ * @brief 为CURL句柄设置认证、端口和协议相关的公共选项
+ * @param handle CURL句柄
+ */
+void FtpClient::applyCommonOptions(CURL *handle)
+{
+    curl_easy_setopt(handle, CURLOPT_PORT, static_cast<long>(m_port));
+    
+    if (m_isHttp) {
+        // HTTP服务器通常允许匿名访问，只有填写了用户名时才发送认证信息
+        if (!m_username.isEmpty()) {
+            curl_easy_setopt(handle, CURLOPT_USERNAME, m_username.toUtf8().constData());
+            curl_easy_setopt(handle, CURLOPT_PASSWORD, m_password.toUtf8().constData());
+        }
+        
+        // HTTPS上协商HTTP/2，使多个请求能在同一个连接上多路复用
+        curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+        curl_easy_setopt(handle, CURLOPT_FOLLOWLOCATION, 1L);
+        // 404等错误页面不能被当作文件内容保存
+        curl_easy_setopt(handle, CURLOPT_FAILONERROR, 1L);
+    } else if (!m_isLocal) {
+        curl_easy_setopt(handle, CURLOPT_USERNAME, m_username.toUtf8().constData());
+        curl_easy_setopt(handle, CURLOPT_PASSWORD, m_password.toUtf8().constData());
+        // 显式FTPS：控制连接和数据连接都要求TLS
+        curl_easy_setopt(handle, CURLOPT_USE_SSL, static_cast<long>(m_useTls ? CURLUSESSL_ALL : CURLUSESSL_NONE));
+    }
+}
+
+/**
+ * @brief 设置模拟链路参数
+ * @param latencyMs 每个请求的附加延迟（毫秒），0表示不附加
+ * @param bytesPerSecond 传输带宽上限（字节/秒），0表示不限制
+ */
+void FtpClient::setSimulatedLink(int latencyMs, qint64 bytesPerSecond)
+{
+    m_simulatedLatencyMs = qMax(0, latencyMs);
+    m_simulatedBytesPerSecond = qMax<qint64>(0, bytesPerSecond);
+}
+
+/**
+ * @brief 在请求开始前施加模拟延迟
+ */
+void FtpClient::simulateLatency()
+{
+    if (m_simulatedLatencyMs > 0) {
+        QThread::msleep(static_cast<unsigned long>(m_simulatedLatencyMs));
+    }
+}
+
+/**
+ * @brief 按模拟带宽限制传输速度
+ * @param bytes 本次收到的字节数
+ * 
+ * 根据本次传输开始以来的累计字节数计算应耗费的时间，接收过快时休眠补齐
+ */
+void FtpClient::throttleTransfer(qint64 bytes)
+{
+    if (m_simulatedBytesPerSecond <= 0 || !m_linkTimer.isValid()) {
+        return;
+    }
+    
+    m_linkBytes += bytes;
+    qint64 expectedMs = m_linkBytes * 1000 / m_simulatedBytesPerSecond;
+    qint64 elapsedMs = m_linkTimer.elapsed();
+    if (expectedMs > elapsedMs) {
+        QThread::msleep(static_cast<unsigned long>(expectedMs - elapsedMs));
+    }
+}
+
+/**
+ * @brief 计算并发传输在模拟带宽下应暂停的时间
+ * @param bytes 本次收到的字节数
+ * @return 应暂停的毫秒数；为0时字节已计入链路
+ * 
+ * 与throttleTransfer()使用同一条链路的累计字节数，链路已超前时不计入本次数据
+ */
+qint64 FtpClient::linkDelay(qint64 bytes)
+{
+    if (m_simulatedBytesPerSecond <= 0 || !m_linkTimer.isValid()) {
+        return 0;
+    }
+    
+    qint64 expectedMs = m_linkBytes * 1000 / m_simulatedBytesPerSecond;
+    qint64 elapsedMs = m_linkTimer.elapsed();
+    if (expectedMs > elapsedMs) {
+        return expectedMs - elapsedMs;
+    }
+    m_linkBytes += bytes;
+    return 0;
+}
+
+/**
+ * @brief 获取本地传输的根目录
+ * @return file:// URL对应的本地目录路径
+ */
+QString FtpClient::localRoot() const
+{
+    QString root = QUrl(serverBaseUrl()).toLocalFile();
+    return root.isEmpty() ? QString("/") : root;
+}
+
+/**
+ * @brief 以Unix列表格式列出本地目录
+ * @param path 相对于本地根目录的路径
+ * @param lines 输出目录列表
+ * @return 操作是否成功
+ * 
+ * 输出格式与FTP服务器的LIST结果一致，使本地传输与FTP共用同一套解析和下载逻辑
+ */
+bool FtpClient::localListing(const QString &path, QStringList *lines)
+{
+    simulateLatency();
+    
+    QString root = localRoot();
+    if (root.endsWith('/')) {
+        root.chop(1);
+    }
+    
+    QString cleanPath = path;
+    cleanPath.remove('\r');
+    if (!cleanPath.startsWith('/')) {
+        cleanPath = "/" + cleanPath;
+    }
+    
+    QDir dir(root + cleanPath);
+    if (!dir.exists()) {
+        m_lastError = QString("获取目录列表失败: 本地目录不存在: %1").arg(dir.path());
+        return false;
+    }
+    
+    // 月份名称必须使用英文，与Unix列表的日期格式一致
+    QLocale cLocale = QLocale::c();
+    const QFileInfoList entries = dir.entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden,
+                                                    QDir::Name);
+    lines->clear();
+    for (const QFileInfo &entry : entries) {
+        lines->append(QString("%1rw-r--r-- 1 local local %2 %3 %4")
+                          .arg(QString(entry.isDir() ? "d" : "-"),
+                               QString::number(entry.isDir() ? 0 : entry.size()),
+                               cLocale.toString(entry.lastModified(), "MMM d HH:mm"),
+                               entry.fileName()));
+    }
+    
+    return true;
+}
+
+/**
+ * @brief 取出接收缓冲区中的列表数据
+ * @return 按行拆分的目录列表，HTTP服务器的索引页会被转换为Unix列表格式
+ */
+QStringList FtpClient::takeReceivedLines()
+{
+    QString data = QString::fromUtf8(m_receiveBuffer);
+    m_receiveBuffer.clear();
+    
+    if (m_isHttp) {
+        return htmlIndexToListing(data);
+    }
+    
+    return data.split("\n", Qt::SkipEmptyParts);
+}
+
+/**
+ * @brief 将HTTP服务器的目录索引页转换为Unix格式的目录列表
+ * @param html 索引页HTML内容（nginx autoindex、Apache mod_autoindex等）
+ * @return Unix格式的目录列表，便于与FTP列表共用同一套解析逻辑
+ */
+QStringList FtpClient::htmlIndexToListing(const QString &html)
+{
+    QStringList lines;
+    QSet<QString> seen;
+    QRegularExpression linkRe("<a\\s[^>]*href\\s*=\\s*\"([^\"]+)\"[^>]*>.*?</a>(.*)$",
+                              QRegularExpression::CaseInsensitiveOption);
+    QRegularExpression tagRe("<[^>]*>");
+    
+    for (const QString &htmlLine : html.split("\n", Qt::SkipEmptyParts)) {
+        QRegularExpressionMatch match = linkRe.match(htmlLine);
+        if (!match.hasMatch()) {
+            continue;
+        }
+        
+        // 跳过排序链接、锚点、绝对路径、外部链接和上级目录
+        QString href = match.captured(1);
+        if (href.startsWith('?') || href.startsWith('#') || href.startsWith('/')
+            || href.contains("://") || href.startsWith("mailto:")
+            || href.startsWith("../") || href.startsWith("./")) {
+            continue;
+        }
+        
+        bool isDir = href.endsWith('/');
+        QString name = QUrl::fromPercentEncoding(href.toUtf8());
+        if (isDir) {
+            name.chop(1);
+        }
+        if (name.isEmpty() || name.contains('/') || seen.contains(name)) {
+            continue;
+        }
+        seen.insert(name);
+        
+        // nginx在链接后给出以字节为单位的文件大小，其他格式无法可靠解析时记为0
+        qint64 fileSize = 0;
+        if (!isDir) {
+            QStringList trailing = match.captured(2).remove(tagRe).split(QRegularExpression("\\s+"),
+                                                                           Qt::SkipEmptyParts);
+            if (!trailing.isEmpty()) {
+                bool ok = false;
+                qint64 value = trailing.last().toLongLong(&ok);
+                if (ok) {
+                    fileSize = value;
+                }
+            }
+        }
+        
+        lines.append(QString("%1rw-r--r-- 1 http http %2 Jan  1 00:00 %3")
+                         .arg(isDir ? "d" : "-")
+                         .arg(fileSize)
+                         .arg(name));
+    }
+    
+    return lines;
+}
+
+/**
+ * @brief 创建用于并发传输的CURL句柄
+ * @param url 完整的远程URL
+ * @param transfer 传输上下文，作为写入回调的用户数据
+ * @return CURL句柄，失败时返回nullptr
+ */
+CURL *FtpClient::createTransferHandle(const QString &url, MultiTransfer *transfer)
+{
+    CURL *handle = curl_easy_init();
+    if (!handle) {
+        return nullptr;
+    }
+    
+    curl_easy_setopt(handle, CURLOPT_URL, url.toUtf8().constData());
+    applyCommonOptions(handle);
+    curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, MultiWriteCallback);
+    curl_easy_setopt(handle, CURLOPT_WRITEDATA, transfer);
+    transfer->client = this;
+    transfer->interfaceName = applyLocalBinding(handle);
+    
+    if (m_isHttp) {
+        // 等待已有连接确认是否支持多路复用，而不是为每个请求新建连接
+        curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L);
+    }
+    
+    return handle;
+}
+
+/**
+ * @brief 使用CURL多路句柄并发执行一组传输
+ * @param transfers 传输上下文列表，函数返回后全部释放
+ * @param bytesTotal 整组传输的总字节数，用于进度回调
+ * @param progressCallback 进度回调函数
+ * @param failedFiles 输出失败的远程路径（可选）
+ * @param discard 为true时不执行传输，只释放资源
+ * @return 是否全部成功
+ */
+bool FtpClient::performMulti(const QList<MultiTransfer*> &transfers, qint64 bytesTotal,
+                             std::function<void(qint64, qint64)> progressCallback,
+                             QStringList *failedFiles, bool discard)
+{
+    bool success = true;
+    CURLM *multi = discard ? nullptr : curl_multi_init();
+    
+    if (multi) {
+        m_linkBytes = 0;
+        m_linkTimer.start();
+        
+        // HTTP/2时所有请求复用同一个连接；服务器只支持HTTP/1.1时限制并发连接数，
+        // FTP每个传输需要独立的控制连接，同样限制数量以免超出服务器的每用户连接上限
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        if (m_isHttp) {
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                              m_maxHostConnections > 0 ? static_cast<long>(m_maxHostConnections) : 6L);
+        } else if (!m_isLocal) {
+            curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+                              m_maxHostConnections > 0 ? static_cast<long>(m_maxHostConnections) : 4L);
+        }
+        
+        // 模拟延迟按传输计：每个传输各自等待一次延迟后才加入多路句柄，同时开始的传输数
+        // 不超过连接数上限（本地传输按FTP的默认值），一个结束后下一个才开始等待，
+        // 与逐个下载时每个文件付出一次延迟可比
+        qint64 latencyMs = m_simulatedLatencyMs;
+        int slots = transfers.size();
+        if (latencyMs > 0) {
+            slots = m_maxHostConnections > 0 ? m_maxHostConnections : (m_isHttp ? 6 : 4);
+        }
+        QList<MultiTransfer*> pending;   // 尚未加入多路句柄的传输，已开始等待的在前
+        for (MultiTransfer *transfer : transfers) {
+            if (transfer->handle) {
+                pending.append(transfer);
+            }
+        }
+        int started = 0;                 // 已开始等待或进行中、尚未结束的传输数
+        auto admit = [&]() {
+            qint64 now = m_linkTimer.elapsed();
+            int added = 0;
+            for (int i = 0; i < pending.size(); ) {
+                MultiTransfer *transfer = pending.at(i);
+                if (transfer->startAt < 0) {
+                    if (started >= slots) {
+                        break;
+                    }
+                    transfer->startAt = now + latencyMs;
+                    ++started;
+                }
+                if (transfer->startAt > now) {
+                    ++i;
+                    continue;
+                }
+                curl_multi_add_handle(multi, transfer->handle);
+                pending.removeAt(i);
+                ++added;
+            }
+            return added;
+        };
+        // 下一个等待结束（延迟或暂停）的时间，最长100毫秒
+        auto nextWake = [&]() {
+            qint64 now = m_linkTimer.elapsed();
+            qint64 wait = 100;
+            for (MultiTransfer *transfer : pending) {
+                if (transfer->startAt >= 0) {
+                    wait = qMin(wait, transfer->startAt - now);
+                }
+            }
+            for (MultiTransfer *transfer : transfers) {
+                if (transfer->resumeAt >= 0) {
+                    wait = qMin(wait, transfer->resumeAt - now);
+                }
+            }
+            return static_cast<int>(qMax<qint64>(0, wait));
+        };
+        
+        int running = 0;
+        int added = admit();
+        do {
+            CURLMcode mc = curl_multi_perform(multi, &running);
+            if (mc == CURLM_OK && (running || !pending.isEmpty())) {
+                mc = curl_multi_poll(multi, nullptr, 0, nextWake(), nullptr);
+            }
+            if (mc != CURLM_OK) {
+                m_lastError = QString("并发传输失败: %1").arg(curl_multi_strerror(mc));
+                break;
+            }
+            
+            // 收集已结束的传输结果
+            int queued = 0;
+            CURLMsg *msg = nullptr;
+            while ((msg = curl_multi_info_read(multi, &queued))) {
+                if (msg->msg != CURLMSG_DONE) {
+                    continue;
+                }
+                for (MultiTransfer *transfer : transfers) {
+                    if (transfer->handle == msg->easy_handle && !transfer->done) {
+                        transfer->done = true;
+                        transfer->result = msg->data.result;
+                        --started;
+                    }
+                }
+            }
+            
+            // 恢复到时间的暂停传输，开始等待或加入新的传输
+            qint64 now = m_linkTimer.elapsed();
+            for (MultiTransfer *transfer : transfers) {
+                if (transfer->resumeAt >= 0 && transfer->resumeAt <= now && !transfer->done) {
+                    transfer->resumeAt = -1;
+                    curl_easy_pause(transfer->handle, CURLPAUSE_CONT);
+                }
+            }
+            added = admit();
+            
+            // 汇总整组传输的进度
+            if (progressCallback) {
+                qint64 bytesReceived = 0;
+                for (MultiTransfer *transfer : transfers) {
+                    bytesReceived += transfer->received;
+                }
+                progressCallback(bytesReceived, bytesTotal);
+            }
+        } while (running || added > 0 || !pending.isEmpty());
+    } else if (!discard) {
+        m_lastError = "无法初始化CURL多路句柄";
+    }
+    
+    // 统计结果并释放资源
+    for (MultiTransfer *transfer : transfers) {
+        if (!transfer->done || transfer->result != CURLE_OK) {
+            success = false;
+            if (!discard) {
+                CURLcode res = transfer->done ? transfer->result : CURLE_FAILED_INIT;
+                m_lastError = QString("下载文件失败: %1 (%2)").arg(transfer->remotePath).arg(curl_easy_strerror(res));
+                if (failedFiles && !failedFiles->contains(transfer->remotePath)) {
+                    failedFiles->append(transfer->remotePath);
+                }
+            }
+        }
+        
+        if (transfer->handle) {
+            if (multi) {
+                curl_multi_remove_handle(multi, transfer->handle);
+                recordInterfaceUsage(transfer->handle, transfer->interfaceName);
+                if (!discard) {
+                    recordTransferInfo(transfer->handle, transfer->remotePath,
+                                       transfer->done ? transfer->result : CURLE_FAILED_INIT);
+                }
+            }
+            curl_easy_cleanup(transfer->handle);
+        }
+        bool completed = !discard && transfer->done && transfer->result == CURLE_OK;
+        if (transfer->buffered) {
+            if (completed) {
+                m_localWriter->writeFile(transfer->localPath, static_cast<QBuffer*>(transfer->file)->data());
+            }
+            delete transfer->file;
+        } else if (!closeOutput(transfer->file, completed) && completed) {
+            success = false;
+            if (failedFiles && !failedFiles->contains(transfer->remotePath)) {
+                failedFiles->append(transfer->remotePath);
+            }
+        }
+        delete transfer;
+    }
+    
+    if (multi) {
+        curl_multi_cleanup(multi);
+    }
+    
+    return success;
+}
+
 /**
  * @brief CURL写入回调函数
  * @param contents 接收到的数据
@@ -562,15 +2303,46 @@ size_t FtpClient::WriteCallback(void *contents, size_t size, size_t nmemb, void
     FtpClient *client = static_cast<FtpClient*>(userp);
     
     if (client) {
-        // 将接收到的数据转换为字符串并添加到buffer
-        QByteArray data(static_cast<const char*>(contents), realsize);
-        QString line = QString::fromUtf8(data);
-        client->m_listBuffer.append(line.split("\n", Qt::SkipEmptyParts));
+        // 先缓存原始数据，传输结束后再按行拆分，避免多字节字符或行被数据块边界截断
+        client->m_receiveBuffer.append(static_cast<const char*>(contents), static_cast<qsizetype>(realsize));
     }
     
     return realsize;
 }
 
+/**
+ * @brief 上传数据读取回调函数
+ * @param buffer 输出缓冲区
+ * @param size 数据块大小
+ * @param nitems 数据块数量
+ * @param userp 用户数据指针
+ * @return 读取的数据大小
+ */
+size_t FtpClient::UploadCallback(char *buffer, size_t size, size_t nitems, void *userp)
+{
+    FtpClient *client = static_cast<FtpClient*>(userp);
+    if (!client || !client->m_currentUploadSource) {
+        return CURL_READFUNC_ABORT;
+    }
+    
+    // 没有可用数据时阻塞，直到数据源的读取线程交出下一个缓冲区
+    UploadSource *source = client->m_currentUploadSource;
+    qint64 length = source->read(buffer, static_cast<qint64>(size * nitems));
+    if (length < 0) {
+        return CURL_READFUNC_ABORT;
+    }
+    
+    // 模拟链路带宽限制
+    client->throttleTransfer(length);
+    
+    // 总大小未知时报告-1，由调用方显示已发送的字节数
+    if (client->m_progressCallback) {
+        client->m_progressCallback(source->bytesRead(), source->size());
+    }
+    
+    return static_cast<size_t>(length);
+}
+
 /**
  * @brief 下载文件回调函数
  * @param contents 接收到的数据
@@ -585,14 +2357,30 @@ size_t FtpClient::DownloadCallback(void *contents, size_t size, size_t nmemb, vo
     size_t realsize = size * nmemb;
     
     if (client && client->m_currentDownloadFile) {
+        HOTPATH_SPAN(callbackSpan, Callback, realsize);
+        
+        // 模拟链路带宽限制
+        {
+            HOTPATH_SPAN(throttleSpan, Throttle, realsize);
+            client->throttleTransfer(static_cast<qint64>(realsize));
+        }
+        
         // 将数据写入文件
-        qint64 written = client->m_currentDownloadFile->write(static_cast<char*>(contents), realsize);
+        qint64 written;
+        {
+            HOTPATH_SPAN(sinkSpan, Sink, realsize);
+            written = client->m_currentDownloadFile->write(static_cast<char*>(contents), realsize);
+        }
+        if (written < 0) {
+            return 0;
+        }
         
         // 更新下载进度
         client->m_totalBytesReceived += written;
         
         // 如果有回调函数，调用它更新进度
         if (client->m_progressCallback) {
+            HOTPATH_SPAN(progressSpan, Progress, realsize);
             client->m_progressCallback(client->m_totalBytesReceived, client->m_totalBytesReceived);
         }
         
@@ -7,7 +7,8 @@
  * 1. 连接/断开FTP服务器
  * 2. 浏览FTP服务器目录结构
  * 3. 下载文件和目录
- * 使用libcurl库处理FTP协议通信
+ * 使用libcurl库处理FTP协议通信，同时支持通过HTTP(S)服务器的目录索引页浏览和下载，
+ * 以及以file://地址访问本地目录（用于排除网络因素的基准测试和本地镜像）
  */
 
 #ifndef FTPCLIENT_H
@@ -18,7 +19,24 @@
 #include <QQueue>
 #include <QMutex>
 #include <QFile>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QRegularExpression>
+#include <functional>
+#include <memory>
+#include <atomic>
 #include <curl/curl.h> // libcurl头文件，用于FTP协议处理
+#include "downloadsink.h"
+#include "localfilewriter.h"
+#include "listingcache.h"
+#include "memorybudget.h"
+
+struct MultiTransfer;
+class BlockModeSession;
+class UploadSource;
+class QThread;
+class QHostAddress;
 
 /**
  * @struct DownloadTask
@@ -33,6 +51,66 @@ struct DownloadTask {
     bool isDirectory;        ///< 是否是目录（true表示目录，false表示文件）
     qint64 fileSize;         ///< 文件大小（字节数）
     QString displayName;     ///< 显示名称（用于进度对话框显示）
+    QStringList copyTargets; ///< 下载完成后还需复制到的其他本地路径（同一文件被多个作业请求时）
+};
+
+/**
+ * @struct RemoteEntry
+ * @brief 远程目录项
+ * 
+ * 目录列表（LIST或MLSD）解析后的单个条目
+ */
+struct RemoteEntry {
+    QString name;            ///< 名称（不含路径）
+    bool isDirectory = false; ///< 是否是目录
+    qint64 size = 0;         ///< 文件大小（字节数），未知时为0
+    QDateTime modified;      ///< 修改时间（UTC），未知时无效
+};
+
+/**
+ * @struct InterfaceStats
+ * @brief 本地接口吞吐统计
+ * 
+ * 记录通过某个本地网卡或源地址完成的传输字节数和耗时，
+ * 用于评估多条上行链路之间的负载分布
+ */
+struct InterfaceStats {
+    qint64 bytes = 0;        ///< 累计传输字节数
+    double seconds = 0.0;    ///< 累计传输耗时（秒）
+    int transfers = 0;       ///< 传输次数
+
+    /**
+     * @brief 平均吞吐量
+     * @return 字节/秒，未发生传输时返回0
+     */
+    double throughput() const { return seconds > 0.0 ? bytes / seconds : 0.0; }
+};
+
+/**
+ * @struct TransferRecord
+ * @brief 一次传输的记录
+ * 
+ * 每个文件的每次传输尝试一条，供传输历史的导出和离线分析使用
+ */
+struct TransferRecord {
+    qint64 started = 0;      ///< 开始时间（UTC毫秒）
+    QString server;          ///< 服务器标识（如"ftp.example.com:21"）
+    QString remotePath;      ///< 远程文件路径
+    QString localPath;       ///< 本地文件路径
+    qint64 bytes = 0;        ///< 传输的字节数
+    qint64 durationMs = 0;   ///< 耗时（毫秒）
+    int batchSize = 1;       ///< 同批传输的文件数，大于1时耗时为整批的耗时
+    bool success = false;    ///< 是否成功
+    QString error;           ///< 失败原因
+    int resultCode = 0;      ///< libcurl结果码，0为成功
+    int retries = 0;         ///< 重试次数（如服务器拒绝续传后从头重新下载）
+    qint64 connectionId = -1; ///< libcurl连接编号，复用同一连接的传输编号相同，未知时为-1
+    qint64 nameLookupUs = -1; ///< 从开始到域名解析完成的时间（微秒），未知时为-1
+    qint64 connectUs = -1;   ///< 从开始到连接建立的时间（微秒）
+    qint64 tlsUs = -1;       ///< 从开始到TLS握手完成的时间（微秒），未使用TLS时为-1
+    qint64 firstByteUs = -1; ///< 从开始到收到第一个字节的时间（微秒）
+    QString hash;            ///< 本地文件摘要（如"sha-256:..."），未计算时为空
+    bool upload = false;     ///< 是否为上传，上传记录不计入下载的吞吐统计
 };
 
 /**
@@ -44,10 +122,19 @@ struct DownloadTask {
 class FtpClient
 {
 public:
+    /**
+     * @brief 目录扫描模式
+     */
+    enum CrawlMode {
+        FullListCrawl,       ///< 使用LIST获取完整列表（默认）
+        MachineListCrawl     ///< 使用MLSD一次取得类型、大小和UTC修改时间，服务器不支持时退回LIST
+    };
+
     /**
      * @brief 构造函数
      * 
-     * 初始化CURL和相关资源
+     * 不初始化CURL，libcurl全局环境（含TLS库）在initialize()或第一次connect()时才初始化，
+     * 创建客户端不会拖慢程序启动
      */
     FtpClient();
     
@@ -58,6 +145,14 @@ public:
      */
     ~FtpClient();
 
+    /**
+     * @brief 初始化libcurl全局环境和主连接句柄
+     * @return 操作是否成功，失败原因见lastError()
+     *
+     * 可以在程序空闲时提前调用，否则由第一次connect()调用；重复调用直接返回
+     */
+    bool initialize();
+
     /**
      * @brief 连接FTP服务器
      * @param server 服务器地址
@@ -79,16 +174,80 @@ public:
      * @return 目录内容列表(每行一条目录项信息)
      */
     QStringList listDirectory(const QString &path = "/");
+
+    /**
+     * @brief 列出目录项
+     * @param path 要列出的目录路径
+     * @param entries 输出目录项，不包含"."和".."
+     * @return 操作是否成功
+     * 
+     * 与listDirectory不同，返回解析后的名称、类型和大小，并遵循当前的扫描模式和名称过滤条件
+     */
+    bool listEntries(const QString &path, QList<RemoteEntry> *entries);
+
+    /**
+     * @brief 请求服务器计算文件摘要（FTP HASH命令）
+     * @param remotePath 远程文件路径
+     * @param algorithm 输出服务器使用的摘要算法（如"SHA-256"）
+     * @param digest 输出十六进制摘要
+     * @return 服务器支持并成功返回摘要时为true
+     */
+    bool remoteHash(const QString &remotePath, QString *algorithm, QString *digest);
+
+    /**
+     * @brief 读取远程文件的一段数据
+     * @param remotePath 远程文件路径
+     * @param offset 起始偏移
+     * @param length 读取长度
+     * @param data 输出数据，文件较短时可能少于length
+     * @return 操作是否成功
+     * 
+     * 连续的区间读取复用同一个CURL句柄，FTP上只需在已登录的控制连接上发送REST/RETR
+     */
+    bool readRange(const QString &remotePath, qint64 offset, qint64 length, QByteArray *data);
     
     /**
      * @brief 下载文件
      * @param remotePath 远程文件路径
      * @param localPath 本地保存路径
      * @param progressCallback 进度回调函数(可选)
+     * @param resumeOffset 续传起始位置，大于0时追加到已有的本地文件（FTP REST / HTTP Range）
+     * @param remoteSize 远程文件大小，已知时在本地文件旁记录续传标记（"<本地路径>.part"），
+     *                   下载未完成时localResumeOffset()据此判断本地文件是否可以续传
      * @return 下载是否成功
+     * 
+     * 服务器不支持续传时自动从头重新下载
      */
     bool downloadFile(const QString &remotePath, const QString &localPath, 
-                      std::function<void(qint64, qint64)> progressCallback = nullptr);
+                      std::function<void(qint64, qint64)> progressCallback = nullptr,
+                      qint64 resumeOffset = 0, qint64 remoteSize = -1);
+
+    /**
+     * @brief 批量下载多个文件
+     * @param tasks 下载任务列表
+     * @param progressCallback 进度回调函数，报告整批的已接收字节数和总字节数
+     * @param failedFiles 输出下载失败的远程路径（可选）
+     * @return 是否全部下载成功
+     * 
+     * 所有文件通过CURL多路句柄并发下载，HTTP/2服务器上所有请求复用同一个连接
+     */
+    bool downloadFiles(const QList<DownloadTask> &tasks,
+                       std::function<void(qint64, qint64)> progressCallback = nullptr,
+                       QStringList *failedFiles = nullptr);
+
+    /**
+     * @brief 分段并行下载单个大文件
+     * @param remotePath 远程文件路径
+     * @param localPath 本地保存路径
+     * @param fileSize 远程文件大小（字节）
+     * @param segments 分段数量
+     * @param progressCallback 进度回调函数
+     * @return 下载是否成功
+     * 
+     * 每个分段使用独立的Range请求写入文件的对应位置，大小未知时退回普通下载
+     */
+    bool downloadFileSegmented(const QString &remotePath, const QString &localPath, qint64 fileSize,
+                               int segments, std::function<void(qint64, qint64)> progressCallback = nullptr);
     
     /**
      * @brief 下载目录
@@ -101,12 +260,79 @@ public:
     bool downloadDirectory(const QString &remotePath, const QString &localPath,
                           std::function<void(qint64, qint64)> progressCallback = nullptr,
                           QQueue<DownloadTask> *taskQueue = nullptr);
+
+    /**
+     * @brief 在一次扫描中下载多个目录
+     * @param roots 目录任务，remotePath和localPath分别为远程目录和对应的本地目录
+     * @param progressCallback 进度回调函数
+     * @param taskQueue 下载任务队列，用于存储所有目录中待下载的文件任务
+     * @return 是否全部成功，某个目录失败时仍继续扫描其余目录
+     * 
+     * 各目录共用一次扫描：子目录在全部扫描结束后一次性交给落盘线程池创建，
+     * 所有文件进入同一个任务队列；内存预算紧张时之后扫描到的文件写入溢出文件，
+     * 由调用方通过takeCrawlSpill()取走
+     */
+    bool downloadDirectories(const QList<DownloadTask> &roots,
+                             std::function<void(qint64, qint64)> progressCallback = nullptr,
+                             QQueue<DownloadTask> *taskQueue = nullptr);
+
+    /**
+     * @brief 取走上次扫描的溢出文件
+     * @return 溢出文件路径，没有溢出时为空；文件此后归调用方所有（见DownloadQueue::addSpillFile）
+     */
+    QString takeCrawlSpill();
+
+    /**
+     * @brief 流式上传文件
+     * @param source 上传数据源（本地文件、标准输入、子进程输出、内存数据或生成函数），未打开时自动打开
+     * @param remotePath 远程文件路径
+     * @param progressCallback 进度回调函数，报告已发送字节数和总字节数（未知时为-1）
+     * @return 上传是否成功，数据源出错（如导出命令异常退出）时中止上传并返回false
+     * 
+     * 总大小未知时不预先声明大小（FTP直接STOR到数据结束，HTTP使用分块传输）
+     */
+    bool uploadFile(UploadSource *source, const QString &remotePath,
+                    std::function<void(qint64, qint64)> progressCallback = nullptr);
     
     /**
      * @brief 获取当前连接状态
      * @return 是否已连接
      */
     bool isConnected() const { return m_isConnected; }
+
+    /**
+     * @brief 当前服务器是否为HTTP(S)服务器
+     * @return 是否使用HTTP(S)传输
+     */
+    bool isHttp() const { return m_isHttp; }
+
+    /**
+     * @brief 当前服务器是否为本地目录（file://）
+     * @return 是否使用本地传输
+     */
+    bool isLocal() const { return m_isLocal; }
+
+    /**
+     * @brief 获取本地传输的根目录
+     * @return file:// URL对应的本地目录路径
+     */
+    QString localRoot() const;
+
+    /**
+     * @brief 设置模拟链路参数
+     * @param latencyMs 每个请求的附加延迟（毫秒），0表示不附加
+     * @param bytesPerSecond 传输带宽上限（字节/秒），0表示不限制
+     * 
+     * 主要用于本地传输，在不引入真实网络的情况下模拟不同往返时延和带宽。
+     * 批量下载中每个文件同样各付出一次延迟，同时等待的文件数不超过连接数上限
+     */
+    void setSimulatedLink(int latencyMs, qint64 bytesPerSecond);
+
+    /**
+     * @brief 设置是否对FTP连接启用TLS（显式FTPS）
+     * @param enabled 为true时要求控制连接和数据连接都使用TLS
+     */
+    void setUseTls(bool enabled) { m_useTls = enabled; }
     
     /**
      * @brief 获取上一个错误消息
@@ -120,8 +346,183 @@ public:
      * @return 上级目录路径
      */
     QString getParentDirectory(const QString &path);
+
+    /**
+     * @brief 设置本地绑定接口
+     * @param interfaces 本地网卡名或源地址列表（如"eth0"、"192.168.1.10"、"if!eth1"、"host!10.0.0.2"），
+     *                   为空表示使用系统默认路由
+     * @param localPort 起始本地端口，0表示由系统分配
+     * @param localPortRange 从起始端口开始可尝试的端口数量
+     * 
+     * 每个新的传输按轮询方式绑定到列表中的下一个接口（CURLOPT_INTERFACE/CURLOPT_LOCALPORT），
+     * 使连续和并行的传输分散到多条上行链路上
+     */
+    void setLocalInterfaces(const QStringList &interfaces, int localPort = 0, int localPortRange = 0);
+
+    /**
+     * @brief 获取本地绑定接口列表
+     * @return 接口列表
+     */
+    QStringList localInterfaces() const { return m_localInterfaces; }
+
+    /**
+     * @brief 获取各本地接口的吞吐统计
+     * @return 接口名到统计信息的映射，未绑定接口时键为"default"
+     */
+    QHash<QString, InterfaceStats> interfaceStats() const { return m_interfaceStats; }
+
+    /**
+     * @brief 清空本地接口吞吐统计
+     */
+    void resetInterfaceStats() { m_interfaceStats.clear(); }
+
+    /**
+     * @brief 获取最近一次下载调用中某个文件的传输信息
+     * @param remotePath 远程文件路径
+     * @param record 输出记录，填写字节数、libcurl耗时、结果码、重试次数、连接编号和各阶段计时
+     * @return 有该文件的记录时返回true
+     * 
+     * 每次调用downloadFile()、downloadFiles()或downloadFileSegmented()时清空；
+     * 分段下载的各段合并为一条，块模式传输没有libcurl计时，不产生记录
+     */
+    bool transferInfo(const QString &remotePath, TransferRecord *record) const;
+
+    /**
+     * @brief 设置目录扫描模式
+     * @param mode 扫描模式
+     * 
+     * MachineListCrawl只对FTP服务器生效：每个目录只发送一次MLSD，同时得到子目录、
+     * 文件大小和UTC修改时间，无需逐个文件发送SIZE/MDTM，名称过滤在本地进行；
+     * 是否支持MLSD在第一个目录确定，服务器明确拒绝（500/502）后本次连接改用LIST，
+     * LIST不提供修改时间，退回后目录项的修改时间无效
+     */
+    void setCrawlMode(CrawlMode mode) { m_crawlMode = mode; }
+
+    /**
+     * @brief 服务器是否已在本次连接上拒绝MLSD
+     */
+    bool isMlsdUnsupported() const { return m_mlsdUnsupported; }
+
+    /**
+     * @brief 获取目录扫描模式
+     * @return 扫描模式
+     */
+    CrawlMode crawlMode() const { return m_crawlMode; }
+
+    /**
+     * @brief 设置文件名过滤条件
+     * @param patterns 通配符列表（如"*.log"、"report_??.csv"），不区分大小写，为空表示不过滤
+     * 
+     * 过滤条件只作用于目录下载中的文件，子目录总是会被继续扫描
+     */
+    void setNameFilter(const QStringList &patterns);
+
+    /**
+     * @brief 获取文件名过滤条件
+     * @return 通配符列表
+     */
+    QStringList nameFilter() const { return m_nameFilterPatterns; }
+
+    /**
+     * @brief 启用下载文件的落盘加密
+     * @param key 32字节密钥，为空表示关闭加密
+     * @param cipher 加密算法
+     * 
+     * 启用后所有下载在写盘时以分块认证加密格式保存（见EncryptedFileSink），
+     * 大文件不再分段并行下载，续传从最后一个完整的加密块开始
+     */
+    void setEncryption(const QByteArray &key, EncryptedFileSink::Cipher cipher = EncryptedFileSink::Aes256Gcm);
+
+    /**
+     * @brief 是否启用了落盘加密
+     */
+    bool isEncrypting() const { return m_encryptionKey.size() == EncryptedFileSink::KeySize; }
+
+    /**
+     * @brief 获取本地文件可续传的位置
+     * @param localPath 本地文件路径
+     * @param remotePath 远程文件路径
+     * @param remoteSize 远程文件大小
+     * @return 可以从该偏移继续下载；本地文件不能证明是该远程文件的未完成部分时为0（从头下载并覆盖）
+     * 
+     * 只有续传标记记录的远程路径、远程大小与本次一致，且本地文件大小仍是下载中断时记录的大小，
+     * 才视为未完成的下载；普通文件为文件大小，加密文件为完整加密块对应的明文大小
+     */
+    qint64 localResumeOffset(const QString &localPath, const QString &remotePath, qint64 remoteSize) const;
+
+    /**
+     * @brief 设置本地落盘器
+     * @param writer 落盘器，为空表示在下载线程中直接写文件；由调用方持有
+     * 
+     * 设置后，目录下载扫描到的子目录在扫描结束时批量并行创建，
+     * downloadFiles()中不超过落盘器小文件上限的文件先下载到内存，再交给落盘器批量写入。
+     * 调用方需要在使用这些文件前调用writer->flush()
+     */
+    void setLocalWriter(LocalFileWriter *writer) { m_localWriter = writer; }
+
+    /**
+     * @brief 设置目录列表缓存
+     * @param cache 缓存，为空表示不缓存；由调用方持有
+     * 
+     * listDirectory()和目录下载的完整列表扫描先查缓存，重新连接时清空
+     */
+    void setListingCache(ListingCache *cache) { m_listingCache = cache; }
+
+    /**
+     * @brief 设置内存预算
+     * @param budget 内存预算，为空表示不记账；由调用方持有
+     * 
+     * 目录下载扫描出的任务记入预算，预算紧张时扫描到的文件写入溢出文件而不再进入任务队列
+     */
+    void setMemoryBudget(MemoryBudget *budget) { m_budget = budget; }
+
+    /**
+     * @brief 设置是否尝试FTP块模式（MODE B）
+     * @param enabled 为true（默认）时，downloadFiles()在支持块模式的服务器上通过同一个数据连接依次传输所有文件
+     */
+    void setBlockModeEnabled(bool enabled) { m_blockModeEnabled = enabled; }
+
+    /**
+     * @brief 当前服务器是否可以使用块模式
+     * @return 连接时的探测已确认服务器接受MODE B时返回true
+     * 
+     * 不做任何网络操作，可以在界面线程中调用：探测在connect()成功后于后台线程进行，
+     * 完成之前返回false。使用TLS或启用了落盘加密时总是返回false
+     */
+    bool blockModeAvailable() const;
+
+    /**
+     * @brief 块模式会话建立过的数据连接数
+     * @return 数据连接数，未使用块模式时为0
+     */
+    int blockModeDataConnections() const;
+
+    /**
+     * @brief 设置块模式下数据连接的预热深度
+     * @param depth 当前文件结束前预先发出命令的后续文件数，0表示不预热（默认1）
+     *
+     * 服务器保持数据连接时预先发出后续文件的RETR，否则预先取得下一个数据连接，
+     * 同一控制连接上连续文件之间不再等待往返
+     */
+    void setPrewarmDepth(int depth);
+
+    /**
+     * @brief 设置批量下载时每个主机的最大连接数
+     * @param count 连接数，0（默认）表示HTTP为6、FTP为4
+     * 
+     * 多个客户端分担同一服务器的连接上限时，每个客户端只使用其中一部分
+     */
+    void setMaxHostConnections(int count) { m_maxHostConnections = qMax(0, count); }
     
 private:
+    /**
+     * @brief 目录列表命令
+     */
+    enum ListCommand {
+        ListFull,            ///< LIST，完整列表
+        ListMachine          ///< MLSD，机器可读的事实列表
+    };
+
     /**
      * @brief 列出目录内容用于下载
      * @param path 要列出的目录路径
@@ -161,21 +562,323 @@ private:
      */
     static size_t DownloadCallback(void *contents, size_t size, size_t nmemb, void *userp);
 
+    /**
+     * @brief 上传数据读取回调函数
+     * @param buffer 输出缓冲区
+     * @param size 数据块大小
+     * @param nitems 数据块数量
+     * @param userp 用户数据指针
+     * @return 读取的数据大小，0表示数据结束，数据源出错时为CURL_READFUNC_ABORT
+     */
+    static size_t UploadCallback(char *buffer, size_t size, size_t nitems, void *userp);
+
+    /**
+     * @brief 并发传输写入回调函数
+     * @param contents 接收到的数据
+     * @param size 数据块大小
+     * @param nmemb 数据块数量
+     * @param userp 指向MultiTransfer的指针
+     * @return 实际写入的数据大小
+     */
+    static size_t MultiWriteCallback(void *contents, size_t size, size_t nmemb, void *userp);
+
+    /**
+     * @brief 使用独立的CURL句柄获取目录列表
+     * @param normalizedPath 以/开头和结尾的远程目录路径
+     * @param lines 输出目录列表
+     * @param command 使用的列表命令
+     * @param responseCode 输出服务器最后的应答码，可以为nullptr
+     * @return 操作是否成功
+     */
+    bool fetchListing(const QString &normalizedPath, QStringList *lines, ListCommand command = ListFull,
+                      int *responseCode = nullptr);
+
+    /**
+     * @brief 把扫描到的任务追加到溢出文件
+     * @param task 下载任务
+     * @return 操作是否成功
+     */
+    bool spillCrawlTask(const DownloadTask &task);
+
+    /**
+     * @brief 获取目录项
+     * @param normalizedPath 以/开头和结尾的远程目录路径
+     * @param entries 输出目录项
+     * @return 操作是否成功
+     */
+    bool fetchEntries(const QString &normalizedPath, QList<RemoteEntry> *entries);
+
+    /**
+     * @brief 以MLSD获取目录项
+     * @param normalizedPath 以/开头和结尾的远程目录路径
+     * @param entries 输出目录项，带有大小和UTC修改时间
+     * @return 操作是否成功
+     * 
+     * 服务器明确拒绝MLSD时记录下来，本目录及之后的目录改用LIST
+     */
+    bool fetchMachineListEntries(const QString &normalizedPath, QList<RemoteEntry> *entries);
+
+    /**
+     * @brief 解析LIST格式的目录列表
+     * @param lines 目录列表
+     * @param normalizedPath 以/开头和结尾的远程目录路径，用于无法识别格式时探测目录
+     * @return 目录项列表，不包含"."和".."
+     */
+    QList<RemoteEntry> parseListLines(const QStringList &lines, const QString &normalizedPath);
+
+    /**
+     * @brief 解析MLSD格式的目录列表
+     * @param lines 目录列表（如"type=file;size=1024;modify=20240101120000; name"）
+     * @return 目录项列表，不包含"."和".."
+     */
+    static QList<RemoteEntry> parseMlsdLines(const QStringList &lines);
+
+    /**
+     * @brief 打开下载输出
+     * @param localPath 本地文件路径
+     * @param resumeOffset 续传偏移，0表示新建文件
+     * @return 已打开的输出设备（普通文件或加密输出），失败时返回nullptr
+     */
+    QIODevice *openOutput(const QString &localPath, qint64 resumeOffset);
+
+    /**
+     * @brief 写入续传标记
+     * @param localPath 本地文件路径
+     * @param remotePath 远程文件路径
+     * @param remoteSize 远程文件大小
+     * @param localBytes 下载中断时本地文件的大小，下载进行中为-1（此时不可续传）
+     */
+    static void writeResumeMarker(const QString &localPath, const QString &remotePath, qint64 remoteSize,
+                                  qint64 localBytes);
+
+    /**
+     * @brief 关闭并释放下载输出
+     * @param output 输出设备
+     * @param complete 下载是否已完整结束，加密输出只有此时才写入最后一块
+     * @return 输出是否成功写完
+     */
+    bool closeOutput(QIODevice *output, bool complete);
+
+    /**
+     * @brief 判断文件名是否匹配过滤条件
+     * @param name 文件名
+     * @return 未设置过滤条件或匹配任一通配符时返回true
+     */
+    bool matchesNameFilter(const QString &name) const;
+
+    /**
+     * @brief 以Unix列表格式列出本地目录
+     * @param path 相对于本地根目录的路径
+     * @param lines 输出目录列表
+     * @return 操作是否成功
+     */
+    bool localListing(const QString &path, QStringList *lines);
+
+    /**
+     * @brief 在请求开始前施加模拟延迟
+     */
+    void simulateLatency();
+
+    /**
+     * @brief 按模拟带宽限制传输速度
+     * @param bytes 本次收到的字节数
+     */
+    void throttleTransfer(qint64 bytes);
+
+    /**
+     * @brief 计算并发传输在模拟带宽下应暂停的时间，不休眠
+     * @param bytes 本次收到的字节数
+     * @return 应暂停的毫秒数；为0时字节已计入链路
+     */
+    qint64 linkDelay(qint64 bytes);
+
+    /**
+     * @brief 获取服务器基础URL
+     * @return 带协议前缀且不以/结尾的服务器地址
+     */
+    QString serverBaseUrl() const;
+
+    /**
+     * @brief 构建远程路径对应的完整URL
+     * @param path 远程路径
+     * @param isDirectory 是否是目录，目录URL以/结尾
+     * @return 经过编码的完整URL
+     */
+    QString buildUrl(const QString &path, bool isDirectory) const;
+
+    /**
+     * @brief 为CURL句柄设置认证、端口和协议相关的公共选项
+     * @param handle CURL句柄
+     */
+    void applyCommonOptions(CURL *handle);
+
+    /**
+     * @brief 取出接收缓冲区中的列表数据
+     * @return 按行拆分的目录列表，HTTP服务器的索引页会被转换为Unix列表格式
+     */
+    QStringList takeReceivedLines();
+
+    /**
+     * @brief 将HTTP服务器的目录索引页转换为Unix格式的目录列表
+     * @param html 索引页HTML内容
+     * @return Unix格式的目录列表
+     */
+    static QStringList htmlIndexToListing(const QString &html);
+
+    /**
+     * @brief 创建用于并发传输的CURL句柄
+     * @param url 完整的远程URL
+     * @param transfer 传输上下文
+     * @return CURL句柄，失败时返回nullptr
+     */
+    CURL *createTransferHandle(const QString &url, MultiTransfer *transfer);
+
+    /**
+     * @brief 通过块模式会话依次下载多个文件
+     * @param tasks 下载任务列表
+     * @param progressCallback 进度回调函数
+     * @param failedFiles 输出下载失败的远程路径（可选）
+     * @param remaining 输出会话中断后尚未尝试的任务，由调用方改用流模式下载
+     * @return 已尝试的文件是否全部下载成功
+     */
+    bool downloadFilesBlockMode(const QList<DownloadTask> &tasks,
+                                std::function<void(qint64, qint64)> progressCallback,
+                                QStringList *failedFiles, QList<DownloadTask> *remaining);
+
+    /**
+     * @brief 使用CURL多路句柄并发执行一组传输
+     * @param transfers 传输上下文列表，函数返回后全部释放
+     * @param bytesTotal 整组传输的总字节数
+     * @param progressCallback 进度回调函数
+     * @param failedFiles 输出失败的远程路径（可选）
+     * @param discard 为true时不执行传输，只释放资源
+     * @return 是否全部成功
+     */
+    bool performMulti(const QList<MultiTransfer*> &transfers, qint64 bytesTotal,
+                      std::function<void(qint64, qint64)> progressCallback,
+                      QStringList *failedFiles = nullptr, bool discard = false);
+
+    /**
+     * @brief 为CURL句柄绑定下一个本地接口
+     * @param handle CURL句柄
+     * @return 本次绑定的接口名，未配置接口时返回"default"
+     */
+    QString applyLocalBinding(CURL *handle);
+
+    /**
+     * @brief 按轮询方式取下一个本地绑定接口
+     * @return 接口名或源地址，未配置接口时为空
+     */
+    QString nextLocalInterface();
+
+    /**
+     * @brief 解析本地绑定接口对应的源地址
+     * @param interfaceSpec 接口名或源地址（可以带"if!"、"host!"前缀）
+     * @return 源地址，为空或无法解析时为空地址
+     *
+     * 网卡名取其第一个IPv4地址，没有时取第一个地址
+     */
+    static QHostAddress interfaceAddress(const QString &interfaceSpec);
+
+    /**
+     * @brief 是否满足使用块模式的前提（FTP、未使用TLS和落盘加密、未被禁用）
+     */
+    bool blockModeAllowed() const;
+
+    /**
+     * @brief 在后台线程中探测服务器是否接受MODE B
+     */
+    void startBlockModeProbe();
+
+    /**
+     * @brief 等待后台的块模式探测结束
+     */
+    void waitForBlockModeProbe();
+
+    /**
+     * @brief 确保块模式会话已打开
+     * @return 会话可用时返回true
+     *
+     * 服务器以5xx拒绝MODE B时记录下来，本次连接不再尝试；其他失败只影响当前这一批
+     */
+    bool ensureBlockSession();
+
+    /**
+     * @brief 记录一次传输的接口吞吐统计
+     * @param handle 已完成传输的CURL句柄
+     * @param interfaceName 本次传输使用的接口名
+     */
+    void recordInterfaceUsage(CURL *handle, const QString &interfaceName);
+
+    /**
+     * @brief 记录一个文件传输的libcurl计时和连接信息
+     * @param handle 已完成传输的CURL句柄
+     * @param remotePath 远程文件路径
+     * @param result 传输结果
+     */
+    void recordTransferInfo(CURL *handle, const QString &remotePath, CURLcode result);
+
 private:
     CURL* m_curl;                           ///< CURL句柄
+    CURL* m_rangeHandle;                    ///< 区间读取句柄，首次readRange()时创建，保持连接以供复用
     struct curl_slist *m_headers;           ///< CURL头部列表
     bool m_isConnected;                     ///< 连接状态
+    bool m_isHttp;                          ///< 是否为HTTP(S)服务器
+    bool m_isLocal;                         ///< 是否为本地目录（file://）
+    bool m_useTls;                          ///< 是否对FTP连接启用TLS
     QString m_server;                       ///< 服务器地址
     int m_port;                             ///< 端口号
     QString m_username;                     ///< 用户名
     QString m_password;                     ///< 密码
     QString m_lastError;                    ///< 最后一个错误消息
-    QStringList m_listBuffer;               ///< 列表数据缓冲区
+    QByteArray m_receiveBuffer;             ///< 列表数据接收缓冲区
     
     // 下载相关变量
-    QFile* m_currentDownloadFile;           ///< 当前下载文件
+    QIODevice* m_currentDownloadFile;       ///< 当前下载输出（普通文件或加密输出）
     qint64 m_totalBytesReceived;            ///< 已接收字节总数
     std::function<void(qint64, qint64)> m_progressCallback; ///< 进度回调函数
+
+    // 上传相关变量
+    UploadSource* m_currentUploadSource;    ///< 当前上传数据源（不拥有）
+
+    // 本地接口绑定相关变量
+    QStringList m_localInterfaces;          ///< 本地绑定接口列表
+    int m_localPort;                        ///< 起始本地端口
+    int m_localPortRange;                   ///< 本地端口范围
+    int m_nextInterface;                    ///< 下一个轮询使用的接口下标
+    QHash<QString, InterfaceStats> m_interfaceStats; ///< 各接口吞吐统计
+    QHash<QString, TransferRecord> m_transferInfo; ///< 最近一次下载调用中各文件的传输信息
+
+    // 模拟链路相关变量
+    int m_simulatedLatencyMs;               ///< 每个请求的附加延迟（毫秒）
+    qint64 m_simulatedBytesPerSecond;       ///< 模拟带宽上限（字节/秒）
+    qint64 m_linkBytes;                     ///< 本次传输已计入限速的字节数
+    QElapsedTimer m_linkTimer;              ///< 本次传输的计时器
+
+    // 目录扫描相关变量
+    CrawlMode m_crawlMode;                  ///< 目录扫描模式
+    QStringList m_nameFilterPatterns;       ///< 文件名通配符列表
+    QList<QRegularExpression> m_nameFilters; ///< 编译后的文件名过滤条件
+    bool m_mlsdUnsupported;                 ///< 服务器是否已确认不支持MLSD
+
+    // 落盘加密相关变量
+    QByteArray m_encryptionKey;             ///< 加密密钥，为空表示不加密
+    EncryptedFileSink::Cipher m_encryptionCipher; ///< 加密算法
+
+    // 本地落盘相关变量
+    LocalFileWriter *m_localWriter;         ///< 本地落盘器（不归本对象所有）
+    QStringList m_pendingDirectories;       ///< 扫描中推迟创建的本地目录
+    ListingCache *m_listingCache;           ///< 目录列表缓存（不归本对象所有）
+    MemoryBudget *m_budget;                 ///< 内存预算（不归本对象所有）
+    qint64 m_crawlQueueBytes;               ///< 本次扫描记入预算的任务字节数
+    QFile *m_crawlSpill;                    ///< 内存预算紧张时扫描到的任务的溢出文件
+    bool m_blockModeEnabled;                ///< 是否尝试块模式
+    std::atomic<int> m_blockModeState;      ///< 块模式探测结果：0未知，1服务器接受，-1服务器拒绝
+    QThread *m_blockProbe;                  ///< 连接后探测块模式的后台线程
+    std::unique_ptr<BlockModeSession> m_blockSession; ///< 块模式会话，在多批下载之间保持
+    int m_prewarmDepth;                     ///< 块模式数据连接预热深度
+    int m_maxHostConnections;               ///< 批量下载时每个主机的最大连接数，0表示默认
+    bool m_curlInitialized;                 ///< 是否已初始化libcurl全局环境
 };
 
 #endif // FTPCLIENT_H 
\ No newline at end of file
@@ -0,0 +1,70 @@
+# FTP客户端核心代码，供主程序和基准测试等工具共用
+INCLUDEPATH += $$PWD
+
+# 块模式（MODE B）会话直接使用TCP连接
+QT += network
+
+# 索引和传输记录导出到SQLite（QSQLITE驱动）
+QT += sql
+
+# 接收路径各阶段的周期级计时：qmake CONFIG+=hotpath_trace
+hotpath_trace: DEFINES += FTPCLIENT_HOTPATH_TRACE
+
+SOURCES += \
+    $$PWD/ftpclient.cpp \
+    $$PWD/downloadqueue.cpp \
+    $$PWD/remoteindex.cpp \
+    $$PWD/duplicatefinder.cpp \
+    $$PWD/downloadsink.cpp \
+    $$PWD/localfilewriter.cpp \
+    $$PWD/memorybudget.cpp \
+    $$PWD/listingcache.cpp \
+    $$PWD/connectionpool.cpp \
+    $$PWD/blockmodesession.cpp \
+    $$PWD/transferengine.cpp \
+    $$PWD/hotpathtrace.cpp \
+    $$PWD/hashcache.cpp \
+    $$PWD/contentprefetcher.cpp \
+    $$PWD/mirrorchecker.cpp \
+    $$PWD/sqliteexport.cpp \
+    $$PWD/transferledger.cpp \
+    $$PWD/directoryindex.cpp \
+    $$PWD/uploadsource.cpp \
+    $$PWD/downloadscheduler.cpp \
+    $$PWD/startupprofile.cpp \
+    $$PWD/sessioncache.cpp \
+    $$PWD/bytesize.cpp
+
+HEADERS += \
+    $$PWD/ftpclient.h \
+    $$PWD/downloadqueue.h \
+    $$PWD/remoteindex.h \
+    $$PWD/duplicatefinder.h \
+    $$PWD/downloadsink.h \
+    $$PWD/localfilewriter.h \
+    $$PWD/memorybudget.h \
+    $$PWD/listingcache.h \
+    $$PWD/connectionpool.h \
+    $$PWD/blockmodesession.h \
+    $$PWD/mpmcqueue.h \
+    $$PWD/transferengine.h \
+    $$PWD/hotpathtrace.h \
+    $$PWD/hashcache.h \
+    $$PWD/contentprefetcher.h \
+    $$PWD/mirrorchecker.h \
+    $$PWD/sqliteexport.h \
+    $$PWD/transferledger.h \
+    $$PWD/directoryindex.h \
+    $$PWD/uploadsource.h \
+    $$PWD/downloadscheduler.h \
+    $$PWD/startupprofile.h \
+    $$PWD/sessioncache.h \
+    $$PWD/bytesize.h
+
+# LibCURL configuration, libcrypto (LibreSSL bundled with curl) for encryption at rest
+win32 {
+    CURL_DIR = C:/curl
+    INCLUDEPATH += $$CURL_DIR/include
+    LIBS += -L$$CURL_DIR/lib -lcurl -lcrypto -lbcrypt -lws2_32
+}
+unix: LIBS += -lcurl -lcrypto
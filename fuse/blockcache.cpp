@@ -0,0 +1,270 @@
+/**
+ * @file blockcache.cpp
+ * @brief 远程文件数据块缓存实现文件
+ */
+
+#include "blockcache.h"
+#include "connectionpool.h"
+#include <cstring>
+
+// 顺序读取状态表的条目上限，超过时整体清空（只影响预读窗口的增长）
+static const int MAX_STREAMS = 1024;
+
+/**
+ * @brief 构造函数
+ * @param pool 连接池
+ * @param blockSize 数据块大小
+ * @param capacity 缓存容量
+ */
+BlockCache::BlockCache(ConnectionPool *pool, qint64 blockSize, qint64 capacity)
+    : m_pool(pool)
+    , m_blockSize(qMax<qint64>(4096, blockSize))
+    , m_capacity(qMax(capacity, m_blockSize))
+    , m_maxReadahead(8)
+    , m_bytes(0)
+{
+    // 预读最多占用连接池中除一个以外的全部连接，给前台读取留出余地
+    m_prefetchPool.setMaxThreadCount(qMax(1, m_pool->maxConnections() - 1));
+}
+
+/**
+ * @brief 析构函数，等待进行中的预读完成
+ */
+BlockCache::~BlockCache()
+{
+    m_prefetchPool.waitForDone();
+}
+
+/**
+ * @brief 读取远程文件的一段数据
+ * @param remotePath 远程文件路径
+ * @param fileSize 文件大小
+ * @param offset 起始偏移
+ * @param buffer 输出缓冲区
+ * @param length 读取长度
+ * @return 实际读取的字节数，失败时返回-1
+ */
+qint64 BlockCache::read(const QString &remotePath, qint64 fileSize, qint64 offset, char *buffer, qint64 length)
+{
+    if (offset >= fileSize || length <= 0) {
+        return 0;
+    }
+    length = qMin(length, fileSize - offset);
+    qint64 first = offset / m_blockSize;
+    qint64 last = (offset + length - 1) / m_blockSize;
+    qint64 blockCount = (fileSize + m_blockSize - 1) / m_blockSize;
+
+    // 从上次结束处继续读取视为顺序读取，预读窗口翻倍；否则归零
+    int window;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_streams.size() >= MAX_STREAMS && !m_streams.contains(remotePath)) {
+            m_streams.clear();
+        }
+        Stream &stream = m_streams[remotePath];
+        if (offset == stream.nextOffset) {
+            stream.window = qMin(m_maxReadahead, stream.window > 0 ? stream.window * 2 : 1);
+        } else {
+            stream.window = 0;
+        }
+        stream.nextOffset = offset + length;
+        window = stream.window;
+    }
+
+    // 登记本次需要的数据块，新登记的由当前线程获取
+    QList<BlockPtr> blocks;
+    QList<qint64> owned;
+    for (qint64 index = first; index <= last; ++index) {
+        bool created = false;
+        blocks.append(lookupBlock(remotePath, index, &created));
+        if (created) {
+            owned.append(index);
+        }
+    }
+
+    // 先把预读交给后台，使其与前台的获取并行进行
+    for (qint64 index = last + 1; index <= last + window && index < blockCount; ++index) {
+        bool created = false;
+        BlockPtr block = lookupBlock(remotePath, index, &created);
+        if (created) {
+            m_prefetchPool.start([this, remotePath, index, fileSize, block]() {
+                fetchBlock(remotePath, index, fileSize, block);
+            });
+        }
+    }
+
+    for (qint64 index : owned) {
+        fetchBlock(remotePath, index, fileSize, blocks.at(index - first));
+    }
+
+    // 拷贝数据；获取完成后数据块的内容不再改变，可以在锁外读取
+    qint64 copied = 0;
+    for (qint64 index = first; index <= last; ++index) {
+        const BlockPtr &block = blocks.at(index - first);
+        if (!waitBlock(block)) {
+            return copied > 0 ? copied : -1;
+        }
+        qint64 blockStart = index * m_blockSize;
+        qint64 from = offset + copied - blockStart;
+        qint64 count = qMin<qint64>(block->data.size() - from, length - copied);
+        if (count <= 0) {
+            break;
+        }
+        memcpy(buffer + copied, block->data.constData() + from, count);
+        copied += count;
+        // 文件在服务器上变短时数据块不满，之后没有数据可读
+        if (block->data.size() < m_blockSize) {
+            break;
+        }
+    }
+    return copied;
+}
+
+/**
+ * @brief 丢弃一个文件的所有缓存数据块
+ * @param remotePath 远程文件路径
+ */
+void BlockCache::invalidate(const QString &remotePath)
+{
+    QString prefix = remotePath + '\n';
+    QMutexLocker locker(&m_mutex);
+    const QList<QString> keys = m_blocks.keys();
+    for (const QString &key : keys) {
+        if (key.startsWith(prefix)) {
+            removeLocked(key);
+        }
+    }
+    m_streams.remove(remotePath);
+}
+
+/**
+ * @brief 当前缓存的数据量
+ * @return 字节数
+ */
+qint64 BlockCache::cachedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+/**
+ * @brief 生成数据块的缓存键
+ * @param remotePath 远程文件路径
+ * @param index 数据块编号
+ * @return 缓存键
+ */
+QString BlockCache::blockKey(const QString &remotePath, qint64 index)
+{
+    return remotePath + '\n' + QString::number(index);
+}
+
+/**
+ * @brief 查找或登记一个数据块
+ * @param remotePath 远程文件路径
+ * @param index 数据块编号
+ * @param created 输出参数
+ * @return 数据块
+ */
+BlockCache::BlockPtr BlockCache::lookupBlock(const QString &remotePath, qint64 index, bool *created)
+{
+    QString key = blockKey(remotePath, index);
+    QMutexLocker locker(&m_mutex);
+    auto it = m_blocks.constFind(key);
+    if (it != m_blocks.constEnd()) {
+        m_order.removeOne(key);
+        m_order.append(key);
+        *created = false;
+        return it.value();
+    }
+
+    BlockPtr block(new Block);
+    m_blocks.insert(key, block);
+    m_order.append(key);
+    *created = true;
+    return block;
+}
+
+/**
+ * @brief 获取一个数据块的内容并唤醒等待者
+ * @param remotePath 远程文件路径
+ * @param index 数据块编号
+ * @param fileSize 文件大小
+ * @param block 数据块
+ */
+void BlockCache::fetchBlock(const QString &remotePath, qint64 index, qint64 fileSize, BlockPtr block)
+{
+    qint64 start = index * m_blockSize;
+    qint64 length = qMin(m_blockSize, fileSize - start);
+
+    QByteArray data;
+    bool ok = false;
+    FtpClient *client = m_pool->acquire();
+    if (client) {
+        ok = client->readRange(remotePath, start, length, &data);
+        m_pool->release(client, ok);
+    }
+
+    QString key = blockKey(remotePath, index);
+    QMutexLocker locker(&m_mutex);
+    block->data = data;
+    block->failed = !ok;
+    block->ready = true;
+    if (m_blocks.value(key) == block) {
+        if (ok) {
+            m_bytes += data.size();
+            trimLocked();
+        } else {
+            // 失败的数据块不保留，下次读取时重新获取
+            removeLocked(key);
+        }
+    }
+    m_ready.wakeAll();
+}
+
+/**
+ * @brief 等待数据块获取完成
+ * @param block 数据块
+ * @return 获取成功时返回true
+ */
+bool BlockCache::waitBlock(const BlockPtr &block)
+{
+    QMutexLocker locker(&m_mutex);
+    while (!block->ready) {
+        m_ready.wait(&m_mutex);
+    }
+    return !block->failed;
+}
+
+/**
+ * @brief 移除一个数据块，调用方需持有m_mutex
+ * @param key 缓存键
+ */
+void BlockCache::removeLocked(const QString &key)
+{
+    BlockPtr block = m_blocks.take(key);
+    if (!block) {
+        return;
+    }
+    m_order.removeOne(key);
+    // 未完成的数据块尚未计入m_bytes，其获取线程发现已被移除后不会再计入
+    if (block->ready && !block->failed) {
+        m_bytes -= block->data.size();
+    }
+}
+
+/**
+ * @brief 淘汰最久未用的数据块直到不超过容量，调用方需持有m_mutex
+ */
+void BlockCache::trimLocked()
+{
+    int i = 0;
+    while (m_bytes > m_capacity && i < m_order.size()) {
+        QString key = m_order.at(i);
+        BlockPtr block = m_blocks.value(key);
+        if (block && block->ready) {
+            removeLocked(key);
+        } else {
+            ++i;
+        }
+    }
+}
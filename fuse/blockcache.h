@@ -0,0 +1,150 @@
+/**
+ * @file blockcache.h
+ * @brief 远程文件数据块缓存
+ * @details 把远程文件按固定大小切成数据块，通过连接池上的区间读取（FTP REST+RETR、HTTP Range）
+ *          按需获取并缓存，检测到顺序读取时在后台预读后续数据块
+ *
+ * 预读窗口从1块开始，每次连续的顺序读取翻倍，直到setMaxReadahead()的上限；
+ * 一旦出现随机访问，窗口归零，避免为随机读取浪费带宽
+ */
+
+#ifndef BLOCKCACHE_H
+#define BLOCKCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSharedPointer>
+#include <QThreadPool>
+
+class ConnectionPool;
+
+/**
+ * @class BlockCache
+ * @brief 带顺序预读的LRU数据块缓存
+ *
+ * 所有方法都是线程安全的，可以被多个文件系统线程同时调用
+ */
+class BlockCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param pool 连接池，由调用方持有
+     * @param blockSize 数据块大小（字节）
+     * @param capacity 缓存容量（字节）
+     */
+    BlockCache(ConnectionPool *pool, qint64 blockSize = 1024 * 1024, qint64 capacity = 64 * 1024 * 1024);
+
+    /**
+     * @brief 析构函数，等待进行中的预读完成
+     */
+    ~BlockCache();
+
+    /**
+     * @brief 设置最大预读块数
+     * @param blocks 顺序读取时最多提前获取的数据块数，0表示不预读
+     */
+    void setMaxReadahead(int blocks) { m_maxReadahead = qMax(0, blocks); }
+
+    /**
+     * @brief 读取远程文件的一段数据
+     * @param remotePath 远程文件路径
+     * @param fileSize 文件大小
+     * @param offset 起始偏移
+     * @param buffer 输出缓冲区
+     * @param length 读取长度
+     * @return 实际读取的字节数，到达文件末尾时可能小于length；失败时返回-1
+     */
+    qint64 read(const QString &remotePath, qint64 fileSize, qint64 offset, char *buffer, qint64 length);
+
+    /**
+     * @brief 丢弃一个文件的所有缓存数据块
+     * @param remotePath 远程文件路径
+     */
+    void invalidate(const QString &remotePath);
+
+    /**
+     * @brief 当前缓存的数据量
+     * @return 字节数
+     */
+    qint64 cachedBytes() const;
+
+private:
+    /**
+     * @struct Block
+     * @brief 数据块，获取完成前ready为false，等待者在m_ready上等待
+     */
+    struct Block {
+        QByteArray data;      ///< 数据
+        bool ready = false;   ///< 是否已获取完成
+        bool failed = false;  ///< 获取是否失败
+    };
+    typedef QSharedPointer<Block> BlockPtr;
+
+    /**
+     * @struct Stream
+     * @brief 单个文件的顺序读取状态
+     */
+    struct Stream {
+        qint64 nextOffset = 0; ///< 顺序读取时下一次读取的偏移
+        int window = 0;        ///< 当前预读窗口（块数）
+    };
+
+    /**
+     * @brief 生成数据块的缓存键
+     */
+    static QString blockKey(const QString &remotePath, qint64 index);
+
+    /**
+     * @brief 查找或登记一个数据块
+     * @param remotePath 远程文件路径
+     * @param index 数据块编号
+     * @param created 输出参数，新登记（需要由调用方获取）时为true
+     * @return 数据块
+     */
+    BlockPtr lookupBlock(const QString &remotePath, qint64 index, bool *created);
+
+    /**
+     * @brief 获取一个数据块的内容并唤醒等待者
+     * @param remotePath 远程文件路径
+     * @param index 数据块编号
+     * @param fileSize 文件大小
+     * @param block 数据块
+     */
+    void fetchBlock(const QString &remotePath, qint64 index, qint64 fileSize, BlockPtr block);
+
+    /**
+     * @brief 等待数据块获取完成
+     * @return 获取成功时返回true
+     */
+    bool waitBlock(const BlockPtr &block);
+
+    /**
+     * @brief 移除一个数据块，调用方需持有m_mutex
+     */
+    void removeLocked(const QString &key);
+
+    /**
+     * @brief 淘汰最久未用的数据块直到不超过容量，调用方需持有m_mutex
+     */
+    void trimLocked();
+
+private:
+    ConnectionPool *m_pool;              ///< 连接池（不拥有）
+    qint64 m_blockSize;                  ///< 数据块大小
+    qint64 m_capacity;                   ///< 缓存容量
+    int m_maxReadahead;                  ///< 最大预读块数
+    mutable QMutex m_mutex;              ///< 保护以下成员
+    QWaitCondition m_ready;              ///< 数据块获取完成时唤醒等待者
+    QHash<QString, BlockPtr> m_blocks;   ///< 缓存键到数据块
+    QList<QString> m_order;              ///< 使用顺序，末尾为最近使用
+    QHash<QString, Stream> m_streams;    ///< 各文件的顺序读取状态
+    qint64 m_bytes;                      ///< 已缓存的数据量
+    QThreadPool m_prefetchPool;          ///< 预读线程池
+};
+
+#endif // BLOCKCACHE_H
@@ -0,0 +1,237 @@
+/**
+ * @file ftpfuse.cpp
+ * @brief 以只读文件系统挂载FTP/HTTP服务器
+ *
+ * 分析人员可以直接用常规工具打开远程文件，而不必先下载：
+ *   ftpfuse [选项] <服务器地址> <挂载点>
+ * 目录内容按需列出并按--ttl缓存，或者用--index加载RemoteIndex生成的索引而完全不列目录；
+ * 文件数据通过连接池上的区间读取按块获取，顺序读取时在后台预读。
+ *
+ * 服务器地址也可以是file://目录，配合--latency/--bandwidth模拟链路，
+ * 在没有FTP服务器的情况下测试缓存和预读的效果。卸载使用fusermount3 -u <挂载点>
+ */
+
+#define FUSE_USE_VERSION 31
+
+#include "connectionpool.h"
+#include "blockcache.h"
+#include "remotefs.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QDateTime>
+#include <fuse.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+// FUSE回调没有用户参数，文件系统对象通过全局指针访问
+static RemoteFs *g_fs = nullptr;
+static int g_ttlSeconds = 30;
+static time_t g_mountTime = 0;
+
+/**
+ * @brief 把目录项转换为stat结构
+ * @param entry 目录项
+ * @param st 输出stat结构
+ */
+static void fillStat(const RemoteEntry &entry, struct stat *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->st_mode = entry.isDirectory ? (S_IFDIR | 0555) : (S_IFREG | 0444);
+    st->st_nlink = entry.isDirectory ? 2 : 1;
+    st->st_size = entry.isDirectory ? 0 : entry.size;
+    st->st_uid = getuid();
+    st->st_gid = getgid();
+    // 完整列表中没有精确的修改时间，未知时使用挂载时间
+    time_t mtime = entry.modified.isValid() ? entry.modified.toSecsSinceEpoch() : g_mountTime;
+    st->st_mtime = st->st_ctime = st->st_atime = mtime;
+}
+
+/**
+ * @brief 初始化回调，设置内核缓存参数
+ */
+static void *fsInit(struct fuse_conn_info *conn, struct fuse_config *cfg)
+{
+    Q_UNUSED(conn);
+    // 元数据在内核中按相同的有效期缓存；文件内容只读，可以保留在页缓存中
+    cfg->attr_timeout = g_ttlSeconds;
+    cfg->entry_timeout = g_ttlSeconds;
+    cfg->negative_timeout = g_ttlSeconds;
+    cfg->kernel_cache = 1;
+    return nullptr;
+}
+
+/**
+ * @brief 获取文件属性回调
+ */
+static int fsGetattr(const char *path, struct stat *st, struct fuse_file_info *fi)
+{
+    Q_UNUSED(fi);
+    RemoteEntry entry;
+    int result = g_fs->stat(QString::fromUtf8(path), &entry);
+    if (result == 0) {
+        fillStat(entry, st);
+    }
+    return result;
+}
+
+/**
+ * @brief 列出目录回调
+ */
+static int fsReaddir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset,
+                     struct fuse_file_info *fi, enum fuse_readdir_flags flags)
+{
+    Q_UNUSED(offset);
+    Q_UNUSED(fi);
+    Q_UNUSED(flags);
+    QList<RemoteEntry> entries;
+    int result = g_fs->readDirectory(QString::fromUtf8(path), &entries);
+    if (result != 0) {
+        return result;
+    }
+
+    filler(buf, ".", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    filler(buf, "..", nullptr, 0, static_cast<fuse_fill_dir_flags>(0));
+    for (const RemoteEntry &entry : entries) {
+        struct stat st;
+        fillStat(entry, &st);
+        if (filler(buf, entry.name.toUtf8().constData(), &st, 0, static_cast<fuse_fill_dir_flags>(0))) {
+            break;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief 打开文件回调，只允许只读打开
+ */
+static int fsOpen(const char *path, struct fuse_file_info *fi)
+{
+    if ((fi->flags & O_ACCMODE) != O_RDONLY) {
+        return -EROFS;
+    }
+    RemoteEntry entry;
+    int result = g_fs->stat(QString::fromUtf8(path), &entry);
+    if (result != 0) {
+        return result;
+    }
+    if (entry.isDirectory) {
+        return -EISDIR;
+    }
+    fi->keep_cache = 1;
+    return 0;
+}
+
+/**
+ * @brief 读取文件回调
+ */
+static int fsRead(const char *path, char *buf, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    Q_UNUSED(fi);
+    return static_cast<int>(g_fs->read(QString::fromUtf8(path), offset, buf, static_cast<qint64>(size)));
+}
+
+/**
+ * @brief 主函数
+ * @param argc 命令行参数数量
+ * @param argv 命令行参数数组
+ * @return 程序退出代码
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ftpfuse");
+    QTextStream out(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("以只读文件系统挂载FTP/HTTP服务器");
+    parser.addHelpOption();
+    parser.addPositionalArgument("server", "服务器地址（ftp://、http(s)://或file://）");
+    parser.addPositionalArgument("mountpoint", "挂载点");
+    QCommandLineOption portOption("port", "端口号", "port", "21");
+    QCommandLineOption userOption("user", "用户名", "name");
+    QCommandLineOption passwordOption("password", "密码", "password");
+    QCommandLineOption tlsOption("tls", "对FTP连接启用TLS");
+    QCommandLineOption rootOption("root", "挂载的远程目录", "path", "/");
+    QCommandLineOption connectionsOption("connections", "连接池大小", "count", "4");
+    QCommandLineOption blockSizeOption("block-size", "数据块大小（KiB）", "kib", "1024");
+    QCommandLineOption cacheOption("cache", "数据块缓存容量（MiB）", "mib", "256");
+    QCommandLineOption readaheadOption("readahead", "顺序读取时最多预读的数据块数", "blocks", "8");
+    QCommandLineOption ttlOption("ttl", "元数据缓存有效期（秒）", "seconds", "30");
+    QCommandLineOption indexOption("index", "从RemoteIndex索引文件加载目录树", "file");
+    QCommandLineOption latencyOption("latency", "模拟每个请求的附加延迟（毫秒，用于file://）", "ms", "0");
+    QCommandLineOption bandwidthOption("bandwidth", "模拟每个连接的带宽（字节/秒，用于file://）", "bytes", "0");
+    QCommandLineOption foregroundOption(QStringList() << "f" << "foreground", "在前台运行");
+    parser.addOptions({portOption, userOption, passwordOption, tlsOption, rootOption, connectionsOption,
+                       blockSizeOption, cacheOption, readaheadOption, ttlOption, indexOption,
+                       latencyOption, bandwidthOption, foregroundOption});
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    if (positional.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    // 连接池中的每个连接使用相同的TLS和模拟链路设置
+    bool useTls = parser.isSet(tlsOption);
+    int latencyMs = parser.value(latencyOption).toInt();
+    qint64 bandwidth = parser.value(bandwidthOption).toLongLong();
+    ConnectionPool pool(parser.value(connectionsOption).toInt());
+    pool.setServer(positional.at(0), parser.value(portOption).toInt(),
+                   parser.value(userOption), parser.value(passwordOption));
+    pool.setConfigurator([useTls, latencyMs, bandwidth](FtpClient *client) {
+        client->setUseTls(useTls);
+        client->setSimulatedLink(latencyMs, bandwidth);
+    });
+
+    // 先试连一次，服务器不可用时在挂载前报错；libfuse转入后台时会fork，不保留这个连接
+    FtpClient *probe = pool.acquire();
+    if (!probe) {
+        out << "无法连接服务器: " << pool.lastError() << "\n";
+        return 1;
+    }
+    pool.release(probe, false);
+
+    BlockCache blockCache(&pool, parser.value(blockSizeOption).toLongLong() * 1024,
+                          parser.value(cacheOption).toLongLong() * 1024 * 1024);
+    blockCache.setMaxReadahead(parser.value(readaheadOption).toInt());
+
+    g_ttlSeconds = qMax(0, parser.value(ttlOption).toInt());
+    g_mountTime = QDateTime::currentSecsSinceEpoch();
+    RemoteFs fs(&pool, parser.value(rootOption), &blockCache);
+    fs.setMetadataTtl(g_ttlSeconds * 1000);
+    if (parser.isSet(indexOption) && !fs.loadIndex(parser.value(indexOption))) {
+        out << fs.lastError() << "\n";
+        return 1;
+    }
+    g_fs = &fs;
+
+    struct fuse_operations operations;
+    memset(&operations, 0, sizeof(operations));
+    operations.init = fsInit;
+    operations.getattr = fsGetattr;
+    operations.readdir = fsReaddir;
+    operations.open = fsOpen;
+    operations.read = fsRead;
+
+    // 把挂载参数交给libfuse，只读挂载，多线程处理请求
+    QByteArray program = QCoreApplication::arguments().first().toLocal8Bit();
+    QByteArray mountpoint = positional.at(1).toLocal8Bit();
+    QByteArray mountOptions = "ro,fsname=ftpfuse,subtype=ftpfuse";
+    QByteArray optionFlag = "-o";
+    QByteArray foregroundFlag = "-f";
+    std::vector<char *> fuseArgs;
+    fuseArgs.push_back(program.data());
+    fuseArgs.push_back(mountpoint.data());
+    fuseArgs.push_back(optionFlag.data());
+    fuseArgs.push_back(mountOptions.data());
+    if (parser.isSet(foregroundOption)) {
+        fuseArgs.push_back(foregroundFlag.data());
+    }
+    fuseArgs.push_back(nullptr);
+
+    return fuse_main(static_cast<int>(fuseArgs.size()) - 1, fuseArgs.data(), &operations, nullptr);
+}
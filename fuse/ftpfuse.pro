@@ -0,0 +1,23 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console link_pkgconfig
+CONFIG -= app_bundle
+
+TARGET = ftpfuse
+
+# 只读FUSE挂载，仅支持Linux（libfuse3）
+!linux: error("ftpfuse requires Linux and libfuse3")
+PKGCONFIG += fuse3
+
+SOURCES += \
+    ftpfuse.cpp \
+    remotefs.cpp \
+    blockcache.cpp
+
+HEADERS += \
+    remotefs.h \
+    blockcache.h
+
+# FTP client core and LibCURL configuration
+include(../ftpcore.pri)
@@ -0,0 +1,245 @@
+/**
+ * @file remotefs.cpp
+ * @brief 只读远程文件系统实现文件
+ */
+
+#include "remotefs.h"
+#include "connectionpool.h"
+#include "remoteindex.h"
+#include <QFile>
+#include <QSet>
+#include <QTimeZone>
+#include <cerrno>
+
+/**
+ * @brief 构造函数
+ * @param pool 连接池
+ * @param remoteRoot 挂载的远程根目录
+ * @param blockCache 数据块缓存
+ */
+RemoteFs::RemoteFs(ConnectionPool *pool, const QString &remoteRoot, BlockCache *blockCache)
+    : m_pool(pool)
+    , m_remoteRoot(normalize(remoteRoot))
+    , m_blockCache(blockCache)
+    , m_ttlMs(30 * 1000)
+{
+    if (m_remoteRoot == "/") {
+        m_remoteRoot.clear();
+    }
+}
+
+/**
+ * @brief 加载远程索引
+ * @param indexPath 索引文件
+ * @return 操作是否成功
+ */
+bool RemoteFs::loadIndex(const QString &indexPath)
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = QString("无法打开索引文件: %1").arg(indexPath);
+        return false;
+    }
+
+    QHash<QString, Directory> directories;
+    QSet<QString> knownDirectories;
+    knownDirectories.insert("/");
+    directories["/"].permanent = true;
+
+    QString prefix = m_remoteRoot + "/";
+    while (!file.atEnd()) {
+        IndexRecord record;
+        if (!RemoteIndex::parseRecord(file.readLine(), &record) || !record.path.startsWith(prefix)) {
+            continue;
+        }
+
+        // 文件加入所在目录，再逐级补齐尚未出现的上级目录
+        QString path = record.path.mid(m_remoteRoot.size());
+        QString parent = path.section('/', 0, -2);
+        RemoteEntry entry;
+        entry.name = path.section('/', -1);
+        entry.size = record.size;
+        if (record.modified >= 0) {
+            entry.modified = QDateTime::fromSecsSinceEpoch(record.modified, QTimeZone::UTC);
+        }
+
+        QString dirPath = parent.isEmpty() ? "/" : parent;
+        Directory &dir = directories[dirPath];
+        dir.permanent = true;
+        dir.byName.insert(entry.name, dir.entries.size());
+        dir.entries.append(entry);
+
+        while (!parent.isEmpty() && !knownDirectories.contains(parent)) {
+            knownDirectories.insert(parent);
+            QString grandParent = parent.section('/', 0, -2);
+            RemoteEntry dirEntry;
+            dirEntry.name = parent.section('/', -1);
+            dirEntry.isDirectory = true;
+            Directory &container = directories[grandParent.isEmpty() ? "/" : grandParent];
+            container.permanent = true;
+            container.byName.insert(dirEntry.name, container.entries.size());
+            container.entries.append(dirEntry);
+            parent = grandParent;
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = directories.begin(); it != directories.end(); ++it) {
+        m_directories.insert(it.key(), it.value());
+    }
+    return true;
+}
+
+/**
+ * @brief 获取文件或目录的元数据
+ * @param path 挂载点内的路径
+ * @param entry 输出目录项
+ * @return 0或负的errno
+ */
+int RemoteFs::stat(const QString &path, RemoteEntry *entry)
+{
+    QString clean = normalize(path);
+    if (clean == "/") {
+        *entry = RemoteEntry();
+        entry->name = "/";
+        entry->isDirectory = true;
+        return 0;
+    }
+
+    QString parent = clean.section('/', 0, -2);
+    Directory directory;
+    int result = lookupDirectory(parent.isEmpty() ? "/" : parent, &directory);
+    if (result != 0) {
+        return result;
+    }
+
+    auto it = directory.byName.constFind(clean.section('/', -1));
+    if (it == directory.byName.constEnd()) {
+        return -ENOENT;
+    }
+    *entry = directory.entries.at(it.value());
+    return 0;
+}
+
+/**
+ * @brief 列出目录
+ * @param path 挂载点内的目录路径
+ * @param entries 输出目录项
+ * @return 0或负的errno
+ */
+int RemoteFs::readDirectory(const QString &path, QList<RemoteEntry> *entries)
+{
+    Directory directory;
+    int result = lookupDirectory(normalize(path), &directory);
+    if (result == 0) {
+        *entries = directory.entries;
+    }
+    return result;
+}
+
+/**
+ * @brief 读取文件
+ * @param path 挂载点内的文件路径
+ * @param offset 起始偏移
+ * @param buffer 输出缓冲区
+ * @param length 读取长度
+ * @return 读取的字节数或负的errno
+ */
+qint64 RemoteFs::read(const QString &path, qint64 offset, char *buffer, qint64 length)
+{
+    RemoteEntry entry;
+    int result = stat(path, &entry);
+    if (result != 0) {
+        return result;
+    }
+    if (entry.isDirectory) {
+        return -EISDIR;
+    }
+
+    qint64 count = m_blockCache->read(remotePath(normalize(path)), entry.size, offset, buffer, length);
+    return count < 0 ? -EIO : count;
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString RemoteFs::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief 挂载点内的路径对应的远程路径
+ * @param path 挂载点内规范化后的路径
+ * @return 远程路径
+ */
+QString RemoteFs::remotePath(const QString &path) const
+{
+    return path == "/" ? (m_remoteRoot.isEmpty() ? "/" : m_remoteRoot) : m_remoteRoot + path;
+}
+
+/**
+ * @brief 获取目录内容，必要时通过连接池列出
+ * @param path 挂载点内规范化后的目录路径
+ * @param directory 输出目录内容
+ * @return 0或负的errno
+ */
+int RemoteFs::lookupDirectory(const QString &path, Directory *directory)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_directories.constFind(path);
+        if (it != m_directories.constEnd() && (it->permanent || !it->age.hasExpired(m_ttlMs))) {
+            *directory = it.value();
+            return 0;
+        }
+    }
+
+    // 在锁外列出目录，多个线程可能同时列出同一目录，结果相同，后写入的覆盖先写入的
+    FtpClient *client = m_pool->acquire();
+    if (!client) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = m_pool->lastError();
+        return -EIO;
+    }
+    QList<RemoteEntry> entries;
+    bool ok = client->listEntries(remotePath(path), &entries);
+    QString error = client->lastError();
+    m_pool->release(client);
+    if (!ok) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = error;
+        return -ENOENT;
+    }
+
+    Directory listed;
+    listed.entries = entries;
+    for (int i = 0; i < entries.size(); ++i) {
+        listed.byName.insert(entries.at(i).name, i);
+    }
+    listed.age.start();
+
+    QMutexLocker locker(&m_mutex);
+    m_directories.insert(path, listed);
+    *directory = listed;
+    return 0;
+}
+
+/**
+ * @brief 规范化挂载点内的路径
+ * @param path 路径
+ * @return 以/开头，除根目录外不以/结尾的路径
+ */
+QString RemoteFs::normalize(const QString &path)
+{
+    QString clean = path;
+    if (!clean.startsWith('/')) {
+        clean = "/" + clean;
+    }
+    while (clean.size() > 1 && clean.endsWith('/')) {
+        clean.chop(1);
+    }
+    return clean;
+}
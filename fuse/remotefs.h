@@ -0,0 +1,129 @@
+/**
+ * @file remotefs.h
+ * @brief 只读远程文件系统
+ * @details 把远程目录树映射为本地路径，为FUSE前端提供与FUSE无关的元数据和读取操作
+ *
+ * 目录内容来自两处：
+ * 1. 预先生成的远程索引（RemoteIndex的索引文件），加载后常驻内存，不再访问服务器
+ * 2. 通过连接池按需列出，结果按setMetadataTtl()设置的有效期缓存
+ * 文件数据通过BlockCache按块读取
+ */
+
+#ifndef REMOTEFS_H
+#define REMOTEFS_H
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include "ftpclient.h"
+#include "blockcache.h"
+
+class ConnectionPool;
+
+/**
+ * @class RemoteFs
+ * @brief 只读远程文件系统
+ *
+ * 路径均为挂载点内的路径（以/开头）；返回int的方法与FUSE约定一致，成功返回0，失败返回负的errno。
+ * 所有方法都是线程安全的
+ */
+class RemoteFs
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param pool 连接池，由调用方持有
+     * @param remoteRoot 挂载的远程根目录
+     * @param blockCache 数据块缓存，由调用方持有
+     */
+    RemoteFs(ConnectionPool *pool, const QString &remoteRoot, BlockCache *blockCache);
+
+    /**
+     * @brief 设置元数据有效期
+     * @param ttlMs 按需列出的目录在多长时间内不再重新列出（毫秒）
+     */
+    void setMetadataTtl(int ttlMs) { m_ttlMs = ttlMs; }
+
+    /**
+     * @brief 加载远程索引
+     * @param indexPath RemoteIndex生成的索引文件
+     * @return 操作是否成功
+     *
+     * 索引中位于远程根目录之下的文件及其上级目录直接作为目录内容，不会过期
+     */
+    bool loadIndex(const QString &indexPath);
+
+    /**
+     * @brief 获取文件或目录的元数据
+     * @param path 挂载点内的路径
+     * @param entry 输出目录项
+     * @return 0或负的errno
+     */
+    int stat(const QString &path, RemoteEntry *entry);
+
+    /**
+     * @brief 列出目录
+     * @param path 挂载点内的目录路径
+     * @param entries 输出目录项
+     * @return 0或负的errno
+     */
+    int readDirectory(const QString &path, QList<RemoteEntry> *entries);
+
+    /**
+     * @brief 读取文件
+     * @param path 挂载点内的文件路径
+     * @param offset 起始偏移
+     * @param buffer 输出缓冲区
+     * @param length 读取长度
+     * @return 读取的字节数或负的errno
+     */
+    qint64 read(const QString &path, qint64 offset, char *buffer, qint64 length);
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+private:
+    /**
+     * @struct Directory
+     * @brief 缓存的目录内容
+     */
+    struct Directory {
+        QList<RemoteEntry> entries;     ///< 目录项
+        QHash<QString, int> byName;     ///< 名称到entries下标
+        QElapsedTimer age;              ///< 列出时间
+        bool permanent = false;         ///< 来自索引，不会过期
+    };
+
+    /**
+     * @brief 挂载点内的路径对应的远程路径
+     */
+    QString remotePath(const QString &path) const;
+
+    /**
+     * @brief 获取目录内容，必要时通过连接池列出
+     * @param path 挂载点内规范化后的目录路径
+     * @param directory 输出目录内容
+     * @return 0或负的errno
+     */
+    int lookupDirectory(const QString &path, Directory *directory);
+
+    /**
+     * @brief 规范化挂载点内的路径：以/开头，除根目录外不以/结尾
+     */
+    static QString normalize(const QString &path);
+
+private:
+    ConnectionPool *m_pool;               ///< 连接池（不拥有）
+    QString m_remoteRoot;                 ///< 远程根目录，不以/结尾
+    BlockCache *m_blockCache;             ///< 数据块缓存（不拥有）
+    int m_ttlMs;                          ///< 元数据有效期
+    mutable QMutex m_mutex;               ///< 保护以下成员
+    QHash<QString, Directory> m_directories; ///< 目录路径到目录内容
+    QString m_lastError;                  ///< 最后一个错误信息
+};
+
+#endif // REMOTEFS_H
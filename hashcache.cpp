@@ -0,0 +1,364 @@
+/**
+ * @file hashcache.cpp
+ * @brief 持久化的本地文件摘要缓存实现文件
+ */
+
+#include "hashcache.h"
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDateTime>
+#include <algorithm>
+#include <vector>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// 计算摘要时每次读取的字节数
+static const qint64 READ_CHUNK = 1024 * 1024;
+
+/**
+ * @brief 构造函数
+ * @param path 缓存文件路径
+ * @param threads 后台计算摘要的线程数
+ * @param maxEntries 最多保存的条目数
+ */
+HashCache::HashCache(const QString &path, int threads, int maxEntries)
+    : m_path(path)
+    , m_maxEntries(qMax(1, maxEntries))
+    , m_dirty(false)
+    , m_hits(0)
+    , m_computed(0)
+    , m_reused(0)
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+/**
+ * @brief 析构函数，等待后台计算结束并保存有变化的缓存
+ */
+HashCache::~HashCache()
+{
+    m_pool.waitForDone();
+    save();
+}
+
+/**
+ * @brief 从缓存文件加载
+ * @return 操作是否成功
+ */
+bool HashCache::load()
+{
+    if (m_path.isEmpty()) {
+        return true;
+    }
+    QFile file(m_path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMutexLocker locker(&m_mutex);
+        m_lastError = QString("无法打开摘要缓存: %1").arg(m_path);
+        return false;
+    }
+
+    // 旧格式没有最近使用时间，按加载时间计
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    QHash<FileKey, Entry> entries;
+    while (!file.atEnd()) {
+        QList<QByteArray> fields = file.readLine().trimmed().split('\t');
+        if (fields.size() != 5 && fields.size() != 6) {
+            continue;
+        }
+        FileKey key;
+        bool ok[4];
+        key.device = fields.at(0).toULongLong(&ok[0]);
+        key.inode = fields.at(1).toULongLong(&ok[1]);
+        key.size = fields.at(2).toLongLong(&ok[2]);
+        key.mtimeNs = fields.at(3).toLongLong(&ok[3]);
+        if (ok[0] && ok[1] && ok[2] && ok[3] && !fields.at(4).isEmpty()) {
+            Entry entry;
+            entry.digest = fields.at(4);
+            entry.lastUsed = fields.size() == 6 ? fields.at(5).toLongLong() : now;
+            entries.insert(key, entry);
+        }
+    }
+
+    QMutexLocker locker(&m_mutex);
+    for (auto it = entries.constBegin(); it != entries.constEnd(); ++it) {
+        m_entries.insert(it.key(), it.value());
+    }
+    trimLocked();
+    return true;
+}
+
+/**
+ * @brief 保存到缓存文件
+ * @return 操作是否成功
+ */
+bool HashCache::save()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_path.isEmpty() || !m_dirty) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_lastError = QString("无法写入摘要缓存: %1").arg(m_path);
+        return false;
+    }
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        const FileKey &key = it.key();
+        file.write(QByteArray::number(key.device) + '\t' + QByteArray::number(key.inode) + '\t'
+                   + QByteArray::number(key.size) + '\t' + QByteArray::number(key.mtimeNs) + '\t'
+                   + it.value().digest + '\t' + QByteArray::number(it.value().lastUsed) + '\n');
+    }
+    if (!file.commit()) {
+        m_lastError = QString("保存摘要缓存失败: %1").arg(file.errorString());
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 获取本地文件的身份键
+ * @param localPath 本地文件路径
+ * @param key 输出键
+ * @return 操作是否成功
+ */
+bool HashCache::fileKey(const QString &localPath, FileKey *key)
+{
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t*>(QDir::toNativeSeparators(localPath).utf16()),
+                                FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ok = GetFileInformationByHandle(handle, &info);
+    CloseHandle(handle);
+    if (!ok || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        return false;
+    }
+    key->device = info.dwVolumeSerialNumber;
+    key->inode = (static_cast<quint64>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+    key->size = (static_cast<qint64>(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+    // FILETIME以100纳秒为单位
+    key->mtimeNs = static_cast<qint64>((static_cast<quint64>(info.ftLastWriteTime.dwHighDateTime) << 32)
+                                       | info.ftLastWriteTime.dwLowDateTime) * 100;
+    return true;
+#else
+    struct stat st;
+    if (::stat(QFile::encodeName(localPath).constData(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        return false;
+    }
+    key->device = static_cast<quint64>(st.st_dev);
+    key->inode = static_cast<quint64>(st.st_ino);
+    key->size = static_cast<qint64>(st.st_size);
+#ifdef Q_OS_DARWIN
+    key->mtimeNs = static_cast<qint64>(st.st_mtimespec.tv_sec) * 1000000000LL + st.st_mtimespec.tv_nsec;
+#else
+    key->mtimeNs = static_cast<qint64>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+#endif
+    return true;
+#endif
+}
+
+/**
+ * @brief 查询缓存中的摘要
+ * @param localPath 本地文件路径
+ * @param digest 输出十六进制摘要
+ * @return 命中时返回true
+ */
+bool HashCache::lookup(const QString &localPath, QByteArray *digest)
+{
+    FileKey key;
+    if (!fileKey(localPath, &key)) {
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    *digest = takeHitLocked(it.value());
+    return true;
+}
+
+/**
+ * @brief 获取文件摘要，未命中时计算并写入缓存
+ * @param localPath 本地文件路径
+ * @return 十六进制摘要，失败时为空
+ */
+QByteArray HashCache::digest(const QString &localPath)
+{
+    return digest(localPath, false);
+}
+
+/**
+ * @brief 获取文件摘要，未命中时计算并写入缓存
+ * @param localPath 本地文件路径
+ * @param prefetching 是否由prefetch()在后台调用
+ * @return 十六进制摘要，失败时为空
+ */
+QByteArray HashCache::digest(const QString &localPath, bool prefetching)
+{
+    FileKey before;
+    if (!fileKey(localPath, &before)) {
+        return QByteArray();
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = m_entries.find(before);
+        if (it != m_entries.end()) {
+            return prefetching ? it.value().digest : takeHitLocked(it.value());
+        }
+    }
+
+    // 在锁外读取文件；计算期间文件被修改时结果不可信，不写入缓存
+    QByteArray result = computeDigest(localPath);
+    ++m_computed;
+    FileKey after;
+    if (result.isEmpty() || !fileKey(localPath, &after) || !(after == before)) {
+        return result;
+    }
+    QMutexLocker locker(&m_mutex);
+    Entry entry;
+    entry.digest = result;
+    entry.lastUsed = QDateTime::currentSecsSinceEpoch();
+    entry.prefetched = prefetching;
+    m_entries.insert(before, entry);
+    m_dirty = true;
+    trimLocked();
+    return result;
+}
+
+/**
+ * @brief 取出命中的条目并更新使用时间和计数
+ * @param entry 命中的条目
+ * @return 摘要
+ */
+QByteArray HashCache::takeHitLocked(Entry &entry)
+{
+    ++m_hits;
+    if (entry.prefetched) {
+        entry.prefetched = false;
+    } else {
+        ++m_reused;
+    }
+    // 使用时间只用于淘汰，精确到天即可，避免每次命中都让缓存变脏
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+    if (now - entry.lastUsed > 86400) {
+        entry.lastUsed = now;
+        m_dirty = true;
+    }
+    return entry.digest;
+}
+
+/**
+ * @brief 条目超出上限时淘汰最久未使用的条目
+ */
+void HashCache::trimLocked()
+{
+    if (m_entries.size() <= m_maxEntries) {
+        return;
+    }
+
+    // 一次淘汰到上限的九成，避免之后每次写入都要重新淘汰
+    std::vector<std::pair<qint64, FileKey>> ages;
+    ages.reserve(m_entries.size());
+    for (auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it) {
+        ages.emplace_back(it.value().lastUsed, it.key());
+    }
+    size_t removeCount = ages.size() - static_cast<size_t>(m_maxEntries) * 9 / 10;
+    std::nth_element(ages.begin(), ages.begin() + removeCount, ages.end(),
+                     [](const std::pair<qint64, FileKey> &a, const std::pair<qint64, FileKey> &b) {
+                         return a.first < b.first;
+                     });
+    for (size_t i = 0; i < removeCount; ++i) {
+        m_entries.remove(ages[i].second);
+    }
+    m_dirty = true;
+}
+
+/**
+ * @brief 在后台线程池中计算尚未缓存的文件摘要
+ * @param localPaths 本地文件路径列表
+ */
+void HashCache::prefetch(const QStringList &localPaths)
+{
+    for (const QString &path : localPaths) {
+        FileKey key;
+        if (!fileKey(path, &key)) {
+            continue;
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_entries.contains(key)) {
+                continue;
+            }
+        }
+        m_pool.start([this, path]() { digest(path, true); });
+    }
+}
+
+/**
+ * @brief 等待后台计算全部结束
+ */
+void HashCache::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+/**
+ * @brief 缓存条目数
+ */
+int HashCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entries.size();
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString HashCache::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief 计算文件的SHA-256摘要
+ * @param localPath 本地文件路径
+ * @return 十六进制摘要，失败时为空
+ */
+QByteArray HashCache::computeDigest(const QString &localPath)
+{
+    QFile file(localPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    QByteArray buffer(READ_CHUNK, Qt::Uninitialized);
+    for (;;) {
+        qint64 n = file.read(buffer.data(), buffer.size());
+        if (n < 0) {
+            return QByteArray();
+        }
+        if (n == 0) {
+            break;
+        }
+        hash.addData(QByteArrayView(buffer.constData(), n));
+    }
+    return hash.result().toHex();
+}
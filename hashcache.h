@@ -0,0 +1,197 @@
+/**
+ * @file hashcache.h
+ * @brief 持久化的本地文件摘要缓存
+ * @details 重复文件查找等功能会反复对同一批未变化的本地文件计算完整摘要。
+ *          缓存以（设备号、inode、大小、修改时间纳秒）为键保存SHA-256摘要：
+ *          文件内容变化必然改变大小或修改时间，改名和移动不改变inode，摘要仍然有效。
+ *
+ * 查询只需一次stat和一次哈希表查找；未命中的文件可以交给后台线程池并行计算。
+ * 缓存文件为文本格式，每行一条：设备号\tinode\t大小\t修改时间纳秒\t摘要（十六进制）\t最近使用时间（UTC秒数）
+ *
+ * 键里没有路径，无法判断被删除或修改过的文件对应的条目是否还有用，
+ * 因此条目数超出上限时按最近使用时间淘汰，旧文件留下的条目最终会被淘汰
+ */
+
+#ifndef HASHCACHE_H
+#define HASHCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QThreadPool>
+#include <atomic>
+
+/**
+ * @struct FileKey
+ * @brief 标识一个文件内容版本的键
+ */
+struct FileKey {
+    quint64 device = 0;      ///< 设备号
+    quint64 inode = 0;       ///< inode（Windows上为文件索引）
+    qint64 size = 0;         ///< 文件大小
+    qint64 mtimeNs = 0;      ///< 修改时间（纳秒）
+
+    bool operator==(const FileKey &other) const
+    {
+        return device == other.device && inode == other.inode && size == other.size && mtimeNs == other.mtimeNs;
+    }
+};
+
+/**
+ * @brief FileKey的哈希函数
+ */
+inline size_t qHash(const FileKey &key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.device, key.inode, key.size, key.mtimeNs);
+}
+
+/**
+ * @class HashCache
+ * @brief 以文件身份为键的SHA-256摘要缓存，线程安全
+ */
+class HashCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param path 缓存文件路径，为空时只在内存中缓存
+     * @param threads 后台计算摘要的线程数
+     * @param maxEntries 最多保存的条目数
+     */
+    explicit HashCache(const QString &path = QString(), int threads = 4, int maxEntries = 200000);
+
+    /**
+     * @brief 析构函数，等待后台计算结束并保存有变化的缓存
+     */
+    ~HashCache();
+
+    /**
+     * @brief 从缓存文件加载
+     * @return 操作是否成功；缓存文件不存在时视为空缓存并返回true
+     */
+    bool load();
+
+    /**
+     * @brief 保存到缓存文件（先写临时文件再替换）
+     * @return 操作是否成功；没有变化时直接返回true
+     */
+    bool save();
+
+    /**
+     * @brief 获取本地文件的身份键
+     * @param localPath 本地文件路径
+     * @param key 输出键
+     * @return 文件不存在或无法访问时返回false
+     */
+    static bool fileKey(const QString &localPath, FileKey *key);
+
+    /**
+     * @brief 查询缓存中的摘要，不计算
+     * @param localPath 本地文件路径
+     * @param digest 输出十六进制摘要
+     * @return 命中时返回true
+     */
+    bool lookup(const QString &localPath, QByteArray *digest);
+
+    /**
+     * @brief 获取文件摘要，未命中时在当前线程计算并写入缓存
+     * @param localPath 本地文件路径
+     * @return 十六进制SHA-256摘要，无法读取时为空
+     */
+    QByteArray digest(const QString &localPath);
+
+    /**
+     * @brief 在后台线程池中计算尚未缓存的文件摘要
+     * @param localPaths 本地文件路径列表
+     *
+     * 立即返回；已缓存的文件跳过，需要结果时调用waitForDone()
+     */
+    void prefetch(const QStringList &localPaths);
+
+    /**
+     * @brief 等待后台计算全部结束
+     */
+    void waitForDone();
+
+    /**
+     * @brief 缓存条目数
+     */
+    int size() const;
+
+    /**
+     * @brief 命中次数
+     */
+    qint64 hits() const { return m_hits; }
+
+    /**
+     * @brief 实际计算摘要的次数
+     */
+    qint64 computed() const { return m_computed; }
+
+    /**
+     * @brief 复用次数：命中的摘要不是为这次查询刚在后台计算出来的
+     *
+     * prefetch()计算的条目被第一次取用时只算命中不算复用，
+     * 因此先prefetch()再digest()的流程中复用次数就是缓存节省的计算次数
+     */
+    qint64 reused() const { return m_reused; }
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+private:
+    /**
+     * @brief 计算文件的SHA-256摘要
+     * @param localPath 本地文件路径
+     * @return 十六进制摘要，无法读取时为空
+     */
+    static QByteArray computeDigest(const QString &localPath);
+
+    /**
+     * @struct Entry
+     * @brief 缓存条目
+     */
+    struct Entry {
+        QByteArray digest;        ///< 十六进制摘要
+        qint64 lastUsed = 0;      ///< 最近使用时间（UTC秒数）
+        bool prefetched = false;  ///< 由prefetch()计算，尚未被取用
+    };
+
+    /**
+     * @brief 获取文件摘要，未命中时计算并写入缓存
+     * @param localPath 本地文件路径
+     * @param prefetching 是否由prefetch()在后台调用；这时命中不计数，计算出的条目标记为预取
+     * @return 十六进制摘要，无法读取时为空
+     */
+    QByteArray digest(const QString &localPath, bool prefetching);
+
+    /**
+     * @brief 取出命中的条目并更新使用时间和计数，调用时须持有m_mutex
+     * @param entry 命中的条目
+     * @return 摘要
+     */
+    QByteArray takeHitLocked(Entry &entry);
+
+    /**
+     * @brief 条目超出上限时淘汰最久未使用的条目，调用时须持有m_mutex
+     */
+    void trimLocked();
+
+private:
+    QString m_path;                       ///< 缓存文件路径
+    int m_maxEntries;                     ///< 最多保存的条目数
+    mutable QMutex m_mutex;               ///< 保护以下成员
+    QHash<FileKey, Entry> m_entries;      ///< 键到条目的映射
+    bool m_dirty;                         ///< 自上次保存以来是否有变化
+    QString m_lastError;                  ///< 最后一个错误信息
+    std::atomic<qint64> m_hits;           ///< 命中次数
+    std::atomic<qint64> m_computed;       ///< 计算次数
+    std::atomic<qint64> m_reused;         ///< 复用次数
+    QThreadPool m_pool;                   ///< 后台计算线程池
+};
+
+#endif // HASHCACHE_H
@@ -0,0 +1,226 @@
+/**
+ * @file hotpathtrace.cpp
+ * @brief 接收路径的周期级计时实现文件
+ */
+
+#include "hotpathtrace.h"
+#include <QMutex>
+#include <QStringList>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#if defined(Q_PROCESSOR_X86)
+#ifdef Q_CC_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define HOTPATH_USE_TSC
+#endif
+
+namespace {
+
+// 每个线程保留最近的样本用于计算分位数，更早的样本只计入累计值
+const int RING_SIZE = 1 << 14;
+const int STAGE_BITS = 4;
+
+const char *const STAGE_NAMES[HotPathTrace::StageCount] = {
+    "callback", "throttle", "sink", "encrypt", "disk-write", "progress"
+};
+
+/**
+ * @struct ThreadRing
+ * @brief 单个线程的样本环和累计计数，只由所属线程写入
+ */
+struct ThreadRing {
+    std::atomic<quint64> samples[RING_SIZE];    ///< 样本：高位为耗时，低STAGE_BITS位为阶段
+    std::atomic<quint64> head{0};               ///< 已写入的样本总数
+    std::atomic<quint64> resetHead{0};          ///< 上次reset()时的head
+    std::atomic<quint64> calls[HotPathTrace::StageCount];
+    std::atomic<quint64> ticks[HotPathTrace::StageCount];
+    std::atomic<quint64> bytes[HotPathTrace::StageCount];
+
+    ThreadRing()
+    {
+        for (int i = 0; i < HotPathTrace::StageCount; ++i) {
+            calls[i].store(0, std::memory_order_relaxed);
+            ticks[i].store(0, std::memory_order_relaxed);
+            bytes[i].store(0, std::memory_order_relaxed);
+        }
+    }
+};
+
+// 所有线程的样本环；线程退出后仍保留，直到进程结束
+QMutex g_registryMutex;
+std::vector<std::shared_ptr<ThreadRing>> g_rings;
+
+/**
+ * @brief 当前线程的样本环，首次使用时注册
+ */
+ThreadRing *threadRing()
+{
+    thread_local std::shared_ptr<ThreadRing> ring;
+    if (!ring) {
+        ring = std::make_shared<ThreadRing>();
+        QMutexLocker locker(&g_registryMutex);
+        g_rings.push_back(ring);
+    }
+    return ring.get();
+}
+
+/**
+ * @brief 计数器单位换算为纳秒的系数，首次调用时对照steady_clock校准约20毫秒
+ */
+double nanosecondsPerTick()
+{
+#ifdef HOTPATH_USE_TSC
+    static const double factor = []() {
+        auto wallStart = std::chrono::steady_clock::now();
+        quint64 tickStart = HotPathTrace::now();
+        QThread::msleep(20);
+        quint64 ticks = HotPathTrace::now() - tickStart;
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - wallStart).count();
+        return ticks > 0 ? ns / ticks : 1.0;
+    }();
+    return factor;
+#else
+    return 1.0;
+#endif
+}
+
+/**
+ * @brief 有序样本的分位数
+ */
+quint64 percentile(const std::vector<quint64> &sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[qMin(index, sorted.size() - 1)];
+}
+
+} // namespace
+
+/**
+ * @brief 是否以计时模式构建
+ */
+bool HotPathTrace::isEnabled()
+{
+#ifdef FTPCLIENT_HOTPATH_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief 读取时间戳计数器
+ * @return 计数器值；没有时间戳计数器的平台上为纳秒
+ */
+quint64 HotPathTrace::now()
+{
+#ifdef HOTPATH_USE_TSC
+    return __rdtsc();
+#else
+    return static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief 记录一次阶段耗时
+ * @param stage 阶段
+ * @param ticks 耗时
+ * @param bytes 本次处理的字节数
+ */
+void HotPathTrace::record(Stage stage, quint64 ticks, qint64 bytes)
+{
+    ThreadRing *ring = threadRing();
+    // 只有本线程写入，无竞争的原子加法；reset()可以从其他线程安全地清零
+    ring->calls[stage].fetch_add(1, std::memory_order_relaxed);
+    ring->ticks[stage].fetch_add(ticks, std::memory_order_relaxed);
+    ring->bytes[stage].fetch_add(static_cast<quint64>(qMax<qint64>(0, bytes)), std::memory_order_relaxed);
+
+    quint64 head = ring->head.load(std::memory_order_relaxed);
+    ring->samples[head % RING_SIZE].store((ticks << STAGE_BITS) | static_cast<quint64>(stage),
+                                          std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * @brief 汇总所有线程的计时
+ * @return 表格文本
+ */
+QString HotPathTrace::report()
+{
+    if (!isEnabled()) {
+        return "接收路径计时未启用（以 CONFIG+=hotpath_trace 重新构建）";
+    }
+
+    quint64 calls[StageCount] = {};
+    quint64 ticks[StageCount] = {};
+    quint64 bytes[StageCount] = {};
+    std::vector<quint64> samples[StageCount];
+    {
+        QMutexLocker locker(&g_registryMutex);
+        for (const std::shared_ptr<ThreadRing> &ring : g_rings) {
+            for (int i = 0; i < StageCount; ++i) {
+                calls[i] += ring->calls[i].load(std::memory_order_relaxed);
+                ticks[i] += ring->ticks[i].load(std::memory_order_relaxed);
+                bytes[i] += ring->bytes[i].load(std::memory_order_relaxed);
+            }
+            // 只取reset()之后且仍在环中的样本；读取期间被覆盖的少量样本不影响分位数
+            quint64 head = ring->head.load(std::memory_order_acquire);
+            quint64 first = qMax(ring->resetHead.load(std::memory_order_relaxed),
+                                 head > static_cast<quint64>(RING_SIZE) ? head - RING_SIZE : 0);
+            for (quint64 i = first; i < head; ++i) {
+                quint64 sample = ring->samples[i % RING_SIZE].load(std::memory_order_relaxed);
+                samples[sample & ((1 << STAGE_BITS) - 1)].push_back(sample >> STAGE_BITS);
+            }
+        }
+    }
+
+    double nsPerTick = nanosecondsPerTick();
+    QStringList lines;
+    lines << QString("%1 %2 %3 %4 %5 %6")
+                 .arg("阶段", -12).arg("调用次数", 12).arg("MiB", 10)
+                 .arg("ns/MiB", 12).arg("p50(ns)", 10).arg("p99(ns)", 10);
+    for (int i = 0; i < StageCount; ++i) {
+        if (calls[i] == 0) {
+            continue;
+        }
+        std::vector<quint64> &stageSamples = samples[i];
+        std::sort(stageSamples.begin(), stageSamples.end());
+        double mib = bytes[i] / (1024.0 * 1024.0);
+        double ns = ticks[i] * nsPerTick;
+        lines << QString("%1 %2 %3 %4 %5 %6")
+                     .arg(STAGE_NAMES[i], -12)
+                     .arg(calls[i], 12)
+                     .arg(mib, 10, 'f', 1)
+                     .arg(mib > 0.0 ? ns / mib : 0.0, 12, 'f', 0)
+                     .arg(percentile(stageSamples, 0.50) * nsPerTick, 10, 'f', 0)
+                     .arg(percentile(stageSamples, 0.99) * nsPerTick, 10, 'f', 0);
+    }
+    return lines.join('\n');
+}
+
+/**
+ * @brief 清空计时，开始新一轮统计
+ */
+void HotPathTrace::reset()
+{
+    QMutexLocker locker(&g_registryMutex);
+    for (const std::shared_ptr<ThreadRing> &ring : g_rings) {
+        for (int i = 0; i < StageCount; ++i) {
+            ring->calls[i].store(0, std::memory_order_relaxed);
+            ring->ticks[i].store(0, std::memory_order_relaxed);
+            ring->bytes[i].store(0, std::memory_order_relaxed);
+        }
+        ring->resetHead.store(ring->head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    }
+}
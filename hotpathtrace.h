@@ -0,0 +1,101 @@
+/**
+ * @file hotpathtrace.h
+ * @brief 接收路径的周期级计时
+ * @details 记录libcurl写回调到落盘输出之间每个阶段的耗时，回答"每MB的CPU花在哪里"：
+ *          回调本身、模拟链路限速、输出写入（其中的加密和文件写入）以及进度更新。
+ *
+ * 只在以 CONFIG+=hotpath_trace 构建时启用（定义FTPCLIENT_HOTPATH_TRACE），
+ * 否则HOTPATH_SPAN展开为空，接收路径上没有任何额外开销。
+ * 计时使用时间戳计数器（x86上为rdtsc），每个线程写入自己的环形缓冲区和累计计数，
+ * 不加锁；report()汇总所有线程，输出每个阶段的ns/MB以及单次调用的p50/p99
+ */
+
+#ifndef HOTPATHTRACE_H
+#define HOTPATHTRACE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @class HotPathTrace
+ * @brief 接收路径各阶段计时的记录与汇总
+ */
+class HotPathTrace
+{
+public:
+    /**
+     * @brief 计时阶段；Sink包含Encrypt和DiskWrite，Callback包含其余所有阶段
+     */
+    enum Stage {
+        Callback,   ///< 写回调整体
+        Throttle,   ///< 模拟链路限速
+        Sink,       ///< 写入输出设备（含加密）
+        Encrypt,    ///< 落盘加密
+        DiskWrite,  ///< 写入文件
+        Progress,   ///< 进度回调
+        StageCount
+    };
+
+    /**
+     * @brief 是否以计时模式构建
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief 读取时间戳计数器
+     * @return 计数器值，单位见report()中的换算
+     */
+    static quint64 now();
+
+    /**
+     * @brief 记录一次阶段耗时
+     * @param stage 阶段
+     * @param ticks 耗时（计数器单位）
+     * @param bytes 本次处理的字节数
+     */
+    static void record(Stage stage, quint64 ticks, qint64 bytes);
+
+    /**
+     * @brief 汇总所有线程的计时
+     * @return 每个阶段一行的表格；未启用时返回说明
+     */
+    static QString report();
+
+    /**
+     * @brief 清空计时，开始新一轮统计
+     */
+    static void reset();
+};
+
+/**
+ * @class HotPathSpan
+ * @brief 作用域计时，析构时记录一次阶段耗时
+ */
+class HotPathSpan
+{
+public:
+    HotPathSpan(HotPathTrace::Stage stage, qint64 bytes)
+        : m_stage(stage)
+        , m_bytes(bytes)
+        , m_start(HotPathTrace::now())
+    {
+    }
+
+    ~HotPathSpan() { HotPathTrace::record(m_stage, HotPathTrace::now() - m_start, m_bytes); }
+
+    HotPathSpan(const HotPathSpan &) = delete;
+    HotPathSpan &operator=(const HotPathSpan &) = delete;
+
+private:
+    HotPathTrace::Stage m_stage;
+    qint64 m_bytes;
+    quint64 m_start;
+};
+
+#ifdef FTPCLIENT_HOTPATH_TRACE
+#define HOTPATH_SPAN(name, stage, bytes) HotPathSpan name(HotPathTrace::stage, static_cast<qint64>(bytes))
+#else
+#define HOTPATH_SPAN(name, stage, bytes) ((void)0)
+#endif
+
+#endif // HOTPATHTRACE_H
@@ -0,0 +1,246 @@
+/**
+ * @file ledgertool.cpp
+ * @brief 传输台账分析工具
+ *
+ * 读取TransferLedger写出的JSONL台账，汇总多日运行的传输情况：
+ *   ledgertool [选项] <台账文件或目录>...
+ * 目录中的transfers-*.jsonl按日期顺序读取。输出总计、按服务器的吞吐分布
+ * （单文件吞吐的p10/p50/p90/p99和首字节时间）、按日期的汇总，以及吞吐最低的文件，
+ * 用于发现变慢的服务器和时段
+ */
+
+#include "transferledger.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QMap>
+#include <QSet>
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+/**
+ * @struct GroupStats
+ * @brief 一组记录（一个服务器或一天）的汇总
+ */
+struct GroupStats {
+    qint64 transfers = 0;              ///< 传输尝试数
+    qint64 failures = 0;               ///< 失败数
+    qint64 retries = 0;                ///< 重试次数
+    qint64 bytes = 0;                  ///< 成功传输的字节数
+    qint64 durationMs = 0;             ///< 成功传输的累计耗时
+    QSet<qint64> connections;          ///< 出现过的连接编号
+    std::vector<double> throughputs;   ///< 单文件吞吐量（MB/s）
+    std::vector<double> firstBytes;    ///< 首字节时间（毫秒）
+};
+
+/**
+ * @struct SlowTransfer
+ * @brief 吞吐量较低的一次传输
+ */
+struct SlowTransfer {
+    double throughput;                 ///< 吞吐量（MB/s）
+    TransferRecord record;             ///< 传输记录
+
+    bool operator<(const SlowTransfer &other) const { return throughput < other.throughput; }
+};
+
+/**
+ * @brief 计算分位数
+ * @param values 样本，会被排序
+ * @param fraction 分位（0~1）
+ * @return 分位数，无样本时为0
+ */
+static double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t index = static_cast<size_t>(fraction * (values.size() - 1) + 0.5);
+    return values[qMin(index, values.size() - 1)];
+}
+
+/**
+ * @brief 展开命令行中的文件和目录
+ * @param paths 命令行参数
+ * @return 台账文件列表，目录中的文件按名称（即日期）排序
+ */
+static QStringList ledgerFiles(const QStringList &paths)
+{
+    QStringList files;
+    for (const QString &path : paths) {
+        QFileInfo info(path);
+        if (info.isDir()) {
+            const QStringList names = QDir(path).entryList(QStringList() << "transfers-*.jsonl", QDir::Files, QDir::Name);
+            for (const QString &name : names) {
+                files.append(QDir(path).filePath(name));
+            }
+        } else {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ledgertool");
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("汇总传输台账中的吞吐分布、失败和慢文件");
+    parser.addHelpOption();
+    parser.addPositionalArgument("ledger", "台账文件或目录（transfers-*.jsonl）", "<ledger>...");
+    QCommandLineOption sinceOption("since", "只统计该日期（UTC，含）之后的记录", "yyyy-MM-dd");
+    QCommandLineOption untilOption("until", "只统计该日期（UTC，含）之前的记录", "yyyy-MM-dd");
+    QCommandLineOption serverOption("server", "只统计服务器标识包含该文本的记录", "text");
+    QCommandLineOption minSizeOption("min-size", "参与吞吐统计的最小文件大小（字节）", "bytes", "65536");
+    QCommandLineOption slowestOption("slowest", "列出吞吐最低的文件数", "count", "10");
+    parser.addOptions({sinceOption, untilOption, serverOption, minSizeOption, slowestOption});
+    parser.process(app);
+
+    const QStringList files = ledgerFiles(parser.positionalArguments());
+    if (files.isEmpty()) {
+        parser.showHelp(1);
+    }
+
+    QDate since = parser.isSet(sinceOption) ? QDate::fromString(parser.value(sinceOption), "yyyy-MM-dd") : QDate();
+    QDate until = parser.isSet(untilOption) ? QDate::fromString(parser.value(untilOption), "yyyy-MM-dd") : QDate();
+    QString serverFilter = parser.value(serverOption);
+    qint64 minSize = parser.value(minSizeOption).toLongLong();
+    int slowestCount = qMax(0, parser.value(slowestOption).toInt());
+
+    GroupStats total;
+    QMap<QString, GroupStats> byServer;
+    QMap<QDate, GroupStats> byDay;
+    // 大顶堆只保留吞吐最低的若干条
+    std::priority_queue<SlowTransfer> slowest;
+    qint64 malformed = 0;
+    qint64 uploads = 0;
+
+    for (const QString &path : files) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "无法打开台账文件: " << path << Qt::endl;
+            continue;
+        }
+        while (!file.atEnd()) {
+            QByteArray line = file.readLine();
+            if (line.trimmed().isEmpty()) {
+                continue;
+            }
+            TransferRecord record;
+            if (!TransferLedger::fromJson(line, &record)) {
+                ++malformed;
+                continue;
+            }
+            // 上传的吞吐受本地数据源限制，不能和下载混在一起统计
+            if (record.upload) {
+                ++uploads;
+                continue;
+            }
+            QDate day = QDateTime::fromMSecsSinceEpoch(record.started, QTimeZone::UTC).date();
+            if ((since.isValid() && day < since) || (until.isValid() && day > until)
+                || (!serverFilter.isEmpty() && !record.server.contains(serverFilter))) {
+                continue;
+            }
+
+            double throughput = -1.0;
+            if (record.success && record.durationMs > 0 && record.bytes >= minSize) {
+                throughput = record.bytes / (1024.0 * 1024.0) / (record.durationMs / 1000.0);
+            }
+            for (GroupStats *stats : {&total, &byServer[record.server], &byDay[day]}) {
+                ++stats->transfers;
+                stats->retries += record.retries;
+                if (!record.success) {
+                    ++stats->failures;
+                    continue;
+                }
+                stats->bytes += record.bytes;
+                stats->durationMs += record.durationMs;
+                if (record.connectionId >= 0) {
+                    stats->connections.insert(record.connectionId);
+                }
+                if (throughput >= 0.0) {
+                    stats->throughputs.push_back(throughput);
+                }
+                if (record.firstByteUs >= 0) {
+                    stats->firstBytes.push_back(record.firstByteUs / 1000.0);
+                }
+            }
+
+            if (throughput >= 0.0 && slowestCount > 0) {
+                slowest.push(SlowTransfer{throughput, record});
+                if (static_cast<int>(slowest.size()) > slowestCount) {
+                    slowest.pop();
+                }
+            }
+        }
+    }
+
+    auto mib = [](qint64 bytes) { return QString::number(bytes / (1024.0 * 1024.0), 'f', 1); };
+    auto rate = [](const GroupStats &stats) {
+        return stats.durationMs > 0 ? stats.bytes / (1024.0 * 1024.0) / (stats.durationMs / 1000.0) : 0.0;
+    };
+
+    out << QString("共 %1 次传输，失败 %2 次，重试 %3 次，成功传输 %4 MiB，平均 %5 MiB/s")
+           .arg(total.transfers).arg(total.failures).arg(total.retries).arg(mib(total.bytes))
+           .arg(rate(total), 0, 'f', 2) << Qt::endl;
+    if (malformed > 0) {
+        out << QString("跳过 %1 行格式错误的记录").arg(malformed) << Qt::endl;
+    }
+    if (uploads > 0) {
+        out << QString("跳过 %1 条上传记录").arg(uploads) << Qt::endl;
+    }
+
+    out << Qt::endl << "按服务器（单文件吞吐 MiB/s，首字节时间 ms）:" << Qt::endl;
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11")
+           .arg("server", -28).arg("files", 8).arg("failed", 7).arg("MiB", 10).arg("conns", 6)
+           .arg("p10", 8).arg("p50", 8).arg("p90", 8).arg("p99", 8).arg("ttfb50", 8).arg("ttfb99", 8) << Qt::endl;
+    for (auto it = byServer.begin(); it != byServer.end(); ++it) {
+        GroupStats &stats = it.value();
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11")
+               .arg(it.key(), -28).arg(stats.transfers, 8).arg(stats.failures, 7).arg(mib(stats.bytes), 10)
+               .arg(stats.connections.size(), 6)
+               .arg(percentile(stats.throughputs, 0.10), 8, 'f', 2)
+               .arg(percentile(stats.throughputs, 0.50), 8, 'f', 2)
+               .arg(percentile(stats.throughputs, 0.90), 8, 'f', 2)
+               .arg(percentile(stats.throughputs, 0.99), 8, 'f', 2)
+               .arg(percentile(stats.firstBytes, 0.50), 8, 'f', 1)
+               .arg(percentile(stats.firstBytes, 0.99), 8, 'f', 1) << Qt::endl;
+    }
+
+    out << Qt::endl << "按日期（UTC）:" << Qt::endl;
+    for (auto it = byDay.begin(); it != byDay.end(); ++it) {
+        GroupStats &stats = it.value();
+        out << QString("%1 %2 次传输，失败 %3，%4 MiB，平均 %5 MiB/s，单文件p50 %6 MiB/s")
+               .arg(it.key().toString("yyyy-MM-dd")).arg(stats.transfers).arg(stats.failures)
+               .arg(mib(stats.bytes)).arg(rate(stats), 0, 'f', 2)
+               .arg(percentile(stats.throughputs, 0.50), 0, 'f', 2) << Qt::endl;
+    }
+
+    if (!slowest.empty()) {
+        std::vector<SlowTransfer> rows;
+        while (!slowest.empty()) {
+            rows.push_back(slowest.top());
+            slowest.pop();
+        }
+        std::reverse(rows.begin(), rows.end());
+        out << Qt::endl << QString("吞吐最低的 %1 个文件:").arg(rows.size()) << Qt::endl;
+        for (const SlowTransfer &row : rows) {
+            out << QString("%1 MiB/s  %2 字节  %3 ms  %4  %5  %6")
+                   .arg(row.throughput, 8, 'f', 3).arg(row.record.bytes).arg(row.record.durationMs)
+                   .arg(QDateTime::fromMSecsSinceEpoch(row.record.started, QTimeZone::UTC).toString("yyyy-MM-dd HH:mm:ss"))
+                   .arg(row.record.server).arg(row.record.remotePath) << Qt::endl;
+        }
+    }
+    return 0;
+}
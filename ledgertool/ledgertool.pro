@@ -0,0 +1,13 @@
+QT       += core
+QT       -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = ledgertool
+
+SOURCES += \
+    ledgertool.cpp
+
+# FTP client core and LibCURL configuration
+include(../ftpcore.pri)
@@ -0,0 +1,221 @@
+/**
+ * @file listingcache.cpp
+ * @brief 目录列表缓存实现文件
+ */
+
+#include "listingcache.h"
+#include "memorybudget.h"
+
+/**
+ * @brief 构造函数
+ * @param ttlMs 条目有效期（毫秒）
+ */
+ListingCache::ListingCache(int ttlMs)
+    : m_bytes(0)
+    , m_ttlMs(ttlMs)
+    , m_budget(nullptr)
+{
+}
+
+/**
+ * @brief 析构函数，释放在内存预算中的记账
+ */
+ListingCache::~ListingCache()
+{
+    setMemoryBudget(nullptr);
+}
+
+/**
+ * @brief 设置内存预算
+ * @param budget 内存预算
+ */
+void ListingCache::setMemoryBudget(MemoryBudget *budget)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_budget) {
+        m_budget->removeReclaimer(MemoryBudget::ListingCache);
+        m_budget->release(MemoryBudget::ListingCache, m_bytes);
+    }
+    m_budget = budget;
+    if (m_budget) {
+        m_budget->charge(MemoryBudget::ListingCache, m_bytes);
+        m_budget->setReclaimer(MemoryBudget::ListingCache, [this](qint64 bytes) {
+            return evict(bytes);
+        });
+    }
+}
+
+/**
+ * @brief 查找目录列表
+ * @param path 远程目录路径
+ * @param lines 输出参数
+ * @return 命中且未过期时返回true
+ */
+bool ListingCache::lookup(const QString &path, QStringList *lines)
+{
+    QString key = keyFor(path);
+    QMutexLocker locker(&m_mutex);
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return false;
+    }
+    if (it->age.hasExpired(m_ttlMs)) {
+        removeLocked(key);
+        return false;
+    }
+
+    *lines = it->lines;
+    m_order.removeOne(key);
+    m_order.append(key);
+    return true;
+}
+
+/**
+ * @brief 插入目录列表
+ * @param path 远程目录路径
+ * @param lines 列表行
+ */
+void ListingCache::insert(const QString &path, const QStringList &lines)
+{
+    QString key = keyFor(path);
+    qint64 bytes = estimateBytes(key, lines);
+    invalidate(key);
+
+    // 申请预算时不能持有缓存锁，预算可能回调evict()
+    MemoryBudget *budget;
+    {
+        QMutexLocker locker(&m_mutex);
+        budget = m_budget;
+    }
+    if (budget && !budget->reserve(MemoryBudget::ListingCache, bytes)) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_entries.contains(key)) {
+        // 并发插入了同一目录，保留已有条目
+        if (budget) {
+            budget->release(MemoryBudget::ListingCache, bytes);
+        }
+        return;
+    }
+    Entry entry;
+    entry.lines = lines;
+    entry.bytes = bytes;
+    entry.age.start();
+    m_entries.insert(key, entry);
+    m_order.append(key);
+    m_bytes += bytes;
+}
+
+/**
+ * @brief 使一个目录的缓存失效
+ * @param path 远程目录路径
+ */
+void ListingCache::invalidate(const QString &path)
+{
+    QMutexLocker locker(&m_mutex);
+    removeLocked(keyFor(path));
+}
+
+/**
+ * @brief 清空缓存
+ */
+void ListingCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_budget) {
+        m_budget->release(MemoryBudget::ListingCache, m_bytes);
+    }
+    m_entries.clear();
+    m_order.clear();
+    m_bytes = 0;
+}
+
+/**
+ * @brief 丢弃最久未用的条目
+ * @param bytes 希望释放的字节数
+ * @return 实际释放的字节数
+ */
+qint64 ListingCache::evict(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 freed = 0;
+    while (freed < bytes && !m_order.isEmpty()) {
+        freed += removeLocked(m_order.first());
+    }
+    return freed;
+}
+
+/**
+ * @brief 列出已缓存的目录
+ * @param prefix 只返回以此开头的路径
+ * @return 目录路径
+ */
+QStringList ListingCache::paths(const QString &prefix) const
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList result;
+    for (const QString &key : m_order) {
+        if (key.startsWith(prefix)) {
+            result.append(key);
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief 当前占用的字节数
+ */
+qint64 ListingCache::memoryUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
+
+/**
+ * @brief 规范化目录路径作为键
+ * @param path 远程目录路径
+ * @return 以/结尾的路径
+ */
+QString ListingCache::keyFor(const QString &path)
+{
+    return path.endsWith('/') ? path : path + "/";
+}
+
+/**
+ * @brief 估算一组列表行占用的内存
+ * @param key 缓存键
+ * @param lines 列表行
+ * @return 字节数
+ */
+qint64 ListingCache::estimateBytes(const QString &key, const QStringList &lines)
+{
+    // QString按UTF-16存储，另加每个元素的对象和分配开销
+    qint64 bytes = key.size() * 2 + 64;
+    for (const QString &line : lines) {
+        bytes += line.size() * 2 + 32;
+    }
+    return bytes;
+}
+
+/**
+ * @brief 移除一个条目，调用方需持有m_mutex
+ * @param key 缓存键
+ * @return 释放的字节数
+ */
+qint64 ListingCache::removeLocked(const QString &key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return 0;
+    }
+    qint64 bytes = it->bytes;
+    m_entries.erase(it);
+    m_order.removeOne(key);
+    m_bytes -= bytes;
+    if (m_budget) {
+        m_budget->release(MemoryBudget::ListingCache, bytes);
+    }
+    return bytes;
+}
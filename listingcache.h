@@ -0,0 +1,133 @@
+/**
+ * @file listingcache.h
+ * @brief 目录列表缓存
+ * @details 缓存LIST的原始输出行，避免刷新、递归下载和重复浏览时反复请求同一目录
+ *
+ * 条目按最近使用顺序淘汰，并有过期时间；占用记入MemoryBudget，
+ * 预算紧张时由预算回调evict()丢弃最久未用的条目
+ */
+
+#ifndef LISTINGCACHE_H
+#define LISTINGCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QElapsedTimer>
+
+class MemoryBudget;
+
+/**
+ * @class ListingCache
+ * @brief 目录列表LRU缓存
+ *
+ * 所有方法都是线程安全的
+ */
+class ListingCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param ttlMs 条目有效期（毫秒）
+     */
+    explicit ListingCache(int ttlMs = 60 * 1000);
+
+    /**
+     * @brief 析构函数，释放在内存预算中的记账
+     */
+    ~ListingCache();
+
+    /**
+     * @brief 设置内存预算
+     * @param budget 内存预算，为nullptr时不记账
+     */
+    void setMemoryBudget(MemoryBudget *budget);
+
+    /**
+     * @brief 设置条目有效期
+     * @param ttlMs 有效期（毫秒）
+     */
+    void setTtl(int ttlMs) { m_ttlMs = ttlMs; }
+
+    /**
+     * @brief 查找目录列表
+     * @param path 远程目录路径
+     * @param lines 输出参数，命中时填入列表行
+     * @return 命中且未过期时返回true
+     */
+    bool lookup(const QString &path, QStringList *lines);
+
+    /**
+     * @brief 插入目录列表
+     * @param path 远程目录路径
+     * @param lines 列表行
+     *
+     * 内存预算不足时放弃插入
+     */
+    void insert(const QString &path, const QStringList &lines);
+
+    /**
+     * @brief 使一个目录的缓存失效
+     * @param path 远程目录路径
+     */
+    void invalidate(const QString &path);
+
+    /**
+     * @brief 清空缓存
+     */
+    void clear();
+
+    /**
+     * @brief 丢弃最久未用的条目
+     * @param bytes 希望释放的字节数
+     * @return 实际释放的字节数
+     */
+    qint64 evict(qint64 bytes);
+
+    /**
+     * @brief 列出已缓存的目录
+     * @param prefix 只返回以此开头的路径
+     * @return 以/结尾的目录路径（含已过期的条目），未排序
+     */
+    QStringList paths(const QString &prefix = QString()) const;
+
+    /**
+     * @brief 当前占用的字节数（估算）
+     */
+    qint64 memoryUsage() const;
+
+private:
+    struct Entry {
+        QStringList lines;      ///< 列表行
+        qint64 bytes;           ///< 估算占用
+        QElapsedTimer age;      ///< 插入时间
+    };
+
+    /**
+     * @brief 规范化目录路径作为键
+     */
+    static QString keyFor(const QString &path);
+
+    /**
+     * @brief 估算一组列表行占用的内存
+     */
+    static qint64 estimateBytes(const QString &key, const QStringList &lines);
+
+    /**
+     * @brief 移除一个条目，调用方需持有m_mutex
+     * @return 释放的字节数
+     */
+    qint64 removeLocked(const QString &key);
+
+private:
+    mutable QMutex m_mutex;          ///< 保护以下成员
+    QHash<QString, Entry> m_entries; ///< 路径到条目
+    QList<QString> m_order;          ///< 使用顺序，末尾为最近使用
+    qint64 m_bytes;                  ///< 总占用
+    int m_ttlMs;                     ///< 条目有效期
+    MemoryBudget *m_budget;          ///< 内存预算（不拥有）
+};
+
+#endif // LISTINGCACHE_H
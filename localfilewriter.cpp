@@ -0,0 +1,238 @@
+/**
+ * @file localfilewriter.cpp
+ * @brief 本地文件并行落盘实现文件
+ */
+
+#include "localfilewriter.h"
+#include "memorybudget.h"
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QSet>
+#include <atomic>
+
+/**
+ * @brief 构造函数
+ * @param threads 工作线程数
+ */
+LocalFileWriter::LocalFileWriter(int threads)
+    : m_batchBytes(0)
+    , m_inFlightBytes(0)
+    , m_tinyFileLimit(64 * 1024)
+    , m_batchFilesLimit(256)
+    , m_batchBytesLimit(4 * 1024 * 1024)
+    , m_maxBufferedBytes(64 * 1024 * 1024)
+    , m_budget(nullptr)
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+/**
+ * @brief 析构函数，等待所有已提交的写入完成
+ */
+LocalFileWriter::~LocalFileWriter()
+{
+    flush();
+}
+
+/**
+ * @brief 设置每批的文件数和字节数上限
+ * @param files 每批最多文件数
+ * @param bytes 每批最多字节数
+ */
+void LocalFileWriter::setBatchLimits(int files, qint64 bytes)
+{
+    m_batchFilesLimit = qMax(1, files);
+    m_batchBytesLimit = qMax<qint64>(1, bytes);
+    m_maxBufferedBytes = qMax(m_maxBufferedBytes, m_batchBytesLimit);
+}
+
+/**
+ * @brief 设置完成回调
+ * @param callback 每写完一批后在工作线程中调用
+ */
+void LocalFileWriter::setWrittenCallback(const std::function<void()> &callback)
+{
+    QMutexLocker locker(&m_mutex);
+    m_writtenCallback = callback;
+}
+
+/**
+ * @brief 并行创建一批目录
+ * @param directories 本地目录列表
+ * @return 全部创建成功时返回true
+ */
+bool LocalFileWriter::createDirectories(const QStringList &directories)
+{
+    // 按深度分层，浅层目录先创建，深层目录的mkdir就只需创建最后一级
+    QMap<int, QStringList> byDepth;
+    QSet<QString> seen;
+    for (const QString &dir : directories) {
+        QString clean = QDir::cleanPath(dir);
+        if (!seen.contains(clean)) {
+            seen.insert(clean);
+            byDepth[clean.count('/')].append(clean);
+        }
+    }
+
+    std::atomic<bool> success(true);
+    for (const QStringList &level : byDepth) {
+        // 每个任务处理一段连续的目录，避免为每个mkdir单独调度
+        const int chunk = 64;
+        for (int start = 0; start < level.size(); start += chunk) {
+            QStringList part = level.mid(start, chunk);
+            m_pool.start([part, &success]() {
+                QDir dir;
+                for (const QString &path : part) {
+                    if (!dir.mkpath(path)) {
+                        success = false;
+                    }
+                }
+            });
+        }
+        m_pool.waitForDone();
+    }
+    return success;
+}
+
+/**
+ * @brief 缓存一个文件的内容，稍后批量落盘
+ * @param path 本地文件路径
+ * @param data 文件内容
+ */
+void LocalFileWriter::writeFile(const QString &path, const QByteArray &data)
+{
+    // 背压：已提交未落盘的数据过多时等待工作线程；内存预算紧张时上限收缩为一个批次
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        qint64 limit = (m_budget && m_budget->underPressure()) ? m_batchBytesLimit : m_maxBufferedBytes;
+        if (m_inFlightBytes + m_batchBytes + data.size() <= limit || m_inFlightBytes == 0) {
+            break;
+        }
+        m_drained.wait(&m_mutex);
+    }
+
+    m_batch.append(qMakePair(path, data));
+    m_pendingFiles.insert(path);
+    m_batchBytes += data.size();
+    if (m_budget) {
+        m_budget->charge(MemoryBudget::WriteBehind, data.size());
+    }
+    if (m_batch.size() >= m_batchFilesLimit || m_batchBytes >= m_batchBytesLimit) {
+        submitBatch();
+    }
+}
+
+/**
+ * @brief 把当前积累的缓存交给工作线程，不等待写完
+ */
+void LocalFileWriter::submit()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_batch.isEmpty()) {
+        submitBatch();
+    }
+}
+
+/**
+ * @brief 文件是否已缓存但尚未写完
+ * @param path 本地文件路径
+ * @return 尚未写完时返回true
+ */
+bool LocalFileWriter::isPending(const QString &path) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_pendingFiles.contains(path);
+}
+
+/**
+ * @brief 提交剩余的缓存并等待全部写完
+ * @return 自上次takeFailedFiles()以来的写入是否全部成功
+ */
+bool LocalFileWriter::flush()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_batch.isEmpty()) {
+            submitBatch();
+        }
+    }
+    m_pool.waitForDone();
+
+    QMutexLocker locker(&m_mutex);
+    return m_failedFiles.isEmpty();
+}
+
+/**
+ * @brief 取出写入失败的文件列表
+ * @return 本地文件路径列表
+ */
+QStringList LocalFileWriter::takeFailedFiles()
+{
+    QMutexLocker locker(&m_mutex);
+    QStringList failed = m_failedFiles;
+    m_failedFiles.clear();
+    return failed;
+}
+
+/**
+ * @brief 当前尚未落盘的数据量
+ * @return 字节数
+ */
+qint64 LocalFileWriter::bufferedBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_inFlightBytes + m_batchBytes;
+}
+
+/**
+ * @brief 把当前批次交给工作线程，调用方需持有m_mutex
+ */
+void LocalFileWriter::submitBatch()
+{
+    QList<QPair<QString, QByteArray>> batch;
+    batch.swap(m_batch);
+    qint64 bytes = m_batchBytes;
+    m_batchBytes = 0;
+    m_inFlightBytes += bytes;
+
+    m_pool.start([this, batch, bytes]() {
+        writeBatch(batch, bytes);
+    });
+}
+
+/**
+ * @brief 写入一批文件（在工作线程中执行）
+ * @param batch 文件路径和内容
+ * @param bytes 本批的总字节数
+ */
+void LocalFileWriter::writeBatch(const QList<QPair<QString, QByteArray>> &batch, qint64 bytes)
+{
+    QStringList failed;
+    for (const auto &item : batch) {
+        QFile file(item.first);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+            || file.write(item.second) != item.second.size()) {
+            failed.append(item.first);
+        }
+    }
+
+    // 失败记录与移出未完成集合在同一次加锁中生效，isPending()为false时失败必然已可取出
+    std::function<void()> callback;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_inFlightBytes -= bytes;
+        if (m_budget) {
+            m_budget->release(MemoryBudget::WriteBehind, bytes);
+        }
+        for (const auto &item : batch) {
+            m_pendingFiles.remove(item.first);
+        }
+        m_failedFiles.append(failed);
+        m_drained.wakeAll();
+        callback = m_writtenCallback;
+    }
+    if (callback) {
+        callback();
+    }
+}
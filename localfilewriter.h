@@ -0,0 +1,164 @@
+/**
+ * @file localfilewriter.h
+ * @brief 本地文件并行落盘
+ * @details 大量小文件下载时，本地的mkdir/open/write/close开销会超过网络传输本身
+ *
+ * LocalFileWriter把这部分工作从下载线程移到一个小的工作线程池：
+ * 1. 目录结构在下载开始前批量并行创建
+ * 2. 小文件内容先缓存在内存中，按批交给工作线程创建、写入并关闭
+ * 3. 缓存的数据量有上限，超过时写入方等待工作线程落盘（背压）
+ * 4. 缓存数据记入MemoryBudget，预算紧张时缓存上限收缩为一个批次
+ * 5. 调用方不必等待落盘：每写完一批调用完成回调，由isPending()和takeFailedFiles()取回结果
+ */
+
+#ifndef LOCALFILEWRITER_H
+#define LOCALFILEWRITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QSet>
+#include <functional>
+
+class MemoryBudget;
+
+/**
+ * @class LocalFileWriter
+ * @brief 本地文件并行落盘器
+ *
+ * writeFile()和flush()应由同一个线程调用；文件的实际写入在内部线程池中进行
+ */
+class LocalFileWriter
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param threads 工作线程数
+     */
+    explicit LocalFileWriter(int threads = 4);
+
+    /**
+     * @brief 析构函数，等待所有已提交的写入完成
+     */
+    ~LocalFileWriter();
+
+    /**
+     * @brief 设置小文件上限
+     * @param bytes 不超过该大小的文件在内存中缓存后批量落盘
+     */
+    void setTinyFileLimit(qint64 bytes) { m_tinyFileLimit = bytes; }
+
+    /**
+     * @brief 获取小文件上限
+     */
+    qint64 tinyFileLimit() const { return m_tinyFileLimit; }
+
+    /**
+     * @brief 设置每批的文件数和字节数上限
+     * @param files 每批最多文件数
+     * @param bytes 每批最多字节数
+     */
+    void setBatchLimits(int files, qint64 bytes);
+
+    /**
+     * @brief 设置缓存数据总量上限
+     * @param bytes 尚未落盘的数据最多占用的字节数
+     */
+    void setMaxBufferedBytes(qint64 bytes) { m_maxBufferedBytes = qMax<qint64>(bytes, m_batchBytesLimit); }
+
+    /**
+     * @brief 设置内存预算
+     * @param budget 内存预算，为nullptr时不记账
+     */
+    void setMemoryBudget(MemoryBudget *budget) { m_budget = budget; }
+
+    /**
+     * @brief 设置完成回调
+     * @param callback 每写完一批后在工作线程中调用，为空时不调用
+     */
+    void setWrittenCallback(const std::function<void()> &callback);
+
+    /**
+     * @brief 并行创建一批目录
+     * @param directories 本地目录列表
+     * @return 全部创建成功时返回true
+     *
+     * 按深度从浅到深分层创建，同一层的目录之间没有依赖，可以并行
+     */
+    bool createDirectories(const QStringList &directories);
+
+    /**
+     * @brief 缓存一个文件的内容，稍后批量落盘
+     * @param path 本地文件路径，父目录必须已经存在
+     * @param data 文件内容
+     *
+     * 缓存数据超过上限时阻塞，直到工作线程写完足够多的文件
+     */
+    void writeFile(const QString &path, const QByteArray &data);
+
+    /**
+     * @brief 把当前积累的缓存交给工作线程，不等待写完
+     */
+    void submit();
+
+    /**
+     * @brief 文件是否已缓存但尚未写完
+     * @param path 本地文件路径
+     * @return 尚未写完时返回true；写完的文件如果失败，已在takeFailedFiles()的列表中
+     */
+    bool isPending(const QString &path) const;
+
+    /**
+     * @brief 提交剩余的缓存并等待全部写完
+     * @return 自上次takeFailedFiles()以来的写入是否全部成功
+     */
+    bool flush();
+
+    /**
+     * @brief 取出写入失败的文件列表
+     * @return 本地文件路径列表
+     */
+    QStringList takeFailedFiles();
+
+    /**
+     * @brief 当前尚未落盘的数据量
+     * @return 字节数
+     */
+    qint64 bufferedBytes() const;
+
+private:
+    /**
+     * @brief 把当前批次交给工作线程
+     */
+    void submitBatch();
+
+    /**
+     * @brief 写入一批文件（在工作线程中执行）
+     * @param batch 文件路径和内容
+     * @param bytes 本批的总字节数
+     */
+    void writeBatch(const QList<QPair<QString, QByteArray>> &batch, qint64 bytes);
+
+private:
+    QThreadPool m_pool;                          ///< 工作线程池
+    mutable QMutex m_mutex;                      ///< 保护以下计数和失败列表
+    QWaitCondition m_drained;                    ///< 有数据落盘时唤醒等待的写入方
+    QList<QPair<QString, QByteArray>> m_batch;   ///< 正在积累的批次
+    qint64 m_batchBytes;                         ///< 当前批次的字节数
+    qint64 m_inFlightBytes;                      ///< 已提交但未写完的字节数
+    QStringList m_failedFiles;                   ///< 写入失败的文件
+    QSet<QString> m_pendingFiles;                ///< 已缓存但尚未写完的文件
+    std::function<void()> m_writtenCallback;     ///< 每写完一批后调用的回调
+    qint64 m_tinyFileLimit;                      ///< 小文件上限
+    int m_batchFilesLimit;                       ///< 每批最多文件数
+    qint64 m_batchBytesLimit;                    ///< 每批最多字节数
+    qint64 m_maxBufferedBytes;                   ///< 缓存数据总量上限
+    MemoryBudget *m_budget;                      ///< 内存预算（不拥有）
+};
+
+#endif // LOCALFILEWRITER_H
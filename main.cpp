@@ -7,8 +7,10 @@
  */
 
 #include "mainwindow.h"
+#include "startupprofile.h"
 
 #include <QApplication>
+#include <QTimer>
 
 /**
  * @brief 主函数
@@ -17,12 +19,18 @@
  * @return 程序退出代码
  * 
  * 初始化Qt应用程序，创建并显示主窗口，
- * 然后进入Qt事件循环。
+ * 然后进入Qt事件循环。窗口显示后再完成其余的初始化（libcurl、缓存和索引），
+ * 启动各阶段的耗时由StartupProfile记录。
  */
 int main(int argc, char *argv[])
 {
+    StartupProfile::start();     // 开始启动计时
     QApplication a(argc, argv);  // 创建Qt应用程序实例
+    StartupProfile::mark("Qt初始化");
     MainWindow w;                // 创建主窗口实例
     w.show();                    // 显示主窗口
+    StartupProfile::mark("显示窗口");
+    // 事件循环处理完窗口的显示后再完成启动
+    QTimer::singleShot(0, &w, &MainWindow::finishStartup);
     return a.exec();             // 进入Qt事件循环，直到应用程序退出
 }
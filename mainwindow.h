@@ -19,6 +19,7 @@
 #include <curl/curl.h> // libcurl头文件，用于FTP协议处理
 #include <QStandardItemModel>
 #include <QStack>
+#include <QSet>
 #include <QQueue>
 #include <QDir>
 #include <QFileInfo>
@@ -26,7 +27,32 @@
 #include <QTimer>
 #include <QProgressBar>
 #include <QProgressDialog>
+#include <QStringListModel>
+#include <functional>
 #include "ftpclient.h"  // 引入FtpClient类
+#include "downloadqueue.h"
+#include "memorybudget.h"
+#include "listingcache.h"
+#include "hashcache.h"
+#include "connectionpool.h"
+#include "contentprefetcher.h"
+#include "sqliteexport.h"
+#include "transferledger.h"
+#include "directoryindex.h"
+#include "downloadscheduler.h"
+#include "sessioncache.h"
+
+class RemoteIndex;
+class QThread;
+
+/**
+ * @struct PendingWrite
+ * @brief 网络传输已完成、等待落盘结果的批量下载文件
+ */
+struct PendingWrite {
+    DownloadTask task;       ///< 下载任务
+    TransferRecord record;   ///< 批量下载结束时取得的传输记录，落盘结果确定后补全并保存
+};
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -61,7 +87,58 @@ public:
      */
     ~MainWindow();
 
+public slots:
+    /**
+     * @brief 完成启动
+     * 
+     * 窗口显示后由事件循环调用：在两个工作线程中分别初始化libcurl和TLS库、加载摘要缓存
+     * 和目录索引，完成后由curlInitialized和startupLoaded信号回到界面线程，全部完成后输出
+     * 启动各阶段的耗时。这些工作不影响窗口出现的时间，加载期间界面保持响应
+     */
+    void finishStartup();
+
+signals:
+    /**
+     * @brief 启动时的libcurl初始化完成，从工作线程发出，以排队连接回到界面线程
+     * @param error 错误信息，成功时为空
+     * @param timing 耗时说明
+     */
+    void curlInitialized(const QString &error, const QString &timing);
+
+    /**
+     * @brief 启动时的缓存加载完成，从工作线程发出，以排队连接回到界面线程
+     * @param errors 各项加载的错误信息
+     * @param timings 各项加载的耗时说明
+     */
+    void startupLoaded(const QStringList &errors, const QString &timings);
+
+    /**
+     * @brief 落盘线程池写完一批小文件，从工作线程发出，以排队连接回到界面线程
+     */
+    void localFilesWritten();
+
 private slots:
+    /**
+     * @brief 启动时的libcurl初始化完成
+     * @param error 错误信息，成功时为空
+     * @param timing 耗时说明
+     *
+     * 之后才允许连接；初始化期间点击过连接时现在连接
+     */
+    void onCurlInitialized(const QString &error, const QString &timing);
+
+    /**
+     * @brief 启动时的缓存加载完成
+     * @param errors 各项加载的错误信息
+     * @param timings 各项加载的耗时说明
+     */
+    void onStartupLoaded(const QStringList &errors, const QString &timings);
+
+    /**
+     * @brief 落盘线程池写完一批小文件，取回等待中的文件的落盘结果
+     */
+    void onLocalFilesWritten();
+
     /**
      * @brief 连接按钮点击事件处理
      * 
@@ -126,6 +203,72 @@ private slots:
      */
     void updateDownloadProgress(qint64 bytesReceived, qint64 bytesTotal);
 
+    /**
+     * @brief 刷新状态栏中的内存占用
+     * 
+     * 由定时器每秒调用，显示内存预算的总占用和各组件占用
+     */
+    void updateMemoryStatus();
+
+    /**
+     * @brief 查找重复文件菜单处理
+     * 
+     * 扫描当前目录树生成远程索引，按大小分组后用服务器端HASH或抽样区间读取确认重复，
+     * 并报告可回收的空间
+     */
+    void onFindDuplicatesTriggered();
+
+    /**
+     * @brief 比较镜像菜单处理
+     * 
+     * 以当前服务器的当前目录为基准，与用户输入的一个或多个镜像并行扫描并按路径比较，
+     * 报告缺失、多出、大小不同和修改时间偏差的文件
+     */
+    void onCompareMirrorsTriggered();
+
+    /**
+     * @brief 导出索引到SQLite菜单处理
+     * 
+     * 扫描当前目录树，把索引导入SQLite数据库的files表，便于用SQL查询
+     */
+    void onExportIndexTriggered();
+
+    /**
+     * @brief 记录传输到SQLite开关菜单处理
+     * @param checked 是否启用
+     * 
+     * 启用时选择数据库，之后每次传输尝试都在transfers表中记录一行
+     */
+    void onTransferDbToggled(bool checked);
+
+    /**
+     * @brief 小文件预取开关菜单处理
+     * @param checked 是否启用
+     */
+    void onPrefetchToggled(bool checked);
+
+    /**
+     * @brief 流式上传菜单处理
+     * 
+     * 选择数据来源（本地文件、命令输出或标准输入）和远程路径后在工作线程中上传，可以取消
+     */
+    void onUploadTriggered();
+
+    /**
+     * @brief 路径栏回车处理
+     * 
+     * 直接列出输入的目录，只需一次LIST；失败时回到原目录
+     */
+    void onPathEditReturnPressed();
+
+    /**
+     * @brief 路径栏输入处理
+     * @param text 已输入的路径
+     * 
+     * 从目录索引和目录列表缓存中查找同层目录，更新补全候选
+     */
+    void onPathEditTextEdited(const QString &text);
+
 private:
     /**
      * @brief 列出目录内容
@@ -184,21 +327,206 @@ private:
     void addDownloadTask(const QString &remotePath, const QString &localPath, 
                          bool isDirectory, const QString &displayName = "", qint64 fileSize = 0);
 
+    /**
+     * @brief 输出各本地接口的吞吐统计
+     * 
+     * 在日志中列出每个绑定接口的传输次数、字节数和平均吞吐量
+     */
+    void logInterfaceStats();
+
+    /**
+     * @brief 把已下载的文件复制到任务的其他目标位置
+     * @param task 已成功下载的任务
+     * 
+     * 同一远程文件被多个作业请求到不同位置时只传输一次，其余位置在此从本地复制
+     */
+    void completeCopyTargets(const DownloadTask &task);
+
+    /**
+     * @brief 取回已落盘的批量下载文件的结果
+     * 
+     * 已写完的文件记录传输并复制到其他位置，写入失败的文件放入重试列表；
+     * 仍在落盘线程池中的文件继续等待
+     */
+    void collectWrittenFiles();
+
+    /**
+     * @brief 完成一个出队后才加入的新目标
+     * @param copy 源文件和新目标
+     * 
+     * 源文件仍在落盘时随它完成后复制；已落盘时立即复制；源文件不可用（下载失败）时直接下载
+     */
+    void completeLocalCopy(const LocalCopy &copy);
+
+    /**
+     * @brief 完成一个批量下载的文件：保存传输记录，成功时复制到其他位置
+     * @param pending 文件和传输记录
+     * @param success 是否成功
+     * @param error 失败原因
+     */
+    void finishBatchItem(PendingWrite pending, bool success, const QString &error);
+
+    /**
+     * @brief 落盘失败的文件直接下载到磁盘重试一次
+     * @param pending 文件和传输记录
+     */
+    void retryWrite(const PendingWrite &pending);
+
+    /**
+     * @brief 按当前服务器的能力生成调度参数
+     * @return HTTP(S)服务器多路复用、支持块模式的FTP服务器合并非分段文件，其他服务器只合并极小文件
+     */
+    SchedulerPolicy schedulerPolicy() const;
+
+    /**
+     * @brief 显示上次会话缓存的目录列表
+     * 
+     * 填入上次的服务器、端口和用户名，未连接时文件列表显示上次最后浏览的目录
+     */
+    void showCachedSession();
+
+    /**
+     * @brief 在后台预取当前目录中的小文件
+     * 
+     * 只在启用预取且没有批量下载进行时执行
+     */
+    void startPrefetch();
+
+    /**
+     * @brief 预览小文件的内容
+     * @param remotePath 远程文件路径
+     * @param size 文件大小
+     * @param modified 列表中的修改时间
+     * 
+     * 已预取且未变化的文件直接显示，否则在工作线程中通过预览连接读取
+     */
+    void showFilePreview(const QString &remotePath, qint64 size, const QDateTime &modified);
+
+    /**
+     * @brief 扫描当前目录树生成索引
+     * @param index 索引生成器
+     * @param indexPath 输出索引文件
+     * @return 操作是否成功，失败原因已写入日志
+     * 
+     * 扫描在工作线程中进行，可以取消；扫描期间不使用名称过滤，结束后恢复原来的扫描设置
+     */
+    bool buildCurrentIndex(RemoteIndex *index, const QString &indexPath);
+
+    /**
+     * @brief 一个启动后台任务完成，全部完成后记录启动阶段并输出启动计时
+     */
+    void finishStartupTask();
+
+    /**
+     * @brief 在工作线程中执行耗时操作，期间显示进度对话框并保持界面响应
+     * @param label 进度对话框的说明文字
+     * @param work 在工作线程中执行的操作，不得访问界面
+     * @param status 在主线程中定时调用，返回显示在说明文字下方的进度，可以为空
+     * @param cancel 用户点击取消时在主线程中调用，应让work尽快返回；为空时不显示取消按钮
+     * @return work的返回值；已有操作在执行时不启动并返回false
+     * 
+     * 对话框是窗口模态的，启动工作线程前即显示，执行期间下载队列暂停处理，
+     * 使用主连接的各入口在backgroundBusy时不做任何事，work可以独占使用主连接
+     */
+    bool runInBackground(const QString &label, const std::function<bool()> &work,
+                         const std::function<QString()> &status = std::function<QString()>(),
+                         const std::function<void()> &cancel = std::function<void()>());
+
+    /**
+     * @brief 记录一次传输到台账和传输记录数据库
+     * @param task 下载任务，fileSize为本次传输的字节数
+     * @param started 开始时间（UTC毫秒）
+     * @param durationMs 耗时（毫秒），批量传输时为整批的耗时
+     * @param batchSize 同批传输的文件数
+     * @param success 是否成功
+     * @param error 失败原因
+     * @param upload 是否为上传，上传记录单独标记，不计入下载的吞吐统计
+     */
+    void recordTransfer(const DownloadTask &task, qint64 started, qint64 durationMs, int batchSize,
+                        bool success, const QString &error, bool upload = false);
+
+    /**
+     * @brief 生成一次传输的记录
+     * @param task 下载任务，fileSize为本次传输的字节数
+     * @param started 开始时间（UTC毫秒）
+     * @param durationMs 耗时（毫秒），批量传输时为整批的耗时
+     * @param batchSize 同批传输的文件数
+     * @param success 网络传输是否成功
+     * @return 带有libcurl计时的传输记录，需在下一次下载调用前生成
+     */
+    TransferRecord transferRecord(const DownloadTask &task, qint64 started, qint64 durationMs, int batchSize,
+                                  bool success) const;
+
+    /**
+     * @brief 保存传输记录到台账和传输记录数据库
+     * @param record 传输记录
+     */
+    void saveTransferRecord(const TransferRecord &record);
+
+    /**
+     * @brief 把多个选中项作为一个作业下载
+     * @param rows 选中的行，按行号排序
+     * 
+     * 只询问一次保存目录；选中的目录共用一次扫描，
+     * 扫描到的文件和选中的文件一次性合并到下载队列，由调度器并发下载
+     */
+    void downloadSelection(const QList<int> &rows);
+
+    /**
+     * @brief 按界面上的过滤条件设置目录扫描（名称过滤和MLSD扫描）
+     */
+    void applyCrawlSettings();
+
+    /**
+     * @brief 获取文件列表中一行的文件大小
+     * @param row 行号
+     * @return 字节数，未知时为0
+     */
+    qint64 fileSizeAt(int row) const;
+
+    /**
+     * @brief 开始处理下载队列（已在处理时不做任何事）
+     */
+    void startDownloads();
+
 private:
     Ui::MainWindow *ui;               ///< UI界面指针
     FtpClient *ftpClient;             ///< FTP客户端对象
+    LocalFileWriter *localWriter;     ///< 本地落盘器（目录批量创建和小文件落盘）
     QStandardItemModel *fileModel;    ///< 文件列表模型
     QString currentPath;              ///< 当前FTP路径
     QStack<QString> directoryHistory; ///< 目录浏览历史
     bool isConnected;                 ///< 连接状态标志
     bool isDownloading;               ///< 下载状态标志
+    bool backgroundBusy;              ///< 是否有runInBackground()的操作在工作线程中执行
+    QThread *curlLoader;              ///< 启动时初始化libcurl和TLS库的工作线程
+    QThread *startupLoader;           ///< 启动时加载摘要缓存和目录索引的工作线程
+    bool curlReady;                   ///< 启动时的libcurl初始化是否已完成
+    bool connectPending;              ///< libcurl初始化期间点击了连接，完成后连接
+    int startupTasks;                 ///< 尚未完成的启动后台任务数
+    QStringList startupTimings;       ///< 启动后台任务的耗时说明
     
     // 下载相关成员
     QTimer *downloadTimer;            ///< 下载队列处理定时器
     QProgressDialog *progressDialog;  ///< 下载进度对话框
-    QQueue<DownloadTask> downloadQueue; ///< 下载任务队列
+    MemoryBudget memoryBudget;        ///< 全局内存预算（需先于以下各组件构造、后于它们析构）
+    ListingCache listingCache;        ///< 目录列表缓存
+    HashCache hashCache;              ///< 本地文件摘要缓存，跨会话保存
+    ConnectionPool previewPool;       ///< 预览小文件的连接池，预取借用其中的空闲连接
+    ContentPrefetcher prefetcher;     ///< 小文件内容预取（需后于previewPool构造）
+    bool prefetchEnabled;             ///< 是否预取小文件内容
+    SqliteExport transferDb;          ///< 传输记录数据库，未启用时未打开
+    TransferLedger ledger;            ///< 传输台账（需后于hashCache构造）
+    DirectoryIndex directoryIndex;    ///< 已知远程目录，用于路径栏补全，跨会话保存
+    SessionCache sessionCache;        ///< 上次会话的服务器和目录列表，启动时立即显示
+    QStringListModel *pathCompletions; ///< 路径栏补全候选
+    DownloadQueue downloadQueue;      ///< 下载任务队列（按服务器、远程路径、本地路径去重）
+    DownloadScheduler downloadScheduler; ///< 下载调度（合并、分段和续传的选择）
     QMutex downloadMutex;             ///< 下载队列互斥锁
     int directoryTaskCount;           ///< 目录任务计数
+    QList<PendingWrite> pendingWrites; ///< 网络传输已完成、仍在落盘线程池中的小文件
+    QList<PendingWrite> writeRetries;  ///< 落盘失败、等待直接下载重试的文件
+    QSet<QString> writeFailures;      ///< 已取出但尚未对应到等待文件的落盘失败路径
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,170 @@
+/**
+ * @file memorybudget.cpp
+ * @brief 全局内存预算实现文件
+ */
+
+#include "memorybudget.h"
+#include <QStringList>
+
+/**
+ * @brief 构造函数
+ * @param limit 预算上限（字节）
+ */
+MemoryBudget::MemoryBudget(qint64 limit)
+    : m_limit(qMax<qint64>(1, limit))
+    , m_total(0)
+{
+}
+
+/**
+ * @brief 设置预算上限
+ * @param bytes 上限（字节）
+ */
+void MemoryBudget::setLimit(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limit = qMax<qint64>(1, bytes);
+}
+
+/**
+ * @brief 获取预算上限
+ */
+qint64 MemoryBudget::limit() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limit;
+}
+
+/**
+ * @brief 注册回收函数
+ * @param component 组件名
+ * @param reclaim 回收函数
+ */
+void MemoryBudget::setReclaimer(const QString &component, std::function<qint64(qint64)> reclaim)
+{
+    QMutexLocker locker(&m_mutex);
+    m_reclaimers.insert(component, reclaim);
+}
+
+/**
+ * @brief 注销回收函数
+ * @param component 组件名
+ */
+void MemoryBudget::removeReclaimer(const QString &component)
+{
+    QMutexLocker locker(&m_mutex);
+    m_reclaimers.remove(component);
+}
+
+/**
+ * @brief 记入内存占用
+ * @param component 组件名
+ * @param bytes 字节数
+ */
+void MemoryBudget::charge(const QString &component, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_usage[component] += bytes;
+    m_total += bytes;
+}
+
+/**
+ * @brief 释放内存占用
+ * @param component 组件名
+ * @param bytes 字节数
+ */
+void MemoryBudget::release(const QString &component, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_usage[component] -= bytes;
+    m_total -= bytes;
+}
+
+/**
+ * @brief 申请内存
+ * @param component 组件名
+ * @param bytes 字节数
+ * @return 申请成功时返回true
+ */
+bool MemoryBudget::reserve(const QString &component, qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_total + bytes <= m_limit) {
+        m_usage[component] += bytes;
+        m_total += bytes;
+        return true;
+    }
+
+    // 超出上限：依次请求可回收的组件释放内存，回收时不持有锁
+    qint64 needed = m_total + bytes - m_limit;
+    QList<std::function<qint64(qint64)>> reclaimers = m_reclaimers.values();
+    locker.unlock();
+    for (const auto &reclaim : reclaimers) {
+        if (needed <= 0) {
+            break;
+        }
+        needed -= reclaim(needed);
+    }
+
+    locker.relock();
+    if (m_total + bytes > m_limit) {
+        return false;
+    }
+    m_usage[component] += bytes;
+    m_total += bytes;
+    return true;
+}
+
+/**
+ * @brief 是否处于内存紧张状态
+ * @return 占用达到上限的90%时返回true
+ */
+bool MemoryBudget::underPressure() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_total * 10 >= m_limit * 9;
+}
+
+/**
+ * @brief 剩余可用的字节数
+ */
+qint64 MemoryBudget::available() const
+{
+    QMutexLocker locker(&m_mutex);
+    return qMax<qint64>(0, m_limit - m_total);
+}
+
+/**
+ * @brief 总占用字节数
+ */
+qint64 MemoryBudget::totalUsage() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_total;
+}
+
+/**
+ * @brief 各组件的占用
+ * @return 组件名到字节数的映射
+ */
+QMap<QString, qint64> MemoryBudget::usageByComponent() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_usage;
+}
+
+/**
+ * @brief 生成占用报告
+ * @return 报告文本
+ */
+QString MemoryBudget::report() const
+{
+    QMutexLocker locker(&m_mutex);
+    const double mib = 1024.0 * 1024.0;
+    QStringList parts;
+    for (auto it = m_usage.constBegin(); it != m_usage.constEnd(); ++it) {
+        parts << QString("%1 %2").arg(it.key()).arg(it.value() / mib, 0, 'f', 1);
+    }
+    return QString("内存 %1/%2 MiB：%3").arg(m_total / mib, 0, 'f', 1).arg(m_limit / mib, 0, 'f', 1)
+        .arg(parts.isEmpty() ? QString("-") : parts.join("，"));
+}
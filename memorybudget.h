@@ -0,0 +1,122 @@
+/**
+ * @file memorybudget.h
+ * @brief 全局内存预算
+ * @details 为缓存、缓冲和队列统一记账，并在内存紧张时协调各组件降级
+ *
+ * 各组件把自己占用的内存记入预算（charge/release），可丢弃数据的组件（如目录缓存）
+ * 注册回收函数。申请内存（reserve）超出上限时，预算先请求各组件回收，仍然不够则拒绝，
+ * 由申请方自行降级：缓存放弃插入、写缓冲缩小并等待落盘、目录扫描把任务暂存到磁盘
+ */
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <functional>
+
+/**
+ * @class MemoryBudget
+ * @brief 内存预算与按组件记账
+ *
+ * 所有方法都是线程安全的；回收函数在不持有预算锁的情况下调用，可以在其中调用release()
+ */
+class MemoryBudget
+{
+public:
+    static constexpr const char *ListingCache = "listing-cache"; ///< 目录列表缓存
+    static constexpr const char *TaskQueue = "task-queue";       ///< 下载任务队列（含扫描中的任务）
+    static constexpr const char *WriteBehind = "write-behind";   ///< 小文件落盘缓冲
+    static constexpr const char *RemoteIndex = "remote-index";   ///< 远程索引排序缓冲
+    static constexpr const char *PrefetchCache = "prefetch-cache"; ///< 小文件内容预取缓存
+
+    /**
+     * @brief 构造函数
+     * @param limit 预算上限（字节）
+     */
+    explicit MemoryBudget(qint64 limit = 256 * 1024 * 1024);
+
+    /**
+     * @brief 设置预算上限
+     * @param bytes 上限（字节）
+     */
+    void setLimit(qint64 bytes);
+
+    /**
+     * @brief 获取预算上限
+     */
+    qint64 limit() const;
+
+    /**
+     * @brief 注册回收函数
+     * @param component 组件名
+     * @param reclaim 回收函数，参数为希望回收的字节数，返回实际回收的字节数
+     */
+    void setReclaimer(const QString &component, std::function<qint64(qint64)> reclaim);
+
+    /**
+     * @brief 注销回收函数
+     * @param component 组件名
+     */
+    void removeReclaimer(const QString &component);
+
+    /**
+     * @brief 记入内存占用（不检查上限）
+     * @param component 组件名
+     * @param bytes 字节数
+     */
+    void charge(const QString &component, qint64 bytes);
+
+    /**
+     * @brief 释放内存占用
+     * @param component 组件名
+     * @param bytes 字节数
+     */
+    void release(const QString &component, qint64 bytes);
+
+    /**
+     * @brief 申请内存
+     * @param component 组件名
+     * @param bytes 字节数
+     * @return 申请成功（已记账）时返回true；回收后仍超出上限时返回false且不记账
+     */
+    bool reserve(const QString &component, qint64 bytes);
+
+    /**
+     * @brief 是否处于内存紧张状态
+     * @return 占用达到上限的90%时返回true
+     */
+    bool underPressure() const;
+
+    /**
+     * @brief 剩余可用的字节数
+     */
+    qint64 available() const;
+
+    /**
+     * @brief 总占用字节数
+     */
+    qint64 totalUsage() const;
+
+    /**
+     * @brief 各组件的占用
+     * @return 组件名到字节数的映射
+     */
+    QMap<QString, qint64> usageByComponent() const;
+
+    /**
+     * @brief 生成占用报告
+     * @return 如"内存 12.3/256.0 MiB：listing-cache 1.2，task-queue 3.4 ..."
+     */
+    QString report() const;
+
+private:
+    mutable QMutex m_mutex;                                   ///< 保护以下成员
+    qint64 m_limit;                                           ///< 预算上限
+    qint64 m_total;                                           ///< 总占用
+    QMap<QString, qint64> m_usage;                            ///< 各组件占用
+    QMap<QString, std::function<qint64(qint64)>> m_reclaimers; ///< 各组件回收函数
+};
+
+#endif // MEMORYBUDGET_H
@@ -0,0 +1,432 @@
+/**
+ * @file mirrorchecker.cpp
+ * @brief 镜像一致性检查实现文件
+ */
+
+#include "mirrorchecker.h"
+#include <QScopeGuard>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 合并时单个索引的读取状态
+ */
+struct IndexCursor {
+    std::unique_ptr<QFile> file;   ///< 排序后的索引文件
+    IndexRecord current;           ///< 当前记录
+    QString relative;              ///< 当前记录相对于根目录的路径，以/开头
+    bool valid = false;            ///< 是否还有记录
+};
+
+/**
+ * @brief 规范化根目录为以/开头和结尾的形式，与RemoteIndex::build()的处理一致
+ */
+QString normalizeRoot(const QString &root)
+{
+    QString result = root.startsWith("/") ? root : "/" + root;
+    if (!result.endsWith("/")) {
+        result += "/";
+    }
+    return result;
+}
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+MirrorChecker::MirrorChecker()
+    : m_mtimeTolerance(2)
+    , m_hashCheck(false)
+    , m_hashBatchSize(1000)
+    , m_sortMemoryLimit(128 * 1024 * 1024)
+    , m_budget(nullptr)
+    , m_cancelled(false)
+    , m_scannedDone(0)
+{
+}
+
+/**
+ * @brief 中止正在进行的比较
+ */
+void MirrorChecker::cancel()
+{
+    QMutexLocker locker(&m_indexMutex);
+    m_cancelled = true;
+    for (RemoteIndex *index : m_activeIndexes) {
+        index->cancel();
+    }
+}
+
+/**
+ * @brief 已扫描的文件数
+ */
+qint64 MirrorChecker::scannedFiles() const
+{
+    QMutexLocker locker(&m_indexMutex);
+    qint64 total = m_scannedDone;
+    for (const RemoteIndex *index : m_activeIndexes) {
+        total += index->entryCount();
+    }
+    return total;
+}
+
+/**
+ * @brief 服务器在报告中的标识
+ * @param index 服务器下标
+ * @return 服务器标识
+ */
+QString MirrorChecker::serverLabel(int index) const
+{
+    const MirrorServer &server = m_servers.at(index);
+    QString label = QString("#%1 %2:%3").arg(index + 1).arg(server.server).arg(server.port);
+    QString root = normalizeRoot(server.root);
+    if (root != "/") {
+        root.chop(1);
+        label += root;
+    }
+    return label;
+}
+
+/**
+ * @brief 扫描并比较所有服务器
+ * @param reportPath 输出报告文件
+ * @return 操作是否成功
+ */
+bool MirrorChecker::run(const QString &reportPath)
+{
+    m_summary = MirrorSummary();
+    if (m_servers.size() < 2) {
+        m_lastError = "至少需要两个服务器才能比较";
+        return false;
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        m_lastError = "无法创建索引临时目录";
+        return false;
+    }
+    QFile report(reportPath);
+    if (!report.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        m_lastError = QString("无法创建报告文件: %1").arg(reportPath);
+        return false;
+    }
+
+    m_roots.clear();
+    m_hashSupport.clear();
+    for (const MirrorServer &server : m_servers) {
+        m_roots.append(normalizeRoot(server.root));
+        m_hashSupport.append(0);
+        FtpClient *client = new FtpClient();
+        if (m_configure) {
+            m_configure(client);
+        }
+        // LIST不提供修改时间，用MLSD取得各服务器可直接比较的UTC时间
+        client->setCrawlMode(FtpClient::MachineListCrawl);
+        m_clients.append(client);
+    }
+    auto closeClients = qScopeGuard([this]() {
+        qDeleteAll(m_clients);
+        m_clients.clear();
+    });
+
+    QStringList sortedPaths;
+    if (!buildIndexes(&sortedPaths, workDir.path())) {
+        return false;
+    }
+    return mergeIndexes(sortedPaths, report);
+}
+
+/**
+ * @brief 并行扫描所有服务器并按路径排序索引
+ * @param sortedPaths 输出各服务器排序后的索引文件
+ * @param workDir 临时文件目录
+ * @return 操作是否成功
+ */
+bool MirrorChecker::buildIndexes(QStringList *sortedPaths, const QString &workDir)
+{
+    int count = m_servers.size();
+    QStringList errors;
+    QVector<int> failedDirectories(count, 0);
+    QVector<bool> untimed(count, false);
+    for (int i = 0; i < count; ++i) {
+        errors.append(QString());
+        sortedPaths->append(QString("%1/mirror%2.sorted.tsv").arg(workDir).arg(i));
+    }
+
+    // 每个服务器一个线程：扫描受各自服务器的往返时间限制，并行后总耗时取决于最慢的镜像
+    QList<QThread*> workers;
+    for (int i = 0; i < count; ++i) {
+        workers.append(QThread::create([this, i, count, workDir, sortedPaths, &errors, &failedDirectories, &untimed]() {
+            const MirrorServer &server = m_servers.at(i);
+            FtpClient *client = m_clients.at(i);
+            if (!client->connect(server.server, server.port, server.username, server.password)) {
+                errors[i] = QString("连接 %1 失败: %2").arg(serverLabel(i)).arg(client->lastError());
+                return;
+            }
+
+            // 排序内存上限由所有服务器平分，同时排序时总占用不超过设置值
+            RemoteIndex index;
+            index.setSortMemoryLimit(m_sortMemoryLimit / count);
+            index.setMemoryBudget(m_budget);
+            {
+                // 登记后cancel()才能中止这次扫描；登记前已取消的直接让扫描失败
+                QMutexLocker locker(&m_indexMutex);
+                if (m_cancelled) {
+                    index.cancel();
+                }
+                m_activeIndexes.append(&index);
+            }
+            QString indexPath = QString("%1/mirror%2.tsv").arg(workDir).arg(i);
+            bool ok = index.build(client, m_roots.at(i), indexPath);
+            {
+                QMutexLocker locker(&m_indexMutex);
+                m_activeIndexes.removeOne(&index);
+                m_scannedDone += index.entryCount();
+            }
+            failedDirectories[i] = index.failedDirectories();
+            untimed[i] = client->isMlsdUnsupported();
+            if (ok) {
+                ok = index.sortByPath(indexPath, sortedPaths->at(i));
+            }
+            QFile::remove(indexPath);
+            if (!ok) {
+                errors[i] = QString("%1 索引失败: %2").arg(serverLabel(i)).arg(index.lastError());
+            }
+        }));
+        workers.last()->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        m_summary.failedDirectories += failedDirectories.at(i);
+        if (untimed.at(i)) {
+            ++m_summary.untimedServers;
+        }
+        if (!errors.at(i).isEmpty()) {
+            m_lastError = errors.at(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按相对路径合并各索引并写出差异
+ * @param sortedPaths 各服务器排序后的索引文件
+ * @param report 报告文件
+ * @return 操作是否成功
+ */
+bool MirrorChecker::mergeIndexes(const QStringList &sortedPaths, QFile &report)
+{
+    int count = sortedPaths.size();
+    std::vector<IndexCursor> cursors(count);
+    auto advance = [&](int i) {
+        IndexCursor &cursor = cursors[i];
+        cursor.valid = false;
+        while (!cursor.file->atEnd()) {
+            if (RemoteIndex::parseRecord(cursor.file->readLine(), &cursor.current)) {
+                // 各索引的路径都以各自的根目录开头，按完整路径排序即按相对路径排序
+                cursor.relative = cursor.current.path.mid(m_roots.at(i).size() - 1);
+                cursor.valid = true;
+                return;
+            }
+        }
+    };
+    for (int i = 0; i < count; ++i) {
+        cursors[i].file.reset(new QFile(sortedPaths.at(i)));
+        if (!cursors[i].file->open(QIODevice::ReadOnly)) {
+            m_lastError = QString("无法打开索引文件: %1").arg(sortedPaths.at(i));
+            return false;
+        }
+        advance(i);
+    }
+
+    QList<HashItem> hashBatch;
+    QVector<const IndexRecord*> present(count);
+    for (;;) {
+        // 镜像数量很少，直接线性查找当前最小的相对路径
+        const QString *smallest = nullptr;
+        for (int i = 0; i < count; ++i) {
+            if (cursors[i].valid && (!smallest || cursors[i].relative < *smallest)) {
+                smallest = &cursors[i].relative;
+            }
+        }
+        if (!smallest) {
+            break;
+        }
+        if (m_cancelled) {
+            m_lastError = "比较已取消";
+            return false;
+        }
+        QString path = *smallest;
+        for (int i = 0; i < count; ++i) {
+            present[i] = cursors[i].valid && cursors[i].relative == path ? &cursors[i].current : nullptr;
+        }
+        ++m_summary.paths;
+
+        const IndexRecord *reference = present.at(0);
+        HashItem hashItem;
+        bool needsHash = false;
+        for (int i = 1; i < count; ++i) {
+            const IndexRecord *record = present.at(i);
+            bool ok = true;
+            if (!reference && record) {
+                ++m_summary.extra;
+                ok = writeDifference(report, "EXTRA", i, path, QString("%1 字节").arg(record->size));
+            } else if (reference && !record) {
+                ++m_summary.missing;
+                ok = writeDifference(report, "MISSING", i, path, QString("基准 %1 字节").arg(reference->size));
+            } else if (reference && record->size != reference->size) {
+                ++m_summary.sizeMismatches;
+                ok = writeDifference(report, "SIZE", i, path,
+                                     QString("基准 %1 字节，此处 %2 字节").arg(reference->size).arg(record->size));
+            } else if (reference) {
+                // 修改时间未知时无法判断偏差，不计入
+                if (m_mtimeTolerance >= 0 && reference->modified >= 0 && record->modified >= 0
+                    && qAbs(record->modified - reference->modified) > m_mtimeTolerance) {
+                    ++m_summary.mtimeSkews;
+                    ok = writeDifference(report, "MTIME", i, path,
+                                         QString("相差 %1 秒").arg(record->modified - reference->modified));
+                }
+                needsHash = true;
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+
+        // 只有与基准大小相同的副本需要确认内容，缺失或大小不同的服务器留空
+        if (m_hashCheck && needsHash) {
+            for (int i = 0; i < count; ++i) {
+                const IndexRecord *record = present.at(i);
+                hashItem.append(record && record->size == reference->size ? record->path : QString());
+            }
+            hashBatch.append(hashItem);
+            if (hashBatch.size() >= m_hashBatchSize) {
+                if (!confirmHashes(hashBatch, report)) {
+                    return false;
+                }
+                hashBatch.clear();
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (present.at(i)) {
+                advance(i);
+            }
+        }
+    }
+
+    if (!hashBatch.isEmpty()) {
+        return confirmHashes(hashBatch, report);
+    }
+    return true;
+}
+
+/**
+ * @brief 各服务器并行计算一批文件的摘要并写出不一致项
+ * @param items 待确认的路径
+ * @param report 报告文件
+ * @return 操作是否成功
+ */
+bool MirrorChecker::confirmHashes(const QList<HashItem> &items, QFile &report)
+{
+    int count = m_clients.size();
+    QVector<QStringList> digests(count);
+    for (int i = 0; i < count; ++i) {
+        for (int j = 0; j < items.size(); ++j) {
+            digests[i].append(QString());
+        }
+    }
+
+    // 每个服务器一个线程，使用扫描时的连接依次请求摘要
+    QList<QThread*> workers;
+    for (int i = 0; i < count; ++i) {
+        workers.append(QThread::create([this, i, &items, &digests]() {
+            FtpClient *client = m_clients.at(i);
+            int support = m_hashSupport.at(i);
+            QStringList &results = digests[i];
+            for (int j = 0; j < items.size() && support >= 0; ++j) {
+                const QString &path = items.at(j).at(i);
+                if (path.isEmpty()) {
+                    continue;
+                }
+                QString algorithm;
+                QString digest;
+                if (client->remoteHash(path, &algorithm, &digest)) {
+                    support = 1;
+                    results[j] = algorithm.toUpper() + ":" + digest;
+                } else if (support == 0) {
+                    // 从未成功过的HASH失败视为服务器不支持，之后不再请求
+                    support = -1;
+                }
+            }
+            m_hashSupport[i] = support;
+        }));
+        workers.last()->start();
+    }
+    for (QThread *worker : workers) {
+        worker->wait();
+        delete worker;
+    }
+
+    for (int j = 0; j < items.size(); ++j) {
+        const HashItem &item = items.at(j);
+        const QString &reference = digests.at(0).at(j);
+        for (int i = 1; i < count; ++i) {
+            if (item.at(i).isEmpty()) {
+                continue;
+            }
+            const QString &digest = digests.at(i).at(j);
+            // 任一方没有摘要或算法不同时无法比较
+            if (reference.isEmpty() || digest.isEmpty() || digest.section(':', 0, 0) != reference.section(':', 0, 0)) {
+                ++m_summary.hashUnverified;
+            } else if (digest == reference) {
+                ++m_summary.hashConfirmed;
+            } else {
+                ++m_summary.hashMismatches;
+                QString relative = item.at(i).mid(m_roots.at(i).size() - 1);
+                if (!writeDifference(report, "HASH", i, relative, QString("基准 %1，此处 %2").arg(reference, digest))) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 写出一条差异
+ * @param report 报告文件
+ * @param type 差异类型
+ * @param server 服务器下标
+ * @param path 相对路径
+ * @param detail 详情
+ * @return 操作是否成功
+ */
+bool MirrorChecker::writeDifference(QFile &report, const char *type, int server, const QString &path,
+                                    const QString &detail)
+{
+    QByteArray line = type;
+    line += '\t';
+    line += serverLabel(server).toUtf8();
+    line += '\t';
+    line += path.toUtf8();
+    line += '\t';
+    line += detail.toUtf8();
+    line += '\n';
+    if (report.write(line) < 0) {
+        m_lastError = QString("写入报告失败: %1").arg(report.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,211 @@
+/**
+ * @file mirrorchecker.h
+ * @brief 镜像一致性检查
+ * @details 比较两个或多个应当内容相同的服务器（镜像）上的目录树
+ *
+ * 检查分三步：
+ * 1. 每个服务器使用独立的连接并行扫描，生成RemoteIndex索引文件
+ * 2. 各索引按路径外部排序
+ * 3. 按相对路径流式多路合并，与第一个服务器（基准）逐项比较，
+ *    报告缺失、多出、大小不同和修改时间偏差超过容差的文件；
+ *    修改时间取自MLSD（UTC），不支持MLSD的服务器没有可比较的时间，不比较修改时间；
+ *    可选地对大小相同的文件使用服务器端HASH命令确认内容
+ * 索引和排序都在磁盘上进行，合并时每个服务器只在内存中保留一条记录，适用于千万级条目的目录树
+ */
+
+#ifndef MIRRORCHECKER_H
+#define MIRRORCHECKER_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QFile>
+#include <QMutex>
+#include <atomic>
+#include <functional>
+#include "ftpclient.h"
+#include "remoteindex.h"
+
+class MemoryBudget;
+
+/**
+ * @struct MirrorServer
+ * @brief 参与比较的一个服务器
+ */
+struct MirrorServer {
+    QString server;          ///< 服务器地址
+    int port = 21;           ///< 端口号
+    QString username;        ///< 用户名
+    QString password;        ///< 密码
+    QString root = "/";      ///< 比较的远程根目录
+};
+
+/**
+ * @struct MirrorSummary
+ * @brief 镜像比较结果汇总，差异按（服务器、文件）计数
+ */
+struct MirrorSummary {
+    qint64 paths = 0;             ///< 至少出现在一个服务器上的路径数
+    qint64 missing = 0;           ///< 基准上有、其他服务器上缺失的文件数
+    qint64 extra = 0;             ///< 基准上没有、其他服务器上多出的文件数
+    qint64 sizeMismatches = 0;    ///< 大小与基准不同的文件数
+    qint64 mtimeSkews = 0;        ///< 修改时间与基准相差超过容差的文件数
+    qint64 hashMismatches = 0;    ///< 大小相同但服务器端摘要不同的文件数
+    qint64 hashConfirmed = 0;     ///< 摘要确认与基准一致的文件数
+    qint64 hashUnverified = 0;    ///< 请求了摘要确认但无法取得可比较摘要的文件数
+    int failedDirectories = 0;    ///< 扫描时各服务器无法列出的目录总数
+    int untimedServers = 0;       ///< 不支持MLSD、没有比较修改时间的服务器数
+};
+
+/**
+ * @class MirrorChecker
+ * @brief 远程对远程的镜像一致性检查器
+ *
+ * 报告文件每行一条差异："类型\t服务器\t路径\t详情"，类型为MISSING、EXTRA、SIZE、MTIME或HASH，
+ * 服务器以"#序号 地址"标识，序号从1开始，#1为基准。
+ * HASH行在每批摘要确认后写出，可能位于同一路径其他差异之后的位置
+ */
+class MirrorChecker
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    MirrorChecker();
+
+    /**
+     * @brief 设置参与比较的服务器
+     * @param servers 服务器列表，第一个为基准，至少两个
+     */
+    void setServers(const QList<MirrorServer> &servers) { m_servers = servers; }
+
+    /**
+     * @brief 设置新连接的初始化函数
+     * @param configure 在连接之前对每个新建的FtpClient调用（如启用TLS）
+     */
+    void setConfigurator(std::function<void(FtpClient *)> configure) { m_configure = configure; }
+
+    /**
+     * @brief 设置修改时间容差
+     * @param seconds 与基准相差不超过该秒数的修改时间视为一致；为负数时不比较修改时间
+     *
+     * MLSD的时间精确到秒，容差只需覆盖镜像同步工具保留时间时的取整
+     */
+    void setMtimeTolerance(qint64 seconds) { m_mtimeTolerance = seconds; }
+
+    /**
+     * @brief 设置是否用服务器端摘要确认内容
+     * @param enabled 为true时对与基准大小相同的文件发送HASH命令比较摘要
+     */
+    void setHashCheck(bool enabled) { m_hashCheck = enabled; }
+
+    /**
+     * @brief 设置每批确认摘要的路径数
+     * @param paths 累积到该数量后各服务器并行计算摘要，决定内存占用上限
+     */
+    void setHashBatchSize(int paths) { m_hashBatchSize = qMax(1, paths); }
+
+    /**
+     * @brief 设置排序时的内存上限
+     * @param bytes 所有服务器的索引排序合计最多占用的内存字节数
+     */
+    void setSortMemoryLimit(qint64 bytes) { m_sortMemoryLimit = bytes; }
+
+    /**
+     * @brief 设置全局内存预算
+     * @param budget 内存预算，为nullptr时只受setSortMemoryLimit()限制
+     */
+    void setMemoryBudget(MemoryBudget *budget) { m_budget = budget; }
+
+    /**
+     * @brief 扫描并比较所有服务器
+     * @param reportPath 输出报告文件
+     * @return 操作是否成功；任一服务器无法连接或索引失败时返回false
+     */
+    bool run(const QString &reportPath);
+
+    /**
+     * @brief 中止正在进行的比较，可以从其他线程调用
+     *
+     * 扫描在各服务器当前目录列完后结束，run()返回false
+     */
+    void cancel();
+
+    /**
+     * @brief 已扫描的文件数（所有服务器合计），可以从其他线程调用
+     */
+    qint64 scannedFiles() const;
+
+    /**
+     * @brief 获取结果汇总
+     */
+    MirrorSummary summary() const { return m_summary; }
+
+    /**
+     * @brief 服务器在报告中的标识
+     * @param index 服务器下标
+     * @return 如"#2 mirror.example.com:21/pub"
+     */
+    QString serverLabel(int index) const;
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    /**
+     * @brief 待确认摘要的路径：各服务器上的完整路径，缺失的服务器为空
+     */
+    typedef QStringList HashItem;
+
+    /**
+     * @brief 并行扫描所有服务器并按路径排序索引
+     * @param sortedPaths 输出各服务器排序后的索引文件
+     * @param workDir 临时文件目录
+     * @return 操作是否成功
+     */
+    bool buildIndexes(QStringList *sortedPaths, const QString &workDir);
+
+    /**
+     * @brief 按相对路径合并各索引并写出差异
+     * @param sortedPaths 各服务器排序后的索引文件
+     * @param report 报告文件
+     * @return 操作是否成功
+     */
+    bool mergeIndexes(const QStringList &sortedPaths, QFile &report);
+
+    /**
+     * @brief 各服务器并行计算一批文件的摘要并写出不一致项
+     * @param items 待确认的路径
+     * @param report 报告文件
+     * @return 操作是否成功
+     */
+    bool confirmHashes(const QList<HashItem> &items, QFile &report);
+
+    /**
+     * @brief 写出一条差异
+     * @return 操作是否成功
+     */
+    bool writeDifference(QFile &report, const char *type, int server, const QString &path, const QString &detail);
+
+private:
+    QList<MirrorServer> m_servers;               ///< 参与比较的服务器
+    std::function<void(FtpClient *)> m_configure; ///< 新连接的初始化函数
+    qint64 m_mtimeTolerance;                     ///< 修改时间容差（秒）
+    bool m_hashCheck;                            ///< 是否确认摘要
+    int m_hashBatchSize;                         ///< 每批确认摘要的路径数
+    qint64 m_sortMemoryLimit;                    ///< 排序内存上限（合计）
+    MemoryBudget *m_budget;                      ///< 全局内存预算（不拥有）
+    QStringList m_roots;                         ///< 规范化后的各服务器根目录，以/结尾
+    QList<FtpClient*> m_clients;                 ///< 各服务器的连接，扫描后继续用于摘要确认
+    QList<int> m_hashSupport;                    ///< 各服务器HASH命令支持状态：0未知，1支持，-1不支持
+    MirrorSummary m_summary;                     ///< 结果汇总
+    QString m_lastError;                         ///< 最后一个错误信息
+    std::atomic<bool> m_cancelled;               ///< 是否已请求中止
+    mutable QMutex m_indexMutex;                 ///< 保护以下成员
+    QList<RemoteIndex*> m_activeIndexes;         ///< 正在扫描的索引，取消时逐个中止
+    qint64 m_scannedDone;                        ///< 已结束扫描的服务器的文件数
+};
+
+#endif // MIRRORCHECKER_H
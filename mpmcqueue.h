@@ -0,0 +1,139 @@
+/**
+ * @file mpmcqueue.h
+ * @brief 有界无锁多生产者多消费者队列
+ * @details 环形缓冲区的每个槽位带一个序号（Dmitry Vyukov的有界MPMC队列）：
+ *          生产者和消费者各自用CAS推进位置，通过槽位序号判断槽位是否可写/可读，
+ *          入队和出队都不加锁，也不分配内存。
+ */
+
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @class MpmcQueue
+ * @brief 有界无锁MPMC队列
+ * @tparam T 元素类型，需可默认构造和移动
+ *
+ * 队列满时tryPush()失败、空时tryPop()失败，由调用方决定重试或转投其他队列
+ */
+template <typename T>
+class MpmcQueue
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param capacity 容量，向上取整为2的幂
+     */
+    explicit MpmcQueue(size_t capacity)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        m_enqueuePos.store(0, std::memory_order_relaxed);
+        m_dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue &) = delete;
+    MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+    /**
+     * @brief 容量
+     */
+    size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief 尝试入队
+     * @param value 元素，成功时被移走
+     * @return 队列已满时返回false
+     */
+    bool tryPush(T &value)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 尝试出队
+     * @param value 输出元素
+     * @return 队列为空时返回false
+     */
+    bool tryPop(T *value)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &m_cells[pos & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        *value = std::move(cell->value);
+        cell->value = T();
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 近似元素数，仅用于统计和选择投递目标
+     */
+    size_t sizeApprox() const
+    {
+        size_t enqueued = m_enqueuePos.load(std::memory_order_relaxed);
+        size_t dequeued = m_dequeuePos.load(std::memory_order_relaxed);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+private:
+    /**
+     * @struct Cell
+     * @brief 槽位，序号等于位置时可写，等于位置+1时可读
+     */
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    // 入队位置和出队位置放在不同的缓存行，生产者和消费者互不干扰
+    alignas(64) std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    alignas(64) std::atomic<size_t> m_enqueuePos;
+    alignas(64) std::atomic<size_t> m_dequeuePos;
+};
+
+#endif // MPMCQUEUE_H
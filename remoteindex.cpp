@@ -0,0 +1,354 @@
+/**
+ * @file remoteindex.cpp
+ * @brief 远程目录索引实现文件
+ */
+
+#include "remoteindex.h"
+#include "memorybudget.h"
+#include <QFile>
+#include <QQueue>
+#include <QScopeGuard>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief 排序比较：先按大小，再按路径，保证结果稳定
+ */
+bool sizeLess(const IndexRecord &a, const IndexRecord &b)
+{
+    if (a.size != b.size) {
+        return a.size < b.size;
+    }
+    return a.path < b.path;
+}
+
+/**
+ * @brief 排序比较：按路径
+ */
+bool pathLess(const IndexRecord &a, const IndexRecord &b)
+{
+    return a.path < b.path;
+}
+
+/**
+ * @brief 估算一条记录在内存中的占用
+ */
+qint64 recordFootprint(const IndexRecord &record)
+{
+    return static_cast<qint64>(sizeof(IndexRecord)) + record.path.size() * 2 + 32;
+}
+
+/**
+ * @brief 归并时单个顺串的读取状态
+ */
+struct RunCursor {
+    std::unique_ptr<QFile> file;   ///< 顺串文件
+    IndexRecord current;           ///< 当前记录
+};
+
+} // namespace
+
+/**
+ * @brief 构造函数
+ */
+RemoteIndex::RemoteIndex()
+    : m_sortMemoryLimit(64 * 1024 * 1024)
+    , m_budget(nullptr)
+    , m_entryCount(0)
+    , m_failedDirectories(0)
+    , m_cancelled(false)
+{
+}
+
+/**
+ * @brief 扫描远程目录树并写入索引文件
+ * @param client 已连接的客户端
+ * @param remoteRoot 远程根目录
+ * @param indexPath 输出索引文件路径
+ * @return 操作是否成功
+ */
+bool RemoteIndex::build(FtpClient *client, const QString &remoteRoot, const QString &indexPath)
+{
+    m_entryCount = 0;
+    m_failedDirectories = 0;
+
+    QFile output(indexPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_lastError = QString("无法创建索引文件: %1").arg(indexPath);
+        return false;
+    }
+
+    QString root = remoteRoot;
+    if (!root.startsWith("/")) {
+        root = "/" + root;
+    }
+    if (!root.endsWith("/")) {
+        root += "/";
+    }
+
+    // 广度优先扫描，只在内存中保留待扫描的目录，文件记录直接写盘
+    QQueue<QString> pending;
+    pending.enqueue(root);
+    while (!pending.isEmpty()) {
+        if (m_cancelled) {
+            m_lastError = "扫描已取消";
+            return false;
+        }
+        QString dir = pending.dequeue();
+        QList<RemoteEntry> entries;
+        if (!client->listEntries(dir, &entries)) {
+            ++m_failedDirectories;
+            continue;
+        }
+
+        for (const RemoteEntry &entry : entries) {
+            // 换行会破坏索引的行格式，这类名称不计入索引
+            if (entry.name.contains('\n')) {
+                continue;
+            }
+            if (entry.isDirectory) {
+                pending.enqueue(dir + entry.name + "/");
+                continue;
+            }
+
+            IndexRecord record;
+            record.size = entry.size;
+            record.modified = entry.modified.isValid() ? entry.modified.toSecsSinceEpoch() : -1;
+            record.path = dir + entry.name;
+            if (output.write(formatRecord(record)) < 0) {
+                m_lastError = QString("写入索引文件失败: %1").arg(output.errorString());
+                return false;
+            }
+            ++m_entryCount;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 按文件大小对索引进行外部排序
+ * @param inputPath 输入索引文件
+ * @param outputPath 输出索引文件
+ * @return 操作是否成功
+ */
+bool RemoteIndex::sortBySize(const QString &inputPath, const QString &outputPath)
+{
+    return sortWith(inputPath, outputPath, sizeLess);
+}
+
+/**
+ * @brief 按路径对索引进行外部排序
+ * @param inputPath 输入索引文件
+ * @param outputPath 输出索引文件
+ * @return 操作是否成功
+ */
+bool RemoteIndex::sortByPath(const QString &inputPath, const QString &outputPath)
+{
+    return sortWith(inputPath, outputPath, pathLess);
+}
+
+/**
+ * @brief 按给定顺序对索引进行外部排序
+ * @param inputPath 输入索引文件
+ * @param outputPath 输出索引文件
+ * @param less 记录比较函数
+ * @return 操作是否成功
+ */
+bool RemoteIndex::sortWith(const QString &inputPath, const QString &outputPath, RecordLess less)
+{
+    m_entryCount = 0;
+
+    QFile input(inputPath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("无法打开索引文件: %1").arg(inputPath);
+        return false;
+    }
+
+    QTemporaryDir runDir;
+    if (!runDir.isValid()) {
+        m_lastError = "无法创建排序临时目录";
+        return false;
+    }
+
+    // 顺串大小不超过全局预算剩余量的一半，排序期间按该大小记账
+    const qint64 minChunk = 1024 * 1024;
+    qint64 chunkLimit = m_sortMemoryLimit;
+    if (m_budget) {
+        chunkLimit = qBound(minChunk, m_budget->available() / 2, m_sortMemoryLimit);
+        m_budget->charge(MemoryBudget::RemoteIndex, chunkLimit);
+    }
+    auto releaseBudget = qScopeGuard([&]() {
+        if (m_budget) {
+            m_budget->release(MemoryBudget::RemoteIndex, chunkLimit);
+        }
+    });
+
+    // 第一阶段：按内存上限切分为若干个已排序的顺串
+    QStringList runs;
+    QList<IndexRecord> chunk;
+    qint64 chunkBytes = 0;
+    auto flushChunk = [&]() -> bool {
+        if (chunk.isEmpty()) {
+            return true;
+        }
+        std::sort(chunk.begin(), chunk.end(), less);
+        QString runPath = runDir.filePath(QString("run%1").arg(runs.size()));
+        if (!writeRun(chunk, runPath)) {
+            return false;
+        }
+        runs.append(runPath);
+        chunk.clear();
+        chunkBytes = 0;
+        return true;
+    };
+
+    while (!input.atEnd()) {
+        IndexRecord record;
+        if (!parseRecord(input.readLine(), &record)) {
+            continue;
+        }
+        chunkBytes += recordFootprint(record);
+        chunk.append(record);
+        ++m_entryCount;
+        // 预算紧张时（其他组件占用增加）提前写出顺串，每4096条检查一次
+        bool full = chunkBytes >= chunkLimit
+            || (m_budget && chunkBytes >= minChunk && (m_entryCount & 4095) == 0 && m_budget->underPressure());
+        if (full && !flushChunk()) {
+            return false;
+        }
+    }
+    if (!flushChunk()) {
+        return false;
+    }
+
+    // 第二阶段：多路归并
+    return mergeRuns(runs, outputPath, less);
+}
+
+/**
+ * @brief 把一批已排序的记录写成临时顺串
+ * @param records 已排序的记录
+ * @param runPath 顺串文件路径
+ * @return 操作是否成功
+ */
+bool RemoteIndex::writeRun(const QList<IndexRecord> &records, const QString &runPath)
+{
+    QFile run(runPath);
+    if (!run.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_lastError = QString("无法创建排序临时文件: %1").arg(runPath);
+        return false;
+    }
+    for (const IndexRecord &record : records) {
+        if (run.write(formatRecord(record)) < 0) {
+            m_lastError = QString("写入排序临时文件失败: %1").arg(run.errorString());
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 多路归并所有顺串
+ * @param runs 顺串文件列表
+ * @param outputPath 输出文件
+ * @param less 记录比较函数
+ * @return 操作是否成功
+ */
+bool RemoteIndex::mergeRuns(const QStringList &runs, const QString &outputPath, RecordLess less)
+{
+    QFile output(outputPath);
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_lastError = QString("无法创建排序结果文件: %1").arg(outputPath);
+        return false;
+    }
+
+    std::vector<RunCursor> cursors(runs.size());
+    auto advance = [&](RunCursor &cursor) -> bool {
+        while (!cursor.file->atEnd()) {
+            if (parseRecord(cursor.file->readLine(), &cursor.current)) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // 小顶堆中保存顺串下标，堆顶是当前最小的记录
+    auto greater = [&](int a, int b) {
+        return less(cursors[b].current, cursors[a].current);
+    };
+    std::priority_queue<int, std::vector<int>, decltype(greater)> heap(greater);
+
+    for (int i = 0; i < runs.size(); ++i) {
+        cursors[i].file.reset(new QFile(runs.at(i)));
+        if (!cursors[i].file->open(QIODevice::ReadOnly)) {
+            m_lastError = QString("无法打开排序临时文件: %1").arg(runs.at(i));
+            return false;
+        }
+        if (advance(cursors[i])) {
+            heap.push(i);
+        }
+    }
+
+    while (!heap.empty()) {
+        int i = heap.top();
+        heap.pop();
+        if (output.write(formatRecord(cursors[i].current)) < 0) {
+            m_lastError = QString("写入排序结果失败: %1").arg(output.errorString());
+            return false;
+        }
+        if (advance(cursors[i])) {
+            heap.push(i);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 把记录格式化为索引行
+ * @param record 记录
+ * @return 以换行结尾的索引行
+ */
+QByteArray RemoteIndex::formatRecord(const IndexRecord &record)
+{
+    QByteArray line = QByteArray::number(record.size);
+    line += '\t';
+    line += QByteArray::number(record.modified);
+    line += '\t';
+    line += record.path.toUtf8();
+    line += '\n';
+    return line;
+}
+
+/**
+ * @brief 解析索引行
+ * @param line 索引行
+ * @param record 输出记录
+ * @return 格式正确时返回true
+ */
+bool RemoteIndex::parseRecord(const QByteArray &line, IndexRecord *record)
+{
+    // 路径是最后一个字段，本身可以包含制表符
+    int firstTab = line.indexOf('\t');
+    int secondTab = firstTab < 0 ? -1 : line.indexOf('\t', firstTab + 1);
+    if (secondTab < 0) {
+        return false;
+    }
+
+    bool sizeOk = false;
+    bool timeOk = false;
+    record->size = line.left(firstTab).toLongLong(&sizeOk);
+    record->modified = line.mid(firstTab + 1, secondTab - firstTab - 1).toLongLong(&timeOk);
+    QByteArray path = line.mid(secondTab + 1);
+    if (path.endsWith('\n')) {
+        path.chop(1);
+    }
+    record->path = QString::fromUtf8(path);
+    return sizeOk && timeOk && !record->path.isEmpty();
+}
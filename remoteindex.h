@@ -0,0 +1,166 @@
+/**
+ * @file remoteindex.h
+ * @brief 远程目录索引
+ * @details 把远程目录树扫描为磁盘上的索引文件，并支持在固定内存上限内进行外部排序
+ *
+ * 索引文件每行一条记录："大小\t修改时间\t路径"，修改时间为UTC秒数，未知时为-1。
+ * 使用文本格式是为了便于用常规工具检查，千万级条目时也只在扫描和排序中顺序读写
+ */
+
+#ifndef REMOTEINDEX_H
+#define REMOTEINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+#include "ftpclient.h"
+
+class MemoryBudget;
+
+/**
+ * @struct IndexRecord
+ * @brief 索引中的一条文件记录
+ */
+struct IndexRecord {
+    qint64 size = 0;         ///< 文件大小（字节数）
+    qint64 modified = -1;    ///< 修改时间（UTC秒数），未知时为-1
+    QString path;            ///< 远程完整路径
+};
+
+/**
+ * @class RemoteIndex
+ * @brief 远程目录索引的生成与排序
+ */
+class RemoteIndex
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    RemoteIndex();
+
+    /**
+     * @brief 扫描远程目录树并写入索引文件
+     * @param client 已连接的客户端，扫描遵循其扫描模式和名称过滤条件
+     * @param remoteRoot 远程根目录
+     * @param indexPath 输出索引文件路径
+     * @return 操作是否成功；个别目录无法列出时跳过并计入failedDirectories()，被cancel()中止时返回false
+     */
+    bool build(FtpClient *client, const QString &remoteRoot, const QString &indexPath);
+
+    /**
+     * @brief 中止正在进行的扫描，可以从其他线程调用
+     *
+     * 扫描在当前目录列完后结束，之后的build()也会立即失败
+     */
+    void cancel() { m_cancelled = true; }
+
+    /**
+     * @brief 按文件大小对索引进行外部排序
+     * @param inputPath 输入索引文件
+     * @param outputPath 输出索引文件，按（大小、路径）升序
+     * @return 操作是否成功
+     *
+     * 每次读入不超过内存预算的记录排序后写成临时顺串，最后多路归并，
+     * 内存占用与索引规模无关
+     */
+    bool sortBySize(const QString &inputPath, const QString &outputPath);
+
+    /**
+     * @brief 按路径对索引进行外部排序
+     * @param inputPath 输入索引文件
+     * @param outputPath 输出索引文件，按路径升序
+     * @return 操作是否成功
+     *
+     * 与sortBySize()使用相同的顺串和归并过程，用于按路径合并多个索引（如镜像比较）
+     */
+    bool sortByPath(const QString &inputPath, const QString &outputPath);
+
+    /**
+     * @brief 设置排序时的内存上限
+     * @param bytes 每个顺串最多占用的内存字节数
+     */
+    void setSortMemoryLimit(qint64 bytes) { m_sortMemoryLimit = qMax<qint64>(1024 * 1024, bytes); }
+
+    /**
+     * @brief 设置全局内存预算
+     * @param budget 内存预算，为nullptr时只受setSortMemoryLimit()限制
+     *
+     * 排序时顺串大小不超过预算剩余量的一半，预算紧张时提前写出顺串
+     */
+    void setMemoryBudget(MemoryBudget *budget) { m_budget = budget; }
+
+    /**
+     * @brief 最近一次操作处理的记录数，扫描进行中也可以从其他线程读取
+     */
+    qint64 entryCount() const { return m_entryCount; }
+
+    /**
+     * @brief 扫描时无法列出的目录数
+     */
+    int failedDirectories() const { return m_failedDirectories; }
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+    /**
+     * @brief 把记录格式化为索引行
+     * @param record 记录
+     * @return 以换行结尾的索引行
+     */
+    static QByteArray formatRecord(const IndexRecord &record);
+
+    /**
+     * @brief 解析索引行
+     * @param line 索引行（可以带换行）
+     * @param record 输出记录
+     * @return 格式正确时返回true
+     */
+    static bool parseRecord(const QByteArray &line, IndexRecord *record);
+
+private:
+    /**
+     * @brief 记录比较函数，a排在b之前时返回true
+     */
+    typedef bool (*RecordLess)(const IndexRecord &a, const IndexRecord &b);
+
+    /**
+     * @brief 按给定顺序对索引进行外部排序
+     * @param inputPath 输入索引文件
+     * @param outputPath 输出索引文件
+     * @param less 记录比较函数
+     * @return 操作是否成功
+     */
+    bool sortWith(const QString &inputPath, const QString &outputPath, RecordLess less);
+
+    /**
+     * @brief 把一批已排序的记录写成临时顺串
+     * @param records 已排序的记录
+     * @param runPath 顺串文件路径
+     * @return 操作是否成功
+     */
+    bool writeRun(const QList<IndexRecord> &records, const QString &runPath);
+
+    /**
+     * @brief 多路归并所有顺串
+     * @param runs 顺串文件列表
+     * @param outputPath 输出文件
+     * @param less 记录比较函数
+     * @return 操作是否成功
+     */
+    bool mergeRuns(const QStringList &runs, const QString &outputPath, RecordLess less);
+
+private:
+    qint64 m_sortMemoryLimit;   ///< 排序内存上限（字节）
+    MemoryBudget *m_budget;     ///< 全局内存预算（不拥有）
+    std::atomic<qint64> m_entryCount; ///< 最近一次操作处理的记录数
+    std::atomic<bool> m_cancelled;    ///< 是否已请求中止扫描
+    int m_failedDirectories;    ///< 扫描时无法列出的目录数
+    QString m_lastError;        ///< 最后一个错误信息
+};
+
+#endif // REMOTEINDEX_H
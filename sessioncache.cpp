@@ -0,0 +1,152 @@
+/**
+ * @file sessioncache.cpp
+ * @brief 上次会话的持久化缓存实现文件
+ */
+
+#include "sessioncache.h"
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+
+/**
+ * @brief 构造函数
+ * @param path 缓存文件路径
+ * @param maxLines 最多保存的列表行数
+ */
+SessionCache::SessionCache(const QString &path, int maxLines)
+    : m_path(path)
+    , m_maxLines(maxLines)
+    , m_port(0)
+    , m_savedAt(0)
+    , m_dirty(false)
+{
+}
+
+/**
+ * @brief 析构函数，保存有变化的缓存
+ */
+SessionCache::~SessionCache()
+{
+    save();
+}
+
+/**
+ * @brief 从缓存文件加载
+ * @return 操作是否成功
+ */
+bool SessionCache::load()
+{
+    if (m_path.isEmpty()) {
+        return true;
+    }
+    QFile file(m_path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("无法打开会话缓存: %1").arg(m_path);
+        return false;
+    }
+
+    // 字段在空行之前，之后是原始列表
+    bool inListing = false;
+    while (!file.atEnd() && m_listing.size() < m_maxLines) {
+        QByteArray line = file.readLine();
+        if (line.endsWith('\n')) {
+            line.chop(1);
+        }
+        if (inListing) {
+            m_listing.append(QString::fromUtf8(line));
+            continue;
+        }
+        if (line.isEmpty()) {
+            inListing = true;
+            continue;
+        }
+        int tab = line.indexOf('\t');
+        if (tab < 0) {
+            continue;
+        }
+        QByteArray field = line.left(tab);
+        QString value = QString::fromUtf8(line.mid(tab + 1));
+        if (field == "server") {
+            m_server = value;
+        } else if (field == "port") {
+            m_port = value.toInt();
+        } else if (field == "username") {
+            m_username = value;
+        } else if (field == "path") {
+            m_directory = value;
+        } else if (field == "saved") {
+            m_savedAt = value.toLongLong();
+        }
+    }
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 保存到缓存文件
+ * @return 操作是否成功
+ */
+bool SessionCache::save()
+{
+    if (m_path.isEmpty() || !m_dirty) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_lastError = QString("无法写入会话缓存: %1").arg(m_path);
+        return false;
+    }
+    m_savedAt = QDateTime::currentSecsSinceEpoch();
+    file.write("server\t" + m_server.toUtf8() + '\n');
+    file.write("port\t" + QByteArray::number(m_port) + '\n');
+    file.write("username\t" + m_username.toUtf8() + '\n');
+    file.write("path\t" + m_directory.toUtf8() + '\n');
+    file.write("saved\t" + QByteArray::number(m_savedAt) + '\n');
+    file.write("\n");
+    for (const QString &line : m_listing) {
+        file.write(line.toUtf8() + '\n');
+    }
+    if (!file.commit()) {
+        m_lastError = QString("保存会话缓存失败: %1").arg(file.errorString());
+        return false;
+    }
+    m_dirty = false;
+    return true;
+}
+
+/**
+ * @brief 记录当前连接
+ * @param server 服务器地址
+ * @param port 端口号
+ * @param username 用户名
+ */
+void SessionCache::setSession(const QString &server, int port, const QString &username)
+{
+    if (server != m_server || port != m_port || username != m_username) {
+        m_server = server;
+        m_port = port;
+        m_username = username;
+        m_directory.clear();
+        m_listing.clear();
+        m_dirty = true;
+    }
+}
+
+/**
+ * @brief 记录最后浏览的目录
+ * @param path 远程目录路径
+ * @param lines 目录的原始列表
+ */
+void SessionCache::setListing(const QString &path, const QStringList &lines)
+{
+    m_directory = path;
+    m_listing = lines.mid(0, m_maxLines);
+    m_dirty = true;
+}
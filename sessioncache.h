@@ -0,0 +1,93 @@
+/**
+ * @file sessioncache.h
+ * @brief 上次会话的持久化缓存
+ * @details 保存上次连接的服务器、端口、用户名以及最后浏览的目录和它的原始列表，
+ *          下次启动时无需连接即可立即显示，连接后再由服务器上的最新内容替换。
+ *          密码不保存。
+ *
+ * 缓存文件为文本格式：开头若干行"字段\t值"，一个空行，之后每行一条原始列表
+ */
+
+#ifndef SESSIONCACHE_H
+#define SESSIONCACHE_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * @class SessionCache
+ * @brief 上次会话的服务器和目录列表，只在主线程使用
+ */
+class SessionCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param path 缓存文件路径，为空时不保存
+     * @param maxLines 最多保存的列表行数，更大的目录只保存前面的部分
+     */
+    explicit SessionCache(const QString &path = QString(), int maxLines = 5000);
+
+    /**
+     * @brief 析构函数，保存有变化的缓存
+     */
+    ~SessionCache();
+
+    /**
+     * @brief 从缓存文件加载
+     * @return 操作是否成功；缓存文件不存在时视为空缓存并返回true
+     */
+    bool load();
+
+    /**
+     * @brief 保存到缓存文件（先写临时文件再替换）
+     * @return 操作是否成功；没有变化时直接返回true
+     */
+    bool save();
+
+    /**
+     * @brief 记录当前连接
+     * @param server 服务器地址
+     * @param port 端口号
+     * @param username 用户名
+     */
+    void setSession(const QString &server, int port, const QString &username);
+
+    /**
+     * @brief 记录最后浏览的目录
+     * @param path 远程目录路径
+     * @param lines 目录的原始列表
+     */
+    void setListing(const QString &path, const QStringList &lines);
+
+    /**
+     * @brief 是否有可显示的会话
+     */
+    bool isEmpty() const { return m_server.isEmpty(); }
+
+    QString server() const { return m_server; }       ///< 服务器地址
+    int port() const { return m_port; }               ///< 端口号
+    QString username() const { return m_username; }   ///< 用户名
+    QString path() const { return m_directory; }      ///< 最后浏览的目录
+    QStringList listing() const { return m_listing; } ///< 目录的原始列表
+    qint64 savedAt() const { return m_savedAt; }      ///< 保存时间（UTC秒数）
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    QString m_path;          ///< 缓存文件路径
+    int m_maxLines;          ///< 最多保存的列表行数
+    QString m_server;        ///< 服务器地址
+    int m_port;              ///< 端口号
+    QString m_username;      ///< 用户名
+    QString m_directory;     ///< 最后浏览的目录
+    QStringList m_listing;   ///< 目录的原始列表
+    qint64 m_savedAt;        ///< 保存时间（UTC秒数）
+    bool m_dirty;            ///< 是否有未保存的变化
+    QString m_lastError;     ///< 最后一个错误信息
+};
+
+#endif // SESSIONCACHE_H
@@ -0,0 +1,579 @@
+/**
+ * @file jobsim.cpp
+ * @brief 下载作业离线模拟器
+ *
+ * 用记录下来的作业和网络特征离线评估调度策略，无需连接生产服务器：
+ *   jobsim [选项] <台账文件或目录>...
+ *
+ * 一次只模拟一个服务器：台账中有多个服务器的记录时必须用--server选出其中一个，
+ * 不同服务器的网络特征不能混在一起。网络模型从该服务器的TransferLedger记录中提取：
+ * 1. 往返时延：新连接的TCP建连时间（connect_us - dns_us）的中位数
+ * 2. 请求启动时间：复用连接和新建连接时首字节时间（ttfb_us）的中位数
+ * 3. 吞吐曲线：单连接稳态吞吐（单文件下载，扣除首字节时间），以及成批下载时
+ *    同批文件的合计吞吐（并发数按批大小近似），按并发数线性插值
+ * 也可以用--rtt-ms、--curve等选项直接给出或覆盖。
+ *
+ * 作业为RemoteIndex索引文件（--index）中的文件，未指定时重放台账中该服务器的传输。
+ * 文件按DownloadScheduler（与主窗口相同的调度代码）逐步取出，每一步在模拟网络上
+ * 以流体模型计算耗时：活跃的传输按吞吐曲线分享带宽，各连接依次处理分到的文件，
+ * 新连接和复用连接分别计入启动时间。各策略参数可以给出多个值（逗号分隔），
+ * 输出所有组合按预测作业时间排序的对比表
+ */
+
+#include "transferledger.h"
+#include "remoteindex.h"
+#include "downloadqueue.h"
+#include "downloadscheduler.h"
+#include "bytesize.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QMap>
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/**
+ * @struct NetworkModel
+ * @brief 一个服务器的模拟网络
+ */
+struct NetworkModel {
+    double rtt = 0.05;              ///< 往返时延（秒）
+    double connectStartup = -1.0;   ///< 新建连接后第一个文件的首字节时间（秒），未知时为-1
+    double requestStartup = -1.0;   ///< 复用连接时的首字节时间（秒），未知时为-1
+    double streamRate = 10.0 * 1024 * 1024; ///< 单连接稳态吞吐（字节/秒）
+    QMap<int, double> curve;        ///< 并发数到合计吞吐（字节/秒）
+    qint64 samples = 0;             ///< 提取模型所用的记录数
+
+    /**
+     * @brief 新建连接（登录、被动模式、RETR）后第一个字节到达的时间
+     */
+    double connectionStartup() const { return connectStartup >= 0 ? connectStartup : 6 * rtt; }
+
+    /**
+     * @brief 复用连接时一个文件第一个字节到达的时间
+     */
+    double transferStartup() const { return requestStartup >= 0 ? requestStartup : 3 * rtt; }
+
+    /**
+     * @brief 一定并发数下的合计吞吐
+     * @param streams 并发数
+     * @return 字节/秒
+     */
+    double aggregate(int streams) const
+    {
+        if (curve.isEmpty()) {
+            return streams * streamRate;
+        }
+        auto upper = curve.lowerBound(streams);
+        if (upper == curve.end()) {
+            return (curve.end() - 1).value();
+        }
+        if (upper.key() == streams) {
+            return upper.value();
+        }
+        if (upper == curve.begin()) {
+            // 曲线第一个点之前按并发数线性增长
+            return upper.value() * streams / upper.key();
+        }
+        auto lower = upper - 1;
+        double fraction = double(streams - lower.key()) / double(upper.key() - lower.key());
+        return lower.value() + fraction * (upper.value() - lower.value());
+    }
+};
+
+/**
+ * @struct SimResult
+ * @brief 一个策略的模拟结果
+ */
+struct SimResult {
+    QString policy;          ///< 策略描述
+    double seconds = 0.0;    ///< 预测作业时间
+    int steps = 0;           ///< 调度步数
+    int batches = 0;         ///< 批量下载步数
+    int segmented = 0;       ///< 分段下载步数
+    int connections = 0;     ///< 新建的连接数
+};
+
+/**
+ * @brief 计算中位数
+ * @param values 样本，会被排序
+ * @return 中位数，无样本时为-1
+ */
+static double median(std::vector<double> &values)
+{
+    if (values.empty()) {
+        return -1.0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+/**
+ * @brief 展开命令行中的台账文件和目录
+ * @param paths 命令行参数
+ * @return 台账文件列表
+ */
+static QStringList ledgerFiles(const QStringList &paths)
+{
+    QStringList files;
+    for (const QString &path : paths) {
+        if (QFileInfo(path).isDir()) {
+            const QStringList names = QDir(path).entryList(QStringList() << "transfers-*.jsonl", QDir::Files, QDir::Name);
+            for (const QString &name : names) {
+                files.append(QDir(path).filePath(name));
+            }
+        } else {
+            files.append(path);
+        }
+    }
+    return files;
+}
+
+/**
+ * @brief 从台账记录提取网络模型
+ * @param records 同一服务器的传输记录
+ * @param minSize 参与吞吐统计的最小文件大小
+ * @param model 输出模型，没有样本的参数保持原值
+ */
+static void buildModel(const QList<TransferRecord> &records, qint64 minSize, NetworkModel *model)
+{
+    std::vector<double> rtts;
+    std::vector<double> connectStartups;
+    std::vector<double> requestStartups;
+    std::vector<double> streamRates;
+    // 同一批的记录开始时间相同：开始时间 → (文件数, 字节数, 最长耗时)
+    struct Group { int files = 0; qint64 bytes = 0; double seconds = 0.0; };
+    QMap<qint64, Group> groups;
+
+    for (const TransferRecord &record : records) {
+        if (!record.success) {
+            continue;
+        }
+        ++model->samples;
+        if (record.connectUs > 0) {
+            rtts.push_back((record.connectUs - qMax<qint64>(0, record.nameLookupUs)) / 1e6);
+            if (record.firstByteUs > 0) {
+                connectStartups.push_back(record.firstByteUs / 1e6);
+            }
+        } else if (record.firstByteUs > 0) {
+            requestStartups.push_back(record.firstByteUs / 1e6);
+        }
+
+        double seconds = record.durationMs / 1000.0;
+        if (record.batchSize <= 1) {
+            double streaming = seconds - qMax<qint64>(0, record.firstByteUs) / 1e6;
+            if (record.bytes >= minSize && streaming > 0) {
+                streamRates.push_back(record.bytes / streaming);
+            }
+        } else {
+            Group &group = groups[record.started];
+            group.files += 1;
+            group.bytes += record.bytes;
+            group.seconds = qMax(group.seconds, seconds);
+        }
+    }
+
+    double rtt = median(rtts);
+    if (rtt > 0) {
+        model->rtt = rtt;
+    }
+    model->connectStartup = median(connectStartups);
+    model->requestStartup = median(requestStartups);
+    double stream = median(streamRates);
+    if (stream > 0) {
+        model->streamRate = stream;
+        model->curve.insert(1, stream);
+    }
+
+    // 只有平均文件不小于minSize的批次才反映带宽，极小文件的批次主要受启动时间限制
+    QMap<int, std::vector<double>> byConcurrency;
+    for (const Group &group : groups) {
+        if (group.seconds > 0 && group.bytes >= minSize * group.files) {
+            byConcurrency[group.files].push_back(group.bytes / group.seconds);
+        }
+    }
+    for (auto it = byConcurrency.begin(); it != byConcurrency.end(); ++it) {
+        model->curve.insert(it.key(), median(it.value()));
+    }
+}
+
+/**
+ * @brief 模拟一步传输
+ * @param model 网络模型
+ * @param sizes 本步各文件要传输的字节数
+ * @param slots 并行的连接（或多路复用的流）数，各自依次处理分到的文件
+ * @param firstStartup 每个连接上第一个文件的启动时间（秒）
+ * @param nextStartup 同一连接上后续文件的启动时间（秒）
+ * @param sharedConnection 是否所有流共用一个连接（HTTP/2多路复用）
+ * @return 本步耗时（秒）
+ *
+ * 流体模型：活跃的传输平分当前并发数下的合计吞吐，单个连接不超过单连接吞吐；
+ * 每当有传输完成或开始时重新分配，直到所有文件传完
+ */
+static double simulateStep(const NetworkModel &model, const QList<qint64> &sizes, int slots,
+                           double firstStartup, double nextStartup, bool sharedConnection)
+{
+    struct Slot { bool busy = false; double readyAt = 0.0; double remaining = 0.0; };
+    std::vector<Slot> lanes(static_cast<size_t>(qMax(1, qMin(slots, sizes.size()))));
+    int nextFile = 0;
+    double now = 0.0;
+
+    for (Slot &lane : lanes) {
+        if (nextFile < sizes.size()) {
+            lane.busy = true;
+            lane.readyAt = firstStartup;
+            lane.remaining = static_cast<double>(sizes.at(nextFile++));
+        }
+    }
+
+    for (;;) {
+        int active = 0;
+        double nextReady = std::numeric_limits<double>::infinity();
+        for (const Slot &lane : lanes) {
+            if (!lane.busy) {
+                continue;
+            }
+            if (lane.readyAt <= now) {
+                ++active;
+            } else {
+                nextReady = qMin(nextReady, lane.readyAt);
+            }
+        }
+        if (active == 0) {
+            if (nextReady == std::numeric_limits<double>::infinity()) {
+                return now;
+            }
+            now = nextReady;
+            continue;
+        }
+
+        double rate = sharedConnection ? qMin(model.streamRate, model.aggregate(1)) / active
+                                       : qMin(model.streamRate, model.aggregate(active) / active);
+        double step = nextReady - now;
+        for (const Slot &lane : lanes) {
+            if (lane.busy && lane.readyAt <= now) {
+                step = qMin(step, lane.remaining / rate);
+            }
+        }
+
+        now += step;
+        for (Slot &lane : lanes) {
+            if (!lane.busy || lane.readyAt > now - step) {
+                continue;
+            }
+            lane.remaining -= rate * step;
+            if (lane.remaining <= 0.5) {
+                // 该连接继续处理下一个文件
+                if (nextFile < sizes.size()) {
+                    lane.readyAt = now + nextStartup;
+                    lane.remaining = static_cast<double>(sizes.at(nextFile++));
+                } else {
+                    lane.busy = false;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief 用调度器模拟整个作业
+ * @param model 网络模型
+ * @param tasks 作业中的文件，按入队顺序
+ * @param policy 调度参数
+ * @param connections 批量下载时的最大连接数
+ * @param stepGap 两步之间的间隔（秒），对应主窗口处理下一步前的定时器延迟
+ * @param result 输出结果
+ */
+static void simulateJob(const NetworkModel &model, const QList<DownloadTask> &tasks, const SchedulerPolicy &policy,
+                        int connections, double stepGap, SimResult *result)
+{
+    DownloadQueue queue;
+    queue.setServer("sim");
+    for (const DownloadTask &task : tasks) {
+        queue.enqueue(task);
+    }
+
+    DownloadScheduler scheduler(policy);
+    bool mainConnected = false;       // 单文件下载使用的主连接在各步之间保持
+    bool blockSessionOpen = false;    // 块模式会话在各批之间保持
+    for (;;) {
+        ScheduledStep step = scheduler.next(&queue);
+        if (step.kind == ScheduledStep::Idle) {
+            break;
+        }
+        ++result->steps;
+        result->seconds += stepGap;
+
+        QList<qint64> sizes;
+        for (const DownloadTask &task : step.tasks) {
+            sizes << task.fileSize;
+        }
+        switch (step.kind) {
+        case ScheduledStep::Batch:
+            ++result->batches;
+            if (policy.batchMode == SchedulerPolicy::BlockMode) {
+                // 同一个数据连接上依次传输，每个文件只需一次RETR往返
+                result->seconds += simulateStep(model, sizes, 1, blockSessionOpen ? model.rtt : model.connectionStartup(),
+                                                model.rtt, false);
+                result->connections += blockSessionOpen ? 0 : 1;
+                blockSessionOpen = true;
+            } else if (policy.batchMode == SchedulerPolicy::Multiplexed) {
+                // 每批新建一个多路句柄，所有请求在一个连接上同时发出
+                result->seconds += simulateStep(model, sizes, sizes.size(), model.connectionStartup(),
+                                                model.transferStartup(), true);
+                result->connections += 1;
+            } else {
+                // 每批新建一个多路句柄，每个连接先登录，之后复用连接依次下载分到的文件
+                int lanes = qMin(connections, sizes.size());
+                result->seconds += simulateStep(model, sizes, lanes, model.connectionStartup(),
+                                                model.transferStartup(), false);
+                result->connections += lanes;
+            }
+            break;
+        case ScheduledStep::Segmented: {
+            ++result->segmented;
+            QList<qint64> parts;
+            qint64 size = step.tasks.first().fileSize;
+            for (int i = 0; i < step.segments; ++i) {
+                parts << (size / step.segments + (i < size % step.segments ? 1 : 0));
+            }
+            result->seconds += simulateStep(model, parts, step.segments, model.connectionStartup(),
+                                            model.transferStartup(), false);
+            result->connections += step.segments;
+            break;
+        }
+        case ScheduledStep::Single:
+            sizes[0] -= step.resumeOffset;
+            result->seconds += simulateStep(model, sizes, 1,
+                                            mainConnected ? model.transferStartup() : model.connectionStartup(),
+                                            model.transferStartup(), false);
+            result->connections += mainConnected ? 0 : 1;
+            mainConnected = true;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+/**
+ * @brief 拆分逗号分隔的选项值
+ * @param text 选项值
+ * @return 各个值
+ */
+static QStringList listValues(const QString &text)
+{
+    QStringList values;
+    for (const QString &value : text.split(',', Qt::SkipEmptyParts)) {
+        values << value.trimmed();
+    }
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("jobsim");
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("用台账记录的网络特征和真实的调度代码离线预测下载作业时间");
+    parser.addHelpOption();
+    parser.addPositionalArgument("ledger", "台账文件或目录（transfers-*.jsonl），提供网络模型和默认作业", "[<ledger>...]");
+    QCommandLineOption serverOption("server", "要模拟的服务器：完全相同的服务器标识，或只匹配一个服务器的文本", "text");
+    QCommandLineOption indexOption("index", "作业为RemoteIndex索引文件中的所有文件", "file");
+    QCommandLineOption minSizeOption("min-size", "参与吞吐统计的最小文件大小", "bytes", "1M");
+    QCommandLineOption rttOption("rtt-ms", "往返时延（覆盖台账中的值）", "ms");
+    QCommandLineOption streamOption("stream-mbps", "单连接吞吐（MiB/s，覆盖台账中的值）", "MiB/s");
+    QCommandLineOption curveOption("curve", "吞吐曲线（覆盖台账中的值），如\"1:40,4:120,8:150\"（并发数:MiB/s）", "points");
+    QCommandLineOption modeOption("batch-mode", "批量合并方式：tiny、multiplexed、block", "modes", "tiny");
+    QCommandLineOption batchOption("batch-size", "每批最多的文件数", "counts", "64");
+    QCommandLineOption tinyOption("tiny-limit", "tiny方式下可合并的文件大小上限", "sizes", "64K");
+    QCommandLineOption thresholdOption("segment-threshold", "分段下载的文件大小下限", "sizes", "64M");
+    QCommandLineOption segmentsOption("segments", "分段数量", "counts", "4");
+    QCommandLineOption connectionsOption("connections", "批量下载的最大连接数", "counts", "4");
+    QCommandLineOption orderOption("order", "入队顺序：recorded、small-first、large-first", "orders", "recorded");
+    QCommandLineOption gapOption("step-gap-ms", "两步之间的间隔（主窗口为100毫秒）", "ms", "100");
+    parser.addOptions({serverOption, indexOption, minSizeOption, rttOption, streamOption, curveOption,
+                       modeOption, batchOption, tinyOption, thresholdOption, segmentsOption,
+                       connectionsOption, orderOption, gapOption});
+    parser.process(app);
+
+    // 读取台账，按服务器分组
+    QString serverFilter = parser.value(serverOption);
+    QMap<QString, QList<TransferRecord>> byServer;
+    for (const QString &path : ledgerFiles(parser.positionalArguments())) {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            err << "无法打开台账文件: " << path << Qt::endl;
+            continue;
+        }
+        while (!file.atEnd()) {
+            TransferRecord record;
+            // 上传记录不反映下载的网络特征
+            if (TransferLedger::fromJson(file.readLine(), &record) && !record.upload
+                && (serverFilter.isEmpty() || record.server.contains(serverFilter))) {
+                byServer[record.server].append(record);
+            }
+        }
+    }
+
+    // 完全相同的服务器标识优先，避免"host:21"同时匹配"host:2121"
+    if (byServer.contains(serverFilter)) {
+        QList<TransferRecord> exact = byServer.value(serverFilter);
+        byServer.clear();
+        byServer.insert(serverFilter, exact);
+    }
+    if (byServer.size() > 1) {
+        err << (serverFilter.isEmpty() ? "台账中有多个服务器的记录，请用--server选择一个:"
+                                       : "--server匹配了多个服务器，请给出完整的服务器标识:") << Qt::endl;
+        for (auto it = byServer.constBegin(); it != byServer.constEnd(); ++it) {
+            err << QString("  %1 %2").arg(it.key(), -28).arg(it.value().size()) << Qt::endl;
+        }
+        return 1;
+    }
+    QString server;
+    QList<TransferRecord> records;
+    if (!byServer.isEmpty()) {
+        server = byServer.firstKey();
+        records = byServer.first();
+    }
+
+    NetworkModel model;
+    qint64 minSize = qMax<qint64>(1, ByteSize::parse(parser.value(minSizeOption)));
+    buildModel(records, minSize, &model);
+    if (parser.isSet(rttOption)) {
+        model.rtt = parser.value(rttOption).toDouble() / 1000.0;
+        model.connectStartup = -1.0;
+        model.requestStartup = -1.0;
+    }
+    if (parser.isSet(streamOption)) {
+        model.streamRate = parser.value(streamOption).toDouble() * 1024 * 1024;
+    }
+    if (parser.isSet(curveOption)) {
+        model.curve.clear();
+        for (const QString &point : listValues(parser.value(curveOption))) {
+            QStringList parts = point.split(':');
+            if (parts.size() == 2 && parts[0].toInt() > 0 && parts[1].toDouble() > 0) {
+                model.curve.insert(parts[0].toInt(), parts[1].toDouble() * 1024 * 1024);
+            }
+        }
+    }
+
+    // 作业：索引文件中的文件，或台账中该服务器的传输
+    QList<DownloadTask> tasks;
+    if (parser.isSet(indexOption)) {
+        QFile index(parser.value(indexOption));
+        if (!index.open(QIODevice::ReadOnly)) {
+            err << "无法打开索引文件: " << index.fileName() << Qt::endl;
+            return 1;
+        }
+        while (!index.atEnd()) {
+            IndexRecord record;
+            if (RemoteIndex::parseRecord(index.readLine(), &record)) {
+                tasks << DownloadTask{record.path, "sim:" + record.path, false, record.size,
+                                      QFileInfo(record.path).fileName(), QStringList()};
+            }
+        }
+    } else {
+        // 同一文件可能传输过多次，路径加上序号以免被队列去重或合并
+        for (const TransferRecord &record : records) {
+            if (record.success) {
+                QString path = QString("/%1%2").arg(tasks.size()).arg(record.remotePath);
+                tasks << DownloadTask{path, "sim:" + path, false, record.bytes,
+                                      QFileInfo(record.remotePath).fileName(), QStringList()};
+            }
+        }
+    }
+    if (tasks.isEmpty()) {
+        err << "作业中没有文件，请提供台账或--index" << Qt::endl;
+        parser.showHelp(1);
+    }
+
+    qint64 totalBytes = 0;
+    for (const DownloadTask &task : tasks) {
+        totalBytes += task.fileSize;
+    }
+    out << QString("作业: %1 个文件，%2 MiB").arg(tasks.size()).arg(totalBytes / (1024.0 * 1024.0), 0, 'f', 1) << Qt::endl;
+    out << QString("网络模型: %1（%2 条记录）RTT %3 ms，新连接首字节 %4 ms，复用连接首字节 %5 ms，单连接 %6 MiB/s")
+           .arg(server.isEmpty() ? QString("命令行参数") : server).arg(model.samples)
+           .arg(model.rtt * 1000, 0, 'f', 1).arg(model.connectionStartup() * 1000, 0, 'f', 1)
+           .arg(model.transferStartup() * 1000, 0, 'f', 1).arg(model.streamRate / (1024.0 * 1024.0), 0, 'f', 2)
+        << Qt::endl;
+    for (auto it = model.curve.constBegin(); it != model.curve.constEnd(); ++it) {
+        out << QString("  %1 并发: %2 MiB/s").arg(it.key(), 3).arg(it.value() / (1024.0 * 1024.0), 0, 'f', 2) << Qt::endl;
+    }
+
+    // 所有策略参数的组合
+    QMap<QString, SchedulerPolicy::BatchMode> modes;
+    modes.insert("tiny", SchedulerPolicy::TinyFiles);
+    modes.insert("multiplexed", SchedulerPolicy::Multiplexed);
+    modes.insert("block", SchedulerPolicy::BlockMode);
+    double stepGap = parser.value(gapOption).toDouble() / 1000.0;
+    QList<SimResult> results;
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString &order : listValues(parser.value(orderOption))) {
+        QList<DownloadTask> ordered = tasks;
+        if (order == "small-first") {
+            std::stable_sort(ordered.begin(), ordered.end(),
+                             [](const DownloadTask &a, const DownloadTask &b) { return a.fileSize < b.fileSize; });
+        } else if (order == "large-first") {
+            std::stable_sort(ordered.begin(), ordered.end(),
+                             [](const DownloadTask &a, const DownloadTask &b) { return a.fileSize > b.fileSize; });
+        } else if (order != "recorded") {
+            err << "未知的入队顺序: " << order << Qt::endl;
+            return 1;
+        }
+        for (const QString &mode : listValues(parser.value(modeOption))) {
+            if (!modes.contains(mode)) {
+                err << "未知的批量合并方式: " << mode << Qt::endl;
+                return 1;
+            }
+            for (const QString &batchSize : listValues(parser.value(batchOption))) {
+                for (const QString &tinyLimit : listValues(parser.value(tinyOption))) {
+                    for (const QString &threshold : listValues(parser.value(thresholdOption))) {
+                        for (const QString &segments : listValues(parser.value(segmentsOption))) {
+                            for (const QString &connections : listValues(parser.value(connectionsOption))) {
+                                SchedulerPolicy policy;
+                                policy.batchMode = modes.value(mode);
+                                policy.batchSize = qMax(1, batchSize.toInt());
+                                policy.tinyFileLimit = qMax<qint64>(0, ByteSize::parse(tinyLimit));
+                                policy.segmentThreshold = qMax<qint64>(1, ByteSize::parse(threshold));
+                                policy.segments = qMax(1, segments.toInt());
+
+                                SimResult result;
+                                result.policy = QString("%1 %2 batch=%3 tiny=%4 seg>=%5x%6 conn=%7")
+                                                .arg(order, mode, batchSize, tinyLimit, threshold, segments, connections);
+                                simulateJob(model, ordered, policy, qMax(1, connections.toInt()), stepGap, &result);
+                                results << result;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end(),
+              [](const SimResult &a, const SimResult &b) { return a.seconds < b.seconds; });
+    out << Qt::endl << QString("%1 种策略，模拟用时 %2 ms，按预测作业时间排序:")
+                       .arg(results.size()).arg(timer.elapsed()) << Qt::endl;
+    out << QString("%1 %2 %3 %4 %5 %6 %7")
+           .arg("seconds", 10).arg("MiB/s", 9).arg("steps", 7).arg("batches", 8).arg("segm", 6).arg("conns", 6)
+           .arg("policy") << Qt::endl;
+    for (const SimResult &result : results) {
+        out << QString("%1 %2 %3 %4 %5 %6 %7")
+               .arg(result.seconds, 10, 'f', 2)
+               .arg(result.seconds > 0 ? totalBytes / (1024.0 * 1024.0) / result.seconds : 0.0, 9, 'f', 2)
+               .arg(result.steps, 7).arg(result.batches, 8).arg(result.segmented, 6).arg(result.connections, 6)
+               .arg(result.policy) << Qt::endl;
+    }
+    return 0;
+}
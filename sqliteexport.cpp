@@ -0,0 +1,306 @@
+/**
+ * @file sqliteexport.cpp
+ * @brief 远程索引和传输历史的SQLite导出实现文件
+ */
+
+#include "sqliteexport.h"
+#include "remoteindex.h"
+#include <QDateTime>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+
+/**
+ * @brief 构造函数
+ */
+SqliteExport::SqliteExport()
+    : m_connectionName(QString("sqliteexport-%1").arg(reinterpret_cast<quintptr>(this)))
+    , m_batchSize(50000)
+    , m_exportedFiles(0)
+{
+}
+
+/**
+ * @brief 析构函数，写出缓冲的传输记录并关闭数据库
+ */
+SqliteExport::~SqliteExport()
+{
+    close();
+}
+
+/**
+ * @brief 打开（必要时创建）数据库
+ * @param databasePath 数据库文件路径
+ * @return 操作是否成功
+ */
+bool SqliteExport::open(const QString &databasePath)
+{
+    close();
+    if (!QSqlDatabase::isDriverAvailable("QSQLITE")) {
+        m_lastError = "Qt SQLite驱动不可用";
+        return false;
+    }
+
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_connectionName);
+        db.setDatabaseName(databasePath);
+        if (!db.open()) {
+            m_lastError = QString("无法打开数据库: %1").arg(db.lastError().text());
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(m_connectionName);
+            return false;
+        }
+    }
+    m_databasePath = databasePath;
+
+    // WAL下提交只需顺序追加日志，读者（如外部查询）不阻塞写入
+    bool ok = exec("PRAGMA journal_mode=WAL")
+        && exec("PRAGMA synchronous=NORMAL")
+        && exec("CREATE TABLE IF NOT EXISTS crawls (id INTEGER PRIMARY KEY, server TEXT, root TEXT, "
+                "created INTEGER, files INTEGER, bytes INTEGER)")
+        && exec("CREATE TABLE IF NOT EXISTS files (crawl INTEGER, path TEXT, dir TEXT, size INTEGER, modified INTEGER)")
+        && exec("CREATE TABLE IF NOT EXISTS transfers (started INTEGER, server TEXT, remote_path TEXT, "
+                "local_path TEXT, bytes INTEGER, duration_ms INTEGER, batch_size INTEGER, success INTEGER, error TEXT, "
+                "direction TEXT DEFAULT 'down')")
+        && addDirectionColumn()
+        && exec("CREATE INDEX IF NOT EXISTS transfers_started ON transfers(started)")
+        && exec("CREATE INDEX IF NOT EXISTS transfers_server ON transfers(server, started)")
+        && createFileIndexes();
+    if (!ok) {
+        QString error = m_lastError;
+        close();
+        m_lastError = error;
+    }
+    return ok;
+}
+
+/**
+ * @brief 写出缓冲的传输记录并关闭数据库
+ */
+void SqliteExport::close()
+{
+    if (m_databasePath.isEmpty()) {
+        return;
+    }
+    flush();
+    m_pending.clear();
+    QSqlDatabase::database(m_connectionName, false).close();
+    QSqlDatabase::removeDatabase(m_connectionName);
+    m_databasePath.clear();
+}
+
+/**
+ * @brief 导入索引文件
+ * @param indexPath 索引文件
+ * @param server 服务器标识
+ * @param root 扫描的远程根目录
+ * @param crawlId 输出本次导入的id
+ * @return 操作是否成功
+ */
+bool SqliteExport::exportIndex(const QString &indexPath, const QString &server, const QString &root, qint64 *crawlId)
+{
+    m_exportedFiles = 0;
+    if (!isOpen()) {
+        m_lastError = "数据库未打开";
+        return false;
+    }
+    QFile input(indexPath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("无法打开索引文件: %1").arg(indexPath);
+        return false;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+    QSqlQuery crawl(db);
+    crawl.prepare("INSERT INTO crawls (server, root, created, files, bytes) VALUES (?, ?, ?, 0, 0)");
+    crawl.addBindValue(server);
+    crawl.addBindValue(root);
+    crawl.addBindValue(QDateTime::currentSecsSinceEpoch());
+    if (!crawl.exec()) {
+        m_lastError = QString("写入crawls表失败: %1").arg(crawl.lastError().text());
+        return false;
+    }
+    qint64 id = crawl.lastInsertId().toLongLong();
+    if (crawlId) {
+        *crawlId = id;
+    }
+
+    // 空表时导入期间不维护索引，导入结束后一次建好；已有数据时重建索引要重排所有历史行，
+    // 保留索引，只在最后提交一次。两种情况都不等待每次提交落盘
+    QSqlQuery existing(db);
+    if (!existing.exec("SELECT EXISTS (SELECT 1 FROM files)") || !existing.next()) {
+        m_lastError = QString("查询files表失败: %1").arg(existing.lastError().text());
+        return false;
+    }
+    bool bulkLoad = existing.value(0).toInt() == 0;
+    existing.finish();
+    if (bulkLoad && (!exec("DROP INDEX IF EXISTS files_dir") || !exec("DROP INDEX IF EXISTS files_size")
+                     || !exec("DROP INDEX IF EXISTS files_modified"))) {
+        return false;
+    }
+    if (!exec("PRAGMA synchronous=OFF")) {
+        return false;
+    }
+    // 空表时失败前写入的部分同样提交，已有数据时整体回滚；之后恢复同步设置和查询索引
+    qint64 bytes = 0;
+    auto finishLoad = [&](bool ok) -> bool {
+        if (!ok && !bulkLoad) {
+            db.rollback();
+            m_exportedFiles = 0;
+            bytes = 0;
+        } else if (!db.commit() && ok) {
+            m_lastError = QString("提交事务失败: %1").arg(db.lastError().text());
+            ok = false;
+        }
+        QSqlQuery totals(db);
+        totals.prepare("UPDATE crawls SET files = ?, bytes = ? WHERE id = ?");
+        totals.addBindValue(m_exportedFiles);
+        totals.addBindValue(bytes);
+        totals.addBindValue(id);
+        if (!totals.exec() && ok) {
+            m_lastError = QString("写入crawls表失败: %1").arg(totals.lastError().text());
+            ok = false;
+        }
+        bool restored = exec("PRAGMA synchronous=NORMAL") && createFileIndexes();
+        return ok && restored;
+    };
+
+    QSqlQuery insert(db);
+    insert.prepare("INSERT INTO files (crawl, path, dir, size, modified) VALUES (?, ?, ?, ?, ?)");
+    if (!db.transaction()) {
+        m_lastError = QString("开始事务失败: %1").arg(db.lastError().text());
+        finishLoad(false);
+        return false;
+    }
+    while (!input.atEnd()) {
+        IndexRecord record;
+        if (!RemoteIndex::parseRecord(input.readLine(), &record)) {
+            continue;
+        }
+        insert.bindValue(0, id);
+        insert.bindValue(1, record.path);
+        insert.bindValue(2, record.path.left(record.path.lastIndexOf('/') + 1));
+        insert.bindValue(3, record.size);
+        insert.bindValue(4, record.modified);
+        if (!insert.exec()) {
+            m_lastError = QString("写入files表失败: %1").arg(insert.lastError().text());
+            return finishLoad(false);
+        }
+        ++m_exportedFiles;
+        bytes += record.size;
+        if (bulkLoad && m_exportedFiles % m_batchSize == 0 && (!db.commit() || !db.transaction())) {
+            m_lastError = QString("提交事务失败: %1").arg(db.lastError().text());
+            return finishLoad(false);
+        }
+    }
+    return finishLoad(true);
+}
+
+/**
+ * @brief 添加一条传输记录
+ * @param record 传输记录
+ * @return 操作是否成功
+ */
+bool SqliteExport::addTransfer(const TransferRecord &record)
+{
+    if (!isOpen()) {
+        m_lastError = "数据库未打开";
+        return false;
+    }
+    m_pending.append(record);
+    if (m_pending.size() >= m_batchSize) {
+        return flush();
+    }
+    return true;
+}
+
+/**
+ * @brief 写出缓冲的传输记录
+ * @return 操作是否成功
+ */
+bool SqliteExport::flush()
+{
+    if (!isOpen() || m_pending.isEmpty()) {
+        return true;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName, false);
+    if (!db.transaction()) {
+        m_lastError = QString("开始事务失败: %1").arg(db.lastError().text());
+        return false;
+    }
+    {
+        QSqlQuery insert(db);
+        insert.prepare("INSERT INTO transfers (started, server, remote_path, local_path, bytes, duration_ms, "
+                       "batch_size, success, error, direction) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
+        for (const TransferRecord &record : m_pending) {
+            insert.bindValue(0, record.started);
+            insert.bindValue(1, record.server);
+            insert.bindValue(2, record.remotePath);
+            insert.bindValue(3, record.localPath);
+            insert.bindValue(4, record.bytes);
+            insert.bindValue(5, record.durationMs);
+            insert.bindValue(6, record.batchSize);
+            insert.bindValue(7, record.success ? 1 : 0);
+            insert.bindValue(8, record.error);
+            insert.bindValue(9, record.upload ? QString("up") : QString("down"));
+            if (!insert.exec()) {
+                m_lastError = QString("写入transfers表失败: %1").arg(insert.lastError().text());
+                db.rollback();
+                return false;
+            }
+        }
+    }
+    if (!db.commit()) {
+        m_lastError = QString("提交事务失败: %1").arg(db.lastError().text());
+        return false;
+    }
+    m_pending.clear();
+    return true;
+}
+
+/**
+ * @brief 执行一条不返回结果的SQL语句
+ * @param sql SQL语句
+ * @return 操作是否成功
+ */
+bool SqliteExport::exec(const QString &sql)
+{
+    QSqlQuery query(QSqlDatabase::database(m_connectionName, false));
+    if (!query.exec(sql)) {
+        m_lastError = QString("执行SQL失败: %1: %2").arg(sql, query.lastError().text());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief 创建files表上的查询索引
+ * @return 操作是否成功
+ */
+bool SqliteExport::createFileIndexes()
+{
+    return exec("CREATE INDEX IF NOT EXISTS files_dir ON files(crawl, dir)")
+        && exec("CREATE INDEX IF NOT EXISTS files_size ON files(crawl, size)")
+        && exec("CREATE INDEX IF NOT EXISTS files_modified ON files(crawl, modified)");
+}
+
+/**
+ * @brief 给旧版本创建的transfers表补上direction列
+ * @return 操作是否成功
+ */
+bool SqliteExport::addDirectionColumn()
+{
+    QSqlQuery columns(QSqlDatabase::database(m_connectionName, false));
+    if (!columns.exec("PRAGMA table_info(transfers)")) {
+        m_lastError = QString("读取transfers表结构失败: %1").arg(columns.lastError().text());
+        return false;
+    }
+    while (columns.next()) {
+        if (columns.value(1).toString() == "direction") {
+            return true;
+        }
+    }
+    return exec("ALTER TABLE transfers ADD COLUMN direction TEXT DEFAULT 'down'");
+}
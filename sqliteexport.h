@@ -0,0 +1,145 @@
+/**
+ * @file sqliteexport.h
+ * @brief 远程索引和传输历史的SQLite导出
+ * @details 把RemoteIndex生成的索引文件和每次传输的记录写入SQLite数据库，
+ *          以便直接用SQL做临时查询，例如：
+ *
+ *     -- 本月修改过的文件最多的目录（按大小）
+ *     SELECT dir, SUM(size) FROM files WHERE crawl = 1
+ *         AND modified >= strftime('%s', 'now', 'start of month') GROUP BY dir ORDER BY 2 DESC LIMIT 20;
+ *     -- 昨晚最慢的下载
+ *     SELECT remote_path, bytes * 1000.0 / duration_ms AS rate FROM transfers
+ *         WHERE started >= (strftime('%s', 'now', '-1 day') * 1000) AND success AND direction = 'down'
+ *         ORDER BY rate LIMIT 20;
+ *
+ * 写入以事务分批进行，每批数万行只提交一次；files表为空时导入前删除其上的索引、导入后重建，
+ * 避免逐行维护B树，百万行的导出只需数秒。已有数据时重建索引要重新排序所有历史行，
+ * 代价随数据库增长，此时保留索引，整次导入在一个事务中完成
+ */
+
+#ifndef SQLITEEXPORT_H
+#define SQLITEEXPORT_H
+
+#include <QString>
+#include <QList>
+#include "ftpclient.h"
+
+/**
+ * @class SqliteExport
+ * @brief SQLite导出器
+ *
+ * 数据库包含三张表：
+ * - crawls(id, server, root, created, files, bytes)：每次导入的索引一行，created为UTC秒数
+ * - files(crawl, path, dir, size, modified)：索引中的文件，dir为所在目录（以/结尾），modified为UTC秒数，未知时为-1
+ * - transfers(started, server, remote_path, local_path, bytes, duration_ms, batch_size, success, error, direction)：
+ *   传输记录，started为UTC毫秒数，direction为"down"或"up"，统计下载吞吐时应只取"down"
+ *
+ * 使用创建它的线程中的数据库连接，只能在该线程中调用
+ */
+class SqliteExport
+{
+public:
+    /**
+     * @brief 构造函数
+     */
+    SqliteExport();
+
+    /**
+     * @brief 析构函数，写出缓冲的传输记录并关闭数据库
+     */
+    ~SqliteExport();
+
+    /**
+     * @brief 打开（必要时创建）数据库
+     * @param databasePath 数据库文件路径
+     * @return 操作是否成功
+     */
+    bool open(const QString &databasePath);
+
+    /**
+     * @brief 写出缓冲的传输记录并关闭数据库
+     */
+    void close();
+
+    /**
+     * @brief 数据库是否已打开
+     */
+    bool isOpen() const { return !m_databasePath.isEmpty(); }
+
+    /**
+     * @brief 数据库文件路径，未打开时为空
+     */
+    QString databasePath() const { return m_databasePath; }
+
+    /**
+     * @brief 设置每个事务写入的行数
+     * @param rows 行数；传输记录也在缓冲达到该数量时写出
+     */
+    void setBatchSize(int rows) { m_batchSize = qMax(1, rows); }
+
+    /**
+     * @brief 导入索引文件
+     * @param indexPath RemoteIndex生成的索引文件
+     * @param server 服务器标识
+     * @param root 扫描的远程根目录
+     * @param crawlId 输出本次导入在crawls表中的id，可以为nullptr
+     * @return 操作是否成功；files表为空时失败后已写入的部分保留，crawls表中的文件数为实际写入数；
+     *         已有数据时整次导入在一个事务中，失败时回滚，crawls表中的文件数为0
+     */
+    bool exportIndex(const QString &indexPath, const QString &server, const QString &root, qint64 *crawlId = nullptr);
+
+    /**
+     * @brief 添加一条传输记录
+     * @param record 传输记录
+     * @return 操作是否成功
+     *
+     * 记录先缓冲在内存中，达到批大小或调用flush()时在一个事务中写出
+     */
+    bool addTransfer(const TransferRecord &record);
+
+    /**
+     * @brief 写出缓冲的传输记录
+     * @return 操作是否成功
+     */
+    bool flush();
+
+    /**
+     * @brief 最近一次导入索引写入的文件数
+     */
+    qint64 exportedFiles() const { return m_exportedFiles; }
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    /**
+     * @brief 执行一条不返回结果的SQL语句
+     * @param sql SQL语句
+     * @return 操作是否成功
+     */
+    bool exec(const QString &sql);
+
+    /**
+     * @brief 创建files表上的查询索引
+     * @return 操作是否成功
+     */
+    bool createFileIndexes();
+
+    /**
+     * @brief 给旧版本创建的transfers表补上direction列，已有的行视为下载
+     * @return 操作是否成功
+     */
+    bool addDirectionColumn();
+
+private:
+    QString m_connectionName;             ///< Qt数据库连接名，每个对象唯一
+    QString m_databasePath;               ///< 数据库文件路径
+    int m_batchSize;                      ///< 每个事务写入的行数
+    QList<TransferRecord> m_pending;      ///< 尚未写出的传输记录
+    qint64 m_exportedFiles;               ///< 最近一次导入的文件数
+    QString m_lastError;                  ///< 最后一个错误信息
+};
+
+#endif // SQLITEEXPORT_H
@@ -0,0 +1,92 @@
+/**
+ * @file startupprofile.cpp
+ * @brief 冷启动各阶段计时实现文件
+ */
+
+#include "startupprofile.h"
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QStringList>
+
+namespace {
+
+QElapsedTimer g_timer;                          // 从start()开始计时
+QList<QPair<QString, qint64>> g_phases;         // 阶段名称和结束时间（纳秒）
+qint64 g_firstPaintNs = -1;                     // 首次显示的时间（纳秒）
+
+} // namespace
+
+/**
+ * @brief 开始计时
+ */
+void StartupProfile::start()
+{
+    g_phases.clear();
+    g_firstPaintNs = -1;
+    g_timer.start();
+}
+
+/**
+ * @brief 记录一个阶段结束
+ * @param phase 阶段名称
+ */
+void StartupProfile::mark(const QString &phase)
+{
+    if (g_timer.isValid()) {
+        g_phases.append(qMakePair(phase, g_timer.nsecsElapsed()));
+    }
+}
+
+/**
+ * @brief 记录窗口首次显示
+ */
+void StartupProfile::markFirstPaint()
+{
+    if (g_timer.isValid() && g_firstPaintNs < 0) {
+        g_firstPaintNs = g_timer.nsecsElapsed();
+        g_phases.append(qMakePair(QString("首次显示"), g_firstPaintNs));
+    }
+}
+
+/**
+ * @brief 从start()到现在的毫秒数
+ */
+qint64 StartupProfile::elapsed()
+{
+    return g_timer.isValid() ? g_timer.elapsed() : 0;
+}
+
+/**
+ * @brief 从start()到首次显示的毫秒数
+ */
+qint64 StartupProfile::firstPaint()
+{
+    return g_firstPaintNs < 0 ? -1 : g_firstPaintNs / 1000000;
+}
+
+/**
+ * @brief 汇总各阶段耗时
+ * @return 每个阶段一行的表格
+ */
+QString StartupProfile::report()
+{
+    if (!g_timer.isValid()) {
+        return QString("未记录启动计时");
+    }
+
+    QStringList lines;
+    lines << QString("%1 %2 %3").arg("阶段", -16).arg("耗时ms", 10).arg("累计ms", 10);
+    qint64 previous = 0;
+    for (const QPair<QString, qint64> &phase : g_phases) {
+        lines << QString("%1 %2 %3").arg(phase.first, -16)
+                 .arg((phase.second - previous) / 1e6, 10, 'f', 1)
+                 .arg(phase.second / 1e6, 10, 'f', 1);
+        previous = phase.second;
+    }
+    if (g_firstPaintNs >= 0) {
+        lines << QString("首次显示 %1 ms，全部完成 %2 ms")
+                 .arg(g_firstPaintNs / 1e6, 0, 'f', 1).arg(previous / 1e6, 0, 'f', 1);
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,57 @@
+/**
+ * @file startupprofile.h
+ * @brief 冷启动各阶段计时
+ * @details 记录从进程进入main()到窗口可用的各阶段耗时（Qt初始化、界面创建、
+ *          加载上次会话、curl/TLS初始化、加载缓存和索引等），回答"窗口为什么出来得慢"。
+ *
+ * 计时从start()开始，各阶段在结束时调用mark()，耗时为与上一个标记之间的时间；
+ * report()输出每个阶段一行以及到首次显示的总耗时
+ */
+
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @class StartupProfile
+ * @brief 启动阶段计时的记录与汇总，只在主线程使用
+ */
+class StartupProfile
+{
+public:
+    /**
+     * @brief 开始计时，应在main()的第一行调用
+     */
+    static void start();
+
+    /**
+     * @brief 记录一个阶段结束
+     * @param phase 阶段名称
+     */
+    static void mark(const QString &phase);
+
+    /**
+     * @brief 记录窗口首次显示，之后的阶段不计入首次显示耗时
+     */
+    static void markFirstPaint();
+
+    /**
+     * @brief 从start()到现在的毫秒数
+     */
+    static qint64 elapsed();
+
+    /**
+     * @brief 从start()到首次显示的毫秒数，尚未显示时为-1
+     */
+    static qint64 firstPaint();
+
+    /**
+     * @brief 汇总各阶段耗时
+     * @return 每个阶段一行的表格
+     */
+    static QString report();
+};
+
+#endif // STARTUPPROFILE_H
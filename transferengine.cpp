@@ -0,0 +1,280 @@
+/**
+ * @file transferengine.cpp
+ * @brief 按核心分片的传输引擎实现文件
+ */
+
+#include "transferengine.h"
+#include <QThread>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// 空闲分片先让出CPU若干次，再以逐渐加长的间隔休眠，最长1毫秒
+static const int IDLE_SPINS = 64;
+static const unsigned long MAX_IDLE_SLEEP_US = 1000;
+
+/**
+ * @brief 构造函数
+ * @param shards 分片数，0表示使用CPU核心数
+ * @param queueCapacity 每个分片任务队列的容量
+ */
+TransferEngine::TransferEngine(int shards, int queueCapacity)
+    : m_port(21)
+    , m_maxConnections(0)
+    , m_batchSize(64)
+    , m_nextShard(0)
+    , m_pending(0)
+    , m_running(false)
+    , m_stopping(false)
+{
+    int count = shards > 0 ? shards : qMax(1, QThread::idealThreadCount());
+    for (int i = 0; i < count; ++i) {
+        m_shards.emplace_back(new Shard(static_cast<size_t>(qMax(2, queueCapacity))));
+    }
+}
+
+/**
+ * @brief 析构函数，处理完已提交的任务后停止所有分片
+ */
+TransferEngine::~TransferEngine()
+{
+    stop();
+}
+
+/**
+ * @brief 设置服务器和登录信息
+ * @param server 服务器地址
+ * @param port 端口号
+ * @param username 用户名
+ * @param password 密码
+ */
+void TransferEngine::setServer(const QString &server, int port, const QString &username, const QString &password)
+{
+    m_server = server;
+    m_port = port;
+    m_username = username;
+    m_password = password;
+}
+
+/**
+ * @brief 为每个分片建立连接并启动分片线程
+ * @return 操作是否成功
+ */
+bool TransferEngine::start()
+{
+    if (m_running) {
+        return true;
+    }
+
+    int perShard = m_maxConnections > 0 ? qMax(1, m_maxConnections / shardCount()) : 0;
+    for (const std::unique_ptr<Shard> &shard : m_shards) {
+        std::unique_ptr<FtpClient> client(new FtpClient());
+        if (m_configure) {
+            m_configure(client.get());
+        }
+        client->setMaxHostConnections(perShard);
+        // 块模式会话是每个客户端额外的一条控制连接，不受连接上限约束，分片走多路句柄
+        client->setBlockModeEnabled(false);
+        if (!client->connect(m_server, m_port, m_username, m_password)) {
+            m_lastError = client->lastError();
+            for (const std::unique_ptr<Shard> &connected : m_shards) {
+                connected->client.reset();
+            }
+            return false;
+        }
+        shard->client = std::move(client);
+    }
+
+    m_stopping = false;
+    m_running = true;
+    for (int i = 0; i < shardCount(); ++i) {
+        m_shards[i]->thread = QThread::create([this, i]() { runShard(i); });
+        m_shards[i]->thread->start();
+    }
+    return true;
+}
+
+/**
+ * @brief 提交下载任务
+ * @param task 下载任务
+ * @return 引擎未启动时返回false
+ */
+bool TransferEngine::submit(const DownloadTask &task)
+{
+    if (!m_running || m_stopping) {
+        m_lastError = "传输引擎未启动";
+        return false;
+    }
+
+    // 先计入未完成数，保证任务被取走时计数不会先减到负数
+    m_pending.fetch_add(1, std::memory_order_relaxed);
+    DownloadTask item = task;
+    size_t count = m_shards.size();
+    for (;;) {
+        size_t first = m_nextShard.fetch_add(1, std::memory_order_relaxed);
+        for (size_t i = 0; i < count; ++i) {
+            if (m_shards[(first + i) % count]->queue.tryPush(item)) {
+                return true;
+            }
+        }
+        QThread::yieldCurrentThread();
+    }
+}
+
+/**
+ * @brief 等待所有已提交的任务完成
+ */
+void TransferEngine::finish()
+{
+    QMutexLocker locker(&m_drainMutex);
+    while (m_pending.load(std::memory_order_acquire) > 0) {
+        m_drained.wait(&m_drainMutex, 100);
+    }
+}
+
+/**
+ * @brief 处理完已提交的任务后停止所有分片并断开连接
+ */
+void TransferEngine::stop()
+{
+    if (!m_running) {
+        return;
+    }
+    finish();
+    m_stopping = true;
+    for (const std::unique_ptr<Shard> &shard : m_shards) {
+        shard->thread->wait();
+        delete shard->thread;
+        shard->thread = nullptr;
+        shard->client.reset();
+    }
+    m_running = false;
+}
+
+/**
+ * @brief 汇总各分片的统计
+ * @return 统计
+ */
+TransferEngineStats TransferEngine::stats() const
+{
+    TransferEngineStats stats;
+    for (const std::unique_ptr<Shard> &shard : m_shards) {
+        qint64 files = shard->files.load(std::memory_order_relaxed);
+        qint64 failures = shard->failures.load(std::memory_order_relaxed);
+        stats.files += files;
+        stats.failures += failures;
+        stats.bytes += shard->bytes.load(std::memory_order_relaxed);
+        stats.steals += shard->steals.load(std::memory_order_relaxed);
+        stats.filesPerShard.append(files + failures);
+    }
+    return stats;
+}
+
+/**
+ * @brief 分片线程主循环
+ * @param index 分片序号
+ */
+void TransferEngine::runShard(int index)
+{
+#ifdef Q_OS_LINUX
+    // 每个分片固定在一个核心上，连接、CURL句柄和缓冲区始终留在同一个核心的缓存中
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(index % qMax(1, QThread::idealThreadCount()), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#endif
+
+    Shard *shard = m_shards[index].get();
+    FtpClient *client = shard->client.get();
+    QList<DownloadTask> batch;
+    int idleRounds = 0;
+
+    for (;;) {
+        batch.clear();
+        DownloadTask task;
+        while (batch.size() < m_batchSize && shard->queue.tryPop(&task)) {
+            batch.append(task);
+        }
+        if (batch.isEmpty()) {
+            // 只窃取半批，给被窃取的分片留下自己的工作
+            steal(index, &batch, qMax(1, m_batchSize / 2));
+        }
+
+        if (batch.isEmpty()) {
+            if (m_stopping && m_pending.load(std::memory_order_acquire) == 0) {
+                break;
+            }
+            if (++idleRounds <= IDLE_SPINS) {
+                QThread::yieldCurrentThread();
+            } else {
+                QThread::usleep(qMin<unsigned long>(MAX_IDLE_SLEEP_US, 10UL << qMin(idleRounds - IDLE_SPINS, 7)));
+            }
+            continue;
+        }
+        idleRounds = 0;
+
+        QStringList failedFiles;
+        if (batch.size() == 1) {
+            if (!client->downloadFile(batch.first().remotePath, batch.first().localPath)) {
+                failedFiles.append(batch.first().remotePath);
+            }
+        } else {
+            client->downloadFiles(batch, nullptr, &failedFiles);
+        }
+
+        for (const DownloadTask &done : batch) {
+            TransferResult result;
+            result.task = done;
+            result.shard = index;
+            result.success = !failedFiles.contains(done.remotePath);
+            if (result.success) {
+                shard->files.fetch_add(1, std::memory_order_relaxed);
+                shard->bytes.fetch_add(done.fileSize > 0 ? done.fileSize : QFileInfo(done.localPath).size(),
+                                       std::memory_order_relaxed);
+            } else {
+                shard->failures.fetch_add(1, std::memory_order_relaxed);
+                result.error = client->lastError();
+            }
+            if (m_completion) {
+                m_completion(result);
+            }
+        }
+        complete(batch.size());
+    }
+}
+
+/**
+ * @brief 从其他分片窃取任务
+ * @param index 窃取方分片序号
+ * @param batch 输出任务
+ * @param limit 最多窃取的任务数
+ */
+void TransferEngine::steal(int index, QList<DownloadTask> *batch, int limit)
+{
+    int count = shardCount();
+    DownloadTask task;
+    for (int offset = 1; offset < count && batch->size() < limit; ++offset) {
+        Shard *victim = m_shards[(index + offset) % count].get();
+        while (batch->size() < limit && victim->queue.tryPop(&task)) {
+            batch->append(task);
+        }
+    }
+    if (!batch->isEmpty()) {
+        m_shards[index]->steals.fetch_add(batch->size(), std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief 记录一批任务完成
+ * @param count 完成的任务数
+ */
+void TransferEngine::complete(qint64 count)
+{
+    if (m_pending.fetch_sub(count, std::memory_order_acq_rel) == count) {
+        QMutexLocker locker(&m_drainMutex);
+        m_drained.wakeAll();
+    }
+}
@@ -0,0 +1,210 @@
+/**
+ * @file transferengine.h
+ * @brief 按核心分片的传输引擎
+ * @details 主窗口的下载队列由单个互斥锁保护、由一个线程逐个取出任务，
+ *          文件很多时取任务和调度本身成为瓶颈，吞吐量不随核心数增长。
+ *
+ * 引擎为每个核心建立一个分片，分片之间不共享可变状态：
+ * 1. 每个分片一个线程（Linux上绑定到对应核心）和一个FtpClient，
+ *    批量下载使用该客户端自己的CURL多路句柄和连接（不使用块模式），连接上限在分片之间平分
+ * 2. 每个分片一个无锁MPMC任务队列，提交时轮流投递，队列满时转投下一个分片
+ * 3. 分片自己的队列为空时从其他分片的队列中窃取任务
+ * 4. 统计计数按分片存放在各自的缓存行中，读取时再汇总
+ */
+
+#ifndef TRANSFERENGINE_H
+#define TRANSFERENGINE_H
+
+#include <QString>
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "ftpclient.h"
+#include "mpmcqueue.h"
+
+class QThread;
+
+/**
+ * @struct TransferResult
+ * @brief 单个任务的完成结果
+ */
+struct TransferResult {
+    DownloadTask task;       ///< 下载任务
+    bool success = false;    ///< 是否下载成功
+    QString error;           ///< 失败原因
+    int shard = -1;          ///< 执行该任务的分片
+};
+
+/**
+ * @struct TransferEngineStats
+ * @brief 引擎累计统计
+ */
+struct TransferEngineStats {
+    qint64 files = 0;              ///< 成功下载的文件数
+    qint64 failures = 0;           ///< 失败的文件数
+    qint64 bytes = 0;              ///< 成功下载的字节数
+    qint64 steals = 0;             ///< 从其他分片窃取的任务数
+    QList<qint64> filesPerShard;   ///< 每个分片完成（含失败）的文件数
+};
+
+/**
+ * @class TransferEngine
+ * @brief 按核心分片、无锁分发任务的下载引擎
+ *
+ * 用法：setServer() → start() → 多次submit() → finish()；
+ * submit()可以从任意线程调用，完成回调在分片线程中执行
+ */
+class TransferEngine
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param shards 分片数，0表示使用CPU核心数
+     * @param queueCapacity 每个分片任务队列的容量
+     */
+    explicit TransferEngine(int shards = 0, int queueCapacity = 4096);
+
+    /**
+     * @brief 析构函数，处理完已提交的任务后停止所有分片
+     */
+    ~TransferEngine();
+
+    /**
+     * @brief 设置服务器和登录信息
+     * @param server 服务器地址
+     * @param port 端口号
+     * @param username 用户名
+     * @param password 密码
+     */
+    void setServer(const QString &server, int port, const QString &username, const QString &password);
+
+    /**
+     * @brief 设置分片客户端的初始化函数
+     * @param configure 在连接之前对每个分片的FtpClient调用（如启用TLS、设置模拟链路）
+     */
+    void setConfigurator(std::function<void(FtpClient *)> configure) { m_configure = configure; }
+
+    /**
+     * @brief 设置所有分片合计的最大连接数
+     * @param count 连接数，在分片之间平分，每个分片至少1个；0（默认）表示每个分片使用客户端的默认上限
+     */
+    void setMaxConnections(int count) { m_maxConnections = qMax(0, count); }
+
+    /**
+     * @brief 设置每批最多交给多路句柄的任务数
+     * @param count 任务数
+     */
+    void setBatchSize(int count) { m_batchSize = qMax(1, count); }
+
+    /**
+     * @brief 设置任务完成回调
+     * @param handler 每个任务完成后在分片线程中调用，需要线程安全
+     */
+    void setCompletionHandler(std::function<void(const TransferResult &)> handler) { m_completion = handler; }
+
+    /**
+     * @brief 分片数
+     */
+    int shardCount() const { return static_cast<int>(m_shards.size()); }
+
+    /**
+     * @brief 为每个分片建立连接并启动分片线程
+     * @return 操作是否成功；任一分片无法连接时不启动任何线程
+     */
+    bool start();
+
+    /**
+     * @brief 提交下载任务
+     * @param task 下载任务（文件）
+     * @return 引擎未启动时返回false
+     *
+     * 所有分片队列都已满时让出CPU并重试，形成对提交方的背压
+     */
+    bool submit(const DownloadTask &task);
+
+    /**
+     * @brief 等待所有已提交的任务完成
+     */
+    void finish();
+
+    /**
+     * @brief 处理完已提交的任务后停止所有分片并断开连接
+     */
+    void stop();
+
+    /**
+     * @brief 尚未完成的任务数
+     */
+    qint64 pending() const { return m_pending.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 汇总各分片的统计
+     */
+    TransferEngineStats stats() const;
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const { return m_lastError; }
+
+private:
+    /**
+     * @struct Shard
+     * @brief 分片：线程、客户端、任务队列和统计
+     */
+    struct Shard {
+        explicit Shard(size_t capacity) : queue(capacity) {}
+
+        MpmcQueue<DownloadTask> queue;          ///< 任务队列
+        std::unique_ptr<FtpClient> client;      ///< 本分片的客户端
+        QThread *thread = nullptr;              ///< 分片线程
+        alignas(64) std::atomic<qint64> files{0};  ///< 成功下载的文件数
+        std::atomic<qint64> failures{0};        ///< 失败的文件数
+        std::atomic<qint64> bytes{0};           ///< 成功下载的字节数
+        std::atomic<qint64> steals{0};          ///< 窃取的任务数
+    };
+
+    /**
+     * @brief 分片线程主循环
+     * @param index 分片序号
+     */
+    void runShard(int index);
+
+    /**
+     * @brief 从其他分片窃取任务
+     * @param index 窃取方分片序号
+     * @param batch 输出任务
+     * @param limit 最多窃取的任务数
+     */
+    void steal(int index, QList<DownloadTask> *batch, int limit);
+
+    /**
+     * @brief 记录一批任务完成
+     * @param count 完成的任务数
+     */
+    void complete(qint64 count);
+
+private:
+    std::vector<std::unique_ptr<Shard>> m_shards; ///< 分片
+    QString m_server;                          ///< 服务器地址
+    int m_port;                                ///< 端口号
+    QString m_username;                        ///< 用户名
+    QString m_password;                        ///< 密码
+    std::function<void(FtpClient *)> m_configure; ///< 分片客户端的初始化函数
+    std::function<void(const TransferResult &)> m_completion; ///< 任务完成回调
+    int m_maxConnections;                      ///< 合计最大连接数，0表示默认
+    int m_batchSize;                           ///< 每批最多的任务数
+    alignas(64) std::atomic<size_t> m_nextShard; ///< 下一个投递目标
+    alignas(64) std::atomic<qint64> m_pending; ///< 尚未完成的任务数
+    std::atomic<bool> m_running;               ///< 分片线程是否在运行
+    std::atomic<bool> m_stopping;              ///< 队列排空后退出
+    QMutex m_drainMutex;                       ///< 配合m_drained使用，只在等待完成时加锁
+    QWaitCondition m_drained;                  ///< 所有任务完成时唤醒finish()
+    QString m_lastError;                       ///< 最后一个错误信息
+};
+
+#endif // TRANSFERENGINE_H
@@ -0,0 +1,293 @@
+/**
+ * @file transferledger.cpp
+ * @brief 传输台账实现文件
+ */
+
+#include "transferledger.h"
+#include "hashcache.h"
+#include <QDateTime>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimeZone>
+
+/**
+ * @brief 构造函数，启动写入线程
+ * @param directory 台账目录
+ * @param capacity 队列容量
+ */
+TransferLedger::TransferLedger(const QString &directory, int capacity)
+    : m_directory(directory)
+    , m_capacity(qMax(1, capacity))
+    , m_writing(false)
+    , m_stopping(false)
+    , m_written(0)
+    , m_dropped(0)
+    , m_hashCache(nullptr)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start(QThread::LowPriority);
+}
+
+/**
+ * @brief 析构函数，写完队列中的记录后停止写入线程
+ */
+TransferLedger::~TransferLedger()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_notEmpty.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+/**
+ * @brief 设置本地文件摘要缓存
+ * @param cache 缓存
+ */
+void TransferLedger::setHashCache(HashCache *cache)
+{
+    QMutexLocker locker(&m_mutex);
+    m_hashCache = cache;
+}
+
+/**
+ * @brief 是否计算摘要
+ */
+bool TransferLedger::hashing() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_hashCache != nullptr;
+}
+
+/**
+ * @brief 追加一条记录
+ * @param record 传输记录
+ */
+void TransferLedger::append(const TransferRecord &record)
+{
+    // 调用方是界面线程，等待写盘会让界面卡住；台账缺几行比界面停顿好
+    QMutexLocker locker(&m_mutex);
+    if (m_queue.size() >= m_capacity) {
+        ++m_dropped;
+        return;
+    }
+    m_queue.enqueue(record);
+    m_notEmpty.wakeOne();
+}
+
+/**
+ * @brief 等待此前追加的记录全部写入文件
+ * @return 写入过程中没有出错时返回true
+ */
+bool TransferLedger::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.isEmpty() || m_writing) {
+        m_drained.wait(&m_mutex);
+    }
+    return m_lastError.isEmpty();
+}
+
+/**
+ * @brief 已写入的记录数
+ */
+qint64 TransferLedger::written() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_written;
+}
+
+/**
+ * @brief 取出自上次调用以来丢弃的记录数，并清零
+ */
+qint64 TransferLedger::takeDropped()
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 dropped = m_dropped;
+    m_dropped = 0;
+    return dropped;
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString TransferLedger::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief 某一天的台账文件名
+ * @param date UTC日期
+ * @return 文件名
+ */
+QString TransferLedger::fileName(const QDate &date)
+{
+    return QString("transfers-%1.jsonl").arg(date.toString("yyyy-MM-dd"));
+}
+
+/**
+ * @brief 把记录格式化为一行JSON
+ * @param record 传输记录
+ * @return 以换行结尾的JSON行
+ */
+QByteArray TransferLedger::toJson(const TransferRecord &record)
+{
+    QJsonObject object;
+    object.insert("ts", record.started);
+    object.insert("server", record.server);
+    object.insert("remote", record.remotePath);
+    object.insert("local", record.localPath);
+    object.insert("bytes", record.bytes);
+    object.insert("duration_ms", record.durationMs);
+    object.insert("batch", record.batchSize);
+    object.insert("ok", record.success);
+    object.insert("code", record.resultCode);
+    object.insert("retries", record.retries);
+    object.insert("conn", record.connectionId);
+    object.insert("dns_us", record.nameLookupUs);
+    object.insert("connect_us", record.connectUs);
+    object.insert("tls_us", record.tlsUs);
+    object.insert("ttfb_us", record.firstByteUs);
+    if (!record.error.isEmpty()) {
+        object.insert("error", record.error);
+    }
+    if (!record.hash.isEmpty()) {
+        object.insert("hash", record.hash);
+    }
+    if (record.upload) {
+        object.insert("dir", QString("up"));
+    }
+    QByteArray line = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    line += '\n';
+    return line;
+}
+
+/**
+ * @brief 解析一行JSON
+ * @param line JSON行
+ * @param record 输出记录
+ * @return 格式正确时返回true
+ */
+bool TransferLedger::fromJson(const QByteArray &line, TransferRecord *record)
+{
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        return false;
+    }
+    QJsonObject object = document.object();
+    if (!object.contains("ts") || !object.contains("remote")) {
+        return false;
+    }
+
+    *record = TransferRecord();
+    record->started = object.value("ts").toInteger();
+    record->server = object.value("server").toString();
+    record->remotePath = object.value("remote").toString();
+    record->localPath = object.value("local").toString();
+    record->bytes = object.value("bytes").toInteger();
+    record->durationMs = object.value("duration_ms").toInteger();
+    record->batchSize = object.value("batch").toInt(1);
+    record->success = object.value("ok").toBool();
+    record->resultCode = object.value("code").toInt();
+    record->retries = object.value("retries").toInt();
+    record->connectionId = object.value("conn").toInteger(-1);
+    record->nameLookupUs = object.value("dns_us").toInteger(-1);
+    record->connectUs = object.value("connect_us").toInteger(-1);
+    record->tlsUs = object.value("tls_us").toInteger(-1);
+    record->firstByteUs = object.value("ttfb_us").toInteger(-1);
+    record->error = object.value("error").toString();
+    record->hash = object.value("hash").toString();
+    record->upload = object.value("dir").toString() == "up";
+    return true;
+}
+
+/**
+ * @brief 写入线程主循环
+ */
+void TransferLedger::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_queue.isEmpty() && !m_stopping) {
+            m_notEmpty.wait(&m_mutex);
+        }
+        if (m_queue.isEmpty()) {
+            break;
+        }
+
+        // 一次取走整个队列，写文件和计算摘要时不持有锁
+        QList<TransferRecord> records;
+        records.reserve(m_queue.size());
+        while (!m_queue.isEmpty()) {
+            records.append(m_queue.dequeue());
+        }
+        m_writing = true;
+        locker.unlock();
+
+        int written = writeRecords(records);
+
+        locker.relock();
+        m_writing = false;
+        if (written < records.size()) {
+            m_lastError = QString("写入传输台账失败: %1").arg(m_file.errorString());
+        }
+        m_written += written;
+        if (m_queue.isEmpty()) {
+            m_drained.wakeAll();
+        }
+    }
+    m_file.close();
+    m_drained.wakeAll();
+}
+
+/**
+ * @brief 把一批记录写入对应日期的文件
+ * @param records 记录
+ * @return 成功写入的记录数
+ */
+int TransferLedger::writeRecords(QList<TransferRecord> &records)
+{
+    HashCache *hashCache;
+    {
+        QMutexLocker locker(&m_mutex);
+        hashCache = m_hashCache;
+    }
+
+    int written = 0;
+    for (TransferRecord &record : records) {
+        if (hashCache && record.success && !record.upload && record.hash.isEmpty()
+            && !record.localPath.isEmpty()) {
+            QByteArray digest = hashCache->digest(record.localPath);
+            if (!digest.isEmpty()) {
+                record.hash = "sha-256:" + QString::fromLatin1(digest);
+            }
+        }
+
+        // 按记录的UTC日期换文件，跨午夜的运行自然分到两天
+        QDate date = QDateTime::fromMSecsSinceEpoch(record.started, QTimeZone::UTC).date();
+        if (!m_file.isOpen() || date != m_fileDate) {
+            if (m_file.isOpen()) {
+                m_file.close();
+            }
+            QDir().mkpath(m_directory);
+            m_file.setFileName(QDir(m_directory).filePath(fileName(date)));
+            if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+                continue;
+            }
+            m_fileDate = date;
+        }
+        if (m_file.write(toJson(record)) >= 0) {
+            ++written;
+        }
+    }
+    if (m_file.isOpen() && !m_file.flush()) {
+        return 0;
+    }
+    return written;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file transferledger.h
+ * @brief 传输台账
+ * @details 日志窗口中的文本会被清空，也不便于统计。台账为每次传输尝试追加一行JSON（JSONL），
+ *          包含路径、字节数、耗时、libcurl各阶段计时、连接编号、重试次数、结果码和摘要，
+ *          按UTC日期分文件保存，可用ledgertool或任何JSON工具离线分析多日的吞吐分布
+ *
+ * 写入在独立线程中进行：append()只把记录放入有界队列，从不阻塞调用方（通常是界面线程）；
+ * 磁盘跟不上、队列满时丢弃新记录并计数，内存占用有上限，缺口由takeDropped()报告
+ */
+
+#ifndef TRANSFERLEDGER_H
+#define TRANSFERLEDGER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDate>
+#include <QFile>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include "ftpclient.h"
+
+class HashCache;
+
+/**
+ * @class TransferLedger
+ * @brief 追加写入的JSONL传输台账，append()和flush()是线程安全的
+ *
+ * 每行一个JSON对象，字段为：
+ * ts（开始时间，UTC毫秒）、server、remote、local、bytes、duration_ms、batch（同批文件数）、
+ * ok、code（libcurl结果码）、retries、conn（连接编号）、dns_us、connect_us、tls_us、ttfb_us，
+ * 以及非空时才出现的error和hash；未知的计时和连接编号为-1。
+ * 上传记录另有"dir":"up"，没有dir字段的记录是下载
+ */
+class TransferLedger
+{
+public:
+    /**
+     * @brief 构造函数，启动写入线程
+     * @param directory 台账目录，文件名为transfers-YYYY-MM-DD.jsonl
+     * @param capacity 队列中最多缓冲的记录数
+     */
+    explicit TransferLedger(const QString &directory, int capacity = 4096);
+
+    /**
+     * @brief 析构函数，写完队列中的记录后停止写入线程
+     */
+    ~TransferLedger();
+
+    /**
+     * @brief 设置本地文件摘要缓存
+     * @param cache 缓存，为nullptr时不计算摘要；由调用方持有
+     *
+     * 设置后写入线程为没有摘要的成功记录计算本地文件的SHA-256。
+     * 调用方需保证append()时本地文件已经完整落盘
+     */
+    void setHashCache(HashCache *cache);
+
+    /**
+     * @brief 是否计算摘要
+     */
+    bool hashing() const;
+
+    /**
+     * @brief 追加一条记录
+     * @param record 传输记录
+     *
+     * 不阻塞；队列满时丢弃该记录，计入takeDropped()
+     */
+    void append(const TransferRecord &record);
+
+    /**
+     * @brief 等待此前追加的记录全部写入文件
+     * @return 写入过程中没有出错时返回true，否则原因见lastError()
+     */
+    bool flush();
+
+    /**
+     * @brief 台账目录
+     */
+    QString directory() const { return m_directory; }
+
+    /**
+     * @brief 已写入的记录数
+     */
+    qint64 written() const;
+
+    /**
+     * @brief 取出自上次调用以来因队列满而丢弃的记录数，并清零
+     */
+    qint64 takeDropped();
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+    /**
+     * @brief 某一天的台账文件名
+     * @param date UTC日期
+     * @return 如"transfers-2024-05-01.jsonl"
+     */
+    static QString fileName(const QDate &date);
+
+    /**
+     * @brief 把记录格式化为一行JSON
+     * @param record 传输记录
+     * @return 以换行结尾的JSON行
+     */
+    static QByteArray toJson(const TransferRecord &record);
+
+    /**
+     * @brief 解析一行JSON
+     * @param line JSON行（可以带换行）
+     * @param record 输出记录，缺少的字段保持默认值
+     * @return 格式正确时返回true
+     */
+    static bool fromJson(const QByteArray &line, TransferRecord *record);
+
+private:
+    /**
+     * @brief 写入线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 把一批记录写入对应日期的文件
+     * @param records 记录，写入前补齐摘要
+     * @return 成功写入的记录数
+     */
+    int writeRecords(QList<TransferRecord> &records);
+
+private:
+    QString m_directory;                 ///< 台账目录
+    int m_capacity;                      ///< 队列容量
+    mutable QMutex m_mutex;              ///< 保护以下成员
+    QWaitCondition m_notEmpty;           ///< 有新记录或需要停止时唤醒写入线程
+    QWaitCondition m_drained;            ///< 队列写空时唤醒flush()
+    QQueue<TransferRecord> m_queue;      ///< 待写入的记录
+    bool m_writing;                      ///< 写入线程是否正在写一批记录
+    bool m_stopping;                     ///< 是否正在停止
+    qint64 m_written;                    ///< 已写入的记录数
+    qint64 m_dropped;                    ///< 因队列满而丢弃、尚未报告的记录数
+    HashCache *m_hashCache;              ///< 本地文件摘要缓存（不拥有）
+    QString m_lastError;                 ///< 最后一个错误信息
+    QFile m_file;                        ///< 当前台账文件（只由写入线程访问）
+    QDate m_fileDate;                    ///< 当前台账文件的日期（只由写入线程访问）
+    QThread *m_thread;                   ///< 写入线程
+};
+
+#endif // TRANSFERLEDGER_H
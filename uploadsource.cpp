@@ -0,0 +1,507 @@
+/**
+ * @file uploadsource.cpp
+ * @brief 流式上传数据源实现文件
+ */
+
+#include "uploadsource.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#ifdef Q_OS_UNIX
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// 每次从设备读取的上限，读取方等待时按此粒度交出部分缓冲区
+static const qint64 READ_CHUNK_SIZE = 64 * 1024;
+// 等待子进程输出或标准输入时检查是否需要停止的间隔（毫秒）
+static const int PROCESS_POLL_MS = 100;
+
+/**
+ * @brief 构造函数
+ */
+UploadSource::UploadSource()
+    : m_kind(None)
+    , m_size(-1)
+    , m_bufferSize(DefaultBufferSize)
+    , m_bytesRead(0)
+    , m_readIndex(0)
+    , m_readOffset(0)
+    , m_finished(false)
+    , m_failed(false)
+    , m_stopping(false)
+    , m_waiting(0)
+    , m_cancelled(0)
+    , m_thread(nullptr)
+{
+    m_lengths[0] = -1;
+    m_lengths[1] = -1;
+}
+
+/**
+ * @brief 析构函数，停止读取线程
+ */
+UploadSource::~UploadSource()
+{
+    close();
+}
+
+/**
+ * @brief 从本地文件读取
+ * @param path 文件路径
+ */
+void UploadSource::setFile(const QString &path)
+{
+    m_kind = File;
+    m_path = path;
+    m_size = -1;
+}
+
+/**
+ * @brief 从本进程的标准输入读取
+ */
+void UploadSource::setStandardInput()
+{
+    m_kind = StandardInput;
+    m_size = -1;
+}
+
+/**
+ * @brief 标准输入能否作为上传数据
+ * @param error 不能时输出原因
+ * @return 可以时返回true
+ */
+bool UploadSource::standardInputUsable(QString *error)
+{
+    QString reason;
+#ifdef Q_OS_UNIX
+    struct stat st;
+    if (fstat(STDIN_FILENO, &st) != 0) {
+        reason = "标准输入已关闭";
+    } else if (isatty(STDIN_FILENO)) {
+        reason = "标准输入是终端，请通过管道或重定向提供数据（如 pg_dump db | ftpclient）";
+    } else if (!S_ISFIFO(st.st_mode) && !S_ISREG(st.st_mode) && !S_ISSOCK(st.st_mode)) {
+        // 从桌面启动时标准输入通常是/dev/null，上传的会是空文件
+        reason = "标准输入没有连接到管道或文件（从桌面启动时通常为/dev/null）";
+    }
+#else
+    if (!stdin || fileno(stdin) < 0) {
+        reason = "标准输入已关闭";
+    }
+#endif
+    if (error) {
+        *error = reason;
+    }
+    return reason.isEmpty();
+}
+
+/**
+ * @brief 从子进程的标准输出读取
+ * @param program 程序
+ * @param arguments 参数
+ */
+void UploadSource::setProcess(const QString &program, const QStringList &arguments)
+{
+    m_kind = Process;
+    m_path = program;
+    m_arguments = arguments;
+    m_size = -1;
+}
+
+/**
+ * @brief 从内存数据读取
+ * @param data 数据
+ */
+void UploadSource::setData(const QByteArray &data)
+{
+    m_kind = Memory;
+    m_data = data;
+    m_size = data.size();
+}
+
+/**
+ * @brief 从生成函数读取
+ * @param producer 生成函数
+ * @param size 总大小
+ */
+void UploadSource::setProducer(Producer producer, qint64 size)
+{
+    m_kind = Generator;
+    m_producer = producer;
+    m_size = size >= 0 ? size : -1;
+}
+
+/**
+ * @brief 设置每个缓冲区的大小
+ * @param bytes 字节数
+ */
+void UploadSource::setBufferSize(qint64 bytes)
+{
+    m_bufferSize = qMax(READ_CHUNK_SIZE, bytes);
+}
+
+/**
+ * @brief 开始读取
+ * @return 操作是否成功
+ */
+bool UploadSource::open()
+{
+    close();
+    m_bytesRead.storeRelaxed(0);
+    m_lengths[0] = -1;
+    m_lengths[1] = -1;
+    m_readIndex = 0;
+    m_readOffset = 0;
+    m_finished = false;
+    m_failed = false;
+    m_stopping = false;
+    m_lastError.clear();
+
+    switch (m_kind) {
+    case None:
+        m_lastError = "未设置上传数据源";
+        return false;
+    case Memory:
+        // 内存数据直接从原数组读取，不需要读取线程
+        return true;
+    case StandardInput:
+        if (!standardInputUsable(&m_lastError)) {
+            return false;
+        }
+        break;
+    case File: {
+        QFileInfo info(m_path);
+        if (!info.isFile()) {
+            m_lastError = QString("本地文件不存在: %1").arg(m_path);
+            return false;
+        }
+        m_size = info.size();
+        break;
+    }
+    case Generator:
+        if (!m_producer) {
+            m_lastError = "未设置数据生成函数";
+            return false;
+        }
+        break;
+    default:
+        break;
+    }
+
+    m_buffers[0].resize(m_bufferSize);
+    m_buffers[1].resize(m_bufferSize);
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+    return true;
+}
+
+/**
+ * @brief 停止读取，终止子进程
+ */
+void UploadSource::close()
+{
+    if (!m_thread) {
+        return;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_consumed.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_buffers[0].clear();
+    m_buffers[1].clear();
+}
+
+/**
+ * @brief 取消读取
+ */
+void UploadSource::cancel()
+{
+    QMutexLocker locker(&m_mutex);
+    m_cancelled.storeRelaxed(1);
+    m_stopping = true;
+    m_lastError = "上传已取消";
+    m_consumed.wakeAll();
+    m_filled.wakeAll();
+}
+
+/**
+ * @brief 读取数据
+ * @param data 输出缓冲区
+ * @param maxSize 缓冲区大小
+ * @return 读取的字节数，0表示数据结束，-1表示出错
+ */
+qint64 UploadSource::read(char *data, qint64 maxSize)
+{
+    if (maxSize <= 0) {
+        return 0;
+    }
+    // 返回-1让发送方（libcurl读回调）中止传输
+    if (m_cancelled.loadRelaxed()) {
+        return -1;
+    }
+
+    if (m_kind == Memory) {
+        qint64 offset = m_bytesRead.loadRelaxed();
+        qint64 length = qMin(maxSize, m_data.size() - offset);
+        memcpy(data, m_data.constData() + offset, static_cast<size_t>(length));
+        m_bytesRead.storeRelaxed(offset + length);
+        return length;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_thread) {
+        m_lastError = "上传数据源未打开";
+        return -1;
+    }
+    // 读取线程按顺序轮流填充两个缓冲区，当前缓冲区为空时另一个也一定为空
+    while (m_lengths[m_readIndex] < 0 && !m_finished && !m_cancelled.loadRelaxed()) {
+        m_waiting.storeRelaxed(1);
+        m_filled.wait(&m_mutex);
+    }
+    m_waiting.storeRelaxed(0);
+    if (m_cancelled.loadRelaxed()) {
+        return -1;
+    }
+    if (m_lengths[m_readIndex] < 0) {
+        return m_failed ? -1 : 0;
+    }
+
+    // 已填满的缓冲区在读空之前不会被读取线程修改，复制时无需担心竞争
+    qint64 length = qMin(maxSize, m_lengths[m_readIndex] - m_readOffset);
+    memcpy(data, m_buffers[m_readIndex].constData() + m_readOffset, static_cast<size_t>(length));
+    m_readOffset += length;
+    if (m_readOffset == m_lengths[m_readIndex]) {
+        m_lengths[m_readIndex] = -1;
+        m_readIndex ^= 1;
+        m_readOffset = 0;
+        m_consumed.wakeAll();
+    }
+    m_bytesRead.fetchAndAddRelaxed(length);
+    return length;
+}
+
+/**
+ * @brief 数据源的描述
+ * @return 文件路径、命令行等
+ */
+QString UploadSource::description() const
+{
+    switch (m_kind) {
+    case File:
+        return m_path;
+    case StandardInput:
+        return "标准输入";
+    case Process:
+        return (QStringList() << m_path << m_arguments).join(' ');
+    case Memory:
+        return QString("内存数据（%1 字节）").arg(m_data.size());
+    case Generator:
+        return "生成函数";
+    default:
+        return QString();
+    }
+}
+
+/**
+ * @brief 获取最后一个错误信息
+ */
+QString UploadSource::lastError() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_lastError;
+}
+
+/**
+ * @brief 读取线程主循环
+ */
+void UploadSource::run()
+{
+    // 设备在读取线程中创建，QProcess只能在创建它的线程中使用
+    std::unique_ptr<QIODevice> device(openDevice());
+    if (!device && m_kind != Generator) {
+        return;
+    }
+
+    int index = 0;
+    for (;;) {
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_lengths[index] >= 0 && !m_stopping) {
+                m_consumed.wait(&m_mutex);
+            }
+            if (m_stopping) {
+                break;
+            }
+        }
+
+        // 空闲的缓冲区只由本线程访问，填充时不持有锁，读取方同时发送另一个缓冲区
+        char *buffer = m_buffers[index].data();
+        qint64 filled = 0;
+        qint64 result = 1;
+        QString error;
+        while (filled < m_bufferSize) {
+            result = produce(device.get(), buffer + filled, qMin(READ_CHUNK_SIZE, m_bufferSize - filled), &error);
+            if (result <= 0) {
+                break;
+            }
+            filled += result;
+            // 读取方已把另一个缓冲区发完，先交出已读到的数据，不等缓冲区填满
+            if (m_waiting.loadRelaxed()) {
+                break;
+            }
+        }
+
+        QMutexLocker locker(&m_mutex);
+        if (filled > 0) {
+            m_lengths[index] = filled;
+            index ^= 1;
+        }
+        if (result <= 0) {
+            m_finished = true;
+            if (result < 0) {
+                m_failed = true;
+                m_lastError = error;
+            }
+        }
+        m_filled.wakeAll();
+        if (result <= 0) {
+            break;
+        }
+    }
+
+    QProcess *process = qobject_cast<QProcess*>(device.get());
+    if (process && process->state() != QProcess::NotRunning) {
+        process->kill();
+        process->waitForFinished();
+    }
+}
+
+/**
+ * @brief 在读取线程中打开设备
+ * @return 打开的设备
+ */
+QIODevice *UploadSource::openDevice()
+{
+    switch (m_kind) {
+    case File: {
+        QFile *file = new QFile(m_path);
+        if (!file->open(QIODevice::ReadOnly)) {
+            fail(QString("无法打开本地文件: %1").arg(file->errorString()));
+            delete file;
+            return nullptr;
+        }
+        return file;
+    }
+    case StandardInput: {
+        // 不经过stdio缓冲，管道中有数据就返回
+        QFile *file = new QFile;
+        if (!file->open(fileno(stdin), QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+            fail(QString("无法读取标准输入: %1").arg(file->errorString()));
+            delete file;
+            return nullptr;
+        }
+        return file;
+    }
+    case Process: {
+        // 标准错误转发出去，不会因管道写满而阻塞子进程
+        QProcess *process = new QProcess;
+        process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process->start(m_path, m_arguments, QIODevice::ReadOnly);
+        if (!process->waitForStarted()) {
+            fail(QString("无法启动命令 %1: %2").arg(m_path, process->errorString()));
+            delete process;
+            return nullptr;
+        }
+        return process;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * @brief 从设备或生成函数读取一次
+ * @param device 设备，为nullptr时使用生成函数
+ * @param data 输出缓冲区
+ * @param maxSize 缓冲区大小
+ * @param error 出错时输出错误信息
+ * @return 读取的字节数，0表示数据结束，-1表示出错
+ */
+qint64 UploadSource::produce(QIODevice *device, char *data, qint64 maxSize, QString *error)
+{
+    if (!device) {
+        qint64 length = m_producer(data, maxSize);
+        if (length < 0) {
+            *error = "数据生成函数报告错误";
+        }
+        return qMin(length, maxSize);
+    }
+
+#ifdef Q_OS_UNIX
+    // 标准输入上的read()无法从其他线程中断，先等到有数据（或输入结束）再读，等待期间检查是否需要停止
+    if (m_kind == StandardInput) {
+        struct pollfd input = { STDIN_FILENO, POLLIN, 0 };
+        while (poll(&input, 1, PROCESS_POLL_MS) == 0) {
+            QMutexLocker locker(&m_mutex);
+            if (m_stopping) {
+                *error = "上传已取消";
+                return -1;
+            }
+        }
+    }
+#endif
+
+    QProcess *process = qobject_cast<QProcess*>(device);
+    for (;;) {
+        qint64 length = device->read(data, maxSize);
+        if (length < 0) {
+            *error = QString("读取上传数据失败: %1").arg(device->errorString());
+            return -1;
+        }
+        if (length > 0 || !process) {
+            return length;
+        }
+
+        if (process->state() == QProcess::NotRunning) {
+            if (process->bytesAvailable() > 0) {
+                continue;
+            }
+            // 输出已读完，只有正常退出时才算数据完整
+            if (process->exitStatus() != QProcess::NormalExit || process->exitCode() != 0) {
+                *error = QString("命令 %1 异常退出（退出码 %2）").arg(m_path).arg(process->exitCode());
+                return -1;
+            }
+            return 0;
+        }
+        {
+            QMutexLocker locker(&m_mutex);
+            if (m_stopping) {
+                *error = "上传已取消";
+                return -1;
+            }
+        }
+        process->waitForReadyRead(PROCESS_POLL_MS);
+    }
+}
+
+/**
+ * @brief 读取线程报告错误并结束
+ * @param error 错误信息
+ */
+void UploadSource::fail(const QString &error)
+{
+    QMutexLocker locker(&m_mutex);
+    m_lastError = error;
+    m_failed = true;
+    m_finished = true;
+    m_filled.wakeAll();
+}
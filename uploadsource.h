@@ -0,0 +1,231 @@
+/**
+ * @file uploadsource.h
+ * @brief 流式上传数据源
+ * @details 与下载写入本地文件相对应的上传输入，除本地文件外还可以是标准输入、
+ *          子进程的标准输出（如数据库导出命令）、内存数据或调用方提供的生成函数，
+ *          数据直接流向服务器，无需先写临时文件
+ *
+ * 除内存数据外，数据在独立的读取线程中产生，写入两个轮换的缓冲区：
+ * 网络发送一个缓冲区的同时，读取线程填充另一个，生产者和网络互相重叠。
+ * 发送方在等待数据时，读取线程立即交出已读到的部分，慢速生产者也不会让数据连接长时间空闲。
+ * 总大小未知时size()返回-1，进度按已读取的字节数报告
+ */
+
+#ifndef UPLOADSOURCE_H
+#define UPLOADSOURCE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThread>
+#include <QAtomicInteger>
+#include <functional>
+
+class QIODevice;
+
+/**
+ * @class UploadSource
+ * @brief 顺序读取的上传数据源
+ *
+ * 先用set*()选择一种数据源，再open()开始读取。read()可以在任意线程中调用，
+ * 但同一时刻只能有一个读取方
+ */
+class UploadSource
+{
+public:
+    /**
+     * @brief 数据生成函数
+     * @param data 输出缓冲区
+     * @param maxSize 缓冲区大小
+     * @return 写入的字节数，0表示数据结束，-1表示出错
+     *
+     * 在读取线程中调用
+     */
+    typedef std::function<qint64(char *data, qint64 maxSize)> Producer;
+
+    /**
+     * @brief 数据源类型
+     */
+    enum Kind {
+        None,             ///< 未设置
+        File,             ///< 本地文件
+        StandardInput,    ///< 本进程的标准输入
+        Process,          ///< 子进程的标准输出
+        Memory,           ///< 内存数据
+        Generator         ///< 调用方提供的生成函数
+    };
+
+    static constexpr qint64 DefaultBufferSize = 1024 * 1024; ///< 默认每个缓冲区的大小（字节）
+
+    /**
+     * @brief 构造函数
+     */
+    UploadSource();
+
+    /**
+     * @brief 析构函数，停止读取线程
+     */
+    ~UploadSource();
+
+    /**
+     * @brief 从本地文件读取
+     * @param path 文件路径
+     */
+    void setFile(const QString &path);
+
+    /**
+     * @brief 从本进程的标准输入读取，直到输入结束
+     */
+    void setStandardInput();
+
+    /**
+     * @brief 标准输入能否作为上传数据
+     * @param error 不能时输出原因，可以为nullptr
+     * @return 标准输入是管道、重定向的文件或套接字时返回true；
+     *         终端（没有人会在图形界面后面输入数据）、已关闭或/dev/null等设备返回false
+     */
+    static bool standardInputUsable(QString *error = nullptr);
+
+    /**
+     * @brief 从子进程的标准输出读取
+     * @param program 程序
+     * @param arguments 参数
+     *
+     * 子进程的标准错误转发到本进程的标准错误。子进程以非0状态退出或崩溃时上传失败，
+     * 避免把不完整的导出当作完整文件
+     */
+    void setProcess(const QString &program, const QStringList &arguments = QStringList());
+
+    /**
+     * @brief 从内存数据读取
+     * @param data 数据（隐式共享，不复制）
+     */
+    void setData(const QByteArray &data);
+
+    /**
+     * @brief 从生成函数读取
+     * @param producer 生成函数
+     * @param size 总大小，未知时为-1
+     */
+    void setProducer(Producer producer, qint64 size = -1);
+
+    /**
+     * @brief 设置每个缓冲区的大小，需在open()之前调用
+     * @param bytes 字节数
+     */
+    void setBufferSize(qint64 bytes);
+
+    /**
+     * @brief 开始读取
+     * @return 操作是否成功；子进程启动失败等在之后的read()中报告，标准输入不可用时直接失败
+     */
+    bool open();
+
+    /**
+     * @brief 停止读取，终止子进程，等待读取线程退出
+     *
+     * 读取线程等待标准输入时按固定间隔检查是否需要停止（Windows上除外），不会一直阻塞
+     */
+    void close();
+
+    /**
+     * @brief 取消读取，可以从任意线程调用
+     *
+     * 正在等待数据的read()和之后的read()都立即返回-1（上传因此中止），子进程在读取线程中终止；
+     * 取消后重新open()也不会恢复
+     */
+    void cancel();
+
+    /**
+     * @brief 读取数据
+     * @param data 输出缓冲区
+     * @param maxSize 缓冲区大小
+     * @return 读取的字节数，0表示数据结束，-1表示出错（原因见lastError()）
+     *
+     * 没有可用数据时阻塞
+     */
+    qint64 read(char *data, qint64 maxSize);
+
+    /**
+     * @brief 数据源类型
+     */
+    Kind kind() const { return m_kind; }
+
+    /**
+     * @brief 总大小
+     * @return 字节数，未知时为-1
+     */
+    qint64 size() const { return m_size; }
+
+    /**
+     * @brief 已读取的字节数
+     */
+    qint64 bytesRead() const { return m_bytesRead.loadRelaxed(); }
+
+    /**
+     * @brief 数据源的描述（文件路径、命令行等），用于日志
+     */
+    QString description() const;
+
+    /**
+     * @brief 获取最后一个错误信息
+     */
+    QString lastError() const;
+
+private:
+    /**
+     * @brief 读取线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 在读取线程中打开设备
+     * @return 打开的设备，生成函数为nullptr；出错时设置错误并返回nullptr
+     */
+    QIODevice *openDevice();
+
+    /**
+     * @brief 从设备或生成函数读取一次
+     * @param device 设备，为nullptr时使用生成函数
+     * @param data 输出缓冲区
+     * @param maxSize 缓冲区大小
+     * @param error 出错时输出错误信息
+     * @return 读取的字节数，0表示数据结束，-1表示出错
+     */
+    qint64 produce(QIODevice *device, char *data, qint64 maxSize, QString *error);
+
+    /**
+     * @brief 读取线程报告错误并结束
+     * @param error 错误信息
+     */
+    void fail(const QString &error);
+
+private:
+    Kind m_kind;                         ///< 数据源类型
+    QString m_path;                      ///< 文件路径或程序
+    QStringList m_arguments;             ///< 子进程参数
+    QByteArray m_data;                   ///< 内存数据
+    Producer m_producer;                 ///< 生成函数
+    qint64 m_size;                       ///< 总大小，未知时为-1
+    qint64 m_bufferSize;                 ///< 每个缓冲区的大小
+    QAtomicInteger<qint64> m_bytesRead;  ///< 已读取的字节数
+
+    mutable QMutex m_mutex;              ///< 保护以下成员
+    QWaitCondition m_filled;             ///< 有缓冲区填满或读取结束时唤醒读取方
+    QWaitCondition m_consumed;           ///< 有缓冲区读空或需要停止时唤醒读取线程
+    QByteArray m_buffers[2];             ///< 两个轮换的缓冲区，填充期间只由读取线程访问
+    qint64 m_lengths[2];                 ///< 缓冲区中待读取的字节数，-1表示空闲
+    int m_readIndex;                     ///< 读取方正在读取的缓冲区
+    qint64 m_readOffset;                 ///< 读取方在当前缓冲区中的位置
+    bool m_finished;                     ///< 读取线程是否已结束（数据结束或出错）
+    bool m_failed;                       ///< 是否出错
+    bool m_stopping;                     ///< 是否正在停止
+    QAtomicInt m_waiting;                ///< 读取方是否在等待数据
+    QAtomicInt m_cancelled;              ///< 是否已取消
+    QString m_lastError;                 ///< 最后一个错误信息
+    QThread *m_thread;                   ///< 读取线程
+};
+
+#endif // UPLOADSOURCE_H